@@ -10,10 +10,18 @@
 #include "display.h"
 #include "application.h"
 #include "sd_card.h"
+#include "gif_bundle.h"
+#include "gif_cache.h"
+#include "decoded_gif.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/queue.h"
+#include "latency_histogram.h"
+#include "system_info.h"
 #include <type_traits>
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -24,11 +32,20 @@
 #include <unistd.h>  // For unlink() and access()
 #include <wifi_station.h>
 #include <atomic>
+#include <mutex>
 
 // Overlay pixel format magic number (0x4F50584C = "OPXL" in ASCII)
 #define OVERLAY_PIXELS_FORMAT 0x4F50584C
 #define OVERLAY_ENTRY_SIZE_BYTES 6  // uint16 x, uint16 y, uint16 color
 
+// Frame-based SD animations carry no timing of their own
+#define ANIMATION_FRAME_DELAY_MS 500
+// Shortest frame lv_gif shows, one period of its timer
+#define ANIMATION_GIF_MIN_FRAME_DELAY_MS 10
+#define ANIMATION_RETRY_MS 1000
+#define ANIMATION_UNAVAILABLE_RETRY_MS 5000
+#define ANIMATION_QUEUE_LENGTH 8
+
 namespace {
 static std::atomic<bool> g_startup_load_blocked{false};
 }
@@ -248,6 +265,10 @@ static Animation_t sd_listening = {0};
 static Animation_t sd_smirk = {0};
 static Animation_t sd_wifi = {0};
 static Animation_t sd_battery = {0};
+static Animation_t* const g_sd_animations[] = {
+    &sd_normal, &sd_embarrass, &sd_fire, &sd_happy, &sd_inspiration, &sd_shy, &sd_sleep, &sd_laugh,
+    &sd_sad, &sd_cry, &sd_silence, &sd_listening, &sd_smirk, &sd_wifi, &sd_battery,
+};
 
 // Initialize GIF fields
 #define INIT_ANIM(anim) do { \
@@ -260,8 +281,58 @@ static Animation_t sd_battery = {0};
     (anim).gif_start_data_size = 0; \
     (anim).gif_loop_data = NULL; \
     (anim).gif_loop_data_size = 0; \
+    (anim).gif_lazy = false; \
+    (anim).gif_loop_offset = 0; \
+    (anim).gif_start_offset = 0; \
+    (anim).use_decoded = false; \
+    (anim).decode_attempted = false; \
+    (anim).decoded = NULL; \
 } while(0)
 
+#ifdef CONFIG_ANIMATION_GIF_LAZY_LOAD
+#define GIF_CACHE_BUDGET_BYTES ((size_t)CONFIG_ANIMATION_GIF_CACHE_BUDGET_KB * 1024u)
+#else
+#define GIF_CACHE_BUDGET_BYTES ((size_t)0)
+#endif
+
+// Shared index over test.bin. Opened once per load pass instead of once per
+// GIF; see GifBundle for the on-disk layout. In lazy mode it stays open so the
+// cache can fetch GIFs on first use.
+static GifBundle g_gif_bundle;
+static bool g_gif_bundle_header_failed = false;
+static GifCache g_gif_cache(GIF_CACHE_BUDGET_BYTES);
+// Held by plat_animation_task while it handles an event, and by anyone freeing
+// assets it may be reading
+static std::mutex g_animation_mutex;
+
+static bool animation_has_gif(const Animation_t* anim)
+{
+    return anim->use_gif && anim->gif_data_size > 0 && (anim->gif_data != NULL || anim->gif_lazy);
+}
+
+/**
+ * Get the bytes of an animation's start or loop GIF, fetching them through the
+ * GIF cache for lazily loaded animations.
+ * @return NULL if the GIF is absent or could not be read
+ */
+static const uint8_t* animation_get_gif_bytes(const Animation_t* anim, bool start)
+{
+    if (!anim->gif_lazy) {
+        if (start) {
+            return anim->gif_start_data;
+        }
+        return anim->gif_loop_data ? anim->gif_loop_data : anim->gif_data;
+    }
+    // Callers hold g_animation_mutex, so the bundle cannot be closed under us
+    GifBundle::Entry entry = {};
+    entry.offset = start ? anim->gif_start_offset : anim->gif_loop_offset;
+    entry.size = (uint32_t)(start ? anim->gif_start_data_size : anim->gif_loop_data_size);
+    if (entry.size == 0 || !g_gif_bundle.IsOpen()) {
+        return NULL;
+    }
+    return g_gif_cache.Acquire(g_gif_bundle, entry);
+}
+
 // Function to get the appropriate animation (SD card only)
 Animation_t* get_animation(int index) {
     // Check WiFi and battery status for normal animations
@@ -278,7 +349,7 @@ Animation_t* get_animation(int index) {
             if (should_show_wifi_anim) {
                 Animation_t* wifi_anim = animation_get_wifi_animation();
                 if (wifi_anim != NULL &&
-                    (wifi_anim->use_gif || wifi_anim->use_spiffs)) {
+                    (animation_has_gif(wifi_anim) || wifi_anim->use_spiffs)) {
                     ESP_LOGI("animation", "WiFi disconnected in state %d, showing wifi animation instead of normal", state);
                     return wifi_anim;
                 } else {
@@ -296,7 +367,7 @@ Animation_t* get_animation(int index) {
                 // Battery is below 20%, show battery animation instead of normal
                 Animation_t* battery_anim = animation_get_battery_animation();
                 if (battery_anim != NULL && 
-                    (battery_anim->use_gif || battery_anim->use_spiffs)) {
+                    (animation_has_gif(battery_anim) || battery_anim->use_spiffs)) {
                     ESP_LOGI("animation", "Battery level %d%% < 20%%, showing battery animation instead of normal", battery_level);
                     return battery_anim;
                 } else {
@@ -361,10 +432,6 @@ Animation_t *animations[] = {
     NULL   // ANIMATION_CRY
 };
 
-static int now_animation = ANIMATION_NORMAL;
-int pos = 0;
-TaskHandle_t animation_task_handle = nullptr;
-static bool animation_locked_by_silence = false;  // Lock animation when volume is 0
 
 
 // Helper function to get animation name string
@@ -381,134 +448,299 @@ static const char* get_animation_name(int animation_index) {
     return "UNKNOWN";
 }
 
+#ifdef CONFIG_ANIMATION_PREDECODE_GIFS
+#define PREDECODE_BUDGET_BYTES ((size_t)CONFIG_ANIMATION_PREDECODE_BUDGET_KB * 1024u)
+// Coalescing key for the pre-decode pass on the background task
+#define PREDECODE_JOB_KEY 0x50524544u
+static size_t g_predecoded_bytes = 0;
+// Bumped under g_animation_mutex on every reload, so a pre-decode that raced
+// one throws its frames away instead of attaching them to the new slots
+static uint32_t g_animation_generation = 0;
+
+static bool animation_predecode_wanted(const char* gif_name)
+{
+    if (gif_name == NULL) {
+        return false;
+    }
+    // CONFIG_ANIMATION_PREDECODE_GIF_NAMES is a comma-separated list of loop GIFs
+    const char* list = CONFIG_ANIMATION_PREDECODE_GIF_NAMES;
+    size_t name_len = strlen(gif_name);
+    while (*list != '\0') {
+        const char* end = strchr(list, ',');
+        size_t len = end ? (size_t)(end - list) : strlen(list);
+        if (len == name_len && strncasecmp(list, gif_name, len) == 0) {
+            return true;
+        }
+        list = end ? end + 1 : list + len;
+    }
+    return false;
+}
+#endif
+
+// gifdec decode+render time per source frame, measured while pre-decoding:
+// what lv_gif spends on the LVGL task for every frame of the same GIFs
+static LatencyHistogram animation_gifdec_frame_latency;
+// LVGL render time of a pre-decoded frame
+static LatencyHistogram animation_blit_frame_latency;
+
+// Decoded frames for an animation's loop GIF, once the background pre-decode
+// pass has attached them. NULL means "play it through lv_gif".
+static const DecodedGif* animation_get_decoded(Animation_t* anim)
+{
+    return anim->use_decoded ? anim->decoded : NULL;
+}
+
+// Show an animation's loop, preferring pre-decoded frames over lv_gif.
+static bool animation_show_loop(Display* display, Animation_t* anim,
+                                const DecodedGif** playing_frames, size_t* frame_index)
+{
+    const DecodedGif* decoded = animation_get_decoded(anim);
+    if (decoded != NULL && decoded->frame_count() > 0) {
+        *playing_frames = decoded;
+        *frame_index = 0;
+        display->SetEmotionImg(decoded->frame(0));
+        return true;
+    }
+    *playing_frames = NULL;
+    const uint8_t* loop_bytes = animation_get_gif_bytes(anim, false);
+    if (loop_bytes == NULL) {
+        return false;
+    }
+    display->SetEmotionGif(loop_bytes, anim->gif_data_size);
+    return true;
+}
+
+// Length of one pass through a GIF, summed from its Graphic Control Extension
+// delays without decoding any image data. 0 if the header is not a GIF.
+static uint32_t animation_gif_duration_ms(const uint8_t* data, size_t size)
+{
+    if (data == NULL || size < 13 || memcmp(data, "GIF", 3) != 0) {
+        return 0;
+    }
+    size_t p = 13;
+    if (data[10] & 0x80) {
+        p += 3 * (1u << ((data[10] & 0x07) + 1));   // Global color table
+    }
+    uint32_t total_ms = 0;
+    uint32_t delay_ms = 0;
+    while (p < size) {
+        uint8_t block = data[p++];
+        if (block == 0x21 && p < size) {
+            uint8_t label = data[p++];
+            if (label == 0xF9 && p + 4 <= size && data[p] == 4) {
+                delay_ms = (uint32_t)(data[p + 2] | (data[p + 3] << 8)) * 10;
+            }
+        } else if (block == 0x2C && p + 9 <= size) {
+            uint8_t flags = data[p + 8];
+            p += 9;
+            if (flags & 0x80) {
+                p += 3 * (1u << ((flags & 0x07) + 1));  // Local color table
+            }
+            p++;    // LZW minimum code size
+            // lv_gif shows each frame for at least one of its timer periods
+            total_ms += delay_ms > ANIMATION_GIF_MIN_FRAME_DELAY_MS ? delay_ms : ANIMATION_GIF_MIN_FRAME_DELAY_MS;
+            delay_ms = 0;
+        } else {
+            break;  // Trailer or garbage
+        }
+        // Skip the data sub-blocks of the extension or image
+        while (p < size && data[p] != 0) {
+            p += data[p] + 1;
+        }
+        p++;
+    }
+    return total_ms;
+}
+
+enum AnimationEventType {
+    kAnimationEventSet,         // now_animation changed
+    kAnimationEventGifDone,     // lv_gif finished the last repeat of `gif`
+    kAnimationEventDecoded,     // Pre-decoded frames were attached to an animation
+};
+
+struct AnimationEvent {
+    AnimationEventType type;
+    const uint8_t* gif;
+};
+
+// Owned by plat_animation_task
+struct AnimationPlayer {
+    int shown = -1;                     // now_animation on screen, -1 to retry at the deadline
+    Animation_t* anim = NULL;
+    const uint8_t* start_gif = NULL;    // Start GIF on screen; NULL once the loop is
+    const DecodedGif* frames = NULL;    // Set while a pre-decoded loop is being blitted
+    size_t frame_index = 0;
+    int64_t deadline_us = 0;            // Next timed step, 0 if there is none
+};
+
+static std::atomic<int> now_animation{ANIMATION_NORMAL};
+int pos = 0;
+TaskHandle_t animation_task_handle = nullptr;
+static bool animation_locked_by_silence = false;  // Lock animation when volume is 0
+static QueueHandle_t animation_queue = nullptr;
+static std::atomic<int64_t> animation_requested_us{0};
+// animation_set_now_animation() -> new emotion handed to the display
+static LatencyHistogram animation_switch_latency;
+
+static void animation_player_enter_loop(AnimationPlayer* player, Display* display)
+{
+    if (!animation_show_loop(display, player->anim, &player->frames, &player->frame_index)) {
+        // Cache could not fetch it; keep the start GIF and try again
+        ESP_LOGW("plat_animation_task", "Loop GIF for animation %d unavailable", player->shown);
+        player->deadline_us = esp_timer_get_time() + ANIMATION_RETRY_MS * 1000;
+        return;
+    }
+    player->start_gif = NULL;
+    player->deadline_us = player->frames != NULL ?
+        esp_timer_get_time() + (int64_t)player->frames->delay_ms(0) * 1000 : 0;
+    ESP_LOGD("plat_animation_task", "Switched to GIF loop animation %d", player->shown);
+}
+
+// anim is get_animation(index), resolved by the caller
+static void animation_player_show(AnimationPlayer* player, Display* display, int index, Animation_t* anim)
+{
+    player->start_gif = NULL;
+    player->frames = NULL;
+    player->deadline_us = 0;
+
+    if (anim == NULL) {
+        // Only log warning every 10 seconds instead of on every retry
+        static int64_t last_warning_us = 0;
+        int64_t now_us = esp_timer_get_time();
+        if (now_us - last_warning_us >= 10000 * 1000) {
+            ESP_LOGW("plat_animation_task", "Animation %d is not available, skipping frame", index);
+            last_warning_us = now_us;
+        }
+        // Animations may still be loading; look again later without disturbing audio tasks
+        player->shown = -1;
+        player->deadline_us = now_us + ANIMATION_UNAVAILABLE_RETRY_MS * 1000;
+        return;
+    }
+    player->anim = anim;
+
+    if (animation_has_gif(anim)) {
+        // For animations with start GIF: start with start GIF, the loop follows when it ends
+        const uint8_t* start_bytes = anim->has_start_gif ? animation_get_gif_bytes(anim, true) : NULL;
+        if (start_bytes != NULL) {
+            display->SetEmotionGif(start_bytes, anim->gif_start_data_size);
+            player->start_gif = start_bytes;
+            // lv_gif only reports the end of GIFs with a finite repeat count; for the
+            // others the loop takes over after one pass
+            uint32_t duration_ms = animation_gif_duration_ms(start_bytes, anim->gif_start_data_size);
+            player->deadline_us = esp_timer_get_time() +
+                (int64_t)(duration_ms > 0 ? duration_ms : ANIMATION_RETRY_MS) * 1000;
+            ESP_LOGD("plat_animation_task", "Animation changed to %s: Starting with start GIF (%u ms)",
+                     get_animation_name(index), (unsigned)duration_ms);
+        } else if (animation_show_loop(display, anim, &player->frames, &player->frame_index)) {
+            if (player->frames != NULL) {
+                player->deadline_us = esp_timer_get_time() + (int64_t)player->frames->delay_ms(0) * 1000;
+            }
+            ESP_LOGD("plat_animation_task", "Animation changed to %s: Using main GIF", get_animation_name(index));
+        } else {
+            // Cache could not fetch it; retry shortly
+            ESP_LOGW("plat_animation_task", "GIF for animation %d unavailable", index);
+            player->shown = -1;
+            player->deadline_us = esp_timer_get_time() + ANIMATION_RETRY_MS * 1000;
+            return;
+        }
+    } else {
+        // Frame-based animations
+        pos = 0;
+        display->SetEmotionImg(anim->imges[anim->animations[pos]]);
+        player->deadline_us = esp_timer_get_time() + ANIMATION_FRAME_DELAY_MS * 1000;
+    }
+    player->shown = index;
+
+    int64_t requested_us = animation_requested_us.exchange(0);
+    if (requested_us != 0) {
+        animation_switch_latency.Record(esp_timer_get_time() - requested_us);
+    }
+}
+
+// Called when the player's deadline passes
+static void animation_player_step(AnimationPlayer* player, Display* display)
+{
+    player->deadline_us = 0;
+    if (player->shown < 0) {
+        int requested = now_animation.load();
+        animation_player_show(player, display, requested, get_animation(requested));
+    } else if (player->start_gif != NULL) {
+        animation_player_enter_loop(player, display);
+    } else if (player->frames != NULL && player->anim->decoded != player->frames) {
+        // The frames were freed by a reload; start the animation over
+        animation_player_show(player, display, player->shown, player->anim);
+    } else if (player->frames != NULL) {
+        // Pre-decoded loop: we drive the frames ourselves. The previous frame was
+        // drawn by the LVGL refresh that ran since the last step.
+        uint32_t render_us = display->GetLastRenderUs();
+        if (render_us > 0) {
+            animation_blit_frame_latency.Record(render_us);
+        }
+        player->frame_index = (player->frame_index + 1) % player->frames->frame_count();
+        int64_t t0 = esp_timer_get_time();
+        display->SetEmotionImg(player->frames->frame(player->frame_index));
+        player->deadline_us = t0 + (int64_t)player->frames->delay_ms(player->frame_index) * 1000;
+    } else if (!animation_has_gif(player->anim)) {
+        pos++;
+        if (pos >= player->anim->len) {
+            pos = 0;
+        }
+        display->SetEmotionImg(player->anim->imges[player->anim->animations[pos]]);
+        player->deadline_us = esp_timer_get_time() + ANIMATION_FRAME_DELAY_MS * 1000;
+    }
+}
+
 void plat_animation_task(void *arg)
 {
     auto display = Board::GetInstance().GetDisplay();
-    int last_animation = -1; // Track last animation to detect changes
-    bool in_start_phase = false; // Track if we're in start phase (for start+loop animations)
-    bool start_gif_played = false; // Flag to ensure start GIF is only played once per animation
-    bool loop_gif_set = false; // Flag to track if loop GIF has been set (prevent multiple calls)
-    TickType_t start_phase_start_time = 0; // When we started the start phase
-    TickType_t last_log_time = xTaskGetTickCount(); // Track time for periodic logging
-    
+    display->OnEmotionGifDone([](const uint8_t* gif_data) {
+        AnimationEvent event = {kAnimationEventGifDone, gif_data};
+        xQueueSend(animation_queue, &event, 0);
+    });
+    AnimationPlayer player;
+    player.deadline_us = esp_timer_get_time();
+
+    // Sleeps until an animation is requested, a GIF ends or the next frame is due
     while (1)
     {
-        ESP_LOGD("plat_animation_task", "now_animation: %d, pos: %d", now_animation, pos);
-        
-        // Use get_animation() to get the appropriate animation (SD card only)
-        Animation_t* current_anim = get_animation(now_animation);
-        
-        // Check for NULL animation to prevent crashes
-        if (current_anim == NULL) {
-            // When animations aren't available, reduce task frequency to avoid interfering
-            // with wake word detection and other critical audio tasks
-            // Only log warning every 10 seconds instead of every 500ms
-            static TickType_t last_warning_time = 0;
-            TickType_t current_time_check = xTaskGetTickCount();
-            if ((current_time_check - last_warning_time) >= pdMS_TO_TICKS(10000)) {
-                ESP_LOGW("plat_animation_task", "Animation %d is not available, skipping frame", now_animation);
-                last_warning_time = current_time_check;
-            }
-            // Use longer delay (5 seconds) to reduce CPU usage and avoid interfering with audio tasks
-            vTaskDelay(pdMS_TO_TICKS(5000));
+        TickType_t wait = portMAX_DELAY;
+        if (player.deadline_us != 0) {
+            int64_t remaining_us = player.deadline_us - esp_timer_get_time();
+            wait = remaining_us > 0 ? pdMS_TO_TICKS((remaining_us + 999) / 1000) : 0;
+        }
+
+        AnimationEvent event;
+        bool received = xQueueReceive(animation_queue, &event, wait) == pdTRUE;
+        std::lock_guard<std::mutex> lock(g_animation_mutex);
+        if (!received) {
+            animation_player_step(&player, display);
             continue;
         }
-        
-        // Log current animation every 3 seconds
-        TickType_t current_time = xTaskGetTickCount();
-        if ((current_time - last_log_time) >= pdMS_TO_TICKS(3000)) {
-            const char* anim_name = get_animation_name(now_animation);
-            const char* anim_type = "UNKNOWN";
-            const char* anim_source = "NONE";
-            
-            if (current_anim->use_gif && current_anim->gif_data) {
-                anim_type = "GIF";
-                if (current_anim->gif_path) {
-                    anim_source = current_anim->gif_path;
-                } else {
-                    anim_source = "test.bin";
-                }
-            } else if (current_anim->use_spiffs) {
-                anim_type = "FRAME_BASED";
-                anim_source = "SD_CARD";
+        if (event.type == kAnimationEventGifDone) {
+            // Ignore the end of a start GIF that has already been replaced
+            if (player.start_gif != NULL && event.gif == player.start_gif) {
+                animation_player_enter_loop(&player, display);
             }
-            
-            /*ESP_LOGI("animation", "Currently displaying: %s (index: %d, type: %s, source: %s, frames: %d)", 
-                     anim_name, now_animation, anim_type, anim_source, current_anim->len);*/
-            
-            last_log_time = current_time;
+            continue;
         }
-        
-        // Handle GIF animations
-        if (current_anim->use_gif && current_anim->gif_data) {
-            // Check if animation has changed
-            bool animation_changed = (last_animation != now_animation);
-            
-            if (animation_changed) {
-                // Animation changed - reset all flags and start fresh
-                in_start_phase = false;
-                start_gif_played = false;
-                loop_gif_set = false;
-                start_phase_start_time = 0;
-                
-                // For animations with start GIF: start with start GIF
-                // For animations without start GIF: use main/loop GIF directly
-                if (current_anim->has_start_gif && current_anim->gif_start_data && current_anim->gif_loop_data) {
-                    // New animation with start+loop: start with start GIF (only once)
-                    in_start_phase = true;
-                    start_gif_played = true; // Mark that we've played the start GIF
-                    loop_gif_set = false; // Loop GIF not set yet
-                    start_phase_start_time = xTaskGetTickCount();
-                    display->SetEmotionGif(current_anim->gif_start_data, current_anim->gif_start_data_size);
-                    ESP_LOGD("plat_animation_task", "Animation changed to %d: Starting with start GIF", now_animation);
-                } else {
-                    // New animation without start GIF: use main/loop GIF directly
-                    in_start_phase = false;
-                    start_gif_played = true; // Mark as played (no start GIF to play)
-                    loop_gif_set = true; // Main GIF is the loop
-                    display->SetEmotionGif(current_anim->gif_data, current_anim->gif_data_size);
-                    ESP_LOGD("plat_animation_task", "Animation changed to %d: Using main GIF", now_animation);
-                }
-                last_animation = now_animation;
-            } else {
-                // Same animation - preserve current state, only transition from start to loop
-                if (current_anim->has_start_gif && current_anim->gif_start_data && current_anim->gif_loop_data) {
-                    if (in_start_phase && start_gif_played && !loop_gif_set) {
-                        // Still in start phase - check if we should switch to loop (after ~1 second)
-                        TickType_t elapsed = xTaskGetTickCount() - start_phase_start_time;
-                        if (elapsed >= pdMS_TO_TICKS(1000)) {
-                            // Switch to loop phase (only once)
-                            display->SetEmotionGif(current_anim->gif_loop_data, current_anim->gif_loop_data_size);
-                            in_start_phase = false; // Stay in loop phase
-                            loop_gif_set = true; // Mark loop GIF as set
-                            ESP_LOGD("plat_animation_task", "Switched to GIF loop animation %d", now_animation);
-                        }
-                        // else: still playing start GIF, do nothing (LVGL handles the animation)
-                    }
-                    // else: already in loop phase (loop_gif_set == true), do nothing (LVGL handles the animation)
-                }
-                // else: animation without start GIF, already displaying main GIF, do nothing
+        if (event.type == kAnimationEventDecoded) {
+            // A loop already playing through lv_gif switches to its new frames
+            if (player.shown >= 0 && player.start_gif == NULL && player.frames == NULL &&
+                animation_has_gif(player.anim) && animation_get_decoded(player.anim) != NULL) {
+                animation_player_enter_loop(&player, display);
             }
-            
-            // Check less frequently for GIFs since they animate themselves
-            vTaskDelay(pdMS_TO_TICKS(1000));
             continue;
         }
-        
-        // Handle frame-based animations (existing code)
-        // Reset last_animation when switching to frame-based
-        if (last_animation != now_animation) {
-            pos = 0; // Reset position when animation changes
-            last_animation = now_animation;
-        }
-        
-        pos++;
-        if (pos >= current_anim->len)
-        {
-            pos = 0;
+
+        // get_animation() substitutes the Wi-Fi and battery animations for NORMAL,
+        // so compare what it resolves to, not just the index
+        int requested = now_animation.load();
+        Animation_t* anim = get_animation(requested);
+        if (requested != player.shown || anim != player.anim) {
+            animation_player_show(&player, display, requested, anim);
+        } else {
+            animation_requested_us.store(0);
         }
-        display->SetEmotionImg(current_anim->imges[current_anim->animations[pos]]);
-        vTaskDelay(pdMS_TO_TICKS(500));
     }
 }
 
@@ -522,6 +754,10 @@ void animation_set_now_animation(int animation)
     
     if (animation_task_handle == nullptr)
     {
+        animation_queue = xQueueCreate(ANIMATION_QUEUE_LENGTH, sizeof(AnimationEvent));
+        SystemInfo::RegisterLatencyHistogram("anim.switch", &animation_switch_latency);
+        SystemInfo::RegisterLatencyHistogram("anim.gifdec", &animation_gifdec_frame_latency);
+        SystemInfo::RegisterLatencyHistogram("anim.blit", &animation_blit_frame_latency);
         // Increased stack size to 4096 bytes to handle GIF operations
         // Reduced priority from 4 to 2 to ensure wake word detection (priority 3) has higher priority
         // This prevents animation task from interfering with critical audio processing
@@ -534,8 +770,131 @@ void animation_set_now_animation(int animation)
     }
     
     ESP_LOGI("animation_set_now_animation", "Set now animation: %d", animation);
-    now_animation = animation;
-    pos = 0;
+    if (now_animation.exchange(animation) != animation) {
+        animation_requested_us.store(esp_timer_get_time());
+    }
+    // A full queue already holds a wakeup, which picks up the latest now_animation
+    AnimationEvent event = {kAnimationEventSet, NULL};
+    xQueueSend(animation_queue, &event, 0);
+}
+
+void animation_refresh(void)
+{
+    if (animation_queue == nullptr) {
+        return;
+    }
+    AnimationEvent event = {kAnimationEventSet, NULL};
+    xQueueSend(animation_queue, &event, 0);
+}
+
+#ifdef CONFIG_ANIMATION_PREDECODE_GIFS
+/**
+ * Copy an animation's loop GIF into a private PSRAM buffer, so it can be
+ * decoded without holding g_animation_mutex. Caller holds the mutex.
+ * @return Buffer the caller frees, or NULL
+ */
+static uint8_t* animation_copy_loop_gif(const Animation_t* anim, size_t* size)
+{
+    uint8_t* copy = (uint8_t*)heap_caps_malloc(anim->gif_data_size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (copy == NULL) {
+        return NULL;
+    }
+    bool ok;
+    if (anim->gif_lazy) {
+        // Straight from the bundle, without pushing the cache's GIFs out
+        GifBundle::Entry entry = {};
+        entry.offset = anim->gif_loop_offset;
+        entry.size = (uint32_t)anim->gif_loop_data_size;
+        ok = g_gif_bundle.IsOpen() && g_gif_bundle.Read(entry, copy);
+    } else {
+        const uint8_t* loop_bytes = animation_get_gif_bytes(anim, false);
+        ok = loop_bytes != NULL;
+        if (ok) {
+            memcpy(copy, loop_bytes, anim->gif_data_size);
+        }
+    }
+    if (!ok) {
+        free(copy);
+        return NULL;
+    }
+    *size = anim->gif_data_size;
+    return copy;
+}
+
+// Runs on the background task after a load: decodes the configured loop GIFs
+// one at a time. The mutex is only held to copy a GIF and to attach its frames,
+// so plat_animation_task keeps playing through lv_gif meanwhile.
+static void animation_predecode_pass(void)
+{
+    for (Animation_t* anim : g_sd_animations) {
+        uint8_t* gif = NULL;
+        size_t gif_size = 0;
+        size_t budget_left = 0;
+        uint32_t generation = 0;
+        char name[32];
+        {
+            std::lock_guard<std::mutex> lock(g_animation_mutex);
+            if (anim->decode_attempted || anim->decoded != NULL || !animation_has_gif(anim) ||
+                !animation_predecode_wanted(anim->gif_path)) {
+                continue;
+            }
+            anim->decode_attempted = true;
+            // The slot may be reloaded while we decode; log a copy of the name
+            strlcpy(name, anim->gif_path, sizeof(name));
+            if (g_predecoded_bytes >= PREDECODE_BUDGET_BYTES) {
+                ESP_LOGW("animation", "Pre-decode budget used up; %s stays on lv_gif", name);
+                continue;
+            }
+            gif = animation_copy_loop_gif(anim, &gif_size);
+            budget_left = PREDECODE_BUDGET_BYTES - g_predecoded_bytes;
+            generation = g_animation_generation;
+            if (gif == NULL) {
+                ESP_LOGW("animation", "Could not read %s for pre-decoding", name);
+                continue;
+            }
+        }
+
+        int64_t t0 = esp_timer_get_time();
+        DecodedGif* decoded = DecodedGif::Decode(gif, gif_size, budget_left, &animation_gifdec_frame_latency);
+        int64_t decode_ms = (esp_timer_get_time() - t0) / 1000;
+        free(gif);
+        if (decoded == NULL) {
+            ESP_LOGW("animation", "Pre-decode of %s failed or over budget; using lv_gif", name);
+            continue;
+        }
+
+        std::lock_guard<std::mutex> lock(g_animation_mutex);
+        if (generation != g_animation_generation || anim->decoded != NULL) {
+            // Reloaded while decoding; the pass scheduled by that load takes over
+            delete decoded;
+            continue;
+        }
+        g_predecoded_bytes += decoded->strip_bytes();
+        anim->decoded = decoded;
+        anim->use_decoded = true;
+        ESP_LOGI("animation", "Pre-decoded %s in %lld ms (%u KB of %u KB budget used)", name,
+                 (long long)decode_ms, (unsigned)(g_predecoded_bytes / 1024),
+                 (unsigned)(PREDECODE_BUDGET_BYTES / 1024));
+        if (animation_queue != nullptr) {
+            AnimationEvent event = {kAnimationEventDecoded, NULL};
+            xQueueSend(animation_queue, &event, 0);
+        }
+    }
+}
+#endif
+
+// Queue the pre-decode pass for freshly loaded animations. Back-to-back loads
+// share one pass.
+static void animation_schedule_predecode(void)
+{
+#ifdef CONFIG_ANIMATION_PREDECODE_GIFS
+    BackgroundTask* background_task = Application::GetInstance().GetBackgroundTask();
+    if (background_task == nullptr) {
+        // Torn down for an OTA upgrade
+        return;
+    }
+    background_task->Schedule(animation_predecode_pass, kBackgroundLaneHousekeeping, PREDECODE_JOB_KEY);
+#endif
 }
 
 // Function to check volume and lock/unlock silence animation
@@ -566,12 +925,54 @@ void animation_init(void)
 }
 
 
+// Free an animation's pre-decoded frames and return them to the budget
+static void animation_release_decoded(Animation_t* anim)
+{
+    std::lock_guard<std::mutex> lock(g_animation_mutex);
+    if (anim->decoded) {
+#ifdef CONFIG_ANIMATION_PREDECODE_GIFS
+        g_predecoded_bytes -= anim->decoded->strip_bytes();
+#endif
+        // emotion_label_ keeps pointing at the last frame it was given
+        if (anim->decoded->frame_count() > 0) {
+            Board::GetInstance().GetDisplay()->ReleaseEmotionImages(anim->decoded->frame(0),
+                                                                     anim->decoded->frame_count());
+        }
+        delete anim->decoded;
+        anim->decoded = NULL;
+    }
+    anim->use_decoded = false;
+    anim->decode_attempted = false;
+}
+
+void animation_release_bundle(void)
+{
+    std::lock_guard<std::mutex> lock(g_animation_mutex);
+    g_gif_cache.Clear();
+    g_gif_bundle.Close();
+}
+
 void animation_load_sd_card_animations(void)
 {
     ESP_LOGI("animation", "Attempting to load animations from SD card...");
     
     // Debug SD card status before attempting to load
     SdCard::DebugStatus();
+
+    // Drop anything served from a previous bundle before its slots are reset.
+    animation_release_bundle();
+#ifdef CONFIG_ANIMATION_PREDECODE_GIFS
+    {
+        std::lock_guard<std::mutex> lock(g_animation_mutex);
+        g_animation_generation++;
+    }
+#endif
+    g_gif_bundle_header_failed = false;
+
+    // INIT_ANIM forgets the frames without freeing them
+    for (Animation_t* anim : g_sd_animations) {
+        animation_release_decoded(anim);
+    }
     
     // Initialize GIF fields for all animations
     INIT_ANIM(sd_normal);
@@ -601,6 +1002,7 @@ void animation_load_sd_card_animations(void)
     if (animation_load_gifs_from_test_bin()) {
         ESP_LOGI("animation", "🎉 Successfully loaded GIF animations from test.bin!");
         ESP_LOGI("animation", "   - Using GIF format for animations");
+        animation_schedule_predecode();
         return; // Success with GIFs!
     }
 
@@ -697,10 +1099,11 @@ void animation_cleanup_sd_card_animation(Animation_t* anim)
     
     // Free GIF data if used
     if (anim->use_gif) {
-        if (anim->gif_data) {
+        // gif_data aliases gif_loop_data for start+loop animations
+        if (anim->gif_data && anim->gif_data != anim->gif_loop_data) {
             free(anim->gif_data);
-            anim->gif_data = NULL;
         }
+        anim->gif_data = NULL;
         if (anim->gif_path) {
             free(anim->gif_path);
             anim->gif_path = NULL;
@@ -719,6 +1122,11 @@ void animation_cleanup_sd_card_animation(Animation_t* anim)
         anim->gif_data_size = 0;
         anim->gif_start_data_size = 0;
         anim->gif_loop_data_size = 0;
+        // Lazily loaded GIFs own no memory here; the cache frees them.
+        anim->gif_lazy = false;
+        anim->gif_loop_offset = 0;
+        anim->gif_start_offset = 0;
+        animation_release_decoded(anim);
     }
     
     // Free image data and descriptors
@@ -755,7 +1163,7 @@ void animation_cleanup_sd_card_animation(Animation_t* anim)
 Animation_t* animation_get_normal_animation(void)
 {
     // Check if GIF animation is loaded
-    if (sd_normal.use_gif && sd_normal.gif_data && sd_normal.gif_data_size > 0) {
+    if (animation_has_gif(&sd_normal)) {
         return &sd_normal;
     }
     // Check if SD card frame-based animation is loaded and valid
@@ -775,7 +1183,7 @@ Animation_t* animation_get_normal_animation(void)
 // Function to get the appropriate embarrass animation (SD card only)
 Animation_t* animation_get_embarrass_animation(void)
 {
-    if (sd_embarrass.use_gif && sd_embarrass.gif_data && sd_embarrass.gif_data_size > 0) {
+    if (animation_has_gif(&sd_embarrass)) {
         return &sd_embarrass;
     }
     if (sd_embarrass.use_spiffs && sd_embarrass.imges && sd_embarrass.len > 0) {
@@ -788,7 +1196,7 @@ Animation_t* animation_get_embarrass_animation(void)
 // Function to get the appropriate fire animation (SD card only)
 Animation_t* animation_get_fire_animation(void)
 {
-    if (sd_fire.use_gif && sd_fire.gif_data && sd_fire.gif_data_size > 0) {
+    if (animation_has_gif(&sd_fire)) {
         return &sd_fire;
     }
     if (sd_fire.use_spiffs && sd_fire.imges && sd_fire.len > 0) {
@@ -801,7 +1209,7 @@ Animation_t* animation_get_fire_animation(void)
 // Function to get the appropriate happy animation (SD card only)
 Animation_t* animation_get_happy_animation(void)
 {
-    if (sd_happy.use_gif && sd_happy.gif_data && sd_happy.gif_data_size > 0) {
+    if (animation_has_gif(&sd_happy)) {
         return &sd_happy;
     }
     if (sd_happy.use_spiffs && sd_happy.imges && sd_happy.len > 0) {
@@ -814,7 +1222,7 @@ Animation_t* animation_get_happy_animation(void)
 // Function to get the appropriate inspiration animation (SD card only)
 Animation_t* animation_get_inspiration_animation(void)
 {
-    if (sd_inspiration.use_gif && sd_inspiration.gif_data && sd_inspiration.gif_data_size > 0) {
+    if (animation_has_gif(&sd_inspiration)) {
         return &sd_inspiration;
     }
     if (sd_inspiration.use_spiffs && sd_inspiration.imges && sd_inspiration.len > 0) {
@@ -827,7 +1235,7 @@ Animation_t* animation_get_inspiration_animation(void)
 // Function to get the appropriate shy animation (SD card only)
 Animation_t* animation_get_shy_animation(void)
 {
-    if (sd_shy.use_gif && sd_shy.gif_data && sd_shy.gif_data_size > 0) {
+    if (animation_has_gif(&sd_shy)) {
         return &sd_shy;
     }
     if (sd_shy.use_spiffs && sd_shy.imges && sd_shy.len > 0) {
@@ -840,7 +1248,7 @@ Animation_t* animation_get_shy_animation(void)
 // Function to get the appropriate sleep animation (SD card only)
 Animation_t* animation_get_sleep_animation(void)
 {
-    if (sd_sleep.use_gif && sd_sleep.gif_data && sd_sleep.gif_data_size > 0) {
+    if (animation_has_gif(&sd_sleep)) {
         return &sd_sleep;
     }
     if (sd_sleep.use_spiffs && sd_sleep.imges && sd_sleep.len > 0) {
@@ -853,7 +1261,7 @@ Animation_t* animation_get_sleep_animation(void)
 // Function to get the appropriate laugh animation (SD card only)
 Animation_t* animation_get_laugh_animation(void)
 {
-    if (sd_laugh.use_gif && sd_laugh.gif_data && sd_laugh.gif_data_size > 0) {
+    if (animation_has_gif(&sd_laugh)) {
         return &sd_laugh;
     }
     if (sd_laugh.use_spiffs && sd_laugh.imges && sd_laugh.len > 0) {
@@ -866,7 +1274,7 @@ Animation_t* animation_get_laugh_animation(void)
 // Function to get the appropriate sad animation (SD card only)
 Animation_t* animation_get_sad_animation(void)
 {
-    if (sd_sad.use_gif && sd_sad.gif_data && sd_sad.gif_data_size > 0) {
+    if (animation_has_gif(&sd_sad)) {
         return &sd_sad;
     }
     if (sd_sad.use_spiffs && sd_sad.imges && sd_sad.len > 0) {
@@ -879,10 +1287,7 @@ Animation_t* animation_get_sad_animation(void)
 // Function to get the appropriate cry animation (SD card only)
 Animation_t* animation_get_cry_animation(void)
 {
-    if (sd_cry.use_gif && sd_cry.gif_data && sd_cry.gif_data_size > 0) {
-        return &sd_cry;
-    }
-    if (sd_cry.use_gif && sd_cry.gif_loop_data && sd_cry.gif_loop_data_size > 0) {
+    if (animation_has_gif(&sd_cry)) {
         return &sd_cry;
     }
     if (sd_cry.use_spiffs && sd_cry.imges && sd_cry.len > 0) {
@@ -895,7 +1300,7 @@ Animation_t* animation_get_cry_animation(void)
 // Function to get the appropriate silence animation (SD card only)
 Animation_t* animation_get_silence_animation(void)
 {
-    if (sd_silence.use_gif && sd_silence.gif_data && sd_silence.gif_data_size > 0) {
+    if (animation_has_gif(&sd_silence)) {
         return &sd_silence;
     }
     if (sd_silence.use_spiffs && sd_silence.imges && sd_silence.len > 0) {
@@ -908,7 +1313,7 @@ Animation_t* animation_get_silence_animation(void)
 // Function to get the appropriate listening animation (SD card only)
 Animation_t* animation_get_listening_animation(void)
 {
-    if (sd_listening.use_gif && sd_listening.gif_data && sd_listening.gif_data_size > 0) {
+    if (animation_has_gif(&sd_listening)) {
         return &sd_listening;
     }
     if (sd_listening.use_spiffs && sd_listening.imges && sd_listening.len > 0) {
@@ -921,7 +1326,7 @@ Animation_t* animation_get_listening_animation(void)
 // Function to get the appropriate smirk animation (SD card only)
 Animation_t* animation_get_smirk_animation(void)
 {
-    if (sd_smirk.use_gif && sd_smirk.gif_data && sd_smirk.gif_data_size > 0) {
+    if (animation_has_gif(&sd_smirk)) {
         return &sd_smirk;
     }
     if (sd_smirk.use_spiffs && sd_smirk.imges && sd_smirk.len > 0) {
@@ -934,7 +1339,7 @@ Animation_t* animation_get_smirk_animation(void)
 // Function to get the appropriate battery animation (SD card only)
 Animation_t* animation_get_battery_animation(void)
 {
-    if (sd_battery.use_gif && sd_battery.gif_data && sd_battery.gif_data_size > 0) {
+    if (animation_has_gif(&sd_battery)) {
         return &sd_battery;
     }
     if (sd_battery.use_spiffs && sd_battery.imges && sd_battery.len > 0) {
@@ -947,7 +1352,7 @@ Animation_t* animation_get_battery_animation(void)
 // Function to get the appropriate wifi animation (SD card only)
 Animation_t* animation_get_wifi_animation(void)
 {
-    if (sd_wifi.use_gif && sd_wifi.gif_data && sd_wifi.gif_data_size > 0) {
+    if (animation_has_gif(&sd_wifi)) {
         return &sd_wifi;
     }
     if (sd_wifi.use_spiffs && sd_wifi.imges && sd_wifi.len > 0) {
@@ -975,6 +1380,12 @@ void animation_show_current_sources(void)
             ESP_LOGI("animation", "  %s: Not available", anim_names[i]);
         }
     }
+#ifdef CONFIG_ANIMATION_GIF_LAZY_LOAD
+    GifCache::Stats stats = g_gif_cache.GetStats();
+    ESP_LOGI("animation", "GIF cache: %u entries, %u/%u bytes, hits=%u misses=%u evictions=%u",
+             (unsigned)stats.entries, (unsigned)stats.resident_bytes, (unsigned)stats.budget_bytes,
+             (unsigned)stats.hits, (unsigned)stats.misses, (unsigned)stats.evictions);
+#endif
     ESP_LOGI("animation", "=================================");
 }
 
@@ -2053,54 +2464,32 @@ bool animation_load_sad_from_sd_card(void)
 // GIF LOADING FUNCTIONS
 // ============================================================================
 
-/**
- * Extract a GIF file from test.bin by name
- * @param gif_name Name of the GIF file (e.g., "normal.gif")
- * @param data Output pointer to GIF data (caller must free)
- * @param size Output size of GIF data
- * @return true on success, false on failure
- */
-bool animation_extract_gif_from_test_bin(const char* gif_name, uint8_t** data, size_t* size)
+static bool animation_open_gif_bundle(void)
 {
-    // Static flag to track if we've already failed to read the header
-    static bool header_read_failed = false;
-    
-    if (!gif_name || !data || !size) {
-        ESP_LOGE("animation", "Invalid parameters for GIF extraction");
-        return false;
+    if (g_gif_bundle.IsOpen()) {
+        return true;
     }
-    
     // If we've already failed to read the header, skip immediately
-    if (header_read_failed) {
+    if (g_gif_bundle_header_failed) {
         return false;
     }
-    
     if (!SdCard::IsMounted()) {
         ESP_LOGE("animation", "SD card not mounted");
         return false;
     }
-    
+
     char test_bin_path[512];
-    // Find test.bin file
     if (!find_sdcard_test_bin_path(test_bin_path, sizeof(test_bin_path))) {
         ESP_LOGE("animation", "test.bin not found on SD card");
         return false;
     }
 
-    FILE* f = fopen(test_bin_path, "rb");
-    if (!f) {
-        ESP_LOGE("animation", "Failed to open test.bin: %s", test_bin_path);
-        return false;
+    GifBundle::OpenResult result;
+    {
+        std::lock_guard<std::mutex> lock(g_animation_mutex);
+        result = g_gif_bundle.Open(test_bin_path);
     }
-    
-    // Read header
-    uint32_t file_count, checksum, data_length;
-    if (fread(&file_count, sizeof(uint32_t), 1, f) != 1 ||
-        fread(&checksum, sizeof(uint32_t), 1, f) != 1 ||
-        fread(&data_length, sizeof(uint32_t), 1, f) != 1) {
-        ESP_LOGE("animation", "Failed to read test.bin header");
-        fclose(f);
-        
+    if (result == GifBundle::OpenResult::kBadHeader) {
         // First failure: delete test.bin and set flag to skip future attempts
         ESP_LOGE("animation", "Deleting corrupted test.bin file and skipping animation loading");
         if (unlink(test_bin_path) == 0) {
@@ -2108,91 +2497,76 @@ bool animation_extract_gif_from_test_bin(const char* gif_name, uint8_t** data, s
         } else {
             ESP_LOGW("animation", "Failed to delete test.bin: %s (error: %s)", test_bin_path, strerror(errno));
         }
-        
-        header_read_failed = true;
-        return false;
+        g_gif_bundle_header_failed = true;
     }
-    
-    ESP_LOGI("animation", "test.bin header: %d files, checksum=0x%08X, length=%d", 
-             file_count, checksum, data_length);
-    
-    // Read file table and find the GIF
-    bool found_gif = false;
-    uint32_t gif_offset = 0;
-    uint32_t gif_size = 0;
-    
-    for (uint32_t i = 0; i < file_count; i++) {
-        char name[33] = {0};
-        uint32_t file_size, file_offset;
-        uint16_t width, height;
-        
-        if (fread(name, 32, 1, f) != 1 ||
-            fread(&file_size, sizeof(uint32_t), 1, f) != 1 ||
-            fread(&file_offset, sizeof(uint32_t), 1, f) != 1 ||
-            fread(&width, sizeof(uint16_t), 1, f) != 1 ||
-            fread(&height, sizeof(uint16_t), 1, f) != 1) {
-            ESP_LOGE("animation", "Failed to read file table entry %d", i);
-            fclose(f);
-            return false;
-        }
-        
-        // Remove null padding from name
-        size_t name_len = strnlen(name, 32);
-        name[name_len] = '\0';
-        
-        ESP_LOGD("animation", "File %d: %s, size=%d, offset=%d", i, name, file_size, file_offset);
-        
-        if (strcmp(name, gif_name) == 0) {
-            found_gif = true;
-            gif_offset = file_offset;
-            gif_size = file_size;
-            ESP_LOGI("animation", "Found GIF: %s at offset %d, size %d", gif_name, gif_offset, gif_size);
-            break;
-        }
-    }
-    
-    if (!found_gif) {
-        ESP_LOGE("animation", "GIF not found in test.bin: %s", gif_name);
-        fclose(f);
+    return result == GifBundle::OpenResult::kOk;
+}
+
+/**
+ * Extract a GIF file from test.bin by name
+ * @param gif_name Name of the GIF file (e.g., "normal.gif")
+ * @param data Output pointer to GIF data (caller must free)
+ * @param size Output size of GIF data
+ * @return true on success, false on failure
+ */
+bool animation_extract_gif_from_test_bin(const char* gif_name, uint8_t** data, size_t* size)
+{
+    if (!gif_name || !data || !size) {
+        ESP_LOGE("animation", "Invalid parameters for GIF extraction");
         return false;
     }
-    
-    // Calculate data section start (after header and file table)
-    uint32_t table_size = file_count * 44; // 44 bytes per entry
-    uint32_t data_start = 12 + table_size; // 12 byte header + table
-    
-    // Seek to GIF data (skip magic bytes 0x5A5A)
-    if (fseek(f, data_start + gif_offset + 2, SEEK_SET) != 0) {
-        ESP_LOGE("animation", "Failed to seek to GIF data");
-        fclose(f);
+
+    if (!animation_open_gif_bundle()) {
         return false;
     }
-    
-    // Allocate memory for GIF data
-    *data = (uint8_t*)malloc(gif_size);
-    if (!*data) {
-        ESP_LOGE("animation", "Failed to allocate %d bytes for GIF data", gif_size);
-        fclose(f);
+
+    if (g_gif_bundle.Find(gif_name) == nullptr) {
+        ESP_LOGE("animation", "GIF not found in test.bin: %s", gif_name);
         return false;
     }
-    
-    // Read GIF data
-    if (fread(*data, 1, gif_size, f) != gif_size) {
-        ESP_LOGE("animation", "Failed to read GIF data");
-        free(*data);
-        *data = NULL;
-        fclose(f);
-        header_read_failed = true;
+
+    *data = g_gif_bundle.Load(gif_name, size);
+    if (*data == NULL) {
+        ESP_LOGE("animation", "Failed to read GIF data: %s", gif_name);
         return false;
     }
-    
-    *size = gif_size;
-    fclose(f);
-    
-    ESP_LOGI("animation", "Successfully extracted GIF: %s (%d bytes)", gif_name, gif_size);
+
+    ESP_LOGI("animation", "Successfully extracted GIF: %s (%u bytes)", gif_name, (unsigned)*size);
     return true;
 }
 
+/**
+ * Hand already-extracted GIF buffers to an Animation_t without copying them.
+ * Ownership of loop_data/start_data moves to anim (released by
+ * animation_cleanup_sd_card_animation()).
+ */
+static void animation_adopt_gif_animation(Animation_t* anim, const char* gif_loop_name,
+                                          uint8_t* loop_data, size_t loop_size,
+                                          uint8_t* start_data, size_t start_size)
+{
+    animation_cleanup_sd_card_animation(anim);
+
+    anim->gif_loop_data = loop_data;
+    anim->gif_loop_data_size = loop_size;
+    anim->gif_data = loop_data;
+    anim->gif_data_size = loop_size;
+    anim->gif_start_data = start_data;
+    anim->gif_start_data_size = start_data ? start_size : 0;
+    anim->has_start_gif = start_data != NULL && start_size > 0;
+    anim->use_gif = true;
+    anim->use_spiffs = true; // Mark as loaded from storage
+
+    anim->gif_path = (char*)malloc(strlen(gif_loop_name) + 1);
+    if (anim->gif_path) {
+        strcpy(anim->gif_path, gif_loop_name);
+    }
+
+    anim->len = 1; // Single GIF animation
+    anim->imges = NULL;
+    anim->animations = NULL;
+    anim->spiffs_imgs = NULL;
+}
+
 /**
  * Load a GIF animation into an Animation_t structure
  * @param anim Animation structure to populate
@@ -2330,6 +2704,13 @@ bool animation_load_gifs_from_test_bin(void)
     }
     
     ESP_LOGI("animation", "Loading GIF animations from test.bin (20 fixed GIFs)...");
+    int64_t load_start_us = esp_timer_get_time();
+
+    // Parse the directory once; every extract below is a single positioned read.
+    if (!animation_open_gif_bundle()) {
+        ESP_LOGE("animation", "Failed to index test.bin, skipping all GIF loading");
+        return false;
+    }
 
     typedef struct {
         const char* logical_name;      // For logging only
@@ -2363,6 +2744,46 @@ bool animation_load_gifs_from_test_bin(void)
     const size_t gif_anim_count = sizeof(gif_anims) / sizeof(gif_anims[0]);
     int loaded_count = 0;
 
+#ifdef CONFIG_ANIMATION_GIF_LAZY_LOAD
+    // Only record where each GIF lives; plat_animation_task pulls the bytes
+    // through g_gif_cache on first use. The bundle stays open for that.
+    g_gif_cache.SetInUseCallback([](const uint8_t* data) {
+        return Board::GetInstance().GetDisplay()->GetEmotionGifData() == data;
+    });
+    for (size_t i = 0; i < gif_anim_count; ++i) {
+        const GifAnimDef& def = gif_anims[i];
+        const GifBundle::Entry* loop_entry = g_gif_bundle.Find(def.loop_gif);
+        if (loop_entry == nullptr || loop_entry->size == 0) {
+            ESP_LOGW("animation", "Loop GIF not found in test.bin for %s: %s",
+                     def.logical_name, def.loop_gif);
+            continue;
+        }
+        const GifBundle::Entry* start_entry = def.start_gif ? g_gif_bundle.Find(def.start_gif) : nullptr;
+
+        Animation_t* anim = def.target_anim;
+        animation_cleanup_sd_card_animation(anim);
+        anim->gif_lazy = true;
+        anim->gif_loop_offset = loop_entry->offset;
+        anim->gif_loop_data_size = loop_entry->size;
+        anim->gif_data_size = loop_entry->size;
+        if (start_entry != nullptr && start_entry->size > 0) {
+            anim->gif_start_offset = start_entry->offset;
+            anim->gif_start_data_size = start_entry->size;
+            anim->has_start_gif = true;
+        }
+        anim->use_gif = true;
+        anim->use_spiffs = true; // Mark as loaded from storage
+        anim->gif_path = (char*)malloc(strlen(def.loop_gif) + 1);
+        if (anim->gif_path) {
+            strcpy(anim->gif_path, def.loop_gif);
+        }
+        anim->len = 1;
+        loaded_count++;
+    }
+    ESP_LOGI("animation", "Indexed %d lazy GIF animation(s) in %lld ms (cache budget %u KB)",
+             loaded_count, (long long)((esp_timer_get_time() - load_start_us) / 1000),
+             (unsigned)(GIF_CACHE_BUDGET_BYTES / 1024));
+#else
     for (size_t i = 0; i < gif_anim_count; ++i) {
         const GifAnimDef& def = gif_anims[i];
 
@@ -2388,42 +2809,26 @@ bool animation_load_gifs_from_test_bin(void)
             }
         }
 
-        bool ok = false;
+        // Buffers were read straight into their final PSRAM location; hand
+        // them over instead of copying again.
+        animation_adopt_gif_animation(def.target_anim, def.loop_gif,
+                                      loop_data, loop_size, start_data, start_size);
+        loaded_count++;
         if (start_data != NULL && start_size > 0) {
-            ok = animation_load_gif_animation_with_start_loop(
-                def.target_anim,
-                def.loop_gif, loop_data, loop_size,
-                def.start_gif, start_data, start_size
-            );
-        } else {
-            ok = animation_load_gif_animation_with_start_loop(
-                def.target_anim,
-                def.loop_gif, loop_data, loop_size,
-                NULL, NULL, 0
-            );
-        }
-
-        if (ok) {
-            loaded_count++;
-            if (start_data != NULL && start_size > 0) {
-                ESP_LOGI("animation", "�?Loaded GIF animation %s: %s (start) + %s (loop)",
-                         def.logical_name, def.start_gif, def.loop_gif);
-            } else {
-                ESP_LOGI("animation", "�?Loaded GIF animation %s: %s",
-                         def.logical_name, def.loop_gif);
-            }
+            ESP_LOGI("animation", "✅ Loaded GIF animation %s: %s (start) + %s (loop)",
+                     def.logical_name, def.start_gif, def.loop_gif);
         } else {
-            ESP_LOGE("animation", "�?Failed to load GIF animation %s", def.logical_name);
-        }
-
-        // Free extracted data (copied into Animation_t)
-        if (loop_data) {
-            free(loop_data);
-        }
-        if (start_data) {
-            free(start_data);
+            ESP_LOGI("animation", "✅ Loaded GIF animation %s: %s",
+                     def.logical_name, def.loop_gif);
         }
     }
+
+    // Every GIF is resident now; release the descriptor so the updater can
+    // replace test.bin.
+    animation_release_bundle();
+    ESP_LOGI("animation", "GIF bundle load took %lld ms",
+             (long long)((esp_timer_get_time() - load_start_us) / 1000));
+#endif
     
     // Check if test.bin was deleted (header read failure)
     if (loaded_count == 0) {
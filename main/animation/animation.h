@@ -3,6 +3,8 @@
 #include <cstdint>
 #include <stdbool.h>
 
+class DecodedGif;
+
 typedef struct _Animation_t{
     const lv_image_dsc_t **imges;
     int *animations;
@@ -20,6 +22,16 @@ typedef struct _Animation_t{
     size_t gif_start_data_size;    // Size of start GIF data
     uint8_t* gif_loop_data;         // Loop GIF data in memory (if loaded into RAM)
     size_t gif_loop_data_size;      // Size of loop GIF data
+    // Lazy residency: GIF bytes stay in test.bin and are fetched through the
+    // GIF cache on first use. Sizes above remain valid; data pointers stay NULL.
+    bool gif_lazy;                  // True if GIF data is served from the GIF cache
+    uint32_t gif_loop_offset;       // Bundle offset of the loop GIF payload
+    uint32_t gif_start_offset;      // Bundle offset of the start GIF payload
+    // Pre-decoded RGB565 frames for the loop GIF (hot animations only), attached
+    // by the pre-decode pass on the background task under the animation mutex
+    bool use_decoded;               // True if the loop is blitted from decoded frames
+    bool decode_attempted;          // Decode tried once; don't retry on failure
+    DecodedGif* decoded;            // Owned; released by animation_cleanup_sd_card_animation()
 }Animation_t;
 
 
@@ -43,6 +55,8 @@ typedef enum _AnimationType_e {
 }AnimationType_e;
 
 void animation_set_now_animation(int animation);
+// Re-resolve the current animation after Wi-Fi, battery or device state changed
+void animation_refresh(void);
 void animation_check_volume_and_lock(int volume);  // Check volume and lock/unlock silence animation
 void animation_init(void);
 // Used by startup to prevent animation_init() heavy test.bin loading from
@@ -66,6 +80,9 @@ Animation_t* animation_get_smirk_animation(void);
 Animation_t* animation_get_battery_animation(void);
 Animation_t* animation_get_wifi_animation(void);
 void animation_load_sd_card_animations(void);
+// Drop cached GIFs and close test.bin so it can be replaced; GIFs come back
+// with the next animation_load_sd_card_animations()
+void animation_release_bundle(void);
 void animation_show_current_sources(void);
 
 // SD Card animation loading functions
@@ -6,6 +6,7 @@
 #include "settings.h"
 #include "config.h"
 #include "display/lcd_display.h"
+#include "resumable_download.h"
 #include <esp_log.h>
 #include <esp_timer.h>
 #include <esp_system.h>
@@ -1399,7 +1400,6 @@ bool AnimationUpdater::DownloadStartupWavFile(const std::string& url) {
     constexpr const char* kLocalWavMetadataPath = "/sdcard/startup.wav.meta";
     constexpr const char* kLocalWavFilename = "startup.wav";
     const char* local_path = kLocalWavPath;
-    const char* filename = kLocalWavFilename;
 
     size_t remote_size = 0;
     std::string remote_etag;
@@ -1465,162 +1465,39 @@ bool AnimationUpdater::DownloadStartupWavFile(const std::string& url) {
         }
     }
 
-    auto& board = Board::GetInstance();
-    auto http = std::unique_ptr<Http>(board.CreateHttp());
-    if (!http) {
-        ESP_LOGE(TAG, "Failed to create HTTP client for startup.wav download");
-        return false;
-    }
-
-    http->SetHeader("User-Agent", "Xiaozhi-Startup-Audio-Updater/1.0");
-    http->SetHeader("Accept", "application/octet-stream");
-    http->SetHeader("Accept-Encoding", "identity");
-    http->SetTimeout(60000); // 60 seconds timeout
-
-    ESP_LOGI(TAG, "Downloading startup.wav from: %s", url.c_str());
-    if (!http->Open("GET", url)) {
-        ESP_LOGE(TAG, "Failed to open startup.wav download connection");
-        return false;
-    }
-
-    int status_code = http->GetStatusCode();
-    ESP_LOGI(TAG, "HTTP Status Code (startup.wav): %d", status_code);
-    if (status_code != 200) {
-        ESP_LOGE(TAG, "startup.wav download failed with status code: %d", status_code);
-        http->Close();
-        return false;
-    }
-
-    size_t content_length = http->GetBodyLength();
-    ESP_LOGI(TAG, "startup.wav Content-Length: %u", (unsigned int)content_length);
-    bool unknown_length = (content_length == 0);
-    if (unknown_length) {
-        ESP_LOGW(TAG, "startup.wav Content-Length is 0; will read until connection closes");
-    }
-
-    if (access(local_path, F_OK) == 0) {
-        ESP_LOGI(TAG, "Removing existing %s...", filename);
-        if (unlink(local_path) != 0) {
-            ESP_LOGW(TAG, "Failed to remove existing startup.wav file");
+    ResumableDownload::Options options;
+    options.user_agent = "Xiaozhi-Startup-Audio-Updater/1.0";
+    options.buffer_size = 4096;
+    options.total_timeout_ms = 120000;
+    // A different size means the file changed after the metadata request
+    options.expected_size = remote_size;
+    options.on_progress = [](size_t received, size_t total) {
+        if (total > 0) {
+            ShowAnimationDownloadProgress("Downloading startup.wav", ComputeDownloadPercent(received, total, false), "");
         }
-    }
-
-    FILE* file = fopen(local_path, "wb");
-    if (!file) {
-        ESP_LOGE(TAG, "Failed to open file for writing: %s", local_path);
-        ESP_LOGE(TAG, "Error: %s", strerror(errno));
-        http->Close();
-        return false;
-    }
+    };
 
-    std::unique_ptr<char[]> buffer(new char[4096]);
-    const size_t buf_size = 4096;
-    size_t total_read = 0;
-    bool download_success = true;
-    uint32_t timeout_start = esp_timer_get_time() / 1000;
-    uint32_t timeout_duration = 120000; // 2 minutes total timeout
-    uint32_t last_read_time = timeout_start;
-    uint32_t read_timeout = 30000;      // 30s stall timeout
-
-    while (download_success) {
-        uint32_t current_time = esp_timer_get_time() / 1000;
-        if (current_time - timeout_start > timeout_duration) {
-            ESP_LOGE(TAG, "startup.wav download timeout after %u ms (read %u bytes)",
-                     timeout_duration, (unsigned int)total_read);
-            download_success = false;
-            break;
-        }
-
-        if (current_time - last_read_time > read_timeout) {
-            ESP_LOGE(TAG, "startup.wav download stalled for %u ms (read %u bytes so far)",
-                     current_time - last_read_time, (unsigned int)total_read);
-            download_success = false;
-            break;
-        }
-
-        int bytes_read = http->Read(buffer.get(), buf_size);
-        if (bytes_read > 0) {
-            size_t written = fwrite(buffer.get(), 1, bytes_read, file);
-            if (written != (size_t)bytes_read) {
-                ESP_LOGE(TAG, "Failed to write startup.wav data");
-                download_success = false;
-                break;
-            }
-
-            total_read += bytes_read;
-            last_read_time = esp_timer_get_time() / 1000;
-
-            if (!unknown_length) {
-                ShowAnimationDownloadProgress("Downloading startup.wav",
-                                              ComputeDownloadPercent(total_read, content_length, false),
-                                              "");
-            }
-
-            if (total_read == 1024 || total_read % 16384 == 0) {
-                if (unknown_length) {
-                    ESP_LOGI(TAG, "startup.wav progress: %u bytes", (unsigned int)total_read);
-                } else {
-                    ESP_LOGI(TAG, "startup.wav progress: %u / %u bytes",
-                             (unsigned int)total_read, (unsigned int)content_length);
-                }
-            }
-            continue;
-        }
-
-        if (bytes_read == 0) {
-            ESP_LOGI(TAG, "startup.wav download stream completed, read %u bytes total", (unsigned int)total_read);
-            if (!unknown_length && total_read < content_length) {
-                ESP_LOGW(TAG, "startup.wav download ended early: read %u bytes, expected %u",
-                         (unsigned int)total_read, (unsigned int)content_length);
-            }
-            break;
-        }
-
-        ESP_LOGE(TAG, "HTTP Read() returned error for startup.wav: %d", bytes_read);
-        download_success = false;
-    }
-
-    fflush(file);
-    int fd = fileno(file);
-    if (fd >= 0) {
-        fsync(fd);
-    }
-    fclose(file);
-
-    if (!remote_etag.size()) {
-        remote_etag = http->GetResponseHeader("ETag");
-        if (remote_etag.empty()) {
-            remote_etag = http->GetResponseHeader("etag");
-        }
-    }
-    if (!remote_last_modified.size()) {
-        remote_last_modified = http->GetResponseHeader("Last-Modified");
-        if (remote_last_modified.empty()) {
-            remote_last_modified = http->GetResponseHeader("last-modified");
-        }
-    }
-    http->Close();
-
-    if (!download_success) {
-        ESP_LOGE(TAG, "Failed to download startup.wav, removing partial file");
-        unlink(local_path);
-        unlink(kLocalWavMetadataPath);
+    // The current startup.wav stays in place until the new one is complete
+    ResumableDownload download(url, local_path, "wav", options);
+    ESP_LOGI(TAG, "Downloading startup.wav from: %s", url.c_str());
+    if (!download.Download()) {
+        ESP_LOGE(TAG, "Failed to download startup.wav; will resume from %u bytes next time",
+                 (unsigned int)download.size());
         return false;
     }
-
-    if (total_read == 0) {
-        ESP_LOGE(TAG, "Downloaded startup.wav is 0 bytes, removing");
-        unlink(local_path);
-        unlink(kLocalWavMetadataPath);
+    if (!download.Commit()) {
+        // The part file is complete and verified; the next run installs it without downloading again
+        ESP_LOGE(TAG, "Failed to install startup.wav, keeping %s", download.part_path().c_str());
         return false;
     }
+    ShowAnimationDownloadProgress("Downloading startup.wav", 100, "");
 
-    if (!unknown_length && total_read != content_length) {
-        ESP_LOGW(TAG, "startup.wav size mismatch after download: expected %u bytes, got %u bytes",
-                 (unsigned int)content_length, (unsigned int)total_read);
+    size_t total_read = download.size();
+    if (remote_etag.empty()) {
+        remote_etag = download.etag();
     }
-    if (!unknown_length) {
-        ShowAnimationDownloadProgress("Downloading startup.wav", 100, "");
+    if (remote_last_modified.empty()) {
+        remote_last_modified = download.last_modified();
     }
     if (!SaveStartupWavMetadata(total_read, remote_etag, remote_last_modified)) {
         ESP_LOGW(TAG, "Failed to save startup.wav metadata cache to %s", kLocalWavMetadataPath);
@@ -1646,7 +1523,6 @@ bool AnimationUpdater::DownloadStartupGifFile(const std::string& url) {
     constexpr const char* kLocalGifMetadataPath = "/sdcard/startup.gif.meta";
     constexpr const char* kLocalGifFilename = "startup.gif";
     const char* local_path = kLocalGifPath;
-    const char* filename = kLocalGifFilename;
 
     size_t remote_size = 0;
     std::string remote_etag;
@@ -1712,162 +1588,39 @@ bool AnimationUpdater::DownloadStartupGifFile(const std::string& url) {
         }
     }
 
-    auto& board = Board::GetInstance();
-    auto http = std::unique_ptr<Http>(board.CreateHttp());
-    if (!http) {
-        ESP_LOGE(TAG, "Failed to create HTTP client for startup.gif download");
-        return false;
-    }
-
-    http->SetHeader("User-Agent", "Xiaozhi-Startup-Gif-Updater/1.0");
-    http->SetHeader("Accept", "application/octet-stream");
-    http->SetHeader("Accept-Encoding", "identity");
-    http->SetTimeout(60000); // 60 seconds timeout
-
-    ESP_LOGI(TAG, "Downloading startup.gif from: %s", url.c_str());
-    if (!http->Open("GET", url)) {
-        ESP_LOGE(TAG, "Failed to open startup.gif download connection");
-        return false;
-    }
-
-    int status_code = http->GetStatusCode();
-    ESP_LOGI(TAG, "HTTP Status Code (startup.gif): %d", status_code);
-    if (status_code != 200) {
-        ESP_LOGE(TAG, "startup.gif download failed with status code: %d", status_code);
-        http->Close();
-        return false;
-    }
-
-    size_t content_length = http->GetBodyLength();
-    ESP_LOGI(TAG, "startup.gif Content-Length: %u", (unsigned int)content_length);
-    bool unknown_length = (content_length == 0);
-    if (unknown_length) {
-        ESP_LOGW(TAG, "startup.gif Content-Length is 0; will read until connection closes");
-    }
-
-    if (access(local_path, F_OK) == 0) {
-        ESP_LOGI(TAG, "Removing existing %s...", filename);
-        if (unlink(local_path) != 0) {
-            ESP_LOGW(TAG, "Failed to remove existing startup.gif file");
-        }
-    }
-
-    FILE* file = fopen(local_path, "wb");
-    if (!file) {
-        ESP_LOGE(TAG, "Failed to open file for writing: %s", local_path);
-        ESP_LOGE(TAG, "Error: %s", strerror(errno));
-        http->Close();
-        return false;
-    }
-
-    std::unique_ptr<char[]> buffer(new char[4096]);
-    const size_t buf_size = 4096;
-    size_t total_read = 0;
-    bool download_success = true;
-    uint32_t timeout_start = esp_timer_get_time() / 1000;
-    uint32_t timeout_duration = 120000; // 2 minutes total timeout
-    uint32_t last_read_time = timeout_start;
-    uint32_t read_timeout = 30000;      // 30s stall timeout
-
-    while (download_success) {
-        uint32_t current_time = esp_timer_get_time() / 1000;
-        if (current_time - timeout_start > timeout_duration) {
-            ESP_LOGE(TAG, "startup.gif download timeout after %u ms (read %u bytes)",
-                     timeout_duration, (unsigned int)total_read);
-            download_success = false;
-            break;
-        }
-
-        if (current_time - last_read_time > read_timeout) {
-            ESP_LOGE(TAG, "startup.gif download stalled for %u ms (read %u bytes so far)",
-                     current_time - last_read_time, (unsigned int)total_read);
-            download_success = false;
-            break;
-        }
-
-        int bytes_read = http->Read(buffer.get(), buf_size);
-        if (bytes_read > 0) {
-            size_t written = fwrite(buffer.get(), 1, bytes_read, file);
-            if (written != (size_t)bytes_read) {
-                ESP_LOGE(TAG, "Failed to write startup.gif data");
-                download_success = false;
-                break;
-            }
-
-            total_read += bytes_read;
-            last_read_time = esp_timer_get_time() / 1000;
-
-            if (!unknown_length) {
-                ShowAnimationDownloadProgress("Downloading startup.gif",
-                                              ComputeDownloadPercent(total_read, content_length, false),
-                                              "");
-            }
-
-            if (total_read == 1024 || total_read % 16384 == 0) {
-                if (unknown_length) {
-                    ESP_LOGI(TAG, "startup.gif progress: %u bytes", (unsigned int)total_read);
-                } else {
-                    ESP_LOGI(TAG, "startup.gif progress: %u / %u bytes",
-                             (unsigned int)total_read, (unsigned int)content_length);
-                }
-            }
-            continue;
-        }
-
-        if (bytes_read == 0) {
-            ESP_LOGI(TAG, "startup.gif download stream completed, read %u bytes total", (unsigned int)total_read);
-            if (!unknown_length && total_read < content_length) {
-                ESP_LOGW(TAG, "startup.gif download ended early: read %u bytes, expected %u",
-                         (unsigned int)total_read, (unsigned int)content_length);
-            }
-            break;
-        }
-
-        ESP_LOGE(TAG, "HTTP Read() returned error for startup.gif: %d", bytes_read);
-        download_success = false;
-    }
-
-    fflush(file);
-    int fd = fileno(file);
-    if (fd >= 0) {
-        fsync(fd);
-    }
-    fclose(file);
-
-    if (!remote_etag.size()) {
-        remote_etag = http->GetResponseHeader("ETag");
-        if (remote_etag.empty()) {
-            remote_etag = http->GetResponseHeader("etag");
+    ResumableDownload::Options options;
+    options.user_agent = "Xiaozhi-Startup-Gif-Updater/1.0";
+    options.buffer_size = 4096;
+    options.total_timeout_ms = 120000;
+    // A different size means the file changed after the metadata request
+    options.expected_size = remote_size;
+    options.on_progress = [](size_t received, size_t total) {
+        if (total > 0) {
+            ShowAnimationDownloadProgress("Downloading startup.gif", ComputeDownloadPercent(received, total, false), "");
         }
-    }
-    if (!remote_last_modified.size()) {
-        remote_last_modified = http->GetResponseHeader("Last-Modified");
-        if (remote_last_modified.empty()) {
-            remote_last_modified = http->GetResponseHeader("last-modified");
-        }
-    }
-    http->Close();
+    };
 
-    if (!download_success) {
-        ESP_LOGE(TAG, "Failed to download startup.gif, removing partial file");
-        unlink(local_path);
-        unlink(kLocalGifMetadataPath);
+    // The current startup.gif stays in place until the new one is complete
+    ResumableDownload download(url, local_path, "gif", options);
+    ESP_LOGI(TAG, "Downloading startup.gif from: %s", url.c_str());
+    if (!download.Download()) {
+        ESP_LOGE(TAG, "Failed to download startup.gif; will resume from %u bytes next time",
+                 (unsigned int)download.size());
         return false;
     }
-
-    if (total_read == 0) {
-        ESP_LOGE(TAG, "Downloaded startup.gif is 0 bytes, removing");
-        unlink(local_path);
-        unlink(kLocalGifMetadataPath);
+    if (!download.Commit()) {
+        // The part file is complete and verified; the next run installs it without downloading again
+        ESP_LOGE(TAG, "Failed to install startup.gif, keeping %s", download.part_path().c_str());
         return false;
     }
+    ShowAnimationDownloadProgress("Downloading startup.gif", 100, "");
 
-    if (!unknown_length && total_read != content_length) {
-        ESP_LOGW(TAG, "startup.gif size mismatch after download: expected %u bytes, got %u bytes",
-                 (unsigned int)content_length, (unsigned int)total_read);
+    size_t total_read = download.size();
+    if (remote_etag.empty()) {
+        remote_etag = download.etag();
     }
-    if (!unknown_length) {
-        ShowAnimationDownloadProgress("Downloading startup.gif", 100, "");
+    if (remote_last_modified.empty()) {
+        remote_last_modified = download.last_modified();
     }
     if (!SaveStartupGifMetadata(total_read, remote_etag, remote_last_modified)) {
         ESP_LOGW(TAG, "Failed to save startup.gif metadata cache to %s", kLocalGifMetadataPath);
@@ -2302,255 +2055,65 @@ bool AnimationUpdater::DownloadMegaAnimationFile(const std::string& url) {
             }
         }
         
-        auto& board = Board::GetInstance();
-        auto http = std::unique_ptr<Http>(board.CreateHttp());
-        
-        if (!http) {
-            ESP_LOGE(TAG, "Failed to create HTTP client for mega file download");
-            return false;
-        }
-        
-        // Set headers for download
-        http->SetHeader("User-Agent", "Xiaozhi-Animation-Updater/1.0");
-        http->SetHeader("Accept", "application/octet-stream");
-        http->SetHeader("Accept-Encoding", "identity"); // Disable compression
-        // Don't request Connection: close - let server decide, or use keep-alive for large files
-        http->SetTimeout(600000); // 10 minute timeout for large file downloads (increased from 5 min)
-        
-        ESP_LOGI(TAG, "Downloading animations_mega.bin from: %s", url.c_str());
-        ESP_LOGI(TAG, "HTTP client created, attempting connection...");
-        
-        if (!http->Open("GET", url)) {
-            ESP_LOGE(TAG, "Failed to open download connection for mega file");
-            return false;
-        }
-        
-        ESP_LOGI(TAG, "HTTP connection opened successfully");
-        
-        int status_code = http->GetStatusCode();
-        ESP_LOGI(TAG, "HTTP Status Code: %d", status_code);
-        
-        if (status_code != 200) {
-            ESP_LOGE(TAG, "Download failed with status code: %d", status_code);
-            return false;
-        }
-        
-        size_t content_length = http->GetBodyLength();
-        ESP_LOGI(TAG, "Content-Length: %u", (unsigned int)content_length);
-        
-        // Skip download if Content-Length is explicitly 0 (invalid file)
-        if (content_length == 0) {
-            ESP_LOGW(TAG, "Remote Content-Length is 0 - invalid file, skipping download");
-            http->Close();
-            return false;
-        }
-        
-        // Handle case where server doesn't provide Content-Length
-        bool unknown_length = false;
-        if (content_length < 1000000) {
-            // Warn if Content-Length seems too small (less than 1MB for a 3.87MB file)
-            ESP_LOGW(TAG, "⚠️  Server reported Content-Length (%u bytes) seems too small", 
-                     (unsigned int)content_length);
-            ESP_LOGW(TAG, "⚠️  Expected ~3.87MB, but will ignore Content-Length and read until connection closes");
-            // Treat as unknown length to avoid stopping early
-            unknown_length = true;
-        }
-        
-        ESP_LOGI(TAG, "Downloading animations_mega.bin (%u bytes reported, streaming to SD card)", 
-                 (unsigned int)content_length);
-        
-        // Stream download directly to file (no RAM buffering)
-        // Use shorter filename to avoid FAT32 long filename issues
-        // Note: filename and full_path already defined above in the file comparison check
-        
-        // Remove existing file if it exists
-        if (access(full_path, F_OK) == 0) {
-            ESP_LOGI(TAG, "Removing existing %s...", filename);
-            if (unlink(full_path) != 0) {
-                ESP_LOGW(TAG, "Failed to remove existing file: %s", full_path);
-            }
-        }
-        
-        // Remove dependency on stat() for mount point checks; VFS semantics can make this unreliable
-        
-        // Open file for writing
-        FILE* file = fopen(full_path, "wb");
-        if (!file) {
-            ESP_LOGE(TAG, "Failed to open file for writing: %s", full_path);
-            ESP_LOGE(TAG, "Error: %s", strerror(errno));
-            ESP_LOGE(TAG, "Please check: 1) SD card is inserted, 2) SD card is formatted as FAT32, 3) SD card is not write-protected");
-            http->Close();
-            return false;
-        }
-        
-        // Use larger buffer (8KB) for better performance with large file downloads
-        std::unique_ptr<char[]> buffer(new char[8192]);
-        const size_t buf_size = 8192;
-        size_t total_read = 0;
-        bool download_success = true;
-        uint32_t timeout_start = esp_timer_get_time() / 1000; // Start time in ms
-        uint32_t timeout_duration = 600000; // 10 minutes timeout (increased for large files)
-        uint32_t last_read_time = timeout_start;
-        uint32_t read_timeout = 60000; // 1 minute timeout between reads (to detect stalled downloads)
-        
-        ESP_LOGI(TAG, "Starting download stream to %s...", full_path);
-        
-        while (download_success) {
-            // Check for overall timeout
-            uint32_t current_time = esp_timer_get_time() / 1000;
-            if (current_time - timeout_start > timeout_duration) {
-                ESP_LOGE(TAG, "Download timeout after %u ms (read %u bytes)", 
-                         timeout_duration, (unsigned int)total_read);
-                download_success = false;
-                break;
-            }
-            
-            // Check for read stall (no data received for too long)
-            if (current_time - last_read_time > read_timeout) {
-                ESP_LOGE(TAG, "Download stalled: no data received for %u ms (read %u bytes so far)", 
-                         current_time - last_read_time, (unsigned int)total_read);
-                download_success = false;
-                break;
-            }
-            
-            int bytes_read = http->Read(buffer.get(), buf_size);
-            uint32_t read_complete_time = esp_timer_get_time() / 1000;
-            
-            // Update last read time if we got data
-            if (bytes_read > 0) {
-                last_read_time = read_complete_time;
-            }
-            if (bytes_read <= 0) {
-                // End of data or connection closed
-                if (bytes_read < 0) {
-                    ESP_LOGE(TAG, "HTTP Read() returned error: %d", bytes_read);
-                    ESP_LOGE(TAG, "Download failed after reading %u bytes", (unsigned int)total_read);
-                    download_success = false;
-                    break;
-                } else {
-                    // bytes_read == 0: connection closed or no more data
-                    ESP_LOGI(TAG, "Download stream completed (connection closed), read %u bytes total", (unsigned int)total_read);
-                    
-                    // If we expected more data, warn about incomplete download
-                    if (!unknown_length && total_read < content_length) {
-                        ESP_LOGW(TAG, "⚠️  Download stopped early: read %u bytes but server reported %u bytes", 
-                                 (unsigned int)total_read, (unsigned int)content_length);
-                        ESP_LOGW(TAG, "⚠️  This may indicate connection was closed prematurely by server");
-                    } else if (total_read < 1000000) {
-                        // Warn if downloaded file is suspiciously small (less than 1MB)
-                        ESP_LOGW(TAG, "⚠️  Downloaded file is suspiciously small (%u bytes) - expected ~3.87MB", 
-                                 (unsigned int)total_read);
-                        ESP_LOGW(TAG, "⚠️  This may indicate an incomplete download or server issue");
-                    }
-                }
-                break;
-            }
-            
-            // Write directly to file
-            size_t written = fwrite(buffer.get(), 1, bytes_read, file);
-            if (written != bytes_read) {
-                ESP_LOGE(TAG, "Failed to write data to file");
-                download_success = false;
-                break;
-            }
-            
-            total_read += bytes_read;
-
-            if (!unknown_length) {
+        ResumableDownload::Options options;
+        options.user_agent = "Xiaozhi-Animation-Updater/1.0";
+        options.http_timeout_ms = 600000;
+        options.stall_timeout_ms = 60000;
+        options.total_timeout_ms = 600000;
+        // The bundle header's checksum is the byte sum of everything after the 12-byte header
+        options.checksum_skip = 12;
+        options.on_progress = [](size_t received, size_t total) {
+            if (total > 0) {
                 ShowAnimationDownloadProgress("Downloading animations",
-                                              ComputeDownloadPercent(total_read, content_length, false),
+                                              ComputeDownloadPercent(received, total, false),
                                               "");
             }
-            
-            // Log progress every 50KB (or at first 1KB to show download started)
-            if (total_read == 1024 || total_read % 51200 == 0) {
-                if (unknown_length) {
-                    ESP_LOGI(TAG, "Download progress: %u bytes downloaded", (unsigned int)total_read);
-                } else {
-                    // Log progress, but don't trust Content-Length - continue reading until connection closes
-                    ESP_LOGI(TAG, "Download progress: %u bytes downloaded (server reported %u bytes)", 
-                             (unsigned int)total_read, (unsigned int)content_length);
-                    // Warn if we've exceeded reported Content-Length (likely incorrect header)
-                    if (total_read > content_length) {
-                        ESP_LOGW(TAG, "⚠️  Downloaded %u bytes exceeds reported Content-Length (%u) - server header may be incorrect, continuing...", 
-                                 (unsigned int)total_read, (unsigned int)content_length);
-                    }
-                }
-            }
-            
-            // Note: Don't stop at Content-Length - some servers report incorrect Content-Length headers
-            // Continue reading until connection closes (bytes_read <= 0)
-        }
+        };
 
-        if (!unknown_length) {
-            ShowAnimationDownloadProgress("Downloading animations", 100, "");
+        // Stream into test.bin.part; the installed test.bin stays usable until the new one is verified
+        ResumableDownload download(url, full_path, "mega", options);
+        ESP_LOGI(TAG, "Downloading animations_mega.bin from: %s", url.c_str());
+        if (!download.Download()) {
+            ESP_LOGE(TAG, "Download failed after %u bytes, partial file kept for resuming",
+                     (unsigned int)download.size());
+            return false;
         }
-        
-        // Flush and sync file to ensure all data is written to disk
-        ESP_LOGI(TAG, "Flushing file buffer for %s...", filename);
-        fflush(file);
-        
-        // Sync file to SD card (important for SD card writes)
-        // ESP-IDF provides fsync through unistd.h
-        ESP_LOGI(TAG, "Syncing file to disk...");
-        int fd = fileno(file);
-        if (fd >= 0) {
-            fsync(fd);
+        ShowAnimationDownloadProgress("Downloading animations", 100, "");
+
+        // Checksums were computed while writing, so only the header needs to be read back
+        const char* part_path = download.part_path().c_str();
+        uint32_t file_count = 0, checksum = 0, combined_length = 0;
+        if (!GetLocalFileHeader(part_path, file_count, checksum, combined_length)) {
+            ESP_LOGE(TAG, "Failed to read header of downloaded file, removing");
+            download.Discard();
+            return false;
         }
-        
-        ESP_LOGI(TAG, "Closing file handle...");
-        fclose(file);
-        
-        ESP_LOGI(TAG, "Closing HTTP connection...");
-        http->Close();
-        
-        if (!download_success) {
-            ESP_LOGE(TAG, "Download failed, removing partial file");
-            unlink(full_path);
+        if (download.size() != (size_t)combined_length + 12 || download.byte_sum() != checksum) {
+            ESP_LOGE(TAG, "Downloaded file is corrupt: %u bytes with checksum 0x%08X, header says %u bytes with checksum 0x%08X",
+                     (unsigned int)download.size(), (unsigned int)download.byte_sum(),
+                     (unsigned int)combined_length + 12, (unsigned int)checksum);
+            download.Discard();
             return false;
         }
-        
-        // Check if downloaded file is 0 bytes (invalid)
-        if (total_read == 0) {
-            ESP_LOGE(TAG, "Downloaded file is 0 bytes - invalid file, removing");
-            unlink(full_path);
+        if (!ValidateGifMegaAnimationFileFromDisk(part_path)) {
+            ESP_LOGE(TAG, "Downloaded file failed validation, removing");
+            download.Discard();
             return false;
         }
-        
-        // Give filesystem time to sync, especially important for SD cards
-        vTaskDelay(pdMS_TO_TICKS(500));
-        
-        // Verify file was written completely by checking size
-        FILE* verify_size = fopen(full_path, "rb");
-        if (verify_size) {
-            fseek(verify_size, 0, SEEK_END);
-            size_t actual_size = ftell(verify_size);
-            fclose(verify_size);
-            
-            if (actual_size != total_read) {
-                ESP_LOGE(TAG, "File size mismatch: expected %u bytes, got %zu bytes", 
-                         (unsigned int)total_read, actual_size);
-                unlink(full_path);
-                return false;
-            }
-            
-            if (actual_size == 0) {
-                ESP_LOGE(TAG, "Downloaded file is 0 bytes - invalid file, removing");
-                unlink(full_path);
-                return false;
-            }
-            
-            ESP_LOGI(TAG, "File size verified: %u bytes", (unsigned int)actual_size);
-        } else {
-            ESP_LOGE(TAG, "Failed to verify file size - cannot open file for verification");
-            unlink(full_path);
+        // The lazy GIF cache reads through an open descriptor on test.bin; FAT has no
+        // file locking, so it must be closed before the file is replaced
+        animation_release_bundle();
+        if (!download.Commit()) {
+            // The old test.bin may already be gone; keep the verified part file so
+            // the next run installs it without downloading again
+            ESP_LOGE(TAG, "Failed to install %s, keeping %s", full_path, part_path);
+            // Bring back whatever is still installed
+            animation_load_sd_card_animations();
             return false;
         }
-        
-        // Additional sync delay for SD card to ensure data is fully written
-        vTaskDelay(pdMS_TO_TICKS(500));
-        
-        ESP_LOGI(TAG, "✅ File written and closed successfully: %s (%u bytes)", filename, (unsigned int)total_read);
+
+        ESP_LOGI(TAG, "✅ File verified and installed: %s (%u bytes, %u files, crc32 0x%08X)", filename,
+                 (unsigned int)download.size(), (unsigned int)file_count, (unsigned int)download.crc32());
         
         // Reload animations from SD card
         ESP_LOGI(TAG, "Reloading animations from SD card...");
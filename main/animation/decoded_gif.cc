@@ -0,0 +1,148 @@
+#include "decoded_gif.h"
+#include "latency_histogram.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <cstdlib>
+#include <cstring>
+
+#if LV_USE_GIF
+#include "src/libs/gif/gifdec.h"
+#endif
+
+#define TAG "DecodedGif"
+
+// GIF delays are in 1/100 s; browsers clamp tiny delays to 100 ms, lv_gif to 10 ms.
+#define MIN_FRAME_DELAY_MS 20
+// Emotion GIFs have a few dozen frames; anything longer is not worth a strip
+#define MAX_SOURCE_FRAMES 256
+
+DecodedGif::~DecodedGif() {
+    for (auto buffer : buffers_) {
+        free(buffer);
+    }
+}
+
+DecodedGif* DecodedGif::Decode(const uint8_t* gif_data, size_t gif_size, size_t max_bytes,
+                               LatencyHistogram* frame_decode_us) {
+#if LV_USE_GIF
+    if (gif_data == nullptr || gif_size == 0) {
+        return nullptr;
+    }
+
+    gd_GIF* gif = gd_open_gif_data(gif_data);
+    if (gif == nullptr) {
+        ESP_LOGE(TAG, "Failed to open GIF (%u bytes)", (unsigned)gif_size);
+        return nullptr;
+    }
+
+    auto decoded = new DecodedGif();
+    decoded->width_ = gif->width;
+    decoded->height_ = gif->height;
+    const size_t pixels = (size_t)gif->width * gif->height;
+    const size_t frame_bytes = pixels * 2;
+
+    int64_t decode_us = 0;
+    uint32_t source_frames = 0;
+    bool ok = true;
+    while (true) {
+        int64_t t0 = esp_timer_get_time();
+        int has_frame = gd_get_frame(gif);
+        if (has_frame <= 0) {
+            ok = has_frame == 0 && source_frames > 0;
+            break;
+        }
+        // gifdec rewinds at the trailer while loop_count is 0 (NETSCAPE "forever").
+        // The extension precedes the first image, so overriding it here makes the
+        // trailer end the pass.
+        gif->loop_count = 1;
+        if (source_frames >= MAX_SOURCE_FRAMES) {
+            ESP_LOGW(TAG, "GIF has more than %d frames, giving up", MAX_SOURCE_FRAMES);
+            ok = false;
+            break;
+        }
+        // Same call sequence lv_gif runs per frame: the canvas accumulates
+        // frames according to their disposal method.
+        gd_render_frame(gif, gif->canvas);
+        int64_t frame_us = esp_timer_get_time() - t0;
+        decode_us += frame_us;
+        if (frame_decode_us != nullptr) {
+            frame_decode_us->Record(frame_us);
+        }
+        source_frames++;
+
+        uint32_t delay_ms = (uint32_t)gif->gce.delay * 10;
+        if (delay_ms < MIN_FRAME_DELAY_MS) {
+            delay_ms = MIN_FRAME_DELAY_MS;
+        }
+
+        uint8_t* rgb565 = (uint8_t*)heap_caps_malloc(frame_bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if (rgb565 == nullptr) {
+            ESP_LOGW(TAG, "Out of PSRAM after %u frames", (unsigned)decoded->buffers_.size());
+            ok = false;
+            break;
+        }
+
+        // Canvas is ARGB8888 (B, G, R, A in memory). Fully transparent pixels
+        // become black, which matches the emotion background.
+        const uint8_t* src = gif->canvas;
+        uint16_t* dst = (uint16_t*)rgb565;
+        for (size_t i = 0; i < pixels; i++, src += 4) {
+            if (src[3] == 0) {
+                dst[i] = 0;
+                continue;
+            }
+            dst[i] = (uint16_t)(((src[2] & 0xF8) << 8) | ((src[1] & 0xFC) << 3) | (src[0] >> 3));
+        }
+
+        if (!decoded->buffers_.empty() && memcmp(decoded->buffers_.back(), rgb565, frame_bytes) == 0) {
+            // Identical to the previous frame: just hold that one longer.
+            free(rgb565);
+            decoded->delays_ms_.back() += delay_ms;
+            continue;
+        }
+
+        if (decoded->strip_bytes_ + frame_bytes > max_bytes) {
+            ESP_LOGW(TAG, "Decoded strip would exceed %u bytes, giving up", (unsigned)max_bytes);
+            free(rgb565);
+            ok = false;
+            break;
+        }
+        decoded->buffers_.push_back(rgb565);
+        decoded->delays_ms_.push_back(delay_ms);
+        decoded->strip_bytes_ += frame_bytes;
+    }
+    gd_close_gif(gif);
+
+    if (!ok) {
+        delete decoded;
+        return nullptr;
+    }
+
+    decoded->frames_.resize(decoded->buffers_.size());
+    for (size_t i = 0; i < decoded->buffers_.size(); i++) {
+        lv_image_dsc_t& dsc = decoded->frames_[i];
+        memset(&dsc, 0, sizeof(dsc));
+        dsc.header.magic = LV_IMAGE_HEADER_MAGIC;
+        dsc.header.cf = LV_COLOR_FORMAT_RGB565;
+        dsc.header.w = decoded->width_;
+        dsc.header.h = decoded->height_;
+        dsc.header.stride = decoded->width_ * 2;
+        dsc.data_size = frame_bytes;
+        dsc.data = decoded->buffers_[i];
+    }
+    decoded->gif_decode_us_per_frame_ = (uint32_t)(decode_us / source_frames);
+
+    ESP_LOGI(TAG, "Decoded %dx%d GIF: %u source frames -> %u unique, %u KB, gifdec %u us/frame",
+             decoded->width_, decoded->height_, (unsigned)source_frames, (unsigned)decoded->frames_.size(),
+             (unsigned)(decoded->strip_bytes_ / 1024), (unsigned)decoded->gif_decode_us_per_frame_);
+    return decoded;
+#else
+    (void)gif_data;
+    (void)gif_size;
+    (void)max_bytes;
+    (void)frame_decode_us;
+    return nullptr;
+#endif
+}
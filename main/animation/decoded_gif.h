@@ -0,0 +1,59 @@
+#ifndef DECODED_GIF_H
+#define DECODED_GIF_H
+
+#include <lvgl.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class LatencyHistogram;
+
+/**
+ * @brief A GIF decoded once into a strip of RGB565 frames in PSRAM
+ *
+ * lv_gif re-runs LZW decoding for every frame on the LVGL task. For the few
+ * animations that are on screen most of the time, decoding once and blitting
+ * the frames with lv_image is much cheaper. Consecutive identical frames are
+ * folded into one frame with the summed delay to keep the strip compact.
+ */
+class DecodedGif {
+public:
+    ~DecodedGif();
+
+    DecodedGif(const DecodedGif&) = delete;
+    DecodedGif& operator=(const DecodedGif&) = delete;
+
+    /**
+     * @brief Decode a GIF held in memory
+     * @param max_bytes Upper bound for the frame strip; decoding is abandoned
+     *                  (returns nullptr) rather than exceeding it
+     * @param frame_decode_us If set, records the gifdec time of every source frame
+     */
+    static DecodedGif* Decode(const uint8_t* gif_data, size_t gif_size, size_t max_bytes,
+                              LatencyHistogram* frame_decode_us = nullptr);
+
+    size_t frame_count() const { return frames_.size(); }
+    const lv_image_dsc_t* frame(size_t index) const { return &frames_[index]; }
+    uint32_t delay_ms(size_t index) const { return delays_ms_[index]; }
+    size_t strip_bytes() const { return strip_bytes_; }
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    // Average gifdec decode+render time per source frame, i.e. what lv_gif
+    // spends on the LVGL task for every frame of this animation.
+    uint32_t gif_decode_us_per_frame() const { return gif_decode_us_per_frame_; }
+
+private:
+    DecodedGif() = default;
+
+    std::vector<uint8_t*> buffers_;     // One PSRAM buffer per unique frame
+    size_t strip_bytes_ = 0;
+    int width_ = 0;
+    int height_ = 0;
+    std::vector<lv_image_dsc_t> frames_;
+    std::vector<uint32_t> delays_ms_;
+    uint32_t gif_decode_us_per_frame_ = 0;
+};
+
+#endif // DECODED_GIF_H
@@ -0,0 +1,161 @@
+#include "gif_bundle.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define TAG "GifBundle"
+
+namespace {
+
+uint32_t ReadLe32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+uint16_t ReadLe16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+// pread() may return short counts on some VFS drivers; loop until done.
+bool PreadFully(int fd, uint8_t* dest, size_t size, off_t offset) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t n = pread(fd, dest + done, size - done, offset + (off_t)done);
+        if (n <= 0) {
+            return false;
+        }
+        done += (size_t)n;
+    }
+    return true;
+}
+
+} // namespace
+
+GifBundle::~GifBundle() {
+    Close();
+}
+
+void GifBundle::Close() {
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    index_.clear();
+    path_.clear();
+}
+
+GifBundle::OpenResult GifBundle::Open(const char* path) {
+    Close();
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        ESP_LOGE(TAG, "Failed to open bundle: %s", path);
+        return OpenResult::kNotFound;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return OpenResult::kNotFound;
+    }
+
+    uint8_t header[kHeaderSize];
+    if (!PreadFully(fd, header, sizeof(header), 0)) {
+        ESP_LOGE(TAG, "Failed to read bundle header");
+        close(fd);
+        return OpenResult::kBadHeader;
+    }
+    uint32_t file_count = ReadLe32(header);
+    uint32_t checksum = ReadLe32(header + 4);
+    uint32_t data_length = ReadLe32(header + 8);
+
+    uint64_t table_size = (uint64_t)file_count * kTableEntrySize;
+    if (kHeaderSize + table_size > (uint64_t)st.st_size) {
+        ESP_LOGE(TAG, "File table truncated (%u entries, file %ld bytes)", (unsigned)file_count, (long)st.st_size);
+        close(fd);
+        return OpenResult::kBadTable;
+    }
+
+    // Read the whole table with one read instead of one fread per field.
+    std::vector<uint8_t> table(table_size);
+    if (!PreadFully(fd, table.data(), table.size(), kHeaderSize)) {
+        ESP_LOGE(TAG, "Failed to read file table");
+        close(fd);
+        return OpenResult::kBadTable;
+    }
+
+    const uint64_t data_start = kHeaderSize + table_size;
+    index_.reserve(file_count);
+    for (uint32_t i = 0; i < file_count; i++) {
+        const uint8_t* e = table.data() + (size_t)i * kTableEntrySize;
+        std::string name((const char*)e, strnlen((const char*)e, kNameSize));
+        Entry entry;
+        entry.size = ReadLe32(e + kNameSize);
+        uint64_t offset = data_start + ReadLe32(e + kNameSize + 4) + kDataMagicSize;
+        entry.width = ReadLe16(e + kNameSize + 8);
+        entry.height = ReadLe16(e + kNameSize + 10);
+
+        if (offset + entry.size > (uint64_t)st.st_size) {
+            ESP_LOGE(TAG, "Entry %s out of range (offset=%llu, size=%u, file=%ld)", name.c_str(),
+                     (unsigned long long)offset, (unsigned)entry.size, (long)st.st_size);
+            index_.clear();
+            close(fd);
+            return OpenResult::kBadTable;
+        }
+        entry.offset = (uint32_t)offset;
+        index_[std::move(name)] = entry;
+    }
+
+    fd_ = fd;
+    path_ = path;
+    ESP_LOGI(TAG, "Indexed %s: %u files, checksum=0x%08X, length=%u", path, (unsigned)file_count,
+             (unsigned)checksum, (unsigned)data_length);
+    return OpenResult::kOk;
+}
+
+const GifBundle::Entry* GifBundle::Find(const char* name) const {
+    auto it = index_.find(name);
+    if (it == index_.end()) {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+bool GifBundle::Read(const Entry& entry, uint8_t* dest) const {
+    if (fd_ < 0 || dest == nullptr) {
+        return false;
+    }
+    return PreadFully(fd_, dest, entry.size, (off_t)entry.offset);
+}
+
+uint8_t* GifBundle::Load(const char* name, size_t* size) const {
+    const Entry* entry = Find(name);
+    if (entry == nullptr || entry->size == 0) {
+        return nullptr;
+    }
+
+    uint8_t* data = (uint8_t*)heap_caps_malloc(entry->size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (data == nullptr) {
+        data = (uint8_t*)heap_caps_malloc(entry->size, MALLOC_CAP_8BIT);
+    }
+    if (data == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes for %s", (unsigned)entry->size, name);
+        return nullptr;
+    }
+
+    if (!Read(*entry, data)) {
+        ESP_LOGE(TAG, "Failed to read %s (%u bytes at %u)", name, (unsigned)entry->size, (unsigned)entry->offset);
+        free(data);
+        return nullptr;
+    }
+
+    if (size != nullptr) {
+        *size = entry->size;
+    }
+    return data;
+}
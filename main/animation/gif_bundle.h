@@ -0,0 +1,86 @@
+#ifndef GIF_BUNDLE_H
+#define GIF_BUNDLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief Indexed reader for the GIF bundle (test.bin) on the SD card
+ *
+ * The bundle layout is:
+ *   12-byte header (file_count, checksum, combined_length)
+ *   file_count * 44-byte file table (name[32], size, offset, width, height)
+ *   data section, each entry prefixed with the 2-byte magic 0x5A5A
+ *
+ * Open() parses the header and file table once into a hashed
+ * name -> (offset, size) index and keeps the file descriptor open. Each GIF is
+ * then served with a single positioned read straight into its destination
+ * buffer, so loading N GIFs costs one directory scan instead of N.
+ */
+class GifBundle {
+public:
+    struct Entry {
+        uint32_t offset;    // Absolute file offset of the GIF payload (after magic)
+        uint32_t size;      // Payload size in bytes
+        uint16_t width;
+        uint16_t height;
+    };
+
+    enum class OpenResult {
+        kOk,
+        kNotFound,          // File could not be opened
+        kBadHeader,         // Header could not be read
+        kBadTable,          // File table truncated or entries out of range
+    };
+
+    GifBundle() = default;
+    ~GifBundle();
+
+    GifBundle(const GifBundle&) = delete;
+    GifBundle& operator=(const GifBundle&) = delete;
+
+    /**
+     * @brief Open a bundle and build the name index
+     *
+     * Any previously opened bundle is closed first.
+     */
+    OpenResult Open(const char* path);
+    void Close();
+    bool IsOpen() const { return fd_ >= 0; }
+
+    /**
+     * @brief Look up a GIF by exact name (e.g. "normal.gif")
+     * @return Entry pointer owned by the bundle, or nullptr if absent
+     */
+    const Entry* Find(const char* name) const;
+
+    /**
+     * @brief Read an entry's payload into a caller-provided buffer
+     * @param dest Buffer of at least entry.size bytes
+     */
+    bool Read(const Entry& entry, uint8_t* dest) const;
+
+    /**
+     * @brief Allocate a PSRAM buffer (falls back to internal RAM) and read the GIF into it
+     * @param size Output size of the returned buffer
+     * @return Buffer owned by the caller (release with free()), or nullptr
+     */
+    uint8_t* Load(const char* name, size_t* size) const;
+
+    size_t file_count() const { return index_.size(); }
+    const std::string& path() const { return path_; }
+
+private:
+    static constexpr size_t kHeaderSize = 12;
+    static constexpr size_t kTableEntrySize = 44;
+    static constexpr size_t kNameSize = 32;
+    static constexpr size_t kDataMagicSize = 2;
+
+    int fd_ = -1;
+    std::string path_;
+    std::unordered_map<std::string, Entry> index_;
+};
+
+#endif // GIF_BUNDLE_H
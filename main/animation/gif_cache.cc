@@ -0,0 +1,103 @@
+#include "gif_cache.h"
+
+#include <esp_log.h>
+#include <esp_heap_caps.h>
+#include <cstdlib>
+
+#define TAG "GifCache"
+
+GifCache::GifCache(size_t budget_bytes) : budget_bytes_(budget_bytes) {
+}
+
+GifCache::~GifCache() {
+    for (auto& slot : lru_) {
+        free(slot.data);
+    }
+}
+
+void GifCache::SetInUseCallback(std::function<bool(const uint8_t*)> in_use) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    in_use_ = std::move(in_use);
+}
+
+void GifCache::SetBudget(size_t budget_bytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    budget_bytes_ = budget_bytes;
+}
+
+const uint8_t* GifCache::Acquire(const GifBundle& bundle, const GifBundle::Entry& entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    auto it = index_.find(entry.offset);
+    if (it != index_.end()) {
+        hits_++;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->data;
+    }
+
+    misses_++;
+    EvictFor(entry.size);
+
+    uint8_t* data = (uint8_t*)heap_caps_malloc(entry.size, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (data == nullptr) {
+        data = (uint8_t*)heap_caps_malloc(entry.size, MALLOC_CAP_8BIT);
+    }
+    if (data == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate %u bytes", (unsigned)entry.size);
+        return nullptr;
+    }
+    if (!bundle.Read(entry, data)) {
+        ESP_LOGE(TAG, "Failed to read %u bytes at offset %u", (unsigned)entry.size, (unsigned)entry.offset);
+        free(data);
+        return nullptr;
+    }
+
+    lru_.push_front({entry.offset, entry.size, data, false});
+    index_[entry.offset] = lru_.begin();
+    resident_bytes_ += entry.size;
+    ESP_LOGD(TAG, "Loaded offset %u (%u bytes), resident %u/%u", (unsigned)entry.offset, (unsigned)entry.size,
+             (unsigned)resident_bytes_, (unsigned)budget_bytes_);
+    return data;
+}
+
+void GifCache::EvictFor(size_t incoming_bytes) {
+    // Walk from the cold end; stale slots go first regardless of budget.
+    auto it = lru_.end();
+    while (it != lru_.begin()) {
+        --it;
+        bool over_budget = resident_bytes_ + incoming_bytes > budget_bytes_;
+        if (!over_budget && !it->stale) {
+            continue;
+        }
+        if (in_use_ && in_use_(it->data)) {
+            continue;
+        }
+        if (!it->stale) {
+            index_.erase(it->offset);
+            evictions_++;
+        }
+        resident_bytes_ -= it->size;
+        free(it->data);
+        it = lru_.erase(it);
+    }
+}
+
+void GifCache::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    index_.clear();
+    for (auto it = lru_.begin(); it != lru_.end();) {
+        if (in_use_ && in_use_(it->data)) {
+            it->stale = true;
+            ++it;
+            continue;
+        }
+        resident_bytes_ -= it->size;
+        free(it->data);
+        it = lru_.erase(it);
+    }
+}
+
+GifCache::Stats GifCache::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {hits_, misses_, evictions_, resident_bytes_, budget_bytes_, lru_.size()};
+}
@@ -0,0 +1,80 @@
+#ifndef GIF_CACHE_H
+#define GIF_CACHE_H
+
+#include "gif_bundle.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+/**
+ * @brief LRU cache of GIF payloads read on demand from a GifBundle
+ *
+ * Entries are keyed by their bundle offset. When a new GIF would push the
+ * resident size over the byte budget, least recently used entries are freed,
+ * except the one the display is currently playing (reported by the in-use
+ * callback). The budget is therefore soft: it may be exceeded while the only
+ * evictable candidates are still on screen.
+ */
+class GifCache {
+public:
+    struct Stats {
+        uint32_t hits;
+        uint32_t misses;
+        uint32_t evictions;
+        size_t resident_bytes;
+        size_t budget_bytes;
+        size_t entries;
+    };
+
+    explicit GifCache(size_t budget_bytes);
+    ~GifCache();
+
+    GifCache(const GifCache&) = delete;
+    GifCache& operator=(const GifCache&) = delete;
+
+    // Returns true if the given buffer must not be freed right now.
+    void SetInUseCallback(std::function<bool(const uint8_t*)> in_use);
+    void SetBudget(size_t budget_bytes);
+
+    /**
+     * @brief Get the payload of a bundle entry, reading it on a miss
+     * @return Buffer owned by the cache, valid until evicted; nullptr on read failure
+     */
+    const uint8_t* Acquire(const GifBundle& bundle, const GifBundle::Entry& entry);
+
+    /**
+     * @brief Drop every entry (e.g. before the bundle is replaced)
+     *
+     * Entries still in use are detached from the index and freed by a later
+     * Acquire() once the display has moved on.
+     */
+    void Clear();
+
+    Stats GetStats();
+
+private:
+    struct Slot {
+        uint32_t offset;
+        uint32_t size;
+        uint8_t* data;
+        bool stale;
+    };
+
+    std::mutex mutex_;
+    std::list<Slot> lru_;   // front = most recently used
+    std::unordered_map<uint32_t, std::list<Slot>::iterator> index_;
+    std::function<bool(const uint8_t*)> in_use_;
+    size_t budget_bytes_;
+    size_t resident_bytes_ = 0;
+    uint32_t hits_ = 0;
+    uint32_t misses_ = 0;
+    uint32_t evictions_ = 0;
+
+    void EvictFor(size_t incoming_bytes);
+};
+
+#endif // GIF_CACHE_H
@@ -0,0 +1,382 @@
+#include "resumable_download.h"
+#include "board.h"
+#include "settings.h"
+
+#include <esp_log.h>
+#include <esp_rom_crc.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define TAG "ResumableDownload"
+
+namespace {
+
+std::string GetHeader(Http* http, const char* name, const char* lower_name) {
+    std::string value = http->GetResponseHeader(name);
+    if (value.empty()) {
+        value = http->GetResponseHeader(lower_name);
+    }
+    return value;
+}
+
+}  // namespace
+
+ResumableDownload::ResumableDownload(const std::string& url, const std::string& path, const std::string& key,
+                                     const Options& options)
+    : url_(url), path_(path), part_path_(path + ".part"), key_(key), options_(options) {
+    url_hash_ = esp_rom_crc32_le(0, reinterpret_cast<const uint8_t*>(url_.data()), url_.size());
+}
+
+ResumableDownload::~ResumableDownload() {
+    if (file_ != nullptr) {
+        fclose(file_);
+    }
+}
+
+void ResumableDownload::LoadState() {
+    Settings settings(DOWNLOAD_SETTINGS_NAMESPACE);
+    size_t saved = (uint32_t)settings.GetInt(key_ + "_off", 0);
+    size_t saved_total = (uint32_t)settings.GetInt(key_ + "_tot", 0);
+    if (saved > 0 && ((uint32_t)settings.GetInt(key_ + "_url", 0) != url_hash_ || SizeMismatch(saved_total))) {
+        ESP_LOGW(TAG, "Saved progress of %s belongs to another file, restarting", path_.c_str());
+        Restart();
+        return;
+    }
+    struct stat st;
+    size_t part_size = stat(part_path_.c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+    // Bytes past the checkpoint were written without a matching checksum state
+    if (saved == 0 || saved > part_size ||
+        (saved < part_size && truncate(part_path_.c_str(), saved) != 0)) {
+        Restart();
+        return;
+    }
+
+    uint32_t saved_crc32 = (uint32_t)settings.GetInt(key_ + "_crc", 0);
+    if (!PartMatches(saved, saved_crc32)) {
+        ESP_LOGW(TAG, "%s does not match its checkpoint, restarting", part_path_.c_str());
+        Restart();
+        return;
+    }
+
+    offset_ = saved;
+    resumed_from_ = saved;
+    crc32_ = saved_crc32;
+    byte_sum_ = (uint32_t)settings.GetInt(key_ + "_sum", 0);
+    total_ = saved_total;
+    etag_ = settings.GetString(key_ + "_etag");
+    last_modified_ = settings.GetString(key_ + "_lm");
+}
+
+void ResumableDownload::SaveState() {
+    Settings settings(DOWNLOAD_SETTINGS_NAMESPACE, true);
+    settings.SetInt(key_ + "_off", (int32_t)offset_);
+    settings.SetInt(key_ + "_crc", (int32_t)crc32_);
+    settings.SetInt(key_ + "_sum", (int32_t)byte_sum_);
+    settings.SetInt(key_ + "_tot", (int32_t)total_);
+    settings.SetInt(key_ + "_url", (int32_t)url_hash_);
+    settings.SetString(key_ + "_etag", etag_);
+    settings.SetString(key_ + "_lm", last_modified_);
+    // The checkpoint must be in flash before more bytes are appended
+    SettingsStore::GetInstance().Flush();
+}
+
+void ResumableDownload::ClearState() {
+    Settings settings(DOWNLOAD_SETTINGS_NAMESPACE, true);
+    for (const char* suffix : {"_off", "_crc", "_sum", "_tot", "_url", "_etag", "_lm"}) {
+        settings.EraseKey(key_ + suffix);
+    }
+    // Otherwise a reboot could pair the old checkpoint with a new part file
+    SettingsStore::GetInstance().Flush();
+}
+
+bool ResumableDownload::PartMatches(size_t size, uint32_t crc32) {
+    FILE* file = fopen(part_path_.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    std::unique_ptr<uint8_t[]> buffer(new uint8_t[options_.buffer_size]);
+    uint32_t crc = 0;
+    size_t remaining = size;
+    while (remaining > 0) {
+        size_t n = fread(buffer.get(), 1, std::min(remaining, options_.buffer_size), file);
+        if (n == 0) {
+            break;
+        }
+        crc = esp_rom_crc32_le(crc, buffer.get(), n);
+        remaining -= n;
+    }
+    fclose(file);
+    return remaining == 0 && crc == crc32;
+}
+
+void ResumableDownload::Restart() {
+    if (file_ != nullptr) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+    unlink(part_path_.c_str());
+    ClearState();
+    offset_ = 0;
+    total_ = 0;
+    resumed_from_ = 0;
+    crc32_ = 0;
+    byte_sum_ = 0;
+    etag_.clear();
+    last_modified_.clear();
+}
+
+bool ResumableDownload::Checkpoint() {
+    if (fflush(file_) != 0 || fsync(fileno(file_)) != 0) {
+        ESP_LOGE(TAG, "Failed to sync %s: %s", part_path_.c_str(), strerror(errno));
+        return false;
+    }
+    SaveState();
+    return true;
+}
+
+bool ResumableDownload::SizeMismatch(size_t size) const {
+    return options_.expected_size > 0 && size > 0 && size != options_.expected_size;
+}
+
+bool ResumableDownload::ParseContentRange(const std::string& value, size_t& start, size_t& total) {
+    // bytes <start>-<end>/<total or *>
+    const char* p = value.c_str();
+    if (strncmp(p, "bytes ", 6) != 0) {
+        return false;
+    }
+    char* end;
+    start = strtoul(p + 6, &end, 10);
+    if (*end != '-') {
+        return false;
+    }
+    const char* slash = strchr(end, '/');
+    if (slash == nullptr) {
+        return false;
+    }
+    total = slash[1] == '*' ? 0 : strtoul(slash + 1, nullptr, 10);
+    return true;
+}
+
+ResumableDownload::AttemptResult ResumableDownload::Attempt() {
+    auto http = std::unique_ptr<Http>(Board::GetInstance().CreateHttp());
+    if (!http) {
+        ESP_LOGE(TAG, "Failed to create HTTP client");
+        return kAttemptInterrupted;
+    }
+    http->SetHeader("User-Agent", options_.user_agent);
+    http->SetHeader("Accept", "application/octet-stream");
+    http->SetHeader("Accept-Encoding", "identity");
+    http->SetTimeout(options_.http_timeout_ms);
+
+    bool resuming = offset_ > 0;
+    if (resuming) {
+        http->SetHeader("Range", "bytes=" + std::to_string(offset_) + "-");
+        const std::string& validator = !etag_.empty() ? etag_ : last_modified_;
+        if (!validator.empty()) {
+            http->SetHeader("If-Range", validator);
+        }
+    }
+
+    if (!http->Open("GET", url_)) {
+        ESP_LOGW(TAG, "Failed to connect for %s", path_.c_str());
+        return kAttemptInterrupted;
+    }
+
+    int status_code = http->GetStatusCode();
+    if (status_code == 206 && resuming) {
+        size_t start = 0;
+        size_t total = 0;
+        if (!ParseContentRange(GetHeader(http.get(), "Content-Range", "content-range"), start, total) ||
+            start != offset_) {
+            ESP_LOGW(TAG, "Unexpected Content-Range for %s, restarting", path_.c_str());
+            http->Close();
+            Restart();
+            return kAttemptInterrupted;
+        }
+        if (total > 0) {
+            total_ = total;
+        }
+    } else if (status_code == 200) {
+        if (resuming) {
+            ESP_LOGW(TAG, "%s changed on the server or Range is not supported, restarting", path_.c_str());
+            Restart();
+        }
+        total_ = http->GetBodyLength();
+        etag_ = GetHeader(http.get(), "ETag", "etag");
+        last_modified_ = GetHeader(http.get(), "Last-Modified", "last-modified");
+    } else if (status_code == 416 && resuming && total_ > 0 && offset_ == total_) {
+        // Everything arrived before the last checkpoint's connection ended
+        http->Close();
+        return kAttemptComplete;
+    } else {
+        ESP_LOGE(TAG, "Download of %s failed with status code: %d", path_.c_str(), status_code);
+        http->Close();
+        if (status_code == 416) {
+            Restart();
+            return kAttemptInterrupted;
+        }
+        return status_code >= 500 ? kAttemptInterrupted : kAttemptFailed;
+    }
+
+    if (SizeMismatch(total_)) {
+        ESP_LOGE(TAG, "%s is %u bytes on the server, expected %u", path_.c_str(),
+                 (unsigned)total_, (unsigned)options_.expected_size);
+        http->Close();
+        Restart();
+        return kAttemptFailed;
+    }
+
+    file_ = fopen(part_path_.c_str(), offset_ > 0 ? "ab" : "wb");
+    if (file_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to open %s for writing: %s", part_path_.c_str(), strerror(errno));
+        http->Close();
+        return kAttemptFailed;
+    }
+    if (offset_ == 0) {
+        // Tie the saved progress to this version of the file
+        SaveState();
+    }
+
+    AttemptResult result = ReadBody(http.get());
+    http->Close();
+    if (!Checkpoint() && result == kAttemptComplete) {
+        result = kAttemptFailed;
+    }
+    fclose(file_);
+    file_ = nullptr;
+    return result;
+}
+
+ResumableDownload::AttemptResult ResumableDownload::ReadBody(Http* http) {
+    std::unique_ptr<char[]> buffer(new char[options_.buffer_size]);
+    size_t last_checkpoint = offset_;
+    int64_t last_read_us = esp_timer_get_time();
+
+    while (true) {
+        int64_t now_us = esp_timer_get_time();
+        if (now_us - start_us_ > (int64_t)options_.total_timeout_ms * 1000) {
+            ESP_LOGE(TAG, "%s: timeout after %u ms at %u bytes", path_.c_str(),
+                     (unsigned)options_.total_timeout_ms, (unsigned)offset_);
+            return kAttemptFailed;
+        }
+        if (now_us - last_read_us > (int64_t)options_.stall_timeout_ms * 1000) {
+            ESP_LOGW(TAG, "%s: stalled at %u bytes", path_.c_str(), (unsigned)offset_);
+            return kAttemptInterrupted;
+        }
+
+        int bytes_read = http->Read(buffer.get(), options_.buffer_size);
+        if (bytes_read < 0) {
+            ESP_LOGW(TAG, "%s: read error %d at %u bytes", path_.c_str(), bytes_read, (unsigned)offset_);
+            return kAttemptInterrupted;
+        }
+        if (bytes_read == 0) {
+            if (total_ > 0 && offset_ < total_) {
+                ESP_LOGW(TAG, "%s: connection closed at %u of %u bytes", path_.c_str(),
+                         (unsigned)offset_, (unsigned)total_);
+                return kAttemptInterrupted;
+            }
+            return kAttemptComplete;
+        }
+        last_read_us = esp_timer_get_time();
+
+        if (fwrite(buffer.get(), 1, bytes_read, file_) != (size_t)bytes_read) {
+            ESP_LOGE(TAG, "Failed to write %s: %s", part_path_.c_str(), strerror(errno));
+            return kAttemptFailed;
+        }
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(buffer.get());
+        crc32_ = esp_rom_crc32_le(crc32_, data, bytes_read);
+        size_t skip = 0;
+        if (offset_ < options_.checksum_skip) {
+            skip = std::min(options_.checksum_skip - offset_, (size_t)bytes_read);
+        }
+        for (int i = skip; i < bytes_read; i++) {
+            byte_sum_ += data[i];
+        }
+        offset_ += bytes_read;
+
+        if (offset_ - last_checkpoint >= DOWNLOAD_CHECKPOINT_BYTES) {
+            if (!Checkpoint()) {
+                return kAttemptFailed;
+            }
+            last_checkpoint = offset_;
+        }
+        if (options_.on_progress) {
+            options_.on_progress(offset_, total_);
+        }
+        if (total_ > 0 && offset_ >= total_) {
+            return kAttemptComplete;
+        }
+    }
+}
+
+bool ResumableDownload::Download() {
+    start_us_ = esp_timer_get_time();
+    LoadState();
+    if (resumed_from_ > 0) {
+        ESP_LOGI(TAG, "Resuming %s at %u of %u bytes", path_.c_str(), (unsigned)offset_, (unsigned)total_);
+    }
+
+    int connections = 0;
+    int failures = 0;
+    while (true) {
+        size_t before = offset_;
+        AttemptResult result = Attempt();
+        connections++;
+        if (result == kAttemptComplete) {
+            if (offset_ == 0) {
+                ESP_LOGE(TAG, "%s: server sent an empty file", path_.c_str());
+                return false;
+            }
+            if (SizeMismatch(offset_)) {
+                ESP_LOGE(TAG, "%s: got %u bytes, expected %u", path_.c_str(),
+                         (unsigned)offset_, (unsigned)options_.expected_size);
+                Restart();
+                return false;
+            }
+            ESP_LOGI(TAG, "Downloaded %s: %u bytes (%u resumed) over %d connections in %lld ms, crc32 %08x",
+                     path_.c_str(), (unsigned)offset_, (unsigned)resumed_from_, connections,
+                     (long long)((esp_timer_get_time() - start_us_) / 1000), (unsigned)crc32_);
+            return true;
+        }
+        if (result == kAttemptFailed) {
+            return false;
+        }
+
+        failures = offset_ > before ? 1 : failures + 1;
+        if (failures >= options_.max_attempts) {
+            ESP_LOGE(TAG, "Giving up on %s at %u bytes; the next attempt resumes from there",
+                     path_.c_str(), (unsigned)offset_);
+            return false;
+        }
+        int delay_ms = 1000 << std::min(failures, 4);
+        ESP_LOGI(TAG, "Retrying %s from %u bytes in %d ms", path_.c_str(), (unsigned)offset_, delay_ms);
+        vTaskDelay(pdMS_TO_TICKS(delay_ms));
+    }
+}
+
+bool ResumableDownload::Commit() {
+    // FAT cannot rename over an existing file
+    if (access(path_.c_str(), F_OK) == 0 && unlink(path_.c_str()) != 0) {
+        ESP_LOGE(TAG, "Failed to remove old %s: %s", path_.c_str(), strerror(errno));
+        return false;
+    }
+    if (rename(part_path_.c_str(), path_.c_str()) != 0) {
+        ESP_LOGE(TAG, "Failed to rename %s: %s", part_path_.c_str(), strerror(errno));
+        return false;
+    }
+    ClearState();
+    return true;
+}
+
+void ResumableDownload::Discard() {
+    Restart();
+}
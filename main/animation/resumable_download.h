@@ -0,0 +1,104 @@
+#ifndef RESUMABLE_DOWNLOAD_H
+#define RESUMABLE_DOWNLOAD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+class Http;
+
+// Progress is made durable (fsync + saved offset) every this many bytes
+#define DOWNLOAD_CHECKPOINT_BYTES (64 * 1024)
+#define DOWNLOAD_SETTINGS_NAMESPACE "download"
+
+/**
+ * @brief HTTP download into `<path>.part` that survives dropped connections
+ *
+ * The offset, CRC32 and byte sum of the part file are checkpointed to
+ * Settings after each fsync, so a later attempt (in the same call, or after
+ * a reboot) asks for the rest with a Range request instead of starting over.
+ * The checkpoint records a hash of the URL; progress saved for another URL
+ * under the same key is thrown away.
+ * If-Range carries the ETag or Last-Modified of the first response; a server
+ * answering 200 instead of 206 means the file changed and the download
+ * restarts from zero. Checksums are computed while writing; only when an
+ * earlier call left a part file is its kept prefix read back once and
+ * checked against the checkpoint's CRC32, so a checkpoint that does not
+ * describe the file on disk restarts the download. Checkpoints are flushed
+ * to NVS before the download continues. Commit() then renames the part
+ * file over `path`.
+ */
+class ResumableDownload {
+public:
+    struct Options {
+        const char* user_agent = "Xiaozhi-Animation-Updater/1.0";
+        size_t buffer_size = 8192;
+        int http_timeout_ms = 60000;
+        uint32_t stall_timeout_ms = 30000;      // No data for this long drops the connection
+        uint32_t total_timeout_ms = 600000;
+        int max_attempts = 5;                   // Connections in a row without progress
+        size_t checksum_skip = 0;               // byte_sum() starts at this offset
+        size_t expected_size = 0;               // Size the caller already fetched; any other fails, 0 = unknown
+        std::function<void(size_t received, size_t total)> on_progress;
+    };
+
+    // key names the persisted progress; keep it to 8 characters (NVS key length)
+    ResumableDownload(const std::string& url, const std::string& path, const std::string& key, const Options& options);
+    ~ResumableDownload();
+
+    // Returns true once the part file holds the whole resource
+    bool Download();
+    // Replace path with the finished part file; on failure the part file and
+    // its progress are kept, so the next Download() completes without refetching
+    bool Commit();
+    // Drop the part file and the saved progress
+    void Discard();
+
+    const std::string& part_path() const { return part_path_; }
+    size_t size() const { return offset_; }
+    size_t resumed_from() const { return resumed_from_; }
+    uint32_t crc32() const { return crc32_; }
+    // Sum of all bytes from checksum_skip on, modulo 2^32
+    uint32_t byte_sum() const { return byte_sum_; }
+    const std::string& etag() const { return etag_; }
+    const std::string& last_modified() const { return last_modified_; }
+
+private:
+    enum AttemptResult {
+        kAttemptComplete,
+        kAttemptInterrupted,    // Worth another connection
+        kAttemptFailed,
+    };
+
+    std::string url_;
+    std::string path_;
+    std::string part_path_;
+    std::string key_;
+    Options options_;
+    uint32_t url_hash_ = 0;
+
+    size_t offset_ = 0;
+    size_t total_ = 0;      // 0 while unknown
+    size_t resumed_from_ = 0;
+    uint32_t crc32_ = 0;
+    uint32_t byte_sum_ = 0;
+    std::string etag_;
+    std::string last_modified_;
+    FILE* file_ = nullptr;
+    int64_t start_us_ = 0;
+
+    void LoadState();
+    void SaveState();
+    void ClearState();
+    void Restart();
+    bool Checkpoint();
+    bool PartMatches(size_t size, uint32_t crc32);
+    bool SizeMismatch(size_t size) const;
+    AttemptResult Attempt();
+    AttemptResult ReadBody(Http* http);
+    bool ParseContentRange(const std::string& value, size_t& start, size_t& total);
+};
+
+#endif // RESUMABLE_DOWNLOAD_H
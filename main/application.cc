@@ -79,17 +79,29 @@ void SetStartupVisualLock(bool locked) {
 
 }  // namespace
 
-// Minimal WAV-from-HTTP player for POC: expects mono 16-bit PCM at codec sample rate
-static bool PlayWavFromUrl(const std::string &url, float gain)
-{
-    auto &board = Board::GetInstance();
-    auto codec = board.GetAudioCodec();
-    if (!codec)
-    {
-        ESP_LOGE(TAG, "Audio codec not available");
-        return false;
+namespace {
+
+class HttpPcmSource : public PcmSource {
+public:
+    explicit HttpPcmSource(std::unique_ptr<Http> http) : http_(std::move(http)) {}
+    ~HttpPcmSource() override { http_->Close(); }
+
+    int Read(uint8_t* buffer, size_t size) override {
+        return http_->Read(reinterpret_cast<char*>(buffer), size);
     }
 
+private:
+    std::unique_ptr<Http> http_;
+};
+
+}  // namespace
+
+// Minimal WAV-from-HTTP player for POC: expects mono 16-bit PCM at codec sample rate.
+// Returns once the stream has started; on_done reports the end of playback.
+static bool PlayWavFromUrl(PcmStreamPlayer &player, const std::string &url, float gain,
+                           PcmStreamPlayer::DoneCallback on_done)
+{
+    auto &board = Board::GetInstance();
     std::unique_ptr<Http> http(board.CreateHttp());
     if (!http)
     {
@@ -127,64 +139,7 @@ static bool PlayWavFromUrl(const std::string &url, float gain)
         to_skip -= n;
     }
 
-    // Stream PCM frames -> codec
-    const size_t BUF = 1024;
-    std::unique_ptr<uint8_t[]> buf(new uint8_t[BUF]);
-    bool have_leftover = false;
-    uint8_t leftover = 0;
-    gain = (gain <= 0.0f) ? 1.0f : gain;
-    codec->EnableOutput(true);
-
-    while (true)
-    {
-        int n = http->Read(reinterpret_cast<char *>(buf.get()), BUF);
-        if (n <= 0)
-        {
-            break;
-        }
-
-        size_t offset = 0;
-        std::vector<int16_t> samples;
-        samples.reserve(n / 2 + 1);
-
-        // Handle odd byte from previous chunk
-        if (have_leftover)
-        {
-            int16_t s = (int16_t)((uint16_t)buf[offset] << 8 | leftover);
-            int32_t v = (int32_t)(s * gain);
-            if (v > 32767) v = 32767; else if (v < -32768) v = -32768;
-            samples.push_back((int16_t)v);
-            offset += 1;
-            have_leftover = false;
-        }
-
-        // Convert little-endian 16-bit to int16_t, apply gain
-        for (; offset + 1 < (size_t)n; offset += 2)
-        {
-            int16_t s = (int16_t)((uint16_t)buf[offset + 1] << 8 | buf[offset]);
-            int32_t v = (int32_t)(s * gain);
-            if (v > 32767)
-                v = 32767;
-            else if (v < -32768)
-                v = -32768;
-            samples.push_back((int16_t)v);
-        }
-
-        // Save leftover byte if odd length
-        if (offset < (size_t)n)
-        {
-            leftover = buf[offset];
-            have_leftover = true;
-        }
-
-        if (!samples.empty())
-        {
-            codec->OutputData(samples);
-        }
-    }
-
-    http->Close();
-    return true;
+    return player.Play(std::make_unique<HttpPcmSource>(std::move(http)), 1, gain, std::move(on_done));
 }
 
 static uint16_t ReadUint16LE(FILE *file, bool &ok)
@@ -210,13 +165,10 @@ static uint32_t ReadUint32LE(FILE *file, bool &ok)
 
 // Play a local WAV file from SD card during startup.
 // Expects PCM RIFF/WAVE, 16-bit PCM, and channels that can be mixed to mono.
-static bool PlayWavFromSdCard(const std::string& path, float gain) {
-    auto &board = Board::GetInstance();
-    auto codec = board.GetAudioCodec();
-    if (!codec) {
-        ESP_LOGE(TAG, "Audio codec not available");
-        return false;
-    }
+// Returns once the stream has started; on_done reports the end of playback.
+static bool PlayWavFromSdCard(PcmStreamPlayer &player, const std::string& path, float gain,
+                              PcmStreamPlayer::DoneCallback on_done) {
+    auto codec = Board::GetInstance().GetAudioCodec();
     constexpr TickType_t WaitPerPoll = pdMS_TO_TICKS(100);
     constexpr int MaxPolls = 30;
     for (int i = 0; i < MaxPolls; ++i) {
@@ -324,75 +276,8 @@ static bool PlayWavFromSdCard(const std::string& path, float gain) {
         return false;
     }
 
-    codec->EnableOutput(true);
-    gain = (gain <= 0.0f) ? 1.0f : gain;
-
-    constexpr size_t kReadBufferSize = 2048;
-    std::vector<uint8_t> read_buf(kReadBufferSize);
-    std::vector<int16_t> samples;
-    samples.reserve(2048);
-    uint32_t frame_size = static_cast<uint32_t>(channels) * sizeof(int16_t);
-    uint32_t remaining = data_size;
-    uint64_t emitted_samples = 0;
-    bool decode_ok = false;
-    constexpr uint32_t kTailMarginMs = 60;
-
-    while (remaining > 0) {
-        size_t request = sizeof(read_buf);
-        if (remaining < request) {
-            request = remaining;
-        }
-        size_t got = fread(read_buf.data(), 1, request, file);
-        if (got == 0) {
-            break;
-        }
-        remaining -= got;
-
-        size_t offset = 0;
-        while (offset + frame_size <= got) {
-            int32_t sample_sum = 0;
-            for (uint16_t ch = 0; ch < channels; ++ch) {
-                size_t sample_offset = offset + ch * sizeof(int16_t);
-                int16_t s = static_cast<int16_t>(read_buf[sample_offset] |
-                                                (read_buf[sample_offset + 1] << 8));
-                sample_sum += s;
-            }
-            sample_sum /= channels;
-            int32_t scaled = static_cast<int32_t>(sample_sum * gain);
-            if (scaled > 32767) {
-                scaled = 32767;
-            } else if (scaled < -32768) {
-                scaled = -32768;
-            }
-            samples.push_back(static_cast<int16_t>(scaled));
-            offset += frame_size;
-            ++emitted_samples;
-            if (samples.size() >= 256) {
-                codec->OutputData(samples);
-                samples.clear();
-            }
-        }
-        decode_ok = true;
-    }
-
-    if (!samples.empty()) {
-        codec->OutputData(samples);
-    }
-    fclose(file);
-    if (decode_ok && emitted_samples > 0) {
-        const uint32_t output_sample_rate = static_cast<uint32_t>(codec->output_sample_rate());
-        const uint32_t playback_ms = static_cast<uint32_t>(
-            (emitted_samples * 1000ULL) / output_sample_rate);
-        vTaskDelay(pdMS_TO_TICKS(playback_ms + kTailMarginMs));
-    }
-
-    if (!decode_ok || emitted_samples == 0) {
-        ESP_LOGW(TAG, "No PCM frames emitted from startup.wav");
-        return false;
-    }
-
-    ESP_LOGI(TAG, "Played %llu samples from %s", emitted_samples, path.c_str());
-    return true;
+    // The source owns the file from here on
+    return player.Play(std::make_unique<FilePcmSource>(file, data_size), channels, gain, std::move(on_done));
 }
 
 static const char *const STATE_STRINGS[] = {
@@ -414,6 +299,14 @@ Application::Application()
     event_group_ = xEventGroupCreate();
     background_task_ = new BackgroundTask(4096 * 7);
 
+    SystemInfo::RegisterLatencyHistogram("dec.queue", &decode_queue_latency_);
+    SystemInfo::RegisterLatencyHistogram("dec.decode", &decode_latency_);
+    SystemInfo::RegisterLatencyHistogram("dec.i2s", &i2s_write_latency_);
+    SystemInfo::RegisterLatencyHistogram("dec.total", &playout_latency_);
+    SystemInfo::RegisterLatencyHistogram("enc.queue", &encode_queue_latency_);
+    SystemInfo::RegisterLatencyHistogram("enc.encode", &encode_latency_);
+    SystemInfo::RegisterLatencyHistogram("wake.first", &wake_first_byte_latency_);
+
 #if CONFIG_USE_DEVICE_AEC
     aec_mode_ = kAecOnDeviceSide;
 #elif CONFIG_USE_SERVER_AEC
@@ -530,11 +423,8 @@ void Application::CheckNewVersion()
             auto codec = board.GetAudioCodec();
             codec->EnableInput(false);
             codec->EnableOutput(false);
-            {
-                std::lock_guard<std::mutex> lock(mutex_);
-                audio_decode_queue_.clear();
-            }
-            background_task_->WaitForCompletion();
+            ClearDecodeQueue();
+            WaitForAudioIdle();
             delete background_task_;
             background_task_ = nullptr;
             vTaskDelay(pdMS_TO_TICKS(1000));
@@ -655,6 +545,7 @@ void Application::DismissAlert()
     {
         auto display = Board::GetInstance().GetDisplay();
         display->SetStatus(Lang::Strings::STANDBY);
+        clock_minute_ = -1;
         display->SetEmotion("normal");
         // DISABLED: Comment out transcript display to reduce memory usage
         // display->SetChatMessage("system", "");
@@ -663,14 +554,20 @@ void Application::DismissAlert()
 
 void Application::PlaySound(const std::string_view &sound)
 {
-    // Wait for the previous sound to finish
+    // Wait for the previous sound to finish. The decoder notifies without
+    // taking mutex_, so re-check once per frame in case a wakeup is missed.
     {
         std::unique_lock<std::mutex> lock(mutex_);
-        audio_decode_cv_.wait(lock, [this]()
-                              { return audio_decode_queue_.empty(); });
+        while (!audio_decode_queue_.empty() || has_held_packet_.load() || jitter_buffer_.size() > 0)
+        {
+            audio_decode_cv_.wait_for(lock, std::chrono::milliseconds(OPUS_FRAME_DURATION_MS));
+        }
     }
-    background_task_->WaitForCompletion();
+    WaitForAudioIdle();
 
+    // Start the jitter buffer afresh; the clip is numbered from 0
+    audio_decode_queue_.TryPush(AudioStreamPacket());
+    uint32_t sequence = 0;
     const char *data = sound.data();
     size_t size = sound.size();
     for (const char *p = data; p < data + size;)
@@ -682,12 +579,15 @@ void Application::PlaySound(const std::string_view &sound)
         AudioStreamPacket packet;
         packet.sample_rate = 16000;
         packet.frame_duration = 60;
-        packet.payload.resize(payload_size);
-        memcpy(packet.payload.data(), p3->payload, payload_size);
+        packet.sequence = sequence++;
+        packet.payload.assign(p3->payload, payload_size);
         p += payload_size;
 
-        std::lock_guard<std::mutex> lock(mutex_);
-        audio_decode_queue_.emplace_back(std::move(packet));
+        if (!audio_decode_queue_.TryPush(std::move(packet)))
+        {
+            ESP_LOGW(TAG, "Sound longer than the decode queue, truncated");
+            break;
+        }
     }
 }
 
@@ -703,9 +603,17 @@ void Application::ExitAudioTestingMode()
     ESP_LOGI(TAG, "Exiting audio testing mode");
     SetDeviceState(kDeviceStateWifiConfiguring);
     // Copy audio_testing_queue_ to audio_decode_queue_
+    static_assert(AUDIO_TESTING_MAX_DURATION_MS / OPUS_FRAME_DURATION_MS <= AUDIO_DECODE_RING_SIZE,
+                  "decode ring must hold a full audio test");
     std::lock_guard<std::mutex> lock(mutex_);
-    audio_decode_queue_ = std::move(audio_testing_queue_);
-    audio_decode_cv_.notify_all();
+    audio_decode_queue_.TryPush(AudioStreamPacket());
+    uint32_t sequence = 0;
+    for (auto &packet : audio_testing_queue_)
+    {
+        packet.sequence = sequence++;
+        audio_decode_queue_.TryPush(std::move(packet));
+    }
+    audio_testing_queue_.clear();
 }
 
 void Application::ToggleChatState()
@@ -804,11 +712,7 @@ void Application::ToggleChatState()
                      }
                      
                      // Clear all pending audio decode queue
-                     {
-                         std::lock_guard<std::mutex> lock(mutex_);
-                         audio_decode_queue_.clear();
-                         audio_decode_cv_.notify_all();
-                     }
+                     ClearDecodeQueue();
                      
                      // Reset decoder state
                      ResetDecoder();
@@ -933,8 +837,10 @@ void Application::Start()
 
     /* Setup the audio codec */
     auto codec = board.GetAudioCodec();
-    opus_decoder_ = std::make_unique<OpusDecoderWrapper>(codec->output_sample_rate(), 1, OPUS_FRAME_DURATION_MS);
-    opus_encoder_ = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
+    // Reserve the audio frame buffers before the heap gets fragmented
+    AudioFramePool::GetInstance();
+    opus_decoder_ = std::make_unique<OpusFrameDecoder>(codec->output_sample_rate(), 1, OPUS_FRAME_DURATION_MS);
+    opus_encoder_ = std::make_unique<OpusFrameEncoder>(16000, 1, OPUS_FRAME_DURATION_MS);
     if (aec_mode_ != kAecOff)
     {
         ESP_LOGI(TAG, "AEC mode: %d, setting opus encoder complexity to 0", aec_mode_);
@@ -950,6 +856,13 @@ void Application::Start()
         ESP_LOGI(TAG, "WiFi board detected, setting opus encoder complexity to 0");
         opus_encoder_->SetComplexity(0);
     }
+    opus_encoder_->SetBitrate(rate_controller_.settings().bitrate);
+    decode_worker_ = std::make_unique<AudioWorker<DecodeJob, AUDIO_DECODE_WORKER_DEPTH>>(
+        "audio_decode", 4096 * 4, AUDIO_DECODE_TASK_PRIORITY, AUDIO_DECODE_TASK_CORE,
+        [this](DecodeJob &job) { DecodeFrame(job); });
+    encode_worker_ = std::make_unique<AudioWorker<EncodeJob, AUDIO_ENCODE_WORKER_DEPTH>>(
+        "audio_encode", 4096 * 7, AUDIO_ENCODE_TASK_PRIORITY, AUDIO_ENCODE_TASK_CORE,
+        [this](EncodeJob &job) { EncodeFrame(job); });
 
     if (codec->input_sample_rate() != 16000)
     {
@@ -957,14 +870,24 @@ void Application::Start()
         reference_resampler_.Configure(codec->input_sample_rate(), 16000);
     }
     codec->Start();
+    wav_player_ = std::make_unique<PcmStreamPlayer>(codec);
 
 #ifdef CONFIG_BOARD_TYPE_ECHOEAR
     animation_block_startup_load(true);
-    if (!PlayWavFromSdCard("/sdcard/startup.wav", 1.0f)) {
-        ESP_LOGW(TAG, "startup.wav playback skipped or failed");
-    } else {
-        ESP_LOGI(TAG, "startup.wav playback finished");
-    }
+    // The SD card may still be mounting; wait for the file off the main task
+    // and let network bring-up continue while startup.wav plays.
+    background_task_->Schedule([this]() {
+        bool started = PlayWavFromSdCard(*wav_player_, "/sdcard/startup.wav", 1.0f, [](bool ok, uint64_t samples) {
+            if (ok) {
+                ESP_LOGI(TAG, "startup.wav playback finished");
+            } else {
+                ESP_LOGW(TAG, "startup.wav playback failed after %llu samples", (unsigned long long)samples);
+            }
+        });
+        if (!started) {
+            ESP_LOGW(TAG, "startup.wav playback skipped or failed");
+        }
+    }, kBackgroundLaneAudio);
 #endif
 
 #if CONFIG_USE_AUDIO_PROCESSOR
@@ -999,6 +922,9 @@ void Application::Start()
 
     // Update the status bar immediately to show the network state
     display->UpdateStatusBar(true);
+    board.GetAudioCodec()->OnOutputVolumeChange([display](int volume) {
+        display->SetMuted(volume == 0);
+    });
 
     // Check WiFi connection status and show message if not connected
     // Note: If no WiFi credentials exist, StartNetwork() will block in WiFi config mode,
@@ -1202,9 +1128,9 @@ void Application::Start()
         Alert(Lang::Strings::ERROR, message.c_str(), "wifi", Lang::Sounds::P3_EXCLAMATION); });
     protocol_->OnIncomingAudio([this](AudioStreamPacket &&packet)
                                {
-        std::lock_guard<std::mutex> lock(mutex_);
-        if (device_state_ == kDeviceStateSpeaking && audio_decode_queue_.size() < MAX_AUDIO_PACKETS_IN_QUEUE) {
-            audio_decode_queue_.emplace_back(std::move(packet));
+        if (device_state_ == kDeviceStateSpeaking && !packet.payload.empty()) {
+            packet.arrival_us = esp_timer_get_time();
+            audio_decode_queue_.Push(std::move(packet), MAX_AUDIO_PACKETS_IN_QUEUE, RingOverflow::kDropNewest);
         } });
     protocol_->OnAudioChannelOpened([this, codec, &board]()
                                     {
@@ -1214,304 +1140,46 @@ void Application::Start()
                                             ESP_LOGW(TAG, "Server sample rate %d does not match device output sample rate %d, resampling may cause distortion",
                                                      protocol_->server_sample_rate(), codec->output_sample_rate());
                                         }
+                                        opus_encoder_->SetDtx(protocol_->server_dtx());
 
 #if CONFIG_IOT_PROTOCOL_XIAOZHI
                                         auto &thing_manager = iot::ThingManager::GetInstance();
                                         protocol_->SendIotDescriptors(thing_manager.GetDescriptorsJson());
-                                        std::string states;
-                                        if (thing_manager.GetStatesJson(states, false))
-                                        {
-                                            protocol_->SendIotStates(states);
-                                        }
+                                        SendIotStates(false);
 #endif
                                     });
     protocol_->OnAudioChannelClosed([this, &board]()
                                     {
         board.SetPowerSaveMode(true);
+#if CONFIG_IOT_PROTOCOL_MCP
+        // Results for this session can no longer be delivered
+        McpServer::GetInstance().CancelToolCalls();
+#endif
         Schedule([this]() {
             /* removed unused: display */
             // DISABLED: Comment out transcript display to reduce memory usage
             // display->SetChatMessage("system", "");
             SetDeviceState(kDeviceStateIdle);
         }); });
-    protocol_->OnIncomingJson([this, display](const cJSON *root)
-                              {
-        // Parse JSON data
-        ESP_LOGI(TAG, "OnIncomingJson: Entry point - message received");
-        auto type = cJSON_GetObjectItem(root, "type");
-        if (type && cJSON_IsString(type)) {
-            ESP_LOGI(TAG, "OnIncomingJson: Message type='%s'", type->valuestring);
-        } else {
-            ESP_LOGW(TAG, "OnIncomingJson: Message missing or invalid type field");
-        }
-        if (strcmp(type->valuestring, "tts") == 0) {
-            auto state = cJSON_GetObjectItem(root, "state");
-            if (strcmp(state->valuestring, "start") == 0) {
-                Schedule([this]() {
-                    aborted_ = false;
-                    if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
-                        // Save state before TTS to determine if we should resume listening after TTS
-                        state_before_tts_ = device_state_;
-                        
-                        // If we're in LISTENING state, stop listening before TTS starts
-                        // This ensures no microphone audio interference during TTS playback
-                        if (device_state_ == kDeviceStateListening) {
-                            auto* active_protocol = GetActiveProtocol();
-                            if (active_protocol && active_protocol->IsAudioChannelOpened()) {
-                                ESP_LOGI(TAG, "TTS starting while listening - stopping listening before TTS");
-                                active_protocol->SendStopListening();
-                                // Small delay to ensure server receives listen:stop before TTS starts
-                                vTaskDelay(pdMS_TO_TICKS(50));
-                            }
-                        }
-                        
-                        SetDeviceState(kDeviceStateSpeaking);
-                    }
-                });
-            } else if (strcmp(state->valuestring, "stop") == 0) {
-                Schedule([this]() {
-                    ESP_LOGI(TAG, "TTS stop (primary): state=%d, listening_mode=%d", device_state_, (int)listening_mode_);
-                    background_task_->WaitForCompletion();
-                    if (device_state_ == kDeviceStateSpeaking) {
-                        // Check if user aborted speaking - don't auto-resume listening
-                        if (aborted_) {
-                            ESP_LOGI(TAG, "TTS stopped after user abort - going to idle without resuming listening");
-                            aborted_ = false;  // Reset flag
-                            state_before_tts_ = kDeviceStateUnknown;  // Reset
-                            SetDeviceState(kDeviceStateIdle);
-                            return;  // Early return, don't continue with auto-resume logic
-                        }
-                        
-                        // Check if remote wakeup scenario (WebSocket still open)
-                        auto* active_protocol = GetActiveProtocol();
-                        bool is_remote_wakeup = (websocket_protocol_ != nullptr && 
-                                                websocket_protocol_->IsAudioChannelOpened() &&
-                                                active_protocol && active_protocol->IsAudioChannelOpened());
-                        
-                        if (is_remote_wakeup) {
-                            // Automatically resume listening after TTS in remote wakeup scenario
-                            if (is_alarm_mode_) {
-                                // Alarm mode: Always start listening after TTS (even if wasn't listening before)
-                                // This is the expected flow: ws_start → TTS → listening
-                                ESP_LOGI(TAG, "TTS stopped, alarm mode - starting listening for user response");
-                                SetDeviceState(kDeviceStateListening);
-                                is_alarm_mode_ = false; // Reset alarm mode after first TTS completes
-                            } else if (state_before_tts_ == kDeviceStateListening) {
-                                // Normal remote wakeup: Only resume if we were listening before TTS started
-                                ESP_LOGI(TAG, "TTS stopped, remote wakeup detected (WebSocket open) - automatically resuming listening");
-                                SetDeviceState(kDeviceStateListening);
-                            } else {
-                                ESP_LOGI(TAG, "TTS stopped, remote wakeup detected but was not listening before TTS - going to idle");
-                                SetDeviceState(kDeviceStateIdle);
-                            }
-                            state_before_tts_ = kDeviceStateUnknown; // Reset
-                        } else if (listening_mode_ == kListeningModeManualStop) {
-                            // Go to idle for manual interactions
-                            ESP_LOGI(TAG, "TTS stopped, going to idle (manual stop mode)");
-                            SetDeviceState(kDeviceStateIdle);
-                            state_before_tts_ = kDeviceStateUnknown; // Reset
-                        } else {
-                            // Auto mode: resume listening
-                            ESP_LOGI(TAG, "TTS stopped, automatically resuming listening (auto stop mode)");
-                            SetDeviceState(kDeviceStateListening);
-                            state_before_tts_ = kDeviceStateUnknown; // Reset
-                        }
-                    }
-                });
-            } else if (strcmp(state->valuestring, "sentence_start") == 0) {
-                auto text = cJSON_GetObjectItem(root, "text");
-                if (cJSON_IsString(text)) {
-                    ESP_LOGI(TAG, "<< %s", text->valuestring);
-                    // DISABLED: Comment out transcript display to reduce memory usage
-                    // Schedule([this, display, message = std::string(text->valuestring)]() {
-                    //     display->SetChatMessage("assistant", message.c_str());
-                    // });
-                }
-            }
-        } else if (strcmp(type->valuestring, "stt") == 0) {
-            auto text = cJSON_GetObjectItem(root, "text");
-            if (cJSON_IsString(text)) {
-                ESP_LOGI(TAG, ">> %s", text->valuestring);
-                // DISABLED: Comment out transcript display to reduce memory usage
-                // Schedule([this, display, message = std::string(text->valuestring)]() {
-                //     display->SetChatMessage("user", message.c_str());
-                // });
-            }
-        } else if (strcmp(type->valuestring, "llm") == 0) {
-            auto emotion = cJSON_GetObjectItem(root, "emotion");
-            if (cJSON_IsString(emotion)) {
-                Schedule([this, display, emotion_str = std::string(emotion->valuestring)]() {
-                    display->SetEmotion(emotion_str.c_str());
-                });
-            }
-#if CONFIG_IOT_PROTOCOL_MCP
-        } else if (strcmp(type->valuestring, "mcp") == 0) {
-            ESP_LOGI(TAG, "OnIncomingJson: Received MCP message");
-            auto payload = cJSON_GetObjectItem(root, "payload");
-            if (cJSON_IsObject(payload)) {
-                char* payload_str = cJSON_PrintUnformatted(payload);
-                if (payload_str) {
-                    ESP_LOGI(TAG, "OnIncomingJson: MCP payload: %s", payload_str);
-                    cJSON_free(payload_str);
-                }
-                ESP_LOGI(TAG, "OnIncomingJson: Forwarding MCP payload to McpServer::ParseMessage");
-                McpServer::GetInstance().ParseMessage(payload);
-            } else {
-                ESP_LOGW(TAG, "OnIncomingJson: MCP message missing or invalid payload");
-            }
-#endif
-#if CONFIG_IOT_PROTOCOL_XIAOZHI
-        } else if (strcmp(type->valuestring, "iot") == 0) {
-            auto commands = cJSON_GetObjectItem(root, "commands");
-            if (cJSON_IsArray(commands)) {
-                auto& thing_manager = iot::ThingManager::GetInstance();
-                for (int i = 0; i < cJSON_GetArraySize(commands); ++i) {
-                    auto command = cJSON_GetArrayItem(commands, i);
-                    thing_manager.Invoke(command);
-                }
-            }
-#endif
-        } else if (strcmp(type->valuestring, "listen") == 0) {
-            auto state = cJSON_GetObjectItem(root, "state");
-            if (cJSON_IsString(state)) {
-                if (strcmp(state->valuestring, "start") == 0) {
-                    ESP_LOGI(TAG, "Received listen:start from server, starting listening");
-                    Schedule([this]() { 
-                        ESP_LOGI(TAG, "Executing listen:start - setting listening mode (AutoStop)");
-                        SetListeningMode(kListeningModeAutoStop); 
-                    });
-                } else if (strcmp(state->valuestring, "stop") == 0) {
-                    ESP_LOGI(TAG, "Received listen:stop from server, stopping listening");
-                    Schedule([this]() { StopListening(); });
-                } else {
-                    ESP_LOGW(TAG, "Received listen message with unknown state: %s", state->valuestring);
-                }
-            } else {
-                ESP_LOGW(TAG, "Received listen message without valid state field");
-            }
-        } else if (strcmp(type->valuestring, "system") == 0) {
-            auto command = cJSON_GetObjectItem(root, "command");
-            if (cJSON_IsString(command)) {
-                ESP_LOGI(TAG, "System command: %s", command->valuestring);
-                if (strcmp(command->valuestring, "reboot") == 0) {
-                    // Do a reboot if user requests a OTA update
-                    Schedule([this]() {
-                        Reboot();
-                    });
-                } else {
-                    ESP_LOGW(TAG, "Unknown system command: %s", command->valuestring);
-                }
-            }
-        } else if (strcmp(type->valuestring, "alert") == 0) {
-            auto status = cJSON_GetObjectItem(root, "status");
-            auto message = cJSON_GetObjectItem(root, "message");
-            auto emotion = cJSON_GetObjectItem(root, "emotion");
-            if (cJSON_IsString(status) && cJSON_IsString(message) && cJSON_IsString(emotion)) {
-                Alert(status->valuestring, message->valuestring, emotion->valuestring, Lang::Sounds::P3_VIBRATION);
-            } else {
-                ESP_LOGW(TAG, "Alert command requires status, message and emotion");
-            }
-        } else if (strcmp(type->valuestring, "play_url") == 0) {
-            auto url = cJSON_GetObjectItem(root, "url");
-            auto gain = cJSON_GetObjectItem(root, "gain");
-            if (cJSON_IsString(url)) {
-                float g = cJSON_IsNumber(gain) ? (float)gain->valuedouble : 1.0f;
-                // Run playback in background to avoid blocking main loop
-                Schedule([this, url_str = std::string(url->valuestring), g]() {
-                    ResetDecoder();
-                    if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
-                        SetDeviceState(kDeviceStateSpeaking);
-                    }
-                    background_task_->Schedule([this, url_str, g]() {
-                        bool ok = PlayWavFromUrl(url_str, g);
-                        Schedule([this, ok]() {
-                            if (device_state_ == kDeviceStateSpeaking) {
-                                SetDeviceState(kDeviceStateIdle);
-                            }
-                            ESP_LOGI(TAG, "PlayWavFromUrl %s", ok ? "done" : "failed");
-                        });
-                    });
-                });
-            } else {
-                ESP_LOGW(TAG, "play_url missing 'url' field");
-            }
-        } else if (strcmp(type->valuestring, "adjust_volume") == 0) {
-            // Handle volume adjustment: accepts "volume" (number) or "message" (number as string)
-            auto volume_item = cJSON_GetObjectItem(root, "volume");
-            int target_volume = -1;
-            
-            if (cJSON_IsNumber(volume_item)) {
-                target_volume = volume_item->valueint;
-            } else {
-                // Fallback to "message" field for compatibility with test script pattern
-                auto message_item = cJSON_GetObjectItem(root, "message");
-                if (cJSON_IsString(message_item)) {
-                    // Try to parse message as integer
-                    target_volume = atoi(message_item->valuestring);
-                } else if (cJSON_IsNumber(message_item)) {
-                    target_volume = message_item->valueint;
-                }
-            }
-            
-            if (target_volume >= 0 && target_volume <= 100) {
-                ESP_LOGI(TAG, "Received adjust_volume command, setting volume to %d", target_volume);
-                Schedule([this, target_volume]() {
-                    auto codec = Board::GetInstance().GetAudioCodec();
-                    if (codec != nullptr) {
-                        codec->SetOutputVolume(target_volume);
-                        ESP_LOGI(TAG, "Volume adjusted to %d", target_volume);
-                    } else {
-                        ESP_LOGW(TAG, "Cannot adjust volume: audio codec not available");
-                    }
-                });
-            } else {
-                ESP_LOGW(TAG, "adjust_volume requires volume value between 0-100, got: %d", target_volume);
-            }
-        } else {
-            ESP_LOGW(TAG, "Unknown message type: %s", type->valuestring);
-        } });
+    RegisterJsonHandlers();
+    protocol_->OnIncomingJson([this](const cJSON *root)
+                              { json_handlers_.Dispatch(root); });
     bool protocol_started = protocol_->Start();
 
     audio_debugger_ = std::make_unique<AudioDebugger>();
     audio_processor_->Initialize(codec);
-    audio_processor_->OnOutput([this](std::vector<int16_t> &&data)
+    audio_processor_->OnOutput([this](PcmFrame &&data)
                                {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (audio_send_queue_.size() >= MAX_AUDIO_PACKETS_IN_QUEUE) {
-                ESP_LOGW(TAG, "Too many audio packets in queue, drop the newest packet");
-                return;
-            }
+        if (audio_send_queue_.size() >= MAX_AUDIO_PACKETS_IN_QUEUE) {
+            ESP_LOGW(TAG, "Too many audio packets in queue, drop the newest packet");
+            return;
         }
-        background_task_->Schedule([this, data = std::move(data)]() mutable {
-            opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t>&& opus) {
-                AudioStreamPacket packet;
-                packet.payload = std::move(opus);
-#ifdef CONFIG_USE_SERVER_AEC
-                {
-                    std::lock_guard<std::mutex> lock(timestamp_mutex_);
-                    if (!timestamp_queue_.empty()) {
-                        packet.timestamp = timestamp_queue_.front();
-                        timestamp_queue_.pop_front();
-                    } else {
-                        packet.timestamp = 0;
-                    }
-
-                    if (timestamp_queue_.size() > 3) { // 限制队列长度3
-                        timestamp_queue_.pop_front(); // 该包发送前先出队保持队列长度
-                        return;
-                    }
-                }
-#endif
-                std::lock_guard<std::mutex> lock(mutex_);
-                if (audio_send_queue_.size() >= MAX_AUDIO_PACKETS_IN_QUEUE) {
-                    ESP_LOGW(TAG, "Too many audio packets in queue, drop the oldest packet");
-                    audio_send_queue_.pop_front();
-                }
-                audio_send_queue_.emplace_back(std::move(packet));
-                xEventGroupSetBits(event_group_, SEND_AUDIO_EVENT);
-            });
-        }); });
+        EncodeJob job;
+        job.pcm = std::move(data);
+        job.enqueue_us = esp_timer_get_time();
+        if (!encode_worker_->Post(std::move(job))) {
+            ESP_LOGW(TAG, "Audio encoder busy, drop the newest frame");
+        } });
     audio_processor_->OnVadStateChange([this](bool speaking)
                                        {
         ESP_LOGD(TAG, "VAD state changed: %s", speaking ? "SPEECH" : "SILENCE");
@@ -1538,7 +1206,9 @@ void Application::Start()
 
     wake_word_->Initialize(codec);
     wake_word_->OnWakeWordDetected([this](const std::string &wake_word)
-                                   { Schedule([this, &wake_word]()
+                                   {
+        int64_t detected_us = esp_timer_get_time();
+        Schedule([this, &wake_word, detected_us]()
                                               {
             if (!protocol_) {
                 return;
@@ -1572,13 +1242,20 @@ void Application::Start()
                 ESP_LOGI(TAG, "Wake word detected: %s", wake_word.c_str());
 #if CONFIG_USE_AFE_WAKE_WORD
                 AudioStreamPacket packet;
-                // Encode and send the wake word data to the server
-                while (wake_word_->GetWakeWordOpus(packet.payload)) {
+                std::vector<uint8_t> opus;
+                int packets = 0;
+                int64_t first_byte_us = 0;
+                // Send the pre-encoded wake word audio to the server
+                while (wake_word_->GetWakeWordOpus(opus)) {
+                    packet.payload.assign(opus.data(), opus.size());
                     auto* active_protocol = GetActiveProtocol();
-                    if (active_protocol) {
-                        active_protocol->SendAudio(packet);
+                    if (active_protocol && active_protocol->SendAudio(packet) && packets++ == 0) {
+                        first_byte_us = esp_timer_get_time() - detected_us;
+                        wake_first_byte_latency_.Record(first_byte_us);
                     }
                 }
+                ESP_LOGI(TAG, "Sent %d wake word packets, first %ld ms after detection", packets,
+                         (long)(first_byte_us / 1000));
                 // Set the chat state to wake word detected
                 // Use primary protocol for wake word detection (MQTT)
                 if (protocol_) {
@@ -1627,28 +1304,89 @@ void Application::OnClockTimer()
     clock_ticks_++;
 
     auto display = Board::GetInstance().GetDisplay();
+    // Only inputs that changed reach the display, so an idle status bar is not redrawn
     display->UpdateStatusBar();
 
+    // If we have synchronized server time, set the status to clock "HH:MM" once the device
+    // has been idle for 10 seconds, then again on every minute rollover
+    if (device_state_ == kDeviceStateIdle && clock_ticks_ >= 10 && ota_.HasServerTime())
+    {
+        time_t now = time(NULL);
+        struct tm local;
+        localtime_r(&now, &local);
+        if (local.tm_min != clock_minute_)
+        {
+            clock_minute_ = local.tm_min;
+            Schedule([local]()
+                     {
+                char time_str[16];
+                strftime(time_str, sizeof(time_str), "%H:%M  ", &local);
+                Board::GetInstance().GetDisplay()->SetStatus(time_str); });
+        }
+    }
+
     // Print the debug info every 10 seconds
     if (clock_ticks_ % 10 == 0)
     {
         // SystemInfo::PrintTaskCpuUsage(pdMS_TO_TICKS(1000));
         // SystemInfo::PrintTaskList();
         SystemInfo::PrintHeapStats();
-
-        // If we have synchronized server time, set the status to clock "HH:MM" if the device is idle
-        if (ota_.HasServerTime())
+        AudioFramePool::GetInstance().PrintStats();
+        SystemInfo::PrintLatencyHistograms();
+        if (background_task_ != nullptr)
         {
-            if (device_state_ == kDeviceStateIdle)
-            {
-                Schedule([this]()
-                         {
-                    // Set status to clock "HH:MM"
-                    time_t now = time(NULL);
-                    char time_str[64];
-                    strftime(time_str, sizeof(time_str), "%H:%M  ", localtime(&now));
-                    Board::GetInstance().GetDisplay()->SetStatus(time_str); });
-            }
+            background_task_->PrintStats();
+        }
+        if (decode_worker_ && (decode_worker_->dropped() > 0 || encode_worker_->dropped() > 0))
+        {
+            ESP_LOGW(TAG, "Audio worker drops: decode %u, encode %u",
+                     (unsigned)decode_worker_->dropped(), (unsigned)encode_worker_->dropped());
+        }
+        if (audio_send_queue_.dropped() > 0 || audio_decode_queue_.dropped() > 0)
+        {
+            ESP_LOGW(TAG, "Audio packets dropped: send %u, decode %u",
+                     (unsigned)audio_send_queue_.dropped(), (unsigned)audio_decode_queue_.dropped());
+        }
+        if (rate_controller_.changes() > 0)
+        {
+            auto rate = rate_controller_.settings();
+            ESP_LOGI(TAG, "Uplink: %d bps, FEC %s, expected loss %d%%, measured loss %u%%, %u send failures",
+                     rate.bitrate, rate.fec ? "on" : "off", rate.packet_loss_percent,
+                     (unsigned)rate_controller_.loss_percent(), (unsigned)audio_send_failures_.load());
+        }
+        DisplayRenderStats render;
+        if (display->GetRenderStats(render))
+        {
+            ESP_LOGI(TAG, "Display: %u.%u fps, %u frames, %u flushes, waited %u ms for the panel, %u px/min invalidated",
+                     (unsigned)(render.fps_x10 / 10), (unsigned)(render.fps_x10 % 10), (unsigned)render.frames,
+                     (unsigned)render.flushes, (unsigned)(render.flush_wait_us / 1000),
+                     (unsigned)render.invalidated_px_per_min);
+        }
+        auto jitter = jitter_buffer_.GetStats();
+        auto json = JsonDispatcher::GetStats();
+        ESP_LOGI(TAG, "JSON messages: %u, %u parsed, %u unhandled",
+                 (unsigned)json.messages, (unsigned)json.parsed, (unsigned)json.unhandled);
+        auto settings = SettingsStore::GetInstance().GetStats();
+        ESP_LOGI(TAG, "Settings: %u reads (%u from NVS), %u writes, %u flash writes in %u flushes, %u failed",
+                 (unsigned)settings.reads, (unsigned)settings.nvs_reads, (unsigned)settings.writes,
+                 (unsigned)settings.nvs_writes, (unsigned)settings.flushes, (unsigned)settings.failed_writes);
+#if CONFIG_IOT_PROTOCOL_XIAOZHI
+        auto iot = iot::ThingManager::GetInstance().GetStats();
+        if (iot.updates > 0)
+        {
+            ESP_LOGI(TAG, "IoT states: %u updates, %u unchanged polls, %u bytes/update, %lld us/update",
+                     (unsigned)iot.updates, (unsigned)iot.skipped, (unsigned)(iot.bytes / iot.updates),
+                     (long long)(iot.total_us / iot.updates));
+        }
+#endif
+        if (jitter.received > 0)
+        {
+            ESP_LOGI(TAG, "Jitter buffer: %u received, %u played, %u late, %u lost (%u FEC, %u PLC), "
+                          "%u dup, %u rebuffers, %u resyncs, jitter %u ms, target %u frames",
+                     (unsigned)jitter.received, (unsigned)jitter.played, (unsigned)jitter.late, (unsigned)jitter.lost,
+                     (unsigned)jitter.recovered, (unsigned)jitter.concealed, (unsigned)jitter.duplicates,
+                     (unsigned)jitter.rebuffers, (unsigned)jitter.resyncs, (unsigned)jitter.jitter_ms,
+                     (unsigned)jitter.target_frames);
         }
     }
 }
@@ -1658,7 +1396,7 @@ void Application::OnClockTimer()
 void Application::Schedule(std::function<void()> callback)
 {
     {
-        std::lock_guard<std::mutex> lock(mutex_);
+        std::lock_guard<std::mutex> lock(main_tasks_mutex_);
         main_tasks_.push_back(std::move(callback));
     }
     xEventGroupSetBits(event_group_, SCHEDULE_EVENT);
@@ -1678,22 +1416,28 @@ void Application::MainEventLoop()
 
         if (bits & SEND_AUDIO_EVENT)
         {
-            std::unique_lock<std::mutex> lock(mutex_);
-            auto packets = std::move(audio_send_queue_);
-            lock.unlock();
-            for (auto &packet : packets)
+            AudioStreamPacket packet;
+            while (audio_send_queue_.TryPop(packet))
             {
                 auto* active_protocol = GetActiveProtocol();
                 if (!active_protocol || !active_protocol->SendAudio(packet))
                 {
+                    audio_send_failures_.fetch_add(1, std::memory_order_relaxed);
+                    // Drop the rest of this batch, as before
+                    audio_send_queue_.Clear();
                     break;
                 }
             }
+            auto* active_protocol = GetActiveProtocol();
+            if (active_protocol && !active_protocol->FlushAudio())
+            {
+                audio_send_failures_.fetch_add(1, std::memory_order_relaxed);
+            }
         }
 
         if (bits & SCHEDULE_EVENT)
         {
-            std::unique_lock<std::mutex> lock(mutex_);
+            std::unique_lock<std::mutex> lock(main_tasks_mutex_);
             auto tasks = std::move(main_tasks_);
             lock.unlock();
             for (auto &task : tasks)
@@ -1780,7 +1524,9 @@ void Application::AudioLoop()
 
 void Application::OnAudioOutput()
 {
-    if (busy_decoding_audio_)
+    // One frame may wait while the previous one is being written to I2S.
+    // Decoded audio also waits while a WAV stream owns the speaker.
+    if (decode_worker_->queued() > 0 || wav_player_->playing())
     {
         return;
     }
@@ -1789,9 +1535,48 @@ void Application::OnAudioOutput()
     auto codec = Board::GetInstance().GetAudioCodec();
     const int max_silence_seconds = 10;
 
-    std::unique_lock<std::mutex> lock(mutex_);
-    if (audio_decode_queue_.empty())
+    // Move everything that has arrived into the jitter buffer. A frame past
+    // the window waits here (the rest stay queued) until playout catches up.
+    AudioStreamPacket packet;
+    int64_t now_us = esp_timer_get_time();
+    if (drop_held_packet_.exchange(false))
     {
+        held_packet_ = AudioStreamPacket();
+        has_held_packet_.store(false, std::memory_order_relaxed);
+    }
+    while (true)
+    {
+        if (!has_held_packet_.load(std::memory_order_relaxed))
+        {
+            if (!audio_decode_queue_.TryPop(held_packet_))
+            {
+                break;
+            }
+            has_held_packet_.store(true, std::memory_order_relaxed);
+        }
+        if (held_packet_.payload.empty())
+        {
+            // Reset marker queued by ClearDecodeQueue()
+            jitter_buffer_.Reset();
+            has_held_packet_.store(false, std::memory_order_relaxed);
+            continue;
+        }
+        if (!jitter_buffer_.Accepts(held_packet_.sequence))
+        {
+            break;
+        }
+        jitter_buffer_.Insert(std::move(held_packet_), now_us);
+        held_packet_ = AudioStreamPacket();
+        has_held_packet_.store(false, std::memory_order_relaxed);
+    }
+
+    auto action = jitter_buffer_.Next(packet, now_us);
+    if (action == JitterBuffer::Action::kWait)
+    {
+        if (jitter_buffer_.size() == 0)
+        {
+            audio_decode_cv_.notify_all();
+        }
         // Disable the output if there is no audio data for a long time
         if (device_state_ == kDeviceStateIdle)
         {
@@ -1804,39 +1589,389 @@ void Application::OnAudioOutput()
         return;
     }
 
-    auto packet = std::move(audio_decode_queue_.front());
-    audio_decode_queue_.pop_front();
-    lock.unlock();
-    audio_decode_cv_.notify_all();
+    DecodeJob job;
+    job.action = action;
+    job.packet = std::move(packet);
+    job.enqueue_us = now_us;
+    decode_worker_->Post(std::move(job));
+}
+
+// Runs on the decode worker, which owns opus_decoder_ and output_resampler_
+void Application::DecodeFrame(DecodeJob &job)
+{
+    int64_t start_us = esp_timer_get_time();
+    decode_queue_latency_.Record(start_us - job.enqueue_us);
+    if (aborted_)
+    {
+        return;
+    }
 
+    auto codec = Board::GetInstance().GetAudioCodec();
+    auto &packet = job.packet;
     // Synchronize the sample rate and frame duration
     SetDecodeSampleRate(packet.sample_rate, packet.frame_duration);
+    if (decoder_reset_pending_.exchange(false))
+    {
+        opus_decoder_->ResetState();
+    }
 
-    busy_decoding_audio_ = true;
-    background_task_->Schedule([this, codec, packet = std::move(packet)]() mutable
-                               {
-        busy_decoding_audio_ = false;
-        if (aborted_) {
-            return;
-        }
+    PcmFrame pcm;
+    bool decoded;
+    if (job.action == JitterBuffer::Action::kDecodeFec)
+    {
+        decoded = opus_decoder_->DecodeFec(packet.payload.data(), packet.payload.size(), pcm);
+    }
+    else if (job.action == JitterBuffer::Action::kConceal)
+    {
+        decoded = opus_decoder_->Conceal(pcm);
+    }
+    else
+    {
+        decoded = opus_decoder_->Decode(packet.payload.data(), packet.payload.size(), pcm);
+    }
+    if (!decoded)
+    {
+        return;
+    }
+    // Resample if the sample rate is different
+    if (opus_decoder_->sample_rate() != codec->output_sample_rate())
+    {
+        int target_size = output_resampler_.GetOutputSamples(pcm.size());
+        PcmFrame resampled;
+        resampled.resize(target_size);
+        output_resampler_.Process(pcm.data(), pcm.size(), resampled.data());
+        pcm = std::move(resampled);
+    }
+    int64_t decoded_us = esp_timer_get_time();
+    decode_latency_.Record(decoded_us - start_us);
+
+    codec->OutputData(pcm.vector());
+    int64_t written_us = esp_timer_get_time();
+    i2s_write_latency_.Record(written_us - decoded_us);
+    playout_latency_.Record(written_us - job.enqueue_us);
+#ifdef CONFIG_USE_SERVER_AEC
+    timestamp_queue_.TryPush(std::move(packet.timestamp));
+#endif
+    last_output_time_ = std::chrono::steady_clock::now();
+}
 
-        std::vector<int16_t> pcm;
-        if (!opus_decoder_->Decode(std::move(packet.payload), pcm)) {
+// Runs on the encode worker, which owns opus_encoder_
+void Application::EncodeFrame(EncodeJob &job)
+{
+    int64_t start_us = esp_timer_get_time();
+    encode_queue_latency_.Record(start_us - job.enqueue_us);
+
+    if (job.testing)
+    {
+        opus_encoder_->Encode(job.pcm.data(), job.pcm.size(), [this](OpusFrame &&opus)
+                              {
+            AudioStreamPacket packet;
+            packet.payload = std::move(opus);
+            packet.frame_duration = OPUS_FRAME_DURATION_MS;
+            packet.sample_rate = 16000;
+            std::lock_guard<std::mutex> lock(mutex_);
+            audio_testing_queue_.push_back(std::move(packet)); });
+    }
+    else
+    {
+        UpdateEncoderRate(start_us);
+        opus_encoder_->Encode(job.pcm.data(), job.pcm.size(), [this](OpusFrame &&opus)
+                              {
+            AudioStreamPacket packet;
+            packet.payload = std::move(opus);
+#ifdef CONFIG_USE_SERVER_AEC
+            if (!timestamp_queue_.TryPop(packet.timestamp)) {
+                packet.timestamp = 0;
+            }
+
+            if (timestamp_queue_.size() > 3) { // 限制队列长度3
+                uint32_t skipped;
+                timestamp_queue_.TryPop(skipped); // 该包发送前先出队保持队列长度
+                return;
+            }
+#endif
+            if (!audio_send_queue_.Push(std::move(packet), MAX_AUDIO_PACKETS_IN_QUEUE, RingOverflow::kDropOldest)) {
+                ESP_LOGW(TAG, "Too many audio packets in queue, drop the oldest packet");
+            }
+            xEventGroupSetBits(event_group_, SEND_AUDIO_EVENT); });
+    }
+    encode_latency_.Record(esp_timer_get_time() - start_us);
+}
+
+// Server messages keyed by their "type" field. The primary protocol takes all
+// of them; WebSocket sessions only the conversation ones.
+void Application::RegisterJsonHandlers()
+{
+    auto display = Board::GetInstance().GetDisplay();
+    json_handlers_.On("tts", [this](const cJSON* root) {
+        auto state = cJSON_GetObjectItem(root, "state");
+        if (!cJSON_IsString(state)) {
+            ESP_LOGW(TAG, "tts message without a state");
             return;
         }
-        // Resample if the sample rate is different
-        if (opus_decoder_->sample_rate() != codec->output_sample_rate()) {
-            int target_size = output_resampler_.GetOutputSamples(pcm.size());
-            std::vector<int16_t> resampled(target_size);
-            output_resampler_.Process(pcm.data(), pcm.size(), resampled.data());
-            pcm = std::move(resampled);
+        if (strcmp(state->valuestring, "start") == 0) {
+            Schedule([this]() {
+                aborted_ = false;
+                if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
+                    // Save state before TTS to determine if we should resume listening after TTS
+                    state_before_tts_ = device_state_;
+                    
+                    // If we're in LISTENING state, stop listening before TTS starts
+                    // This ensures no microphone audio interference during TTS playback
+                    if (device_state_ == kDeviceStateListening) {
+                        auto* active_protocol = GetActiveProtocol();
+                        if (active_protocol && active_protocol->IsAudioChannelOpened()) {
+                            ESP_LOGI(TAG, "TTS starting while listening - stopping listening before TTS");
+                            active_protocol->SendStopListening();
+                            // Small delay to ensure server receives listen:stop before TTS starts
+                            vTaskDelay(pdMS_TO_TICKS(50));
+                        }
+                    }
+                    
+                    SetDeviceState(kDeviceStateSpeaking);
+                }
+            });
+        } else if (strcmp(state->valuestring, "stop") == 0) {
+            Schedule([this]() {
+                ESP_LOGI(TAG, "TTS stop (primary): state=%d, listening_mode=%d", device_state_, (int)listening_mode_);
+                WaitForAudioIdle();
+                if (device_state_ == kDeviceStateSpeaking) {
+                    // Check if user aborted speaking - don't auto-resume listening
+                    if (aborted_) {
+                        ESP_LOGI(TAG, "TTS stopped after user abort - going to idle without resuming listening");
+                        aborted_ = false;  // Reset flag
+                        state_before_tts_ = kDeviceStateUnknown;  // Reset
+                        SetDeviceState(kDeviceStateIdle);
+                        return;  // Early return, don't continue with auto-resume logic
+                    }
+                    
+                    // Check if remote wakeup scenario (WebSocket still open)
+                    auto* active_protocol = GetActiveProtocol();
+                    bool is_remote_wakeup = (websocket_protocol_ != nullptr && 
+                                            websocket_protocol_->IsAudioChannelOpened() &&
+                                            active_protocol && active_protocol->IsAudioChannelOpened());
+                    
+                    if (is_remote_wakeup) {
+                        // Automatically resume listening after TTS in remote wakeup scenario
+                        if (is_alarm_mode_) {
+                            // Alarm mode: Always start listening after TTS (even if wasn't listening before)
+                            // This is the expected flow: ws_start → TTS → listening
+                            ESP_LOGI(TAG, "TTS stopped, alarm mode - starting listening for user response");
+                            SetDeviceState(kDeviceStateListening);
+                            is_alarm_mode_ = false; // Reset alarm mode after first TTS completes
+                        } else if (state_before_tts_ == kDeviceStateListening) {
+                            // Normal remote wakeup: Only resume if we were listening before TTS started
+                            ESP_LOGI(TAG, "TTS stopped, remote wakeup detected (WebSocket open) - automatically resuming listening");
+                            SetDeviceState(kDeviceStateListening);
+                        } else {
+                            ESP_LOGI(TAG, "TTS stopped, remote wakeup detected but was not listening before TTS - going to idle");
+                            SetDeviceState(kDeviceStateIdle);
+                        }
+                        state_before_tts_ = kDeviceStateUnknown; // Reset
+                    } else if (listening_mode_ == kListeningModeManualStop) {
+                        // Go to idle for manual interactions
+                        ESP_LOGI(TAG, "TTS stopped, going to idle (manual stop mode)");
+                        SetDeviceState(kDeviceStateIdle);
+                        state_before_tts_ = kDeviceStateUnknown; // Reset
+                    } else {
+                        // Auto mode: resume listening
+                        ESP_LOGI(TAG, "TTS stopped, automatically resuming listening (auto stop mode)");
+                        SetDeviceState(kDeviceStateListening);
+                        state_before_tts_ = kDeviceStateUnknown; // Reset
+                    }
+                }
+            });
+        } else if (strcmp(state->valuestring, "sentence_start") == 0) {
+            auto text = cJSON_GetObjectItem(root, "text");
+            if (cJSON_IsString(text)) {
+                ESP_LOGI(TAG, "<< %s", text->valuestring);
+                // DISABLED: Comment out transcript display to reduce memory usage
+                // Schedule([this, display, message = std::string(text->valuestring)]() {
+                //     display->SetChatMessage("assistant", message.c_str());
+                // });
+            }
         }
-        codec->OutputData(pcm);
-#ifdef CONFIG_USE_SERVER_AEC
-        std::lock_guard<std::mutex> lock(timestamp_mutex_);
-        timestamp_queue_.push_back(packet.timestamp);
+    });
+    json_handlers_.On("stt", [](const cJSON* root) {
+        auto text = cJSON_GetObjectItem(root, "text");
+        if (cJSON_IsString(text)) {
+            ESP_LOGI(TAG, ">> %s", text->valuestring);
+            // DISABLED: Comment out transcript display to reduce memory usage
+            // Schedule([this, display, message = std::string(text->valuestring)]() {
+            //     display->SetChatMessage("user", message.c_str());
+            // });
+        }
+    });
+    json_handlers_.On("llm", [this, display](const cJSON* root) {
+        auto emotion = cJSON_GetObjectItem(root, "emotion");
+        if (cJSON_IsString(emotion)) {
+            Schedule([this, display, emotion_str = std::string(emotion->valuestring)]() {
+                display->SetEmotion(emotion_str.c_str());
+            });
+        }
+    });
+#if CONFIG_IOT_PROTOCOL_MCP
+    json_handlers_.On("mcp", [](const cJSON* root) {
+        ESP_LOGI(TAG, "OnIncomingJson: Received MCP message");
+        auto payload = cJSON_GetObjectItem(root, "payload");
+        if (cJSON_IsObject(payload)) {
+            char* payload_str = cJSON_PrintUnformatted(payload);
+            if (payload_str) {
+                ESP_LOGI(TAG, "OnIncomingJson: MCP payload: %s", payload_str);
+                cJSON_free(payload_str);
+            }
+            ESP_LOGI(TAG, "OnIncomingJson: Forwarding MCP payload to McpServer::ParseMessage");
+            McpServer::GetInstance().ParseMessage(payload);
+        } else {
+            ESP_LOGW(TAG, "OnIncomingJson: MCP message missing or invalid payload");
+        }
+    });
+#endif
+#if CONFIG_IOT_PROTOCOL_XIAOZHI
+    json_handlers_.On("iot", [](const cJSON* root) {
+        auto commands = cJSON_GetObjectItem(root, "commands");
+        if (cJSON_IsArray(commands)) {
+            auto& thing_manager = iot::ThingManager::GetInstance();
+            for (int i = 0; i < cJSON_GetArraySize(commands); ++i) {
+                auto command = cJSON_GetArrayItem(commands, i);
+                thing_manager.Invoke(command);
+            }
+        }
+    });
 #endif
-        last_output_time_ = std::chrono::steady_clock::now(); });
+    json_handlers_.On("listen", [this](const cJSON* root) {
+        auto state = cJSON_GetObjectItem(root, "state");
+        if (cJSON_IsString(state)) {
+            if (strcmp(state->valuestring, "start") == 0) {
+                ESP_LOGI(TAG, "Received listen:start from server, starting listening");
+                Schedule([this]() { 
+                    ESP_LOGI(TAG, "Executing listen:start - setting listening mode (AutoStop)");
+                    SetListeningMode(kListeningModeAutoStop); 
+                });
+            } else if (strcmp(state->valuestring, "stop") == 0) {
+                ESP_LOGI(TAG, "Received listen:stop from server, stopping listening");
+                Schedule([this]() { StopListening(); });
+            } else {
+                ESP_LOGW(TAG, "Received listen message with unknown state: %s", state->valuestring);
+            }
+        } else {
+            ESP_LOGW(TAG, "Received listen message without valid state field");
+        }
+    });
+    json_handlers_.On("system", [this](const cJSON* root) {
+        auto command = cJSON_GetObjectItem(root, "command");
+        if (cJSON_IsString(command)) {
+            ESP_LOGI(TAG, "System command: %s", command->valuestring);
+            if (strcmp(command->valuestring, "reboot") == 0) {
+                // Do a reboot if user requests a OTA update
+                Schedule([this]() {
+                    Reboot();
+                });
+            } else {
+                ESP_LOGW(TAG, "Unknown system command: %s", command->valuestring);
+            }
+        }
+    });
+    json_handlers_.On("alert", [this](const cJSON* root) {
+        auto status = cJSON_GetObjectItem(root, "status");
+        auto message = cJSON_GetObjectItem(root, "message");
+        auto emotion = cJSON_GetObjectItem(root, "emotion");
+        if (cJSON_IsString(status) && cJSON_IsString(message) && cJSON_IsString(emotion)) {
+            Alert(status->valuestring, message->valuestring, emotion->valuestring, Lang::Sounds::P3_VIBRATION);
+        } else {
+            ESP_LOGW(TAG, "Alert command requires status, message and emotion");
+        }
+    });
+    json_handlers_.On("play_url", [this](const cJSON* root) {
+        auto url = cJSON_GetObjectItem(root, "url");
+        auto gain = cJSON_GetObjectItem(root, "gain");
+        if (cJSON_IsString(url)) {
+            float g = cJSON_IsNumber(gain) ? (float)gain->valuedouble : 1.0f;
+            // Run playback in background to avoid blocking main loop
+            Schedule([this, url_str = std::string(url->valuestring), g]() {
+                ResetDecoder();
+                if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
+                    SetDeviceState(kDeviceStateSpeaking);
+                }
+                background_task_->Schedule([this, url_str, g]() {
+                    auto finish = [this](bool ok, uint64_t samples) {
+                        (void)samples;
+                        Schedule([this, ok]() {
+                            if (device_state_ == kDeviceStateSpeaking) {
+                                SetDeviceState(kDeviceStateIdle);
+                            }
+                            ESP_LOGI(TAG, "PlayWavFromUrl %s", ok ? "done" : "failed");
+                        });
+                    };
+                    if (!PlayWavFromUrl(*wav_player_, url_str, g, finish)) {
+                        finish(false, 0);
+                    }
+                }, kBackgroundLaneAudio);
+            });
+        } else {
+            ESP_LOGW(TAG, "play_url missing 'url' field");
+        }
+    });
+    json_handlers_.On("adjust_volume", [this](const cJSON* root) {
+        // Handle volume adjustment: accepts "volume" (number) or "message" (number as string)
+        auto volume_item = cJSON_GetObjectItem(root, "volume");
+        int target_volume = -1;
+        
+        if (cJSON_IsNumber(volume_item)) {
+            target_volume = volume_item->valueint;
+        } else {
+            // Fallback to "message" field for compatibility with test script pattern
+            auto message_item = cJSON_GetObjectItem(root, "message");
+            if (cJSON_IsString(message_item)) {
+                // Try to parse message as integer
+                target_volume = atoi(message_item->valuestring);
+            } else if (cJSON_IsNumber(message_item)) {
+                target_volume = message_item->valueint;
+            }
+        }
+        
+        if (target_volume >= 0 && target_volume <= 100) {
+            ESP_LOGI(TAG, "Received adjust_volume command, setting volume to %d", target_volume);
+            Schedule([this, target_volume]() {
+                auto codec = Board::GetInstance().GetAudioCodec();
+                if (codec != nullptr) {
+                    codec->SetOutputVolume(target_volume);
+                    ESP_LOGI(TAG, "Volume adjusted to %d", target_volume);
+                } else {
+                    ESP_LOGW(TAG, "Cannot adjust volume: audio codec not available");
+                }
+            });
+        } else {
+            ESP_LOGW(TAG, "adjust_volume requires volume value between 0-100, got: %d", target_volume);
+        }
+    });
+
+    websocket_json_handlers_.Import(json_handlers_, {"tts", "stt", "llm", "listen", "mcp"});
+    // Other types were always ignored on WebSocket; they still count as unhandled
+    websocket_json_handlers_.OnUnhandled([](const cJSON* root) { return false; });
+}
+
+// Feed the link counters to the rate controller and retune the encoder
+// when it asks for different settings
+void Application::UpdateEncoderRate(int64_t now_us)
+{
+    auto jitter = jitter_buffer_.GetStats();
+    AudioRateController::Observation observation;
+    observation.send_drops = audio_send_queue_.dropped() + encode_worker_->dropped();
+    observation.send_failures = audio_send_failures_.load(std::memory_order_relaxed);
+    observation.send_queue_depth = audio_send_queue_.size();
+    observation.send_queue_limit = MAX_AUDIO_PACKETS_IN_QUEUE;
+    observation.downlink_received = jitter.received;
+    observation.downlink_lost = jitter.lost;
+    observation.jitter_ms = jitter.jitter_ms;
+    if (!rate_controller_.Update(now_us, observation))
+    {
+        return;
+    }
+    auto settings = rate_controller_.settings();
+    opus_encoder_->SetBitrate(settings.bitrate);
+    opus_encoder_->SetInbandFec(settings.fec);
+    opus_encoder_->SetPacketLossPercent(settings.packet_loss_percent);
 }
 
 void Application::OnAudioInput()
@@ -1848,40 +1983,40 @@ void Application::OnAudioInput()
             ExitAudioTestingMode();
             return;
         }
-        std::vector<int16_t> data;
+        auto &data = input_buffer_;
         int samples = OPUS_FRAME_DURATION_MS * 16000 / 1000;
         if (ReadAudio(data, 16000, samples))
         {
             // For audio testing, extract mono (mic channel) from 2-channel input
             // This matches the official firmware behavior and ensures clear audio quality
             auto codec = Board::GetInstance().GetAudioCodec();
+            PcmFrame frame;
             if (codec->input_channels() == 2)
             {
                 // Extract left channel (mic) only for mono encoding
-                auto mono_data = std::vector<int16_t>(data.size() / 2);
-                for (size_t i = 0, j = 0; i < mono_data.size(); ++i, j += 2)
+                frame.resize(data.size() / 2);
+                for (size_t i = 0, j = 0; i < frame.size(); ++i, j += 2)
                 {
-                    mono_data[i] = data[j];
+                    frame[i] = data[j];
                 }
-                data = std::move(mono_data);
+            }
+            else
+            {
+                frame.assign(data.data(), data.size());
             }
             
-            background_task_->Schedule([this, data = std::move(data)]() mutable
-                                       { opus_encoder_->Encode(std::move(data), [this](std::vector<uint8_t> &&opus)
-                                                               {
-                    AudioStreamPacket packet;
-                    packet.payload = std::move(opus);
-                    packet.frame_duration = OPUS_FRAME_DURATION_MS;
-                    packet.sample_rate = 16000;
-                    std::lock_guard<std::mutex> lock(mutex_);
-                    audio_testing_queue_.push_back(std::move(packet)); }); });
+            EncodeJob job;
+            job.pcm = std::move(frame);
+            job.testing = true;
+            job.enqueue_us = esp_timer_get_time();
+            encode_worker_->Post(std::move(job));
             return;
         }
     }
 
     if (wake_word_->IsDetectionRunning())
     {
-        std::vector<int16_t> data;
+        auto &data = input_buffer_;
         int samples = wake_word_->GetFeedSize();
         if (samples > 0)
         {
@@ -1895,7 +2030,7 @@ void Application::OnAudioInput()
 
     if (audio_processor_->IsRunning())
     {
-        std::vector<int16_t> data;
+        auto &data = input_buffer_;
         int samples = audio_processor_->GetFeedSize();
         if (samples > 0)
         {
@@ -1927,29 +2062,30 @@ bool Application::ReadAudio(std::vector<int16_t> &data, int sample_rate, int sam
         }
         if (codec->input_channels() == 2)
         {
-            auto mic_channel = std::vector<int16_t>(data.size() / 2);
-            auto reference_channel = std::vector<int16_t>(data.size() / 2);
-            for (size_t i = 0, j = 0; i < mic_channel.size(); ++i, j += 2)
+            // Member scratch buffers keep their capacity, so this does not allocate per frame
+            mic_channel_.resize(data.size() / 2);
+            reference_channel_.resize(data.size() / 2);
+            for (size_t i = 0, j = 0; i < mic_channel_.size(); ++i, j += 2)
             {
-                mic_channel[i] = data[j];
-                reference_channel[i] = data[j + 1];
+                mic_channel_[i] = data[j];
+                reference_channel_[i] = data[j + 1];
             }
-            auto resampled_mic = std::vector<int16_t>(input_resampler_.GetOutputSamples(mic_channel.size()));
-            auto resampled_reference = std::vector<int16_t>(reference_resampler_.GetOutputSamples(reference_channel.size()));
-            input_resampler_.Process(mic_channel.data(), mic_channel.size(), resampled_mic.data());
-            reference_resampler_.Process(reference_channel.data(), reference_channel.size(), resampled_reference.data());
-            data.resize(resampled_mic.size() + resampled_reference.size());
-            for (size_t i = 0, j = 0; i < resampled_mic.size(); ++i, j += 2)
+            resampled_mic_.resize(input_resampler_.GetOutputSamples(mic_channel_.size()));
+            resampled_reference_.resize(reference_resampler_.GetOutputSamples(reference_channel_.size()));
+            input_resampler_.Process(mic_channel_.data(), mic_channel_.size(), resampled_mic_.data());
+            reference_resampler_.Process(reference_channel_.data(), reference_channel_.size(), resampled_reference_.data());
+            data.resize(resampled_mic_.size() + resampled_reference_.size());
+            for (size_t i = 0, j = 0; i < resampled_mic_.size(); ++i, j += 2)
             {
-                data[j] = resampled_mic[i];
-                data[j + 1] = resampled_reference[i];
+                data[j] = resampled_mic_[i];
+                data[j + 1] = resampled_reference_[i];
             }
         }
         else
         {
-            auto resampled = std::vector<int16_t>(input_resampler_.GetOutputSamples(data.size()));
-            input_resampler_.Process(data.data(), data.size(), resampled.data());
-            data = std::move(resampled);
+            resampled_mic_.resize(input_resampler_.GetOutputSamples(data.size()));
+            input_resampler_.Process(data.data(), data.size(), resampled_mic_.data());
+            data.swap(resampled_mic_);
         }
     }
     else
@@ -1992,11 +2128,14 @@ void Application::SetDeviceState(DeviceState state)
     }
 
     clock_ticks_ = 0;
+    clock_minute_ = -1;
     auto previous_state = device_state_;
     device_state_ = state;
     ESP_LOGI(TAG, "STATE: %s", STATE_STRINGS[device_state_]);
-    // The state is changed, wait for all background tasks to finish
-    background_task_->WaitForCompletion();
+    // The Wi-Fi animation depends on the device state
+    animation_refresh();
+    // The state is changed, wait for all background and audio tasks to finish
+    WaitForAudioIdle();
 
     auto &board = Board::GetInstance();
     auto display = board.GetDisplay();
@@ -2016,7 +2155,7 @@ void Application::SetDeviceState(DeviceState state)
         display->SetEmotion("normal");
         // DISABLED: Comment out transcript display to reduce memory usage
         // display->SetChatMessage("system", "");
-        timestamp_queue_.clear();
+        timestamp_queue_.Clear();
         break;
     case kDeviceStateListening:
         display->SetStatus(Lang::Strings::LISTENING);
@@ -2073,8 +2212,7 @@ void Application::SetDeviceState(DeviceState state)
             
             if (previous_state == kDeviceStateSpeaking)
             {
-                audio_decode_queue_.clear();
-                audio_decode_cv_.notify_all();
+                ClearDecodeQueue();
                 // FIXME: Wait for the speaker to empty the buffer
                 vTaskDelay(pdMS_TO_TICKS(120));
             }
@@ -2156,15 +2294,41 @@ void Application::SetDeviceState(DeviceState state)
 
 void Application::ResetDecoder()
 {
-    std::lock_guard<std::mutex> lock(mutex_);
-    opus_decoder_->ResetState();
-    audio_decode_queue_.clear();
-    audio_decode_cv_.notify_all();
+    // The decoder belongs to the decode worker; it resets before the next frame
+    decoder_reset_pending_ = true;
+    ClearDecodeQueue();
     last_output_time_ = std::chrono::steady_clock::now();
     auto codec = Board::GetInstance().GetAudioCodec();
     codec->EnableOutput(true);
 }
 
+// Wait until queued encode / decode frames and background tasks are done
+void Application::WaitForAudioIdle()
+{
+    if (encode_worker_)
+    {
+        encode_worker_->WaitForIdle();
+    }
+    if (decode_worker_)
+    {
+        decode_worker_->WaitForIdle();
+    }
+    if (background_task_ != nullptr)
+    {
+        background_task_->WaitForCompletion();
+    }
+}
+
+// The jitter buffer belongs to the audio loop, so the reset travels through
+// the decode ring as an empty packet, in order with whatever is queued next.
+void Application::ClearDecodeQueue()
+{
+    audio_decode_queue_.Clear();
+    drop_held_packet_.store(true);
+    audio_decode_queue_.TryPush(AudioStreamPacket());
+    audio_decode_cv_.notify_all();
+}
+
 void Application::SetDecodeSampleRate(int sample_rate, int frame_duration)
 {
     if (opus_decoder_->sample_rate() == sample_rate && opus_decoder_->duration_ms() == frame_duration)
@@ -2173,7 +2337,7 @@ void Application::SetDecodeSampleRate(int sample_rate, int frame_duration)
     }
 
     opus_decoder_.reset();
-    opus_decoder_ = std::make_unique<OpusDecoderWrapper>(sample_rate, 1, frame_duration);
+    opus_decoder_ = std::make_unique<OpusFrameDecoder>(sample_rate, 1, frame_duration);
 
     auto codec = Board::GetInstance().GetAudioCodec();
     if (opus_decoder_->sample_rate() != codec->output_sample_rate())
@@ -2186,14 +2350,28 @@ void Application::SetDecodeSampleRate(int sample_rate, int frame_duration)
 void Application::UpdateIotStates()
 {
 #if CONFIG_IOT_PROTOCOL_XIAOZHI
+    SendIotStates(true);
+#endif
+}
+
+#if CONFIG_IOT_PROTOCOL_XIAOZHI
+void Application::SendIotStates(bool delta)
+{
     auto &thing_manager = iot::ThingManager::GetInstance();
     std::string states;
-    if (thing_manager.GetStatesJson(states, true))
+    if (protocol_->server_iot_cbor())
+    {
+        if (thing_manager.GetStatesCbor(states, delta))
+        {
+            protocol_->SendIotStatesCbor(states);
+        }
+    }
+    else if (thing_manager.GetStatesJson(states, delta))
     {
         protocol_->SendIotStates(states);
     }
-#endif
 }
+#endif
 
 void Application::ClearWifiConfiguration()
 {
@@ -2340,9 +2518,9 @@ void Application::OpenWebSocketConnection() {
         });
         
         websocket_protocol_->OnIncomingAudio([this](AudioStreamPacket &&packet) {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (device_state_ == kDeviceStateSpeaking && audio_decode_queue_.size() < MAX_AUDIO_PACKETS_IN_QUEUE) {
-                audio_decode_queue_.emplace_back(std::move(packet));
+            if (device_state_ == kDeviceStateSpeaking && !packet.payload.empty()) {
+                packet.arrival_us = esp_timer_get_time();
+                audio_decode_queue_.Push(std::move(packet), MAX_AUDIO_PACKETS_IN_QUEUE, RingOverflow::kDropNewest);
             }
         });
         
@@ -2352,153 +2530,23 @@ void Application::OpenWebSocketConnection() {
                 ESP_LOGW(TAG, "Server sample rate %d does not match device output sample rate %d, resampling may cause distortion",
                          websocket_protocol_->server_sample_rate(), codec->output_sample_rate());
             }
+            opus_encoder_->SetDtx(websocket_protocol_->server_dtx());
         });
         
         websocket_protocol_->OnAudioChannelClosed([this, &board = Board::GetInstance()]() {
             board.SetPowerSaveMode(true);
+#if CONFIG_IOT_PROTOCOL_MCP
+            McpServer::GetInstance().CancelToolCalls();
+#endif
             Schedule([this]() {
                 is_alarm_mode_ = false; // Reset alarm mode when WebSocket closes
                 SetDeviceState(kDeviceStateIdle);
             });
         });
         
-        // Set up JSON handler - use the same handler as primary protocol
-        auto display = Board::GetInstance().GetDisplay();
-        websocket_protocol_->OnIncomingJson([this, display](const cJSON *root) {
-            // Use the same JSON parsing logic as primary protocol
-            auto type = cJSON_GetObjectItem(root, "type");
-            if (!cJSON_IsString(type)) {
-                return;
-            }
-            
-            if (strcmp(type->valuestring, "tts") == 0) {
-                auto state = cJSON_GetObjectItem(root, "state");
-                if (strcmp(state->valuestring, "start") == 0) {
-                    Schedule([this]() {
-                        aborted_ = false;
-                        if (device_state_ == kDeviceStateIdle || device_state_ == kDeviceStateListening) {
-                            // Save state before TTS to determine if we should resume listening after TTS
-                            state_before_tts_ = device_state_;
-                            
-                            // If we're in LISTENING state, stop listening before TTS starts
-                            // This ensures no microphone audio interference during TTS playback
-                            if (device_state_ == kDeviceStateListening) {
-                                auto* active_protocol = GetActiveProtocol();
-                                if (active_protocol && active_protocol->IsAudioChannelOpened()) {
-                                    ESP_LOGI(TAG, "TTS starting while listening (WebSocket) - stopping listening before TTS");
-                                    active_protocol->SendStopListening();
-                                    // Small delay to ensure server receives listen:stop before TTS starts
-                                    vTaskDelay(pdMS_TO_TICKS(50));
-                                }
-                            }
-                            
-                            SetDeviceState(kDeviceStateSpeaking);
-                        }
-                    });
-                } else if (strcmp(state->valuestring, "stop") == 0) {
-                    Schedule([this]() {
-                        ESP_LOGI(TAG, "TTS stop (WebSocket): state=%d, listening_mode=%d", device_state_, (int)listening_mode_);
-                        background_task_->WaitForCompletion();
-                        if (device_state_ == kDeviceStateSpeaking) {
-                            // Check if user aborted speaking - don't auto-resume listening
-                            if (aborted_) {
-                                ESP_LOGI(TAG, "TTS stopped after user abort (WebSocket) - going to idle without resuming listening");
-                                aborted_ = false;  // Reset flag
-                                state_before_tts_ = kDeviceStateUnknown;  // Reset
-                                SetDeviceState(kDeviceStateIdle);
-                                return;  // Early return, don't continue with auto-resume logic
-                            }
-                            
-                            // Check if remote wakeup scenario (WebSocket still open)
-                            auto* active_protocol = GetActiveProtocol();
-                            bool is_remote_wakeup = (websocket_protocol_ != nullptr && 
-                                                    websocket_protocol_->IsAudioChannelOpened() &&
-                                                    active_protocol && active_protocol->IsAudioChannelOpened());
-                            
-                            if (is_remote_wakeup) {
-                                // Automatically resume listening after TTS in remote wakeup scenario
-                                if (is_alarm_mode_) {
-                                    // Alarm mode: Always start listening after TTS (even if wasn't listening before)
-                                    // This is the expected flow: ws_start → TTS → listening
-                                    ESP_LOGI(TAG, "TTS stopped (WebSocket), alarm mode - starting listening for user response");
-                                    SetDeviceState(kDeviceStateListening);
-                                    is_alarm_mode_ = false; // Reset alarm mode after first TTS completes
-                                } else if (state_before_tts_ == kDeviceStateListening) {
-                                    // Normal remote wakeup: Only resume if we were listening before TTS started
-                                    ESP_LOGI(TAG, "TTS stopped (WebSocket), remote wakeup detected - automatically resuming listening");
-                                    SetDeviceState(kDeviceStateListening);
-                                } else {
-                                    ESP_LOGI(TAG, "TTS stopped (WebSocket), remote wakeup detected but was not listening before TTS - going to idle");
-                                    SetDeviceState(kDeviceStateIdle);
-                                }
-                                state_before_tts_ = kDeviceStateUnknown; // Reset
-                            } else if (listening_mode_ == kListeningModeManualStop) {
-                                // Go to idle for manual interactions
-                                ESP_LOGI(TAG, "TTS stopped (WebSocket), going to idle (manual stop mode)");
-                                SetDeviceState(kDeviceStateIdle);
-                                state_before_tts_ = kDeviceStateUnknown; // Reset
-                            } else {
-                                // Auto mode: resume listening
-                                ESP_LOGI(TAG, "TTS stopped (WebSocket), automatically resuming listening (auto stop mode)");
-                                SetDeviceState(kDeviceStateListening);
-                                state_before_tts_ = kDeviceStateUnknown; // Reset
-                            }
-                        }
-                    });
-                } else if (strcmp(state->valuestring, "sentence_start") == 0) {
-                    auto text = cJSON_GetObjectItem(root, "text");
-                    if (cJSON_IsString(text)) {
-                        ESP_LOGI(TAG, "<< %s", text->valuestring);
-                    }
-                }
-            } else if (strcmp(type->valuestring, "stt") == 0) {
-                auto text = cJSON_GetObjectItem(root, "text");
-                if (cJSON_IsString(text)) {
-                    ESP_LOGI(TAG, ">> %s", text->valuestring);
-                }
-            } else if (strcmp(type->valuestring, "llm") == 0) {
-                auto emotion = cJSON_GetObjectItem(root, "emotion");
-                if (cJSON_IsString(emotion)) {
-                    Schedule([this, display, emotion_str = std::string(emotion->valuestring)]() {
-                        display->SetEmotion(emotion_str.c_str());
-                    });
-                }
-            } else if (strcmp(type->valuestring, "listen") == 0) {
-                auto state = cJSON_GetObjectItem(root, "state");
-                if (cJSON_IsString(state)) {
-                    if (strcmp(state->valuestring, "start") == 0) {
-                        ESP_LOGI(TAG, "Received listen:start from server (WebSocket), starting listening");
-                        Schedule([this]() { 
-                            ESP_LOGI(TAG, "Executing listen:start - setting listening mode (AutoStop)");
-                            SetListeningMode(kListeningModeAutoStop); 
-                        });
-                    } else if (strcmp(state->valuestring, "stop") == 0) {
-                        ESP_LOGI(TAG, "Received listen:stop from server (WebSocket), stopping listening");
-                        Schedule([this]() { StopListening(); });
-                    } else {
-                        ESP_LOGW(TAG, "Received listen message with unknown state: %s", state->valuestring);
-                    }
-                } else {
-                    ESP_LOGW(TAG, "Received listen message without valid state field");
-                }
-#if CONFIG_IOT_PROTOCOL_MCP
-            } else if (strcmp(type->valuestring, "mcp") == 0) {
-                ESP_LOGI(TAG, "OnIncomingJson (WebSocket): Received MCP message");
-                auto payload = cJSON_GetObjectItem(root, "payload");
-                if (cJSON_IsObject(payload)) {
-                    char* payload_str = cJSON_PrintUnformatted(payload);
-                    if (payload_str) {
-                        ESP_LOGI(TAG, "OnIncomingJson (WebSocket): MCP payload: %s", payload_str);
-                        cJSON_free(payload_str);
-                    }
-                    ESP_LOGI(TAG, "OnIncomingJson (WebSocket): Forwarding MCP payload to McpServer::ParseMessage");
-                    McpServer::GetInstance().ParseMessage(payload);
-                } else {
-                    ESP_LOGW(TAG, "OnIncomingJson (WebSocket): MCP message missing or invalid payload");
-                }
-#endif
-            }
-            // Add other message type handlers as needed
+        // Set up JSON handler - the conversation subset of the primary protocol's handlers
+        websocket_protocol_->OnIncomingJson([this](const cJSON *root) {
+            websocket_json_handlers_.Dispatch(root);
         });
         
         // Start the WebSocket protocol
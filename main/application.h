@@ -12,6 +12,7 @@
 #include <vector>
 #include <condition_variable>
 #include <memory>
+#include <atomic>
 
 #include <opus_encoder.h>
 #include <opus_decoder.h>
@@ -23,6 +24,16 @@
 #include "audio_processor.h"
 #include "wake_word.h"
 #include "audio_debugger.h"
+#include "audio_frame_pool.h"
+#include "opus_frame_encoder.h"
+#include "bounded_ring.h"
+#include "opus_frame_decoder.h"
+#include "jitter_buffer.h"
+#include "audio_worker.h"
+#include "latency_histogram.h"
+#include "pcm_stream_player.h"
+#include "audio_rate_controller.h"
+#include "json_dispatcher.h"
 
 #define SCHEDULE_EVENT (1 << 0)
 #define SEND_AUDIO_EVENT (1 << 1)
@@ -52,6 +63,28 @@ enum DeviceState {
 #define OPUS_FRAME_DURATION_MS 60
 #define MAX_AUDIO_PACKETS_IN_QUEUE (2400 / OPUS_FRAME_DURATION_MS)
 #define AUDIO_TESTING_MAX_DURATION_MS 10000
+// Ring sizes (powers of two). The decode ring also has to hold a whole
+// PlaySound() clip or a replayed audio test, so it is larger than the
+// MAX_AUDIO_PACKETS_IN_QUEUE limit applied to network audio.
+#define AUDIO_SEND_RING_SIZE 64
+#define AUDIO_DECODE_RING_SIZE 256
+#define AUDIO_TIMESTAMP_RING_SIZE 8
+// Encode and decode each run on their own task. The decoder queue is kept
+// short on purpose: one frame being written to I2S, one waiting, so that the
+// jitter buffer keeps making the playout decisions.
+#define AUDIO_DECODE_WORKER_DEPTH 2
+#define AUDIO_ENCODE_WORKER_DEPTH 4
+#define AUDIO_DECODE_TASK_PRIORITY 6
+#define AUDIO_ENCODE_TASK_PRIORITY 5
+#if CONFIG_USE_AUDIO_PROCESSOR
+// The audio loop is pinned to core 1; keep playback next to it and move
+// encoding to the other core.
+#define AUDIO_DECODE_TASK_CORE 1
+#define AUDIO_ENCODE_TASK_CORE 0
+#else
+#define AUDIO_DECODE_TASK_CORE tskNO_AFFINITY
+#define AUDIO_ENCODE_TASK_CORE tskNO_AFFINITY
+#endif
 
 class Application {
 public:
@@ -98,7 +131,8 @@ private:
     std::unique_ptr<AudioProcessor> audio_processor_;
     std::unique_ptr<AudioDebugger> audio_debugger_;
     Ota ota_;
-    std::mutex mutex_;
+    std::mutex mutex_;  // audio_testing_queue_ and audio_decode_cv_
+    std::mutex main_tasks_mutex_;
     std::list<std::function<void()>> main_tasks_;
     std::unique_ptr<Protocol> protocol_;  // Primary protocol (MQTT for listening, or WebSocket if configured)
     std::unique_ptr<Protocol> websocket_protocol_;  // WebSocket protocol for conversations
@@ -112,7 +146,6 @@ private:
 
     bool aborted_ = false;
     bool voice_detected_ = false;
-    bool busy_decoding_audio_ = false;
     bool wifi_error_reminder_active_ = false;  // First press shows wifi face, second press exits to normal.
     
     // VAD interrupt debounce state
@@ -120,33 +153,83 @@ private:
     int64_t vad_detected_time_us_ = 0;   // When VAD was first detected during speaking (for debounce)
     bool vad_debounce_active_ = false;    // Whether we're currently in a debounce period
     int clock_ticks_ = 0;
+    int clock_minute_ = -1;     // Minute shown by the idle clock, -1 when the status shows something else
     TaskHandle_t check_new_version_task_handle_ = nullptr;
 
     // Audio encode / decode
     TaskHandle_t audio_loop_task_handle_ = nullptr;
     BackgroundTask* background_task_ = nullptr;
     std::chrono::steady_clock::time_point last_output_time_;
-    std::list<AudioStreamPacket> audio_send_queue_;
-    std::list<AudioStreamPacket> audio_decode_queue_;
+    BoundedRing<AudioStreamPacket, AUDIO_SEND_RING_SIZE> audio_send_queue_;
+    BoundedRing<AudioStreamPacket, AUDIO_DECODE_RING_SIZE> audio_decode_queue_;
     std::condition_variable audio_decode_cv_;
     std::list<AudioStreamPacket> audio_testing_queue_;
 
     // 新增：用于维护音频包的timestamp队列
-    std::list<uint32_t> timestamp_queue_;
-    std::mutex timestamp_mutex_;
-
-    std::unique_ptr<OpusEncoderWrapper> opus_encoder_;
-    std::unique_ptr<OpusDecoderWrapper> opus_decoder_;
+    BoundedRing<uint32_t, AUDIO_TIMESTAMP_RING_SIZE> timestamp_queue_;
+
+    std::unique_ptr<OpusFrameEncoder> opus_encoder_;     // Encode worker; reset while capture is stopped
+    std::unique_ptr<OpusFrameDecoder> opus_decoder_;     // Decode worker only
+    std::atomic<bool> decoder_reset_pending_{false};
+    JitterBuffer jitter_buffer_;    // Audio loop task only
+    AudioStreamPacket held_packet_; // Popped but past the jitter window; audio loop task only
+    std::atomic<bool> has_held_packet_{false};
+    std::atomic<bool> drop_held_packet_{false};     // Set by ClearDecodeQueue()
+    AudioRateController rate_controller_;   // Updated on the encode worker
+    JsonDispatcher json_handlers_;          // Registered once in Start()
+    JsonDispatcher websocket_json_handlers_;    // Subset of json_handlers_ for WebSocket sessions
+    std::atomic<uint32_t> audio_send_failures_{0};
+
+    struct DecodeJob {
+        JitterBuffer::Action action = JitterBuffer::Action::kDecode;
+        AudioStreamPacket packet;
+        int64_t enqueue_us = 0;
+    };
+    struct EncodeJob {
+        PcmFrame pcm;
+        bool testing = false;   // Encoded frames go to audio_testing_queue_
+        int64_t enqueue_us = 0;
+    };
+    std::unique_ptr<AudioWorker<DecodeJob, AUDIO_DECODE_WORKER_DEPTH>> decode_worker_;
+    std::unique_ptr<AudioWorker<EncodeJob, AUDIO_ENCODE_WORKER_DEPTH>> encode_worker_;
+
+    // Per-stage latency, printed through SystemInfo::PrintLatencyHistograms()
+    LatencyHistogram decode_queue_latency_;     // Jitter buffer pop -> decoder start
+    LatencyHistogram decode_latency_;           // Opus decode + resample
+    LatencyHistogram i2s_write_latency_;        // codec->OutputData()
+    LatencyHistogram playout_latency_;          // Jitter buffer pop -> I2S write done
+    LatencyHistogram encode_queue_latency_;     // AFE output -> encoder start
+    LatencyHistogram encode_latency_;           // Opus encode
+    LatencyHistogram wake_first_byte_latency_;  // Wake word detected -> first pre-roll packet sent
+
+    std::unique_ptr<PcmStreamPlayer> wav_player_;   // startup.wav and play_url
 
     OpusResampler input_resampler_;
     OpusResampler reference_resampler_;
     OpusResampler output_resampler_;
 
+    // Scratch buffers owned by the audio loop task; reused for every frame
+    std::vector<int16_t> input_buffer_;
+    std::vector<int16_t> mic_channel_;
+    std::vector<int16_t> reference_channel_;
+    std::vector<int16_t> resampled_mic_;
+    std::vector<int16_t> resampled_reference_;
+
     void MainEventLoop();
     void OnAudioInput();
     void OnAudioOutput();
     bool ReadAudio(std::vector<int16_t>& data, int sample_rate, int samples);
     void ResetDecoder();
+    void ClearDecodeQueue();
+    void WaitForAudioIdle();
+    void DecodeFrame(DecodeJob& job);
+    void EncodeFrame(EncodeJob& job);
+    void UpdateEncoderRate(int64_t now_us);
+    void RegisterJsonHandlers();
+#if CONFIG_IOT_PROTOCOL_XIAOZHI
+    // Full states, or only what changed since the last call
+    void SendIotStates(bool delta);
+#endif
     void SetDecodeSampleRate(int sample_rate, int frame_duration);
     void CheckNewVersion();
     void ShowActivationCode();
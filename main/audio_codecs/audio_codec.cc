@@ -52,6 +52,14 @@ void AudioCodec::SetOutputVolume(int volume) {
     
     // Check volume and lock/unlock silence animation
     animation_check_volume_and_lock(volume);
+
+    if (on_output_volume_change_) {
+        on_output_volume_change_(volume);
+    }
+}
+
+void AudioCodec::OnOutputVolumeChange(std::function<void(int volume)> callback) {
+    on_output_volume_change_ = callback;
 }
 
 void AudioCodec::EnableInput(bool enable) {
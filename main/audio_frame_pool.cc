@@ -0,0 +1,94 @@
+#include "audio_frame_pool.h"
+#include "application.h"
+
+#include <esp_log.h>
+
+#define TAG "AudioFramePool"
+
+// Every packet that can sit in the send or decode queue or the jitter buffer,
+// plus frames in flight between the audio loop, the AFE task and the
+// encode / decode workers.
+#define OPUS_FRAME_SLOTS (MAX_AUDIO_PACKETS_IN_QUEUE + JITTER_BUFFER_SLOTS + 8)
+// 60 ms at 16 kHz is typically 100-250 bytes; larger packets grow a slot once.
+#define OPUS_FRAME_BYTES 512
+#define PCM_FRAME_SLOTS 8
+// One decoded frame resampled to 48 kHz, also enough for stereo 16 kHz input.
+#define PCM_FRAME_SAMPLES (48000 * OPUS_FRAME_DURATION_MS / 1000)
+
+template <typename T>
+AudioBufferPool<T>::AudioBufferPool(size_t slots, size_t slot_capacity)
+    : slots_(slots), slot_capacity_(slot_capacity) {
+    free_.reserve(slots);
+    for (size_t i = 0; i < slots; i++) {
+        std::vector<T> buffer;
+        buffer.reserve(slot_capacity);
+        free_.push_back(std::move(buffer));
+    }
+}
+
+template <typename T>
+std::vector<T> AudioBufferPool<T>::Take() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        acquired_++;
+        in_use_++;
+        if (in_use_ > max_in_use_) {
+            max_in_use_ = in_use_;
+        }
+        if (!free_.empty()) {
+            std::vector<T> buffer = std::move(free_.back());
+            free_.pop_back();
+            return buffer;
+        }
+    }
+
+    CountHeapAllocation();
+    std::vector<T> buffer;
+    buffer.reserve(slot_capacity_);
+    return buffer;
+}
+
+template <typename T>
+void AudioBufferPool<T>::Give(std::vector<T>&& buffer) {
+    buffer.clear();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (in_use_ > 0) {
+        in_use_--;
+    }
+    // Keep the pool at its fixed size; extra or undersized buffers are freed.
+    if (free_.size() < slots_ && buffer.capacity() >= slot_capacity_) {
+        free_.push_back(std::move(buffer));
+    }
+}
+
+template <typename T>
+typename AudioBufferPool<T>::Stats AudioBufferPool<T>::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return {acquired_, heap_allocations_.load(std::memory_order_relaxed), in_use_, max_in_use_,
+            slots_, slot_capacity_};
+}
+
+template class AudioBufferPool<uint8_t>;
+template class AudioBufferPool<int16_t>;
+
+AudioFramePool::AudioFramePool()
+    : opus_(OPUS_FRAME_SLOTS, OPUS_FRAME_BYTES),
+      pcm_(PCM_FRAME_SLOTS, PCM_FRAME_SAMPLES) {
+    ESP_LOGI(TAG, "Reserved %d Opus frames x %d bytes, %d PCM frames x %d samples",
+             OPUS_FRAME_SLOTS, OPUS_FRAME_BYTES, PCM_FRAME_SLOTS, PCM_FRAME_SAMPLES);
+}
+
+uint32_t AudioFramePool::heap_allocations() {
+    return opus_.GetStats().heap_allocations + pcm_.GetStats().heap_allocations;
+}
+
+void AudioFramePool::PrintStats() {
+    auto opus = opus_.GetStats();
+    auto pcm = pcm_.GetStats();
+    ESP_LOGI(TAG, "opus: %u acquired, %u/%u in use (max %u), %u heap allocs; "
+             "pcm: %u acquired, %u/%u in use (max %u), %u heap allocs",
+             (unsigned)opus.acquired, (unsigned)opus.in_use, (unsigned)opus.slots, (unsigned)opus.max_in_use,
+             (unsigned)opus.heap_allocations,
+             (unsigned)pcm.acquired, (unsigned)pcm.in_use, (unsigned)pcm.slots, (unsigned)pcm.max_in_use,
+             (unsigned)pcm.heap_allocations);
+}
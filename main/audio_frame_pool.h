@@ -0,0 +1,180 @@
+#ifndef AUDIO_FRAME_POOL_H
+#define AUDIO_FRAME_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+/**
+ * @brief Fixed set of preallocated buffers of one element type
+ *
+ * Buffers are reserved once at startup and handed out and taken back for
+ * every audio frame, so streaming does not touch the heap. A Take() on an
+ * empty pool and a resize past a buffer's capacity still work, but fall back
+ * to the heap and are counted in heap_allocations.
+ */
+template <typename T>
+class AudioBufferPool {
+public:
+    struct Stats {
+        uint32_t acquired;
+        uint32_t heap_allocations;
+        uint32_t in_use;
+        uint32_t max_in_use;
+        size_t slots;
+        size_t slot_capacity;
+    };
+
+    AudioBufferPool(size_t slots, size_t slot_capacity);
+
+    AudioBufferPool(const AudioBufferPool&) = delete;
+    AudioBufferPool& operator=(const AudioBufferPool&) = delete;
+
+    std::vector<T> Take();
+    void Give(std::vector<T>&& buffer);
+    void CountHeapAllocation() { heap_allocations_.fetch_add(1, std::memory_order_relaxed); }
+
+    Stats GetStats();
+
+private:
+    std::mutex mutex_;
+    std::vector<std::vector<T>> free_;  // Reserved to slots_, never reallocates
+    size_t slots_;
+    size_t slot_capacity_;
+    uint32_t acquired_ = 0;
+    uint32_t in_use_ = 0;
+    uint32_t max_in_use_ = 0;
+    std::atomic<uint32_t> heap_allocations_{0};
+};
+
+class AudioFramePool {
+public:
+    static AudioFramePool& GetInstance() {
+        static AudioFramePool instance;
+        return instance;
+    }
+
+    AudioFramePool(const AudioFramePool&) = delete;
+    AudioFramePool& operator=(const AudioFramePool&) = delete;
+
+    AudioBufferPool<uint8_t>& opus() { return opus_; }
+    AudioBufferPool<int16_t>& pcm() { return pcm_; }
+
+    template <typename T>
+    AudioBufferPool<T>& For();
+
+    // Total fallbacks to the heap since boot; stays flat while streaming
+    // once every buffer has reached its working size.
+    uint32_t heap_allocations();
+    void PrintStats();
+
+private:
+    AudioFramePool();
+    ~AudioFramePool() = default;
+
+    AudioBufferPool<uint8_t> opus_;
+    AudioBufferPool<int16_t> pcm_;
+};
+
+template <>
+inline AudioBufferPool<uint8_t>& AudioFramePool::For<uint8_t>() { return opus_; }
+
+template <>
+inline AudioBufferPool<int16_t>& AudioFramePool::For<int16_t>() { return pcm_; }
+
+/**
+ * @brief RAII handle to a pooled audio buffer
+ *
+ * The buffer is taken from the pool on first use (resize, assign or
+ * vector()) and given back when the handle is destroyed or overwritten.
+ * Moving a handle moves the buffer; copying takes a second buffer from the
+ * pool, which only exists so handles can sit in std::function captures.
+ */
+template <typename T>
+class PooledBuffer {
+public:
+    PooledBuffer() = default;
+    ~PooledBuffer() { Release(); }
+
+    PooledBuffer(PooledBuffer&& other) noexcept : buffer_(std::move(other.buffer_)) {
+        other.buffer_ = std::vector<T>();
+    }
+
+    PooledBuffer& operator=(PooledBuffer&& other) noexcept {
+        if (this != &other) {
+            Release();
+            buffer_ = std::move(other.buffer_);
+            other.buffer_ = std::vector<T>();
+        }
+        return *this;
+    }
+
+    PooledBuffer(const PooledBuffer& other) {
+        assign(other.data(), other.size());
+    }
+
+    PooledBuffer& operator=(const PooledBuffer& other) {
+        if (this != &other) {
+            assign(other.data(), other.size());
+        }
+        return *this;
+    }
+
+    T* data() { return buffer_.data(); }
+    const T* data() const { return buffer_.data(); }
+    size_t size() const { return buffer_.size(); }
+    bool empty() const { return buffer_.empty(); }
+    T& operator[](size_t index) { return buffer_[index]; }
+    const T& operator[](size_t index) const { return buffer_[index]; }
+
+    void resize(size_t count) {
+        Acquire();
+        if (count > buffer_.capacity()) {
+            AudioFramePool::GetInstance().For<T>().CountHeapAllocation();
+        }
+        buffer_.resize(count);
+    }
+
+    void assign(const T* source, size_t count) {
+        resize(count);
+        if (count > 0) {
+            memcpy(buffer_.data(), source, count * sizeof(T));
+        }
+    }
+
+    void clear() { buffer_.clear(); }
+
+    /**
+     * @brief The underlying vector, for APIs that take std::vector
+     *
+     * Callers must not shrink_to_fit() or swap out the storage; growing it
+     * is allowed but bypasses the heap allocation counter.
+     */
+    std::vector<T>& vector() {
+        Acquire();
+        return buffer_;
+    }
+
+private:
+    std::vector<T> buffer_;
+
+    void Acquire() {
+        if (buffer_.capacity() == 0) {
+            buffer_ = AudioFramePool::GetInstance().For<T>().Take();
+        }
+    }
+
+    void Release() {
+        if (buffer_.capacity() > 0) {
+            AudioFramePool::GetInstance().For<T>().Give(std::move(buffer_));
+        }
+    }
+};
+
+using OpusFrame = PooledBuffer<uint8_t>;
+using PcmFrame = PooledBuffer<int16_t>;
+
+#endif // AUDIO_FRAME_POOL_H
@@ -101,7 +101,7 @@ bool AfeAudioProcessor::IsRunning() {
     return xEventGroupGetBits(event_group_) & PROCESSOR_RUNNING;
 }
 
-void AfeAudioProcessor::OnOutput(std::function<void(std::vector<int16_t>&& data)> callback) {
+void AfeAudioProcessor::OnOutput(std::function<void(PcmFrame&& data)> callback) {
     output_callback_ = callback;
 }
 
@@ -141,7 +141,9 @@ void AfeAudioProcessor::AudioProcessorTask() {
         }
 
         if (output_callback_) {
-            output_callback_(std::vector<int16_t>(res->data, res->data + res->data_size / sizeof(int16_t)));
+            PcmFrame frame;
+            frame.assign(res->data, res->data_size / sizeof(int16_t));
+            output_callback_(std::move(frame));
         }
     }
 }
@@ -11,9 +11,7 @@
 #define TAG "AfeWakeWord"
 
 AfeWakeWord::AfeWakeWord()
-    : afe_data_(nullptr),
-      wake_word_pcm_(),
-      wake_word_opus_() {
+    : afe_data_(nullptr) {
 
     event_group_ = xEventGroupCreate();
 }
@@ -23,10 +21,6 @@ AfeWakeWord::~AfeWakeWord() {
         afe_iface_->destroy(afe_data_);
     }
 
-    if (wake_word_encode_task_stack_ != nullptr) {
-        heap_caps_free(wake_word_encode_task_stack_);
-    }
-
     vEventGroupDelete(event_group_);
 }
 
@@ -70,6 +64,9 @@ void AfeWakeWord::Initialize(AudioCodec* codec) {
     afe_iface_ = esp_afe_handle_from_config(afe_config);
     afe_data_ = afe_iface_->create_from_config(afe_config);
 
+    // AFE output is 16 kHz mono
+    preroll_ = std::make_unique<WakeWordPreroll>(16000, OPUS_FRAME_DURATION_MS);
+
     xTaskCreate([](void* arg) {
         auto this_ = (AfeWakeWord*)arg;
         this_->AudioDetectionTask();
@@ -82,6 +79,9 @@ void AfeWakeWord::OnWakeWordDetected(std::function<void(const std::string& wake_
 }
 
 void AfeWakeWord::StartDetection() {
+    if (preroll_) {
+        preroll_->Reset();
+    }
     xEventGroupSetBits(event_group_, DETECTION_RUNNING_EVENT);
     ESP_LOGI(TAG, "Wake word detection STARTED - waiting for audio input");
 }
@@ -146,54 +146,26 @@ void AfeWakeWord::AudioDetectionTask() {
 }
 
 void AfeWakeWord::StoreWakeWordData(const int16_t* data, size_t samples) {
-    // store audio data to wake_word_pcm_
-    wake_word_pcm_.emplace_back(std::vector<int16_t>(data, data + samples));
-    // keep about 2 seconds of data, detect duration is 30ms (sample_rate == 16000, chunksize == 512)
-    while (wake_word_pcm_.size() > 2000 / 30) {
-        wake_word_pcm_.pop_front();
+    // Encoded in the background so the pre-roll is ready the moment the wake word fires
+    if (preroll_) {
+        preroll_->Write(data, samples);
     }
 }
 
 void AfeWakeWord::EncodeWakeWordData() {
-    wake_word_opus_.clear();
-    if (wake_word_encode_task_stack_ == nullptr) {
-        wake_word_encode_task_stack_ = (StackType_t*)heap_caps_malloc(4096 * 8, MALLOC_CAP_SPIRAM);
+    if (!preroll_) {
+        return;
     }
-    wake_word_encode_task_ = xTaskCreateStatic([](void* arg) {
-        auto this_ = (AfeWakeWord*)arg;
-        {
-            auto start_time = esp_timer_get_time();
-            auto encoder = std::make_unique<OpusEncoderWrapper>(16000, 1, OPUS_FRAME_DURATION_MS);
-            encoder->SetComplexity(0); // 0 is the fastest
-
-            int packets = 0;
-            for (auto& pcm: this_->wake_word_pcm_) {
-                encoder->Encode(std::move(pcm), [this_](std::vector<uint8_t>&& opus) {
-                    std::lock_guard<std::mutex> lock(this_->wake_word_mutex_);
-                    this_->wake_word_opus_.emplace_back(std::move(opus));
-                    this_->wake_word_cv_.notify_all();
-                });
-                packets++;
-            }
-            this_->wake_word_pcm_.clear();
-
-            auto end_time = esp_timer_get_time();
-            ESP_LOGI(TAG, "Encode wake word opus %d packets in %ld ms", packets, (long)((end_time - start_time) / 1000));
-
-            std::lock_guard<std::mutex> lock(this_->wake_word_mutex_);
-            this_->wake_word_opus_.push_back(std::vector<uint8_t>());
-            this_->wake_word_cv_.notify_all();
-        }
-        vTaskDelete(NULL);
-    }, "encode_detect_packets", 4096 * 8, this, 2, wake_word_encode_task_stack_, &wake_word_encode_task_buffer_);
+    // Only the last partial frame is still being encoded
+    preroll_->Seal();
+    auto stats = preroll_->GetStats();
+    ESP_LOGI(TAG, "Wake word pre-roll sealed (%lu packets encoded, %lu overruns, %lu oversized)",
+             (unsigned long)stats.encoded, (unsigned long)stats.overruns, (unsigned long)stats.oversized);
 }
 
 bool AfeWakeWord::GetWakeWordOpus(std::vector<uint8_t>& opus) {
-    std::unique_lock<std::mutex> lock(wake_word_mutex_);
-    wake_word_cv_.wait(lock, [this]() {
-        return !wake_word_opus_.empty();
-    });
-    opus.swap(wake_word_opus_.front());
-    wake_word_opus_.pop_front();
-    return !opus.empty();
+    if (!preroll_) {
+        return false;
+    }
+    return preroll_->Read(opus);
 }
@@ -12,7 +12,9 @@ void NoAudioProcessor::Feed(const std::vector<int16_t>& data) {
         return;
     }
     // 直接将输入数据传递给输出回调
-    output_callback_(std::vector<int16_t>(data));
+    PcmFrame frame;
+    frame.assign(data.data(), data.size());
+    output_callback_(std::move(frame));
 }
 
 void NoAudioProcessor::Start() {
@@ -27,7 +29,7 @@ bool NoAudioProcessor::IsRunning() {
     return is_running_;
 }
 
-void NoAudioProcessor::OnOutput(std::function<void(std::vector<int16_t>&& data)> callback) {
+void NoAudioProcessor::OnOutput(std::function<void(PcmFrame&& data)> callback) {
     output_callback_ = callback;
 }
 
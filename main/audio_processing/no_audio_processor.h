@@ -17,14 +17,14 @@ public:
     void Start() override;
     void Stop() override;
     bool IsRunning() override;
-    void OnOutput(std::function<void(std::vector<int16_t>&& data)> callback) override;
+    void OnOutput(std::function<void(PcmFrame&& data)> callback) override;
     void OnVadStateChange(std::function<void(bool speaking)> callback) override;
     size_t GetFeedSize() override;
     void EnableDeviceAec(bool enable) override;
 
 private:
     AudioCodec* codec_ = nullptr;
-    std::function<void(std::vector<int16_t>&& data)> output_callback_;
+    std::function<void(PcmFrame&& data)> output_callback_;
     std::function<void(bool speaking)> vad_state_change_callback_;
     bool is_running_ = false;
 };
@@ -0,0 +1,167 @@
+#include "wake_word_preroll.h"
+
+#include <esp_heap_caps.h>
+#include <esp_log.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define TAG "WakeWordPreroll"
+
+WakeWordPreroll::WakeWordPreroll(int sample_rate, int frame_duration_ms) {
+    encoder_ = std::make_unique<OpusFrameEncoder>(sample_rate, 1, frame_duration_ms);
+    encoder_->SetComplexity(0); // 0 is the fastest
+
+    frame_samples_ = sample_rate / 1000 * frame_duration_ms;
+    frame_.resize(frame_samples_);
+    pcm_capacity_ = frame_samples_ * WAKE_WORD_PREROLL_PCM_FRAMES;
+    pcm_ = (int16_t*)heap_caps_malloc(pcm_capacity_ * sizeof(int16_t), MALLOC_CAP_SPIRAM);
+
+    packet_slots_ = WAKE_WORD_PREROLL_MS / frame_duration_ms;
+    packet_sizes_.resize(packet_slots_);
+    packets_ = (uint8_t*)heap_caps_malloc(packet_slots_ * WAKE_WORD_PREROLL_PACKET_BYTES, MALLOC_CAP_SPIRAM);
+
+    task_stack_ = (StackType_t*)heap_caps_malloc(WAKE_WORD_PREROLL_STACK_SIZE, MALLOC_CAP_SPIRAM);
+    if (pcm_ == nullptr || packets_ == nullptr || task_stack_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to allocate pre-roll buffers");
+        return;
+    }
+    task_ = xTaskCreateStatic([](void* arg) {
+        ((WakeWordPreroll*)arg)->EncoderTask();
+    }, "wake_preroll", WAKE_WORD_PREROLL_STACK_SIZE, this, 2, task_stack_, &task_buffer_);
+    ESP_LOGI(TAG, "Keeping %d ms of pre-encoded audio in %u packets", WAKE_WORD_PREROLL_MS, (unsigned)packet_slots_);
+}
+
+WakeWordPreroll::~WakeWordPreroll() {
+    if (task_ != nullptr) {
+        vTaskDelete(task_);
+    }
+    heap_caps_free(task_stack_);
+    heap_caps_free(packets_);
+    heap_caps_free(pcm_);
+}
+
+void WakeWordPreroll::Write(const int16_t* data, size_t samples) {
+    if (task_ == nullptr || seal_requested_.load(std::memory_order_acquire)) {
+        return;
+    }
+    size_t head = pcm_head_.load(std::memory_order_relaxed);
+    size_t tail = pcm_tail_.load(std::memory_order_acquire);
+    if (pcm_capacity_ - (head - tail) < samples) {
+        overruns_.fetch_add(1, std::memory_order_relaxed);
+        xTaskNotifyGive(task_);
+        return;
+    }
+
+    size_t offset = head % pcm_capacity_;
+    size_t first = std::min(samples, pcm_capacity_ - offset);
+    memcpy(pcm_ + offset, data, first * sizeof(int16_t));
+    memcpy(pcm_, data + first, (samples - first) * sizeof(int16_t));
+    pcm_head_.store(head + samples, std::memory_order_release);
+
+    if (head + samples - tail >= frame_samples_) {
+        xTaskNotifyGive(task_);
+    }
+}
+
+void WakeWordPreroll::Seal() {
+    seal_requested_.store(true, std::memory_order_release);
+    if (task_ != nullptr) {
+        xTaskNotifyGive(task_);
+    }
+}
+
+bool WakeWordPreroll::Read(std::vector<uint8_t>& opus) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (task_ == nullptr || !seal_requested_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    cv_.wait(lock, [this]() {
+        return packet_count_ > 0 || sealed_;
+    });
+    if (packet_count_ == 0) {
+        return false;
+    }
+    const uint8_t* slot = packets_ + packet_first_ * WAKE_WORD_PREROLL_PACKET_BYTES;
+    opus.assign(slot, slot + packet_sizes_[packet_first_]);
+    packet_first_ = (packet_first_ + 1) % packet_slots_;
+    packet_count_--;
+    return true;
+}
+
+void WakeWordPreroll::Reset() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        packet_first_ = 0;
+        packet_count_ = 0;
+        sealed_ = false;
+        seal_requested_.store(false, std::memory_order_release);
+    }
+    reset_requested_.store(true, std::memory_order_release);
+    if (task_ != nullptr) {
+        xTaskNotifyGive(task_);
+    }
+}
+
+WakeWordPreroll::Stats WakeWordPreroll::GetStats() const {
+    Stats stats;
+    stats.encoded = encoded_.load(std::memory_order_relaxed);
+    stats.overruns = overruns_.load(std::memory_order_relaxed);
+    stats.oversized = oversized_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+void WakeWordPreroll::StorePacket(const uint8_t* data, size_t size) {
+    if (size > WAKE_WORD_PREROLL_PACKET_BYTES) {
+        oversized_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (packet_count_ == packet_slots_) {
+        // Overwrite the oldest packet
+        packet_first_ = (packet_first_ + 1) % packet_slots_;
+        packet_count_--;
+    }
+    size_t index = (packet_first_ + packet_count_) % packet_slots_;
+    memcpy(packets_ + index * WAKE_WORD_PREROLL_PACKET_BYTES, data, size);
+    packet_sizes_[index] = size;
+    packet_count_++;
+    cv_.notify_all();
+}
+
+void WakeWordPreroll::EncoderTask() {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        if (reset_requested_.exchange(false, std::memory_order_acq_rel)) {
+            // The next packet starts a new stream for the decoder
+            encoder_->ResetState();
+        }
+
+        size_t tail = pcm_tail_.load(std::memory_order_relaxed);
+        while (pcm_head_.load(std::memory_order_acquire) - tail >= frame_samples_) {
+            size_t offset = tail % pcm_capacity_;
+            size_t first = std::min(frame_samples_, pcm_capacity_ - offset);
+            memcpy(frame_.data(), pcm_ + offset, first * sizeof(int16_t));
+            memcpy(frame_.data() + first, pcm_, (frame_samples_ - first) * sizeof(int16_t));
+            tail += frame_samples_;
+            pcm_tail_.store(tail, std::memory_order_release);
+
+            encoder_->Encode(frame_.data(), frame_.size(), [this](OpusFrame&& opus) {
+                StorePacket(opus.data(), opus.size());
+                encoded_.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+
+        if (seal_requested_.load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // Re-checked under the lock so a concurrent Reset() wins
+            if (seal_requested_.load(std::memory_order_relaxed) && !sealed_) {
+                sealed_ = true;
+                // What is left is less than a frame
+                pcm_tail_.store(pcm_head_.load(std::memory_order_acquire), std::memory_order_release);
+                cv_.notify_all();
+            }
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#ifndef WAKE_WORD_PREROLL_H
+#define WAKE_WORD_PREROLL_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "opus_frame_encoder.h"
+
+// Audio kept from before the wake word, sent to the server for speaker recognition
+#define WAKE_WORD_PREROLL_MS 2000
+// PCM staged between the detection task and the encoder
+#define WAKE_WORD_PREROLL_PCM_FRAMES 4
+#define WAKE_WORD_PREROLL_PACKET_BYTES 512
+#define WAKE_WORD_PREROLL_STACK_SIZE (4096 * 8)
+
+/**
+ * @brief Rolling Opus-encoded copy of the last WAKE_WORD_PREROLL_MS of audio
+ *
+ * The detection task writes AFE output into a fixed PCM ring; a low priority
+ * task encodes it at complexity 0 as it arrives and keeps the newest packets
+ * in fixed slots, overwriting the oldest. When the wake word fires, Seal()
+ * only has to encode the last partial ring, so the packets can be streamed
+ * right away. Nothing is allocated after construction.
+ */
+class WakeWordPreroll {
+public:
+    struct Stats {
+        uint32_t encoded;
+        uint32_t overruns;      // PCM writes dropped because the encoder fell behind
+        uint32_t oversized;     // Packets larger than a slot, dropped
+    };
+
+    WakeWordPreroll(int sample_rate, int frame_duration_ms);
+    ~WakeWordPreroll();
+
+    WakeWordPreroll(const WakeWordPreroll&) = delete;
+    WakeWordPreroll& operator=(const WakeWordPreroll&) = delete;
+
+    // Called from the detection task; never blocks
+    void Write(const int16_t* data, size_t samples);
+    // Stop taking audio and finish encoding what was written
+    void Seal();
+    // Oldest packet of the sealed pre-roll; blocks until it is encoded,
+    // returns false once everything has been read
+    bool Read(std::vector<uint8_t>& opus);
+    // Drop the pre-roll and start collecting again
+    void Reset();
+
+    Stats GetStats() const;
+
+private:
+    std::unique_ptr<OpusFrameEncoder> encoder_;
+    size_t frame_samples_;
+
+    // Single producer (detection task), single consumer (encoder task)
+    int16_t* pcm_ = nullptr;
+    size_t pcm_capacity_;
+    std::atomic<size_t> pcm_head_{0};
+    std::atomic<size_t> pcm_tail_{0};
+    std::vector<int16_t> frame_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    uint8_t* packets_ = nullptr;     // packet_slots_ x WAKE_WORD_PREROLL_PACKET_BYTES, in PSRAM
+    std::vector<uint16_t> packet_sizes_;
+    size_t packet_slots_;
+    size_t packet_first_ = 0;
+    size_t packet_count_ = 0;
+    bool sealed_ = false;
+
+    std::atomic<bool> seal_requested_{false};
+    std::atomic<bool> reset_requested_{false};
+    std::atomic<uint32_t> encoded_{0};
+    std::atomic<uint32_t> overruns_{0};
+    std::atomic<uint32_t> oversized_{0};
+
+    TaskHandle_t task_ = nullptr;
+    StaticTask_t task_buffer_;
+    StackType_t* task_stack_ = nullptr;
+
+    void EncoderTask();
+    void StorePacket(const uint8_t* data, size_t size);
+};
+
+#endif // WAKE_WORD_PREROLL_H
@@ -0,0 +1,97 @@
+#include "audio_rate_controller.h"
+
+#include <esp_log.h>
+
+#include <algorithm>
+
+#define TAG "AudioRateController"
+
+// 16 kHz mono speech. The top step is close to what Opus picks on its own
+// for 60 ms wideband frames; the bottom one is still intelligible.
+static const int kBitrateLadder[] = {16000, 14000, 12000, 10000, 8000};
+static const int kLadderSize = sizeof(kBitrateLadder) / sizeof(kBitrateLadder[0]);
+
+// Downlink jitter beyond this is treated like congestion
+#define RATE_CONTROL_JITTER_LIMIT_MS 120
+#define RATE_CONTROL_MAX_LOSS_PERCENT 30
+
+AudioRateController::AudioRateController() : bitrate_(kBitrateLadder[0]) {
+}
+
+AudioRateController::Settings AudioRateController::settings() const {
+    Settings settings;
+    settings.bitrate = bitrate_.load(std::memory_order_relaxed);
+    settings.fec = fec_.load(std::memory_order_relaxed);
+    settings.packet_loss_percent = packet_loss_percent_.load(std::memory_order_relaxed);
+    return settings;
+}
+
+bool AudioRateController::Update(int64_t now_us, const Observation& observation) {
+    if (!started_) {
+        started_ = true;
+        window_start_us_ = now_us;
+        last_ = observation;
+        return false;
+    }
+    if (now_us - window_start_us_ < RATE_CONTROL_INTERVAL_MS * 1000LL) {
+        return false;
+    }
+    window_start_us_ = now_us;
+
+    uint32_t drops = observation.send_drops - last_.send_drops;
+    uint32_t failures = observation.send_failures - last_.send_failures;
+    uint32_t received = observation.downlink_received - last_.downlink_received;
+    uint32_t lost = observation.downlink_lost - last_.downlink_lost;
+    last_ = observation;
+
+    // Only windows with downlink traffic say anything about loss
+    if (received + lost > 0) {
+        uint32_t window_loss = std::min<uint32_t>(lost * 100 / (received + lost), 100);
+        // EMA with alpha = 1/4
+        loss_q4_ += ((int32_t)(window_loss << 4) - loss_q4_) / 4;
+    }
+    uint32_t loss = (uint32_t)(loss_q4_ + 8) >> 4;
+    loss_percent_.store(loss, std::memory_order_relaxed);
+
+    bool congested = drops > 0 || failures > 0 ||
+                     observation.send_queue_depth * 2 > observation.send_queue_limit;
+    bool jittery = observation.jitter_ms > RATE_CONTROL_JITTER_LIMIT_MS;
+
+    int level = level_;
+    if (congested) {
+        // Multiplicative decrease: halve the remaining distance to the bottom
+        level = std::min(kLadderSize - 1, level + std::max(1, (kLadderSize - level) / 2));
+        clean_windows_ = 0;
+    } else if (jittery || loss >= 10) {
+        level = std::min(kLadderSize - 1, level + 1);
+        clean_windows_ = 0;
+    } else if (++clean_windows_ >= RATE_CONTROL_PROBE_WINDOWS) {
+        level = std::max(0, level - 1);
+        clean_windows_ = 0;
+    }
+
+    bool fec = fec_.load(std::memory_order_relaxed);
+    if (loss >= 1) {
+        fec = true;
+        loss_free_windows_ = 0;
+    } else if (fec && ++loss_free_windows_ >= RATE_CONTROL_FEC_HOLD_WINDOWS) {
+        fec = false;
+    }
+    int packet_loss_percent = fec ? std::min<int>(std::max<uint32_t>(loss, 1), RATE_CONTROL_MAX_LOSS_PERCENT) : 0;
+
+    bool changed = level != level_ || fec != fec_.load(std::memory_order_relaxed) ||
+                   packet_loss_percent != packet_loss_percent_.load(std::memory_order_relaxed);
+    if (!changed) {
+        return false;
+    }
+    level_ = level;
+    bitrate_.store(kBitrateLadder[level], std::memory_order_relaxed);
+    fec_.store(fec, std::memory_order_relaxed);
+    packet_loss_percent_.store(packet_loss_percent, std::memory_order_relaxed);
+    changes_.fetch_add(1, std::memory_order_relaxed);
+    ESP_LOGI(TAG, "Bitrate %d, FEC %s, expected loss %d%% (loss %lu%%, jitter %lu ms, drops %lu, failures %lu, queue %u)",
+             kBitrateLadder[level], fec ? "on" : "off", packet_loss_percent, (unsigned long)loss,
+             (unsigned long)observation.jitter_ms, (unsigned long)drops, (unsigned long)failures,
+             (unsigned)observation.send_queue_depth);
+    return true;
+}
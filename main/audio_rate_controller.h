@@ -0,0 +1,77 @@
+#ifndef AUDIO_RATE_CONTROLLER_H
+#define AUDIO_RATE_CONTROLLER_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Evaluation window; short enough to react within a sentence
+#define RATE_CONTROL_INTERVAL_MS 2000
+// Clean windows in a row before stepping the bitrate back up
+#define RATE_CONTROL_PROBE_WINDOWS 3
+// Loss-free windows in a row before in-band FEC is switched off again
+#define RATE_CONTROL_FEC_HOLD_WINDOWS 5
+
+/**
+ * @brief Picks uplink Opus settings from what the link is doing
+ *
+ * The device gets no receiver reports for the uplink, so the controller
+ * works from what it can see: drops and depth of the send queue and failed
+ * sends (congestion on our side), and loss and jitter of the downlink
+ * stream as seen by the jitter buffer (the state of the path).
+ *
+ * Congestion halves down the bitrate ladder at once; after a few clean
+ * windows it climbs back one step at a time. Downlink loss switches on
+ * in-band FEC and sets the expected packet loss percentage so the encoder
+ * budgets for it.
+ *
+ * Update() is called from the encode worker only; the getters may be read
+ * from any task.
+ */
+class AudioRateController {
+public:
+    struct Observation {
+        uint32_t send_drops;        // Cumulative
+        uint32_t send_failures;     // Cumulative
+        size_t send_queue_depth;
+        size_t send_queue_limit;
+        uint32_t downlink_received; // Cumulative
+        uint32_t downlink_lost;     // Cumulative
+        uint32_t jitter_ms;
+    };
+
+    struct Settings {
+        int bitrate;
+        bool fec;
+        int packet_loss_percent;
+    };
+
+    AudioRateController();
+
+    /**
+     * @brief Feed the latest counters
+     * @return true when the settings changed and should be applied
+     */
+    bool Update(int64_t now_us, const Observation& observation);
+
+    Settings settings() const;
+    uint32_t loss_percent() const { return loss_percent_.load(std::memory_order_relaxed); }
+    uint32_t changes() const { return changes_.load(std::memory_order_relaxed); }
+
+private:
+    bool started_ = false;
+    int64_t window_start_us_ = 0;
+    Observation last_ = {};
+    int level_ = 0;
+    int clean_windows_ = 0;
+    int loss_free_windows_ = 0;
+    int32_t loss_q4_ = 0;       // Smoothed downlink loss, percent * 16
+
+    std::atomic<int> bitrate_;
+    std::atomic<bool> fec_{false};
+    std::atomic<int> packet_loss_percent_{0};
+    std::atomic<uint32_t> loss_percent_{0};
+    std::atomic<uint32_t> changes_{0};
+};
+
+#endif // AUDIO_RATE_CONTROLLER_H
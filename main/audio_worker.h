@@ -0,0 +1,103 @@
+#ifndef AUDIO_WORKER_H
+#define AUDIO_WORKER_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <esp_log.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+#include "bounded_ring.h"
+
+/**
+ * @brief Dedicated task that runs one audio pipeline stage
+ *
+ * Jobs go through a small lock-free ring and the task is woken with a
+ * direct-to-task notification, so posting a frame never allocates or takes
+ * a lock. Each stage gets its own priority and core, which keeps Opus
+ * encoding and decoding from queueing behind each other (or behind network
+ * and OTA work) on the shared BackgroundTask.
+ */
+template <typename Job, size_t Depth>
+class AudioWorker {
+public:
+    using Handler = std::function<void(Job& job)>;
+
+    AudioWorker(const char* name, uint32_t stack_size, UBaseType_t priority, BaseType_t core, Handler handler)
+        : name_(name), handler_(std::move(handler)) {
+        xTaskCreatePinnedToCore([](void* arg) {
+            auto worker = (AudioWorker*)arg;
+            worker->Loop();
+        }, name, stack_size, this, priority, &task_handle_, core);
+    }
+
+    ~AudioWorker() {
+        if (task_handle_ != nullptr) {
+            vTaskDelete(task_handle_);
+        }
+    }
+
+    AudioWorker(const AudioWorker&) = delete;
+    AudioWorker& operator=(const AudioWorker&) = delete;
+
+    /**
+     * @brief Queue a job; when the queue is full the job is dropped and counted
+     */
+    bool Post(Job&& job) {
+        active_.fetch_add(1, std::memory_order_relaxed);
+        if (!queue_.TryPush(std::move(job))) {
+            Finish();
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        xTaskNotifyGive(task_handle_);
+        return true;
+    }
+
+    // Jobs waiting to start; the job being run is not included
+    size_t queued() const { return queue_.size(); }
+    // Jobs queued or running
+    size_t pending() const { return active_.load(std::memory_order_relaxed); }
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+    const char* name() const { return name_; }
+
+    void WaitForIdle() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_cv_.wait(lock, [this]() { return active_.load(std::memory_order_relaxed) == 0; });
+    }
+
+private:
+    const char* name_;
+    Handler handler_;
+    BoundedRing<Job, Depth> queue_;
+    TaskHandle_t task_handle_ = nullptr;
+    std::atomic<size_t> active_{0};
+    std::atomic<uint32_t> dropped_{0};
+    std::mutex mutex_;
+    std::condition_variable idle_cv_;
+
+    void Finish() {
+        if (active_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            idle_cv_.notify_all();
+        }
+    }
+
+    void Loop() {
+        ESP_LOGI("AudioWorker", "%s started", name_);
+        Job job;
+        while (true) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            while (queue_.TryPop(job)) {
+                handler_(job);
+                job = Job();
+                Finish();
+            }
+        }
+    }
+};
+
+#endif // AUDIO_WORKER_H
@@ -1,11 +1,23 @@
 #include "background_task.h"
+#include "system_info.h"
 
 #include <esp_log.h>
 #include <esp_task_wdt.h>
+#include <esp_timer.h>
+#include <esp_heap_caps.h>
 
 #define TAG "BackgroundTask"
 
+#define ENTRY_BLOCK_SIZE 16
+
+static const char* const LANE_NAMES[kBackgroundLaneCount] = {"bg.audio", "bg.ui", "bg.housekeeping"};
+
 BackgroundTask::BackgroundTask(uint32_t stack_size) {
+    GrowPool();
+    for (int i = 0; i < kBackgroundLaneCount; i++) {
+        SystemInfo::RegisterLatencyHistogram(LANE_NAMES[i], &lanes_[i].wait);
+    }
+
     xTaskCreate([](void* arg) {
         BackgroundTask* task = (BackgroundTask*)arg;
         task->BackgroundTaskLoop();
@@ -13,51 +25,145 @@ BackgroundTask::BackgroundTask(uint32_t stack_size) {
 }
 
 BackgroundTask::~BackgroundTask() {
+    for (int i = 0; i < kBackgroundLaneCount; i++) {
+        SystemInfo::UnregisterLatencyHistogram(&lanes_[i].wait);
+    }
     if (background_task_handle_ != nullptr) {
         vTaskDelete(background_task_handle_);
     }
 }
 
-void BackgroundTask::Schedule(std::function<void()> callback) {
+void BackgroundTask::GrowPool() {
+    auto block = std::make_unique<Entry[]>(ENTRY_BLOCK_SIZE);
+    for (int i = 0; i < ENTRY_BLOCK_SIZE; i++) {
+        block[i].next = free_;
+        free_ = &block[i];
+    }
+    entry_blocks_.push_back(std::move(block));
+    entry_count_ += ENTRY_BLOCK_SIZE;
+}
+
+// Called with mutex_ held
+BackgroundTask::Entry* BackgroundTask::AllocateEntry() {
+    if (free_ == nullptr) {
+        GrowPool();
+        ESP_LOGW(TAG, "Task pool grown to %u entries", (unsigned)entry_count_);
+    }
+    Entry* entry = free_;
+    free_ = entry->next;
+    entry->next = nullptr;
+    return entry;
+}
+
+void BackgroundTask::Enqueue(BackgroundJob&& job, BackgroundLane lane, uint32_t coalesce_key) {
+    if (job.on_heap()) {
+        heap_jobs_.fetch_add(1, std::memory_order_relaxed);
+    }
+
     std::lock_guard<std::mutex> lock(mutex_);
+    Lane& l = lanes_[lane];
+    if (coalesce_key != 0) {
+        for (Entry* entry = l.head; entry != nullptr; entry = entry->next) {
+            if (entry->key == coalesce_key) {
+                // Keep the queue position (and wait time) of the older task
+                entry->job = std::move(job);
+                l.coalesced++;
+                return;
+            }
+        }
+    }
+
     if (active_tasks_ >= 30) {
         int free_sram = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
         if (free_sram < 10000) {
-            ESP_LOGW(TAG, "active_tasks_ == %u, free_sram == %u", active_tasks_.load(), free_sram);
+            ESP_LOGW(TAG, "active_tasks_ == %u, free_sram == %u", (unsigned)active_tasks_.load(), free_sram);
         }
     }
+
+    Entry* entry = AllocateEntry();
+    entry->job = std::move(job);
+    entry->key = coalesce_key;
+    entry->enqueue_us = esp_timer_get_time();
+    if (l.tail != nullptr) {
+        l.tail->next = entry;
+    } else {
+        l.head = entry;
+    }
+    l.tail = entry;
+    if (++l.depth > l.max_depth) {
+        l.max_depth = l.depth;
+    }
+    queued_++;
     active_tasks_++;
-    background_tasks_.emplace_back([this, cb = std::move(callback)]() {
-        cb();
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            active_tasks_--;
-            if (background_tasks_.empty() && active_tasks_ == 0) {
-                condition_variable_.notify_all();
-            }
-        }
-    });
     condition_variable_.notify_all();
 }
 
 void BackgroundTask::WaitForCompletion() {
     std::unique_lock<std::mutex> lock(mutex_);
     condition_variable_.wait(lock, [this]() {
-        return background_tasks_.empty() && active_tasks_ == 0;
+        return active_tasks_ == 0;
     });
 }
 
+BackgroundTask::LaneStats BackgroundTask::GetLaneStats(BackgroundLane lane) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Lane& l = lanes_[lane];
+    return {l.depth, l.max_depth, l.executed, l.coalesced};
+}
+
+void BackgroundTask::PrintStats() {
+    LaneStats stats[kBackgroundLaneCount];
+    size_t entries;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (int i = 0; i < kBackgroundLaneCount; i++) {
+            Lane& l = lanes_[i];
+            stats[i] = {l.depth, l.max_depth, l.executed, l.coalesced};
+        }
+        entries = entry_count_;
+    }
+    ESP_LOGI(TAG, "audio %u/%u/%u/%u, ui %u/%u/%u/%u, housekeeping %u/%u/%u/%u (depth/max/run/coalesced); "
+             "%u heap jobs, %u entries",
+             (unsigned)stats[0].depth, (unsigned)stats[0].max_depth, (unsigned)stats[0].executed, (unsigned)stats[0].coalesced,
+             (unsigned)stats[1].depth, (unsigned)stats[1].max_depth, (unsigned)stats[1].executed, (unsigned)stats[1].coalesced,
+             (unsigned)stats[2].depth, (unsigned)stats[2].max_depth, (unsigned)stats[2].executed, (unsigned)stats[2].coalesced,
+             (unsigned)heap_jobs_.load(std::memory_order_relaxed), (unsigned)entries);
+}
+
 void BackgroundTask::BackgroundTaskLoop() {
     ESP_LOGI(TAG, "background_task started");
+    BackgroundJob job;
     while (true) {
         std::unique_lock<std::mutex> lock(mutex_);
-        condition_variable_.wait(lock, [this]() { return !background_tasks_.empty(); });
-        
-        std::list<std::function<void()>> tasks = std::move(background_tasks_);
+        condition_variable_.wait(lock, [this]() { return queued_ > 0; });
+
+        // One task at a time, so a task queued on a higher lane runs next
+        Lane* lane = lanes_;
+        while (lane->head == nullptr) {
+            lane++;
+        }
+        Entry* entry = lane->head;
+        lane->head = entry->next;
+        if (lane->head == nullptr) {
+            lane->tail = nullptr;
+        }
+        lane->depth--;
+        lane->executed++;
+        queued_--;
+        lane->wait.Record(esp_timer_get_time() - entry->enqueue_us);
+
+        job = std::move(entry->job);
+        entry->next = free_;
+        free_ = entry;
         lock.unlock();
 
-        for (auto& task : tasks) {
-            task();
+        job();
+        job.Reset();
+
+        lock.lock();
+        active_tasks_--;
+        if (active_tasks_ == 0) {
+            condition_variable_.notify_all();
         }
     }
 }
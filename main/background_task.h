@@ -4,25 +4,180 @@
 #include <freertos/FreeRTOS.h>
 #include <freertos/task.h>
 #include <mutex>
-#include <list>
+#include <functional>
+#include <vector>
+#include <memory>
+#include <new>
 #include <condition_variable>
 #include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include "latency_histogram.h"
+
+// Lanes are served strictly in this order
+enum BackgroundLane {
+    kBackgroundLaneAudio,
+    kBackgroundLaneUi,
+    kBackgroundLaneHousekeeping,
+    kBackgroundLaneCount
+};
+
+/**
+ * @brief Type-erased void() callable with inline storage
+ *
+ * Callables up to kInlineSize bytes (e.g. a lambda capturing `this` and a
+ * few values, or a std::function) are stored in place; bigger ones fall back
+ * to the heap.
+ */
+class BackgroundJob {
+public:
+    static constexpr size_t kInlineSize = 64;
+
+    BackgroundJob() = default;
+
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, BackgroundJob>>>
+    BackgroundJob(F&& callable) {
+        using Fn = std::decay_t<F>;
+        if constexpr (sizeof(Fn) <= kInlineSize && alignof(Fn) <= alignof(std::max_align_t) &&
+                      std::is_nothrow_move_constructible_v<Fn>) {
+            new (storage_) Fn(std::forward<F>(callable));
+            ops_ = &InlineOps<Fn>::kOps;
+        } else {
+            *reinterpret_cast<Fn**>(storage_) = new Fn(std::forward<F>(callable));
+            ops_ = &HeapOps<Fn>::kOps;
+        }
+    }
+
+    BackgroundJob(BackgroundJob&& other) noexcept { MoveFrom(other); }
+
+    BackgroundJob& operator=(BackgroundJob&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(other);
+        }
+        return *this;
+    }
+
+    BackgroundJob(const BackgroundJob&) = delete;
+    BackgroundJob& operator=(const BackgroundJob&) = delete;
+
+    ~BackgroundJob() { Reset(); }
+
+    explicit operator bool() const { return ops_ != nullptr; }
+    bool on_heap() const { return ops_ != nullptr && ops_->on_heap; }
+
+    void operator()() { ops_->invoke(storage_); }
+
+    void Reset() {
+        if (ops_ != nullptr) {
+            ops_->destroy(storage_);
+            ops_ = nullptr;
+        }
+    }
+
+private:
+    struct Ops {
+        void (*invoke)(void* storage);
+        void (*move)(void* dst, void* src);     // Move-construct into dst and destroy src
+        void (*destroy)(void* storage);
+        bool on_heap;
+    };
+
+    template <typename Fn>
+    struct InlineOps {
+        static void Invoke(void* storage) { (*static_cast<Fn*>(storage))(); }
+        static void Move(void* dst, void* src) {
+            new (dst) Fn(std::move(*static_cast<Fn*>(src)));
+            static_cast<Fn*>(src)->~Fn();
+        }
+        static void Destroy(void* storage) { static_cast<Fn*>(storage)->~Fn(); }
+        static constexpr Ops kOps = {Invoke, Move, Destroy, false};
+    };
+
+    template <typename Fn>
+    struct HeapOps {
+        static void Invoke(void* storage) { (**static_cast<Fn**>(storage))(); }
+        static void Move(void* dst, void* src) { *static_cast<Fn**>(dst) = *static_cast<Fn**>(src); }
+        static void Destroy(void* storage) { delete *static_cast<Fn**>(storage); }
+        static constexpr Ops kOps = {Invoke, Move, Destroy, true};
+    };
+
+    alignas(std::max_align_t) unsigned char storage_[kInlineSize];
+    const Ops* ops_ = nullptr;
+
+    void MoveFrom(BackgroundJob& other) {
+        ops_ = other.ops_;
+        if (ops_ != nullptr) {
+            ops_->move(storage_, other.storage_);
+            other.ops_ = nullptr;
+        }
+    }
+};
 
 class BackgroundTask {
 public:
+    struct LaneStats {
+        size_t depth;
+        size_t max_depth;
+        uint32_t executed;
+        uint32_t coalesced;     // Replaced by a newer task with the same key
+    };
+
     BackgroundTask(uint32_t stack_size = 4096 * 2);
     ~BackgroundTask();
 
-    void Schedule(std::function<void()> callback);
+    /**
+     * @brief Queue a callback on the given lane
+     * @param coalesce_key When non-zero and a task with the same key is still
+     *                     queued, that task is replaced in place instead
+     */
+    template <typename F>
+    void Schedule(F&& callback, BackgroundLane lane = kBackgroundLaneHousekeeping, uint32_t coalesce_key = 0) {
+        Enqueue(BackgroundJob(std::forward<F>(callback)), lane, coalesce_key);
+    }
+
     void WaitForCompletion();
 
+    LaneStats GetLaneStats(BackgroundLane lane);
+    void PrintStats();
+
 private:
+    struct Entry {
+        BackgroundJob job;
+        uint32_t key = 0;
+        int64_t enqueue_us = 0;
+        Entry* next = nullptr;
+    };
+
+    struct Lane {
+        Entry* head = nullptr;
+        Entry* tail = nullptr;
+        size_t depth = 0;
+        size_t max_depth = 0;
+        uint32_t executed = 0;
+        uint32_t coalesced = 0;
+        LatencyHistogram wait;  // Queued -> started
+    };
+
     std::mutex mutex_;
-    std::list<std::function<void()>> background_tasks_;
     std::condition_variable condition_variable_;
     TaskHandle_t background_task_handle_ = nullptr;
+    Lane lanes_[kBackgroundLaneCount];
+    size_t queued_ = 0;
     std::atomic<size_t> active_tasks_{0};
 
+    // Entries are recycled through free_; the pool only grows when more
+    // tasks are queued at once than ever before.
+    std::vector<std::unique_ptr<Entry[]>> entry_blocks_;
+    Entry* free_ = nullptr;
+    size_t entry_count_ = 0;
+    std::atomic<uint32_t> heap_jobs_{0};
+
+    void Enqueue(BackgroundJob&& job, BackgroundLane lane, uint32_t coalesce_key);
+    void GrowPool();
+    Entry* AllocateEntry();
     void BackgroundTaskLoop();
 };
 
@@ -0,0 +1,169 @@
+#include "power_monitor.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <cstdlib>
+
+#define TAG "PowerMonitor"
+
+// Voltage smoothing: EMA with alpha = 1/8
+#define VOLTAGE_EMA_SHIFT 3
+// Share of the voltage-based level blended into the estimate per second.
+// Voltage sags under load and rises while charging, so it only corrects
+// the coulomb count slowly, and only while the current is near zero.
+#define VOLTAGE_CORRECTION_PER_SECOND 0.02f
+// A threshold crossed downwards is re-armed only this many percent above it
+#define LEVEL_HYSTERESIS 2
+// Telemetry goes out as an error so the SD error log captures it
+#define TELEMETRY_LOG_INTERVAL_US (15 * 1000 * 1000)
+
+#define STATE_VALID (1u << 31)
+#define STATE_CHARGING (1u << 30)
+#define STATE_DISCHARGING (1u << 29)
+#define STATE_LEVEL_MASK 0xffu
+
+PowerMonitor::PowerMonitor(ReadFunction read, const Config& config)
+    : read_(std::move(read)), config_(config) {
+}
+
+PowerMonitor::~PowerMonitor() {
+    if (task_handle_ != nullptr) {
+        vTaskDelete(task_handle_);
+    }
+}
+
+void PowerMonitor::Start() {
+    // Take the first reading right away so the snapshot is valid on return
+    Sample();
+    xTaskCreatePinnedToCore([](void* arg) {
+        auto monitor = (PowerMonitor*)arg;
+        monitor->Loop();
+    }, "power_monitor", 3 * 1024, this, 3, &task_handle_, 0);
+}
+
+void PowerMonitor::Loop() {
+    while (true) {
+        vTaskDelay(pdMS_TO_TICKS(config_.poll_interval_ms));
+        Sample();
+    }
+}
+
+int PowerMonitor::VoltageToLevel(int voltage_mv) const {
+    if (voltage_mv <= config_.empty_mv) {
+        return 0;
+    }
+    if (voltage_mv >= config_.full_mv) {
+        return 100;
+    }
+    return (voltage_mv - config_.empty_mv) * 100 / (config_.full_mv - config_.empty_mv);
+}
+
+void PowerMonitor::Sample() {
+    uint16_t voltage_mv = 0;
+    int16_t current_ma = 0;
+    int64_t now = esp_timer_get_time();
+    Snapshot previous = published_;
+
+    if (!read_(voltage_mv, current_ma)) {
+        if (previous.valid) {
+            Snapshot snapshot = {};
+            Publish(snapshot);
+            ESP_LOGW(TAG, "Fuel gauge lost");
+            if (on_event_) {
+                on_event_(kGaugeLost, snapshot);
+            }
+        }
+        initialized_ = false;
+        return;
+    }
+
+    if (!initialized_) {
+        voltage_q4_ = (int32_t)voltage_mv << 4;
+        soc_ = VoltageToLevel(voltage_mv);
+        initialized_ = true;
+    } else {
+        voltage_q4_ += (((int32_t)voltage_mv << 4) - voltage_q4_) >> VOLTAGE_EMA_SHIFT;
+        float seconds = (now - last_sample_us_) / 1e6f;
+        soc_ += current_ma * seconds * 100.0f / (3600.0f * config_.capacity_mah);
+        if (abs(current_ma) <= config_.charging_threshold_ma) {
+            float weight = seconds * VOLTAGE_CORRECTION_PER_SECOND;
+            if (weight > 1.0f) {
+                weight = 1.0f;
+            }
+            soc_ += (VoltageToLevel(voltage_q4_ >> 4) - soc_) * weight;
+        }
+        if (soc_ < 0) {
+            soc_ = 0;
+        } else if (soc_ > 100) {
+            soc_ = 100;
+        }
+    }
+    last_sample_us_ = now;
+
+    Snapshot snapshot;
+    snapshot.valid = true;
+    snapshot.level = (int)(soc_ + 0.5f);
+    snapshot.charging = current_ma > config_.charging_threshold_ma;
+    snapshot.discharging = current_ma < -config_.charging_threshold_ma;
+    snapshot.voltage_mv = (uint16_t)(voltage_q4_ >> 4);
+    snapshot.current_ma = current_ma;
+    Publish(snapshot);
+
+    if (now - last_log_us_ >= TELEMETRY_LOG_INTERVAL_US) {
+        ESP_LOGE(TAG, "[BATTERY] Voltage: %d mV (raw %d), Current: %d mA, Level: %d%%, Charging: %s, Discharging: %s",
+                 snapshot.voltage_mv, voltage_mv, current_ma, snapshot.level,
+                 snapshot.charging ? "yes" : "no", snapshot.discharging ? "yes" : "no");
+        last_log_us_ = now;
+    }
+
+    // Below a threshold once under it; above again only past the hysteresis band
+    uint32_t below = 0;
+    for (size_t i = 0; i < config_.level_thresholds.size() && i < 32; i++) {
+        int threshold = config_.level_thresholds[i];
+        bool was_below = previous.valid && (below_thresholds_ & (1u << i)) != 0;
+        if (snapshot.level < threshold || (was_below && snapshot.level < threshold + LEVEL_HYSTERESIS)) {
+            below |= 1u << i;
+        }
+    }
+    uint32_t crossed = below ^ below_thresholds_;
+    below_thresholds_ = below;
+
+    if (!previous.valid || !on_event_) {
+        return;
+    }
+    if (previous.charging != snapshot.charging) {
+        on_event_(kChargingChanged, snapshot);
+    }
+    if (crossed != 0) {
+        on_event_(kThresholdCrossed, snapshot);
+    }
+}
+
+void PowerMonitor::Publish(const Snapshot& snapshot) {
+    published_ = snapshot;
+    uint32_t state = (uint32_t)snapshot.level & STATE_LEVEL_MASK;
+    if (snapshot.valid) {
+        state |= STATE_VALID;
+    }
+    if (snapshot.charging) {
+        state |= STATE_CHARGING;
+    }
+    if (snapshot.discharging) {
+        state |= STATE_DISCHARGING;
+    }
+    electrical_.store((uint32_t)snapshot.voltage_mv << 16 | (uint16_t)snapshot.current_ma, std::memory_order_relaxed);
+    state_.store(state, std::memory_order_release);
+}
+
+PowerMonitor::Snapshot PowerMonitor::GetSnapshot() const {
+    uint32_t state = state_.load(std::memory_order_acquire);
+    uint32_t electrical = electrical_.load(std::memory_order_relaxed);
+    Snapshot snapshot;
+    snapshot.valid = (state & STATE_VALID) != 0;
+    snapshot.level = (int)(state & STATE_LEVEL_MASK);
+    snapshot.charging = (state & STATE_CHARGING) != 0;
+    snapshot.discharging = (state & STATE_DISCHARGING) != 0;
+    snapshot.voltage_mv = (uint16_t)(electrical >> 16);
+    snapshot.current_ma = (int16_t)(electrical & 0xffff);
+    return snapshot;
+}
@@ -0,0 +1,90 @@
+#ifndef __POWER_MONITOR_H__
+#define __POWER_MONITOR_H__
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Polls a fuel gauge on its own task and caches the result
+ *
+ * The monitor is the only code that talks to the gauge, at a fixed cadence.
+ * Everyone else reads the latest Snapshot from two packed atomic words, so
+ * readers never block, never retry and never touch I2C. Level and charging
+ * flags share a word and are always consistent with each other; voltage and
+ * current may be one sample apart from them.
+ *
+ * The state of charge is a complementary filter: coulomb counting from the
+ * measured current tracks fast changes, and a slow pull towards the level
+ * implied by the smoothed voltage corrects the drift.
+ */
+class PowerMonitor {
+public:
+    // Returns false if the gauge could not be read
+    using ReadFunction = std::function<bool(uint16_t& voltage_mv, int16_t& current_ma)>;
+
+    struct Config {
+        uint32_t poll_interval_ms = 1000;
+        uint32_t capacity_mah = 1000;
+        uint16_t empty_mv = 3000;           // 0%
+        uint16_t full_mv = 4200;            // 100%
+        int16_t charging_threshold_ma = 50; // |current| above this is (dis)charging
+        std::vector<int> level_thresholds;  // Crossing any of these raises kThresholdCrossed (2% hysteresis)
+    };
+
+    struct Snapshot {
+        bool valid;
+        int level;          // 0-100
+        bool charging;
+        bool discharging;
+        uint16_t voltage_mv;    // Smoothed
+        int16_t current_ma;
+    };
+
+    enum Event {
+        kChargingChanged,
+        kThresholdCrossed,
+        kGaugeLost,
+    };
+
+    using EventCallback = std::function<void(Event event, const Snapshot& snapshot)>;
+
+    PowerMonitor(ReadFunction read, const Config& config);
+    ~PowerMonitor();
+
+    void OnEvent(EventCallback callback) { on_event_ = std::move(callback); }
+    void Start();
+
+    Snapshot GetSnapshot() const;
+
+private:
+    ReadFunction read_;
+    Config config_;
+    EventCallback on_event_;
+    TaskHandle_t task_handle_ = nullptr;
+
+    // Filter state, monitor task only
+    bool initialized_ = false;
+    int32_t voltage_q4_ = 0;        // Smoothed voltage, mV * 16
+    float soc_ = 0;                 // Percent
+    int64_t last_sample_us_ = 0;
+    int64_t last_log_us_ = 0;
+    Snapshot published_ = {};
+    uint32_t below_thresholds_ = 0; // Bit i: below level_thresholds[i]
+
+    // Published snapshot: valid | charging | discharging | level, and
+    // voltage << 16 | current
+    std::atomic<uint32_t> state_{0};
+    std::atomic<uint32_t> electrical_{0};
+
+    void Loop();
+    void Sample();
+    int VoltageToLevel(int voltage_mv) const;
+    void Publish(const Snapshot& snapshot);
+};
+
+#endif // __POWER_MONITOR_H__
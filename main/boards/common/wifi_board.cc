@@ -554,6 +554,7 @@ void WifiBoard::StartNetwork() {
         notification += ssid;
         display->ShowNotification(notification.c_str(), 30000);
         ClearWifiOverlay(display);
+        animation_refresh();
         
         // Stop BLE server when WiFi is connected
         if (ble_initialized_) {
@@ -596,6 +597,7 @@ void WifiBoard::StartNetwork() {
         }
     });
     wifi_station.OnDisconnected([this](const std::string& ssid, wifi_err_reason_t reason, int8_t rssi) {
+        animation_refresh();
         if (ShouldIgnoreWifiFailure(reason)) {
             return;
         }
@@ -10,6 +10,10 @@
 #define AUDIO_INPUT_REFERENCE    true
 
 #define POWER_CTRL  GPIO_NUM_9
+
+// Fuel gauge (charge IC at 0x55), read only by the PowerMonitor task
+#define BATTERY_POLL_INTERVAL_MS 1000
+#define BATTERY_CAPACITY_MAH     1000
 #define LED_G       GPIO_NUM_43
 #define SD_MISO     GPIO_NUM_17
 #define SD_SCK      GPIO_NUM_16
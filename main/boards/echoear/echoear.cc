@@ -12,6 +12,7 @@
 #include "sd_card.h"
 #include "sd_card_startup.h"
 #include "power_save_timer.h"
+#include "power_monitor.h"
 #include "system_info.h"
 
 #include <wifi_station.h>
@@ -599,26 +600,25 @@ public:
     ~Charge() {
         delete[] read_buffer_;
     }
-    void Printcharge() {
+    // Read voltage (mV) and current (mA, positive = charging); false if either read fails
+    bool Read(uint16_t& voltage_mv, int16_t& current_ma) {
         if (!enabled_) {
-            return;
+            return false;
         }
         if (TryReadRegs(0x08, read_buffer_, 2) != ESP_OK) {
             HandleReadFailure("voltage");
-            return;
+            return false;
         }
         if (TryReadRegs(0x0c, read_buffer_ + 2, 2) != ESP_OK) {
             HandleReadFailure("current");
-            return;
+            return false;
         }
         consecutive_read_failures_ = 0;
-        ESP_ERROR_CHECK(temperature_sensor_get_celsius(temp_sensor, &tsens_value));
-
-        // Read voltage and current values (currently unused but available for future use)
-        (void)((uint16_t)(read_buffer_[1] << 8 | read_buffer_[0]));  // voltage
-        (void)((int16_t)(read_buffer_[3] << 8 | read_buffer_[2]));  // current
+        voltage_mv = (uint16_t)((read_buffer_[1] << 8) | read_buffer_[0]);
+        current_ma = (int16_t)((read_buffer_[3] << 8) | read_buffer_[2]);
+        return true;
     }
-    
+
     // Get battery voltage in millivolts
     uint16_t GetVoltage() {
         if (!enabled_) {
@@ -636,30 +636,6 @@ public:
         return voltage_raw;
     }
     
-    // Get battery current in milliamps (positive = charging, negative = discharging)
-    int16_t GetCurrent() {
-        if (!enabled_) {
-            return 0;
-        }
-        if (TryReadRegs(0x0c, read_buffer_ + 2, 2) != ESP_OK) {
-            HandleReadFailure("current");
-            return 0;
-        }
-        consecutive_read_failures_ = 0;
-        int16_t current_raw = (int16_t)((read_buffer_[3] << 8) | read_buffer_[2]);
-        // Current register format: typically in units of 0.1mA or similar
-        // Adjust scaling based on actual chip specifications
-        return current_raw;
-    }
-    
-    static void TaskFunction(void *pvParameters) {
-        Charge* charge = static_cast<Charge*>(pvParameters);
-        while (true) {
-            charge->Printcharge();
-            vTaskDelay(pdMS_TO_TICKS(300));
-        }
-    }
-
     bool IsAvailable() const {
         return enabled_;
     }
@@ -756,6 +732,8 @@ private:
     
     Cst816s* cst816s_;
     Charge* charge_;
+    PowerMonitor* power_monitor_ = nullptr;
+    TaskHandle_t battery_monitor_task_ = nullptr;
     Button boot_button_;
     LcdDisplay* display_;
     PwmBacklight* backlight_ = nullptr;
@@ -1679,7 +1657,30 @@ private:
             charge_ = nullptr;
             return;
         }
-        xTaskCreatePinnedToCore(Charge::TaskFunction, "batterydecTask", 3 * 1024, charge_, 6, NULL, 0);
+
+        // All later gauge reads happen on the monitor task; everyone else
+        // reads its cached snapshot, keeping the shared I2C bus free.
+        PowerMonitor::Config config;
+        config.poll_interval_ms = BATTERY_POLL_INTERVAL_MS;
+        config.capacity_mah = BATTERY_CAPACITY_MAH;
+        // Power saving policy boundaries, and the low battery animation below 20%
+        config.level_thresholds = {20, 25, 40};
+        power_monitor_ = new PowerMonitor([this](uint16_t& voltage_mv, int16_t& current_ma) {
+            return charge_->Read(voltage_mv, current_ma);
+        }, config);
+        power_monitor_->OnEvent([this](PowerMonitor::Event event, const PowerMonitor::Snapshot& snapshot) {
+            if (event == PowerMonitor::kChargingChanged) {
+                ESP_LOGI(TAG, "[BATTERY] Charging %s at %d%%", snapshot.charging ? "started" : "stopped", snapshot.level);
+            } else if (event == PowerMonitor::kThresholdCrossed) {
+                ESP_LOGI(TAG, "[BATTERY] Level crossed a threshold: %d%%", snapshot.level);
+            }
+            // Let the power saving policy react now instead of at its next poll
+            if (battery_monitor_task_ != nullptr) {
+                xTaskNotifyGive(battery_monitor_task_);
+            }
+            animation_refresh();
+        });
+        power_monitor_->Start();
     }
 
     void InitializeCst816sTouchPad() {
@@ -1962,10 +1963,10 @@ private:
                     }
                 }
 
-                // Check every 5 seconds
-                vTaskDelay(pdMS_TO_TICKS(5000));
+                // Check every 5 seconds, or as soon as the power monitor reports a change
+                ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(5000));
             }
-        }, "battery_monitor", 4096, this, 5, NULL);
+        }, "battery_monitor", 4096, this, 5, &battery_monitor_task_);
         ESP_LOGI(TAG, "[BATTERY] Battery monitoring task started for always power saving mode");
     }
 
@@ -2085,51 +2086,16 @@ public:
     }
 
     virtual bool GetBatteryLevel(int &level, bool& charging, bool& discharging) override {
-        if (charge_ == nullptr || !charge_->IsAvailable()) {
+        if (power_monitor_ == nullptr) {
             return false;
         }
-        
-        // Read voltage and current from charge IC
-        uint16_t voltage_mv = charge_->GetVoltage();
-        int16_t current_ma = charge_->GetCurrent();
-        
-        // Determine charging/discharging status based on current
-        // Positive current typically means charging, negative means discharging
-        charging = (current_ma > 50);  // Threshold: > 50mA considered charging
-        discharging = (current_ma < -50);  // Threshold: < -50mA considered discharging
-        
-        // Convert voltage to battery level percentage
-        // Typical Li-ion battery: 3.0V (0%) to 4.2V (100%)
-        // Voltage register might be in different units - adjust based on actual chip
-        // Assuming voltage is in millivolts, typical range: 3000mV (0%) to 4200mV (100%)
-        const uint16_t MIN_VOLTAGE_MV = 3000;  // 3.0V = 0%
-        const uint16_t MAX_VOLTAGE_MV = 4200;  // 4.2V = 100%
-        
-        // Clamp voltage to valid range
-        if (voltage_mv < MIN_VOLTAGE_MV) {
-            voltage_mv = MIN_VOLTAGE_MV;
-        } else if (voltage_mv > MAX_VOLTAGE_MV) {
-            voltage_mv = MAX_VOLTAGE_MV;
-        }
-        
-        // Calculate percentage using linear interpolation
-        level = ((voltage_mv - MIN_VOLTAGE_MV) * 100) / (MAX_VOLTAGE_MV - MIN_VOLTAGE_MV);
-        
-        // Ensure level is in valid range
-        if (level < 0) level = 0;
-        if (level > 100) level = 100;
-        
-        // Log as E so the SD error-log hook captures battery telemetry in err.txt.
-        static int64_t last_log_time = 0;
-        int64_t current_time = esp_timer_get_time() / 1000; // Convert to milliseconds
-        const int64_t LOG_INTERVAL_MS = 15000; // 15 seconds
-        
-        if (current_time - last_log_time >= LOG_INTERVAL_MS) {
-            ESP_LOGE(TAG, "[BATTERY] Voltage: %d mV, Current: %d mA, Level: %d%%, Charging: %s, Discharging: %s",
-                     voltage_mv, current_ma, level, charging ? "yes" : "no", discharging ? "yes" : "no");
-            last_log_time = current_time;
+        auto snapshot = power_monitor_->GetSnapshot();
+        if (!snapshot.valid) {
+            return false;
         }
-        
+        level = snapshot.level;
+        charging = snapshot.charging;
+        discharging = snapshot.discharging;
         return true;
     }
 
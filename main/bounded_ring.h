@@ -0,0 +1,141 @@
+#ifndef BOUNDED_RING_H
+#define BOUNDED_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+enum class RingOverflow {
+    kDropNewest,    // Reject the item being pushed
+    kDropOldest,    // Discard the head of the queue to make room
+};
+
+/**
+ * @brief Fixed-capacity lock-free FIFO for the audio packet queues
+ *
+ * Each slot carries a sequence number that tells producers and consumers
+ * whether it is free or filled (the bounded queue from D. Vyukov), so push
+ * and pop never take a lock and never allocate. The audio queues have one
+ * producer and one consumer in steady state; the per-slot sequence also
+ * keeps the occasional extra party safe, i.e. PlaySound() pushing next to
+ * the network task, a state change clearing the queue from the main loop,
+ * or a drop-oldest push discarding the head.
+ */
+template <typename T, size_t Capacity>
+class BoundedRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+public:
+    BoundedRing() {
+        for (size_t i = 0; i < Capacity; i++) {
+            slots_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedRing(const BoundedRing&) = delete;
+    BoundedRing& operator=(const BoundedRing&) = delete;
+
+    /**
+     * @brief Move item in if a slot is free; item is left untouched when full
+     */
+    bool TryPush(T&& item) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots_[pos & (Capacity - 1)];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = std::move(item);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& item) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true) {
+            slot = &slots_[pos & (Capacity - 1)];
+            size_t seq = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        item = std::move(slot->value);
+        slot->sequence.store(pos + Capacity, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Push while keeping at most limit items queued
+     * @return false if an item (the new one or the oldest) was dropped
+     */
+    bool Push(T&& item, size_t limit, RingOverflow policy) {
+        bool dropped = false;
+        if (size() >= limit) {
+            if (policy == RingOverflow::kDropNewest) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            T oldest;
+            if (TryPop(oldest)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+                dropped = true;
+            }
+        }
+        if (!TryPush(std::move(item))) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return !dropped;
+    }
+
+    void Clear() {
+        T item;
+        while (TryPop(item)) {
+        }
+    }
+
+    // Approximate while other tasks are pushing or popping
+    size_t size() const {
+        // Read the consumer side first so the difference cannot go negative.
+        size_t dequeued = dequeue_pos_.load(std::memory_order_acquire);
+        size_t enqueued = enqueue_pos_.load(std::memory_order_acquire);
+        size_t count = enqueued - dequeued;
+        return count > Capacity ? Capacity : count;
+    }
+
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+    uint32_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    Slot slots_[Capacity];
+    std::atomic<size_t> enqueue_pos_{0};
+    std::atomic<size_t> dequeue_pos_{0};
+    std::atomic<uint32_t> dropped_{0};
+};
+
+#endif // BOUNDED_RING_H
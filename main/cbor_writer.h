@@ -0,0 +1,72 @@
+#ifndef CBOR_WRITER_H
+#define CBOR_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+/**
+ * @brief Appends definite-length CBOR (RFC 8949) items to a string
+ *
+ * Just the subset the IoT state messages need: maps, arrays, text strings,
+ * integers and booleans. Containers are written with their item count up
+ * front, so callers must know it before writing the members.
+ */
+class CborWriter {
+public:
+    explicit CborWriter(std::string& out) : out_(out) {}
+
+    void Map(size_t pairs) { Head(5, pairs); }
+    void Array(size_t items) { Head(4, items); }
+
+    void String(const char* value, size_t length) {
+        Head(3, length);
+        out_.append(value, length);
+    }
+    void String(const char* value) { String(value, strlen(value)); }
+    void String(const std::string& value) { String(value.data(), value.size()); }
+
+    void Int(int64_t value) {
+        if (value >= 0) {
+            Head(0, (uint64_t)value);
+        } else {
+            Head(1, (uint64_t)(-1 - value));
+        }
+    }
+
+    void Bool(bool value) { out_.push_back(value ? (char)0xf5 : (char)0xf4); }
+
+    // Append an item that was encoded separately
+    void Raw(const std::string& encoded) { out_.append(encoded); }
+
+private:
+    std::string& out_;
+
+    void Head(uint8_t major, uint64_t value) {
+        uint8_t type = major << 5;
+        if (value < 24) {
+            out_.push_back((char)(type | value));
+            return;
+        }
+        int bytes;
+        if (value <= 0xff) {
+            out_.push_back((char)(type | 24));
+            bytes = 1;
+        } else if (value <= 0xffff) {
+            out_.push_back((char)(type | 25));
+            bytes = 2;
+        } else if (value <= 0xffffffff) {
+            out_.push_back((char)(type | 26));
+            bytes = 4;
+        } else {
+            out_.push_back((char)(type | 27));
+            bytes = 8;
+        }
+        for (int i = bytes - 1; i >= 0; i--) {
+            out_.push_back((char)(value >> (i * 8)));
+        }
+    }
+};
+
+#endif // CBOR_WRITER_H
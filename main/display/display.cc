@@ -7,6 +7,7 @@
 #include <esp_log.h>
 #include <esp_err.h>
 #include <string>
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 
@@ -76,7 +77,7 @@ void Display::SetStatus(const char* status) {
     if (status_label_ == nullptr) {
         return;
     }
-    lv_label_set_text(status_label_, status);
+    SetLabelText(status_label_, status);
     lv_obj_clear_flag(status_label_, LV_OBJ_FLAG_HIDDEN);
     if (notification_label_ != nullptr) {
         lv_obj_add_flag(notification_label_, LV_OBJ_FLAG_HIDDEN);
@@ -114,72 +115,93 @@ void Display::ShowNotification(const char* notification, int duration_ms) {
     }
 }
 
-void Display::UpdateStatusBar(bool update_all) {
-    auto& board = Board::GetInstance();
-    auto codec = board.GetAudioCodec();
-
-    {
-        DisplayLockGuard lock(this);
-        if (mute_label_ != nullptr) {
-            // 如果静音状态改变，则更新图标
-            if (codec->output_volume() == 0 && !muted_) {
-                muted_ = true;
-                lv_label_set_text(mute_label_, FONT_AWESOME_VOLUME_MUTE);
-            } else if (codec->output_volume() > 0 && muted_) {
-                muted_ = false;
-                lv_label_set_text(mute_label_, "");
+bool Display::SetLabelText(lv_obj_t* label, const char* text) {
+    if (label == nullptr || strcmp(lv_label_get_text(label), text) == 0) {
+        return false;
+    }
+    lv_label_set_text(label, text);
+    return true;
+}
+
+void Display::SetMuted(bool muted) {
+    if (muted == muted_) {
+        return;
+    }
+    muted_ = muted;
+    DisplayLockGuard lock(this);
+    SetLabelText(mute_label_, muted ? FONT_AWESOME_VOLUME_MUTE : "");
+}
+
+void Display::SetBatteryState(int level, bool charging, bool discharging) {
+    // Play charge sound when USB charging is detected (transition from not charging to charging)
+    // Only play if battery level is 90% or below
+    if (charging && !charging_ && level <= 90) {
+        auto& app = Application::GetInstance();
+        app.PlaySound(Lang::Sounds::P3_CHARGE);
+    }
+    charging_ = charging;
+
+    const char* icon;
+    if (charging) {
+        icon = FONT_AWESOME_BATTERY_CHARGING;
+    } else {
+        const char* levels[] = {
+            FONT_AWESOME_BATTERY_EMPTY, // 0-19%
+            FONT_AWESOME_BATTERY_1,    // 20-39%
+            FONT_AWESOME_BATTERY_2,    // 40-59%
+            FONT_AWESOME_BATTERY_3,    // 60-79%
+            FONT_AWESOME_BATTERY_FULL, // 80-99%
+            FONT_AWESOME_BATTERY_FULL, // 100%
+        };
+        icon = levels[std::clamp(level, 0, 100) / 20];
+    }
+    bool low_battery = strcmp(icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging;
+    if (icon == battery_icon_ && low_battery == low_battery_) {
+        return;
+    }
+
+    DisplayLockGuard lock(this);
+    battery_icon_ = icon;
+    SetLabelText(battery_label_, icon);
+
+    if (low_battery != low_battery_) {
+        low_battery_ = low_battery;
+        if (low_battery_popup_ != nullptr) {
+            if (low_battery) {
+                lv_obj_clear_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
+                auto& app = Application::GetInstance();
+                app.PlaySound(Lang::Sounds::P3_LOW_BATTERY);
+            } else {
+                // Hide the low battery popup when the battery is not empty
+                lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
             }
         }
     }
+}
+
+void Display::SetNetworkIcon(const char* icon) {
+    if (icon == nullptr || icon == network_icon_) {
+        return;
+    }
+    network_icon_ = icon;
+    DisplayLockGuard lock(this);
+    SetLabelText(network_label_, icon);
+}
+
+void Display::UpdateStatusBar(bool update_all) {
+    auto& board = Board::GetInstance();
+
+    // Volume changes arrive through AudioCodec::OnOutputVolumeChange
+    if (update_all) {
+        SetMuted(board.GetAudioCodec()->output_volume() == 0);
+    }
 
     esp_pm_lock_acquire(pm_lock_);
     // 更新电池图标 (always check battery level for logging, even if UI is disabled)
     int battery_level;
     bool charging, discharging;
-    static bool prev_charging = false;  // Track previous charging state
-    const char* icon = nullptr;
     if (board.GetBatteryLevel(battery_level, charging, discharging)) {
-        // Play charge sound when USB charging is detected (transition from not charging to charging)
-        // Only play if battery level is 90% or below
-        if (charging && !prev_charging && battery_level <= 90) {
-            auto& app = Application::GetInstance();
-            app.PlaySound(Lang::Sounds::P3_CHARGE);
-        }
-        prev_charging = charging;  // Update previous state
-        
-        if (charging) {
-            icon = FONT_AWESOME_BATTERY_CHARGING;
-        } else {
-            const char* levels[] = {
-                FONT_AWESOME_BATTERY_EMPTY, // 0-19%
-                FONT_AWESOME_BATTERY_1,    // 20-39%
-                FONT_AWESOME_BATTERY_2,    // 40-59%
-                FONT_AWESOME_BATTERY_3,    // 60-79%
-                FONT_AWESOME_BATTERY_FULL, // 80-99%
-                FONT_AWESOME_BATTERY_FULL, // 100%
-            };
-            icon = levels[battery_level / 20];
-        }
-        DisplayLockGuard lock(this);
-        if (battery_label_ != nullptr && battery_icon_ != icon) {
-            battery_icon_ = icon;
-            lv_label_set_text(battery_label_, battery_icon_);
-        }
-
-        if (low_battery_popup_ != nullptr) {
-            if (strcmp(icon, FONT_AWESOME_BATTERY_EMPTY) == 0 && discharging) {
-                if (lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框隐藏，则显示
-                    lv_obj_clear_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
-                    auto& app = Application::GetInstance();
-                    app.PlaySound(Lang::Sounds::P3_LOW_BATTERY);
-                }
-            } else {
-                // Hide the low battery popup when the battery is not empty
-                if (!lv_obj_has_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN)) { // 如果低电量提示框显示，则隐藏
-                    lv_obj_add_flag(low_battery_popup_, LV_OBJ_FLAG_HIDDEN);
-                }
-            }
-        }
+        SetBatteryState(battery_level, charging, discharging);
     }
 
     // 每 10 秒更新一次网络图标
@@ -195,12 +217,8 @@ void Display::UpdateStatusBar(bool update_all) {
             kDeviceStateActivating,
         };
         if (std::find(allowed_states.begin(), allowed_states.end(), device_state) != allowed_states.end()) {
-            icon = board.GetNetworkStateIcon();
-            if (network_label_ != nullptr && icon != nullptr && network_icon_ != icon) {
-                DisplayLockGuard lock(this);
-                network_icon_ = icon;
-                lv_label_set_text(network_label_, network_icon_);
-            }
+            // The icon is a constant per RSSI bucket, so this only redraws when the bucket changes
+            SetNetworkIcon(board.GetNetworkStateIcon());
         }
     }
 
@@ -288,6 +306,11 @@ void Display::SetTheme(const std::string& theme_name) {
 
 void Display::SetEmotionImg(const lv_image_dsc_t *img){};
 
+void Display::OnEmotionGifDone(std::function<void(const uint8_t* gif_data)> callback) {
+    DisplayLockGuard lock(this);
+    on_emotion_gif_done_ = callback;
+}
+
 void Display::SetEmotionGif(const uint8_t* gif_data, size_t gif_size) {
     // Default implementation does nothing
     // Subclasses (like LcdDisplay) will override this
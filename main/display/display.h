@@ -7,6 +7,16 @@
 #include <esp_pm.h>
 
 #include <string>
+#include <functional>
+
+// LVGL refresh counters, for displays that have them
+struct DisplayRenderStats {
+    uint32_t frames;            // Refreshes that redrew something
+    uint32_t flushes;           // Areas handed to the panel driver
+    uint32_t fps_x10;           // Frames per second since the previous call, times 10
+    uint32_t flush_wait_us;     // Time LVGL waited for the panel since the previous call
+    uint32_t invalidated_px_per_min;    // Pixels marked dirty, averaged since the previous call
+};
 
 struct DisplayFonts {
     const lv_font_t* text_font = nullptr;
@@ -28,9 +38,23 @@ public:
     virtual void SetPreviewImage(const lv_img_dsc_t* image);
     virtual void SetTheme(const std::string& theme_name);
     virtual std::string GetTheme() { return current_theme_name_; }
+    // Samples battery and network state and forwards what changed to the setters below
     virtual void UpdateStatusBar(bool update_all = false);
+    // Status bar inputs; the display is locked and redrawn only when the value changed
+    virtual void SetMuted(bool muted);
+    virtual void SetBatteryState(int level, bool charging, bool discharging);
+    virtual void SetNetworkIcon(const char* icon);
     virtual void SetEmotionImg(const lv_image_dsc_t *img);
     virtual void SetEmotionGif(const uint8_t* gif_data, size_t gif_size);
+    // Buffer currently handed to the GIF widget (nullptr if none)
+    virtual const uint8_t* GetEmotionGifData() { return nullptr; }
+    // Called from the LVGL task when a GIF that does not loop forever has played its last frame
+    void OnEmotionGifDone(std::function<void(const uint8_t* gif_data)> callback);
+    virtual bool GetRenderStats(DisplayRenderStats& stats) { return false; }
+    // Duration of the most recent LVGL refresh, 0 if unknown
+    virtual uint32_t GetLastRenderUs() { return 0; }
+    // Stop showing any of these images before the caller frees them
+    virtual void ReleaseEmotionImages(const lv_image_dsc_t* images, size_t count) {}
     inline int width() const { return width_; }
     inline int height() const { return height_; }
 
@@ -54,9 +78,15 @@ protected:
     const char* battery_icon_ = nullptr;
     const char* network_icon_ = nullptr;
     bool muted_ = false;
+    bool low_battery_ = false;
+    bool charging_ = false;
+
+    // lv_label_set_text() redraws even for the same text; call with the display locked
+    bool SetLabelText(lv_obj_t* label, const char* text);
     std::string current_theme_name_;
 
     esp_timer_handle_t notification_timer_ = nullptr;
+    std::function<void(const uint8_t* gif_data)> on_emotion_gif_done_;
 
     friend class DisplayLockGuard;
     virtual bool Lock(int timeout_ms = 0) = 0;
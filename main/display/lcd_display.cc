@@ -13,6 +13,7 @@
 #include "animation.h"
 #include "board.h"
 #include "audio_codec.h"
+#include "system_info.h"
 #include <stdio.h>
 #include <unistd.h>
 
@@ -87,6 +88,13 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
                              DisplayFonts fonts)
     : LcdDisplay(panel_io, panel, fonts, width, height)
 {
+    mirror_x_ = mirror_x;
+    mirror_y_ = mirror_y;
+    // Mirroring a panel with a GRAM offset would also move the visible window.
+    // Re-applying the board's own mirror settings tells whether the driver can mirror at all.
+#if !CONFIG_LCD_FORCE_SOFTWARE_ROTATION
+    hardware_rotation_ = (offset_x == 0 && offset_y == 0) && esp_lcd_panel_mirror(panel_, mirror_x, mirror_y) == ESP_OK;
+#endif
 
     // draw black before LVGL starts so startup GIF edges never reveal white panel memory
     std::vector<uint16_t> buffer(width_, 0x0000);
@@ -104,18 +112,31 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
 
     ESP_LOGI(TAG, "Initialize LVGL port");
     lvgl_port_cfg_t port_cfg = ESP_LVGL_PORT_INIT_CONFIG();
-    port_cfg.task_priority = 1;
-    port_cfg.timer_period_ms = 50;
+    port_cfg.task_priority = CONFIG_LCD_LVGL_TASK_PRIORITY;
+    port_cfg.timer_period_ms = CONFIG_LCD_LVGL_TICK_PERIOD_MS;
     lvgl_port_init(&port_cfg);
 
-    ESP_LOGI(TAG, "Adding LCD display");
+    // Two draw buffers: the SPI DMA transfer of one overlaps rendering into the other
+#if CONFIG_LCD_DRAW_BUFFER_PSRAM
+    // Full frames in PSRAM, copied out through a DMA-capable bounce buffer
+    const uint32_t buffer_size = static_cast<uint32_t>(width_ * height_);
+    const uint32_t trans_size = static_cast<uint32_t>(width_ * CONFIG_LCD_DRAW_BUFFER_LINES);
+    const bool buffer_spiram = true;
+#else
+    const uint32_t buffer_size = static_cast<uint32_t>(width_ * std::min(height_, CONFIG_LCD_DRAW_BUFFER_LINES));
+    const uint32_t trans_size = 0;
+    const bool buffer_spiram = false;
+#endif
+
+    ESP_LOGI(TAG, "Adding LCD display, 2 x %lu pixel draw buffers in %s", (unsigned long)buffer_size,
+             buffer_spiram ? "PSRAM" : "internal RAM");
     const lvgl_port_display_cfg_t display_cfg = {
         .io_handle = panel_io_,
         .panel_handle = panel_,
         .control_handle = nullptr,
-        .buffer_size = static_cast<uint32_t>(width_ * 20),
-        .double_buffer = false,
-        .trans_size = 0,
+        .buffer_size = buffer_size,
+        .double_buffer = true,
+        .trans_size = trans_size,
         .hres = static_cast<uint32_t>(width_),
         .vres = static_cast<uint32_t>(height_),
         .monochrome = false,
@@ -126,9 +147,10 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         },
         .color_format = LV_COLOR_FORMAT_RGB565,
         .flags = {
-            .buff_dma = 1,
-            .buff_spiram = 0,
-            .sw_rotate = 0,
+            .buff_dma = !buffer_spiram,
+            .buff_spiram = buffer_spiram,
+            // Without sw_rotate esp_lvgl_port implements LVGL rotation with the same panel mirror calls
+            .sw_rotate = !hardware_rotation_,
             .swap_bytes = 1,
             .full_refresh = 0,
             .direct_mode = 0,
@@ -141,6 +163,7 @@ SpiLcdDisplay::SpiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         ESP_LOGE(TAG, "Failed to add display");
         return;
     }
+    EnableRenderStats();
 
     if (offset_x != 0 || offset_y != 0)
     {
@@ -207,6 +230,7 @@ RgbLcdDisplay::RgbLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel_h
         ESP_LOGE(TAG, "Failed to add RGB display");
         return;
     }
+    EnableRenderStats();
 
     if (offset_x != 0 || offset_y != 0)
     {
@@ -267,6 +291,7 @@ MipiLcdDisplay::MipiLcdDisplay(esp_lcd_panel_io_handle_t panel_io, esp_lcd_panel
         ESP_LOGE(TAG, "Failed to add display");
         return;
     }
+    EnableRenderStats();
 
     if (offset_x != 0 || offset_y != 0)
     {
@@ -323,6 +348,77 @@ void LcdDisplay::Unlock()
     lvgl_port_unlock();
 }
 
+void LcdDisplay::EnableRenderStats()
+{
+    SystemInfo::RegisterLatencyHistogram("lcd.render", &render_latency_);
+    SystemInfo::RegisterLatencyHistogram("lcd.flush", &flush_wait_latency_);
+    last_stats_us_ = esp_timer_get_time();
+    for (auto code : {LV_EVENT_RENDER_START, LV_EVENT_RENDER_READY, LV_EVENT_FLUSH_START,
+                      LV_EVENT_FLUSH_WAIT_START, LV_EVENT_FLUSH_WAIT_FINISH, LV_EVENT_INVALIDATE_AREA})
+    {
+        lv_display_add_event_cb(display_, OnRenderEvent, code, this);
+    }
+}
+
+void LcdDisplay::OnRenderEvent(lv_event_t* e)
+{
+    auto self = static_cast<LcdDisplay*>(lv_event_get_user_data(e));
+    int64_t now_us = esp_timer_get_time();
+    switch (lv_event_get_code(e))
+    {
+    case LV_EVENT_RENDER_START:
+        self->render_start_us_ = now_us;
+        break;
+    case LV_EVENT_RENDER_READY:
+        self->frames_.fetch_add(1, std::memory_order_relaxed);
+        self->last_render_us_.store(now_us - self->render_start_us_, std::memory_order_relaxed);
+        self->render_latency_.Record(now_us - self->render_start_us_);
+        break;
+    case LV_EVENT_FLUSH_START:
+        self->flushes_.fetch_add(1, std::memory_order_relaxed);
+        break;
+    case LV_EVENT_FLUSH_WAIT_START:
+        self->flush_wait_start_us_ = now_us;
+        break;
+    case LV_EVENT_FLUSH_WAIT_FINISH:
+        self->flush_wait_latency_.Record(now_us - self->flush_wait_start_us_);
+        self->flush_wait_us_.fetch_add(now_us - self->flush_wait_start_us_, std::memory_order_relaxed);
+        break;
+    case LV_EVENT_INVALIDATE_AREA:
+        // Already clipped to the display; overlapping areas are counted twice
+        self->invalidated_px_.fetch_add(lv_area_get_size(static_cast<lv_area_t*>(lv_event_get_param(e))),
+                                        std::memory_order_relaxed);
+        break;
+    default:
+        break;
+    }
+}
+
+bool LcdDisplay::GetRenderStats(DisplayRenderStats& stats)
+{
+    if (display_ == nullptr)
+    {
+        return false;
+    }
+    int64_t now_us = esp_timer_get_time();
+    uint32_t frames = frames_.load(std::memory_order_relaxed);
+    uint64_t flush_wait_us = flush_wait_us_.load(std::memory_order_relaxed);
+    uint64_t invalidated_px = invalidated_px_.load(std::memory_order_relaxed);
+    int64_t elapsed_us = std::max<int64_t>(now_us - last_stats_us_, 1);
+
+    stats.frames = frames;
+    stats.flushes = flushes_.load(std::memory_order_relaxed);
+    stats.fps_x10 = (uint32_t)((uint64_t)(frames - last_stats_frames_) * 10000000 / elapsed_us);
+    stats.flush_wait_us = (uint32_t)(flush_wait_us - last_stats_flush_wait_us_);
+    stats.invalidated_px_per_min = (uint32_t)((invalidated_px - last_stats_invalidated_px_) * 60000000 / elapsed_us);
+
+    last_stats_frames_ = frames;
+    last_stats_flush_wait_us_ = flush_wait_us;
+    last_stats_invalidated_px_ = invalidated_px;
+    last_stats_us_ = now_us;
+    return true;
+}
+
 #if CONFIG_USE_WECHAT_MESSAGE_STYLE
 void LcdDisplay::SetupUI()
 {
@@ -1413,9 +1509,12 @@ void LcdDisplay::SetEmotionImg(const lv_image_dsc_t *img)
         return;
     }
     
-    // Hide GIF widget if it exists
+    // Hide GIF widget if it exists; pause it so its timer stops decoding
     if (emotion_gif_ != nullptr) {
         lv_obj_add_flag(emotion_gif_, LV_OBJ_FLAG_HIDDEN);
+#if LV_USE_GIF
+        lv_gif_pause(emotion_gif_);
+#endif
     }
     
     // Create emotion_label_ in content area if it doesn't exist (status bar disabled)
@@ -1484,6 +1583,13 @@ void LcdDisplay::SetEmotionGif(const uint8_t* gif_data, size_t gif_size)
         lv_obj_set_style_pad_all(emotion_gif_, 0, 0);
         lv_obj_set_style_margin_all(emotion_gif_, 0, 0);
         lv_obj_set_style_border_width(emotion_gif_, 0, 0);
+        // Sent after the last repeat; GIFs looping forever never send it
+        lv_obj_add_event_cb(emotion_gif_, [](lv_event_t* e) {
+            auto self = static_cast<LcdDisplay*>(lv_event_get_user_data(e));
+            if (self->on_emotion_gif_done_) {
+                self->on_emotion_gif_done_(self->emotion_gif_data_);
+            }
+        }, LV_EVENT_READY, this);
     }
     
     if (emotion_gif_ == nullptr) {
@@ -1502,6 +1608,10 @@ void LcdDisplay::SetEmotionGif(const uint8_t* gif_data, size_t gif_size)
     
     // Avoid resetting the GIF if the source is unchanged.
     if (emotion_gif_data_ == gif_data && emotion_gif_size_ == gif_size) {
+        // May have been paused by SetEmotionImg()
+        if (lv_gif_is_loaded(emotion_gif_)) {
+            lv_gif_resume(emotion_gif_);
+        }
         return;
     }
 
@@ -1537,6 +1647,24 @@ void LcdDisplay::SetEmotionGif(const uint8_t* gif_data, size_t gif_size)
 #endif
 }
 
+void LcdDisplay::ReleaseEmotionImages(const lv_image_dsc_t* images, size_t count)
+{
+    DisplayLockGuard lock(this);
+    if (emotion_label_ == nullptr || count == 0) {
+        return;
+    }
+    auto src = static_cast<const lv_image_dsc_t*>(lv_image_get_src(emotion_label_));
+    if (src >= images && src < images + count) {
+        lv_image_set_src(emotion_label_, nullptr);
+    }
+}
+
+const uint8_t* LcdDisplay::GetEmotionGifData()
+{
+    DisplayLockGuard lock(this);
+    return emotion_gif_data_;
+}
+
 void LcdDisplay::SetStartupVisualLock(bool locked)
 {
     DisplayLockGuard lock(this);
@@ -1825,12 +1953,26 @@ void LcdDisplay::SetDisplayRotation180(bool upside_down)
         ESP_LOGE(TAG, "Display is null, cannot set rotation");
         return;
     }
-    
-    // Track rotation state for overlay coordinate transformation
+
     display_rotated_180_ = upside_down;
-    
-    // Use LVGL display rotation API - most efficient for 180° rotation
+
+    if (hardware_rotation_) {
+        // Undo any LVGL rotation first: esp_lvgl_port re-applies its own mirror settings when it changes
+        lv_display_set_rotation(display_, LV_DISPLAY_ROTATION_0);
+        // The controller scans the frame mirrored on both axes (MADCTL), so LVGL keeps
+        // rendering and flushing unrotated areas
+        esp_err_t err = esp_lcd_panel_mirror(panel_, mirror_x_ != upside_down, mirror_y_ != upside_down);
+        if (err != ESP_OK) {
+            // sw_rotate is fixed when the display is added, so LVGL cannot take over here
+            ESP_LOGE(TAG, "Panel mirror failed (%s), rotation unchanged", esp_err_to_name(err));
+            return;
+        }
+        lv_obj_invalidate(lv_screen_active());
+        ESP_LOGI(TAG, "Display rotation set to %s by the panel", upside_down ? "180° (upside down)" : "0° (normal)");
+        return;
+    }
+
     lv_display_rotation_t rotation = upside_down ? LV_DISPLAY_ROTATION_180 : LV_DISPLAY_ROTATION_0;
     lv_display_set_rotation(display_, rotation);
-    ESP_LOGI(TAG, "Display rotation set to %s", upside_down ? "180° (upside down)" : "0° (normal)");
+    ESP_LOGI(TAG, "Display rotation set to %s by LVGL", upside_down ? "180° (upside down)" : "0° (normal)");
 }
@@ -2,12 +2,14 @@
 #define LCD_DISPLAY_H
 
 #include "display.h"
+#include "latency_histogram.h"
 
 #include <esp_lcd_panel_io.h>
 #include <esp_lcd_panel_ops.h>
 #include <font_emoji.h>
 
 #include <atomic>
+#include <cstdint>
 
 // Theme color structure
 struct ThemeColors {
@@ -48,8 +50,30 @@ protected:
     DisplayFonts fonts_;
     ThemeColors current_theme_;
     bool display_rotated_180_ = false;  // Track 180° rotation state
+    // Panel orientation set up by the board; 180° flips both mirror bits
+    bool mirror_x_ = false;
+    bool mirror_y_ = false;
+    bool hardware_rotation_ = false;    // Panel driver can rotate through esp_lcd_panel_mirror
+
+    // Written from the LVGL task through display events
+    LatencyHistogram render_latency_;       // Render start -> ready, per frame
+    LatencyHistogram flush_wait_latency_;   // LVGL blocked on the panel transfer
+    int64_t render_start_us_ = 0;
+    int64_t flush_wait_start_us_ = 0;
+    std::atomic<uint32_t> frames_{0};
+    std::atomic<uint32_t> last_render_us_{0};
+    std::atomic<uint32_t> flushes_{0};
+    std::atomic<uint64_t> flush_wait_us_{0};
+    std::atomic<uint64_t> invalidated_px_{0};   // Written by whoever holds the LVGL lock
+    uint32_t last_stats_frames_ = 0;
+    uint64_t last_stats_flush_wait_us_ = 0;
+    uint64_t last_stats_invalidated_px_ = 0;
+    int64_t last_stats_us_ = 0;
 
     void SetupUI();
+    // Hook the render counters into display_; call once it has been added
+    void EnableRenderStats();
+    static void OnRenderEvent(lv_event_t* e);
     virtual bool Lock(int timeout_ms = 0) override;
     virtual void Unlock() override;
 
@@ -68,6 +92,10 @@ public:
     virtual void SetEmotionImg(const lv_image_dsc_t *img) override;
     // Set GIF animation from data
     void SetEmotionGif(const uint8_t* gif_data, size_t gif_size);
+    virtual const uint8_t* GetEmotionGifData() override;
+    virtual bool GetRenderStats(DisplayRenderStats& stats) override;
+    virtual uint32_t GetLastRenderUs() override { return last_render_us_.load(std::memory_order_relaxed); }
+    virtual void ReleaseEmotionImages(const lv_image_dsc_t* images, size_t count) override;
     // Add theme switching function
     virtual void SetTheme(const std::string& theme_name) override;
     
@@ -1,5 +1,6 @@
 #include "error_log_uploader.h"
 #include "sd_card.h"
+#include "sd_log_sink.h"
 #include "system_info.h"
 #include "board.h"
 
@@ -10,15 +11,17 @@
 #include <cstdarg>
 #include <cstdio>
 #include <freertos/FreeRTOS.h>
-#include <freertos/semphr.h>
 
 #define TAG "ErrorLogUpload"
 
 // Static variables for error logging hook
 static bool s_error_logging_enabled = false;
 static vprintf_like_t s_original_vprintf = nullptr;
-static SemaphoreHandle_t s_log_mutex = nullptr;
-static bool s_in_hook = false; // Flag to prevent recursion
+
+// err.txt is rotated to err.1.txt ... once it reaches this size. Stay below the
+// 100 KB that ReadErrorLogFile() uploads.
+#define ERROR_LOG_MAX_FILE_BYTES (96 * 1024)
+#define ERROR_LOG_MAX_ROTATED_FILES 2
 
 std::string ErrorLogUploader::GetCurrentTimestamp() {
     time_t now = time(NULL);
@@ -75,6 +78,12 @@ esp_err_t ErrorLogUploader::ReadErrorLogFile(std::string& content) {
 esp_err_t ErrorLogUploader::UploadErrorLog() {
     ESP_LOGI(TAG, "Starting error log upload");
     
+    // Make sure lines still queued in the sink are on the card first
+    auto& sink = SdLogSink::GetInstance();
+    if (sink.IsRunning()) {
+        sink.Flush();
+    }
+
     // Read error log file
     std::string file_content;
     esp_err_t ret = ReadErrorLogFile(file_content);
@@ -178,27 +187,22 @@ esp_err_t ErrorLogUploader::UploadErrorLog() {
     
     // After successful upload, delete the error log file to start fresh
     // Note: This will be done after enabling error logging, so new errors can be captured
-    remove(ERROR_LOG_FILE);
+    if (sink.IsRunning()) {
+        // The sink keeps err.txt open; reopen it on a fresh file.
+        sink.Stop();
+        remove(ERROR_LOG_FILE);
+        sink.Start(ERROR_LOG_FILE, ERROR_LOG_MAX_FILE_BYTES, ERROR_LOG_MAX_ROTATED_FILES);
+    } else {
+        remove(ERROR_LOG_FILE);
+    }
     
     return ESP_OK;
 }
 
-// vprintf hook function that captures ESP log messages and writes to SD card
+// vprintf hook function that captures ESP log messages for the SD card.
+// It only formats and copies the line into SdLogSink's lock-free ring; the
+// sink's writer task does the FAT/SPI work, so logging never blocks on the card.
 int ErrorLogVprintfHook(const char* format, va_list args) {
-    // Prevent recursion - if we're already in the hook, just call original and return
-    if (s_in_hook) {
-        if (s_original_vprintf) {
-            va_list args_copy;
-            va_copy(args_copy, args);
-            int result = s_original_vprintf(format, args_copy);
-            va_end(args_copy);
-            return result;
-        }
-        return 0;
-    }
-    
-    s_in_hook = true;
-    
     // First call the original vprintf to maintain normal logging
     int result = 0;
     if (s_original_vprintf) {
@@ -207,53 +211,27 @@ int ErrorLogVprintfHook(const char* format, va_list args) {
         result = s_original_vprintf(format, args_copy);
         va_end(args_copy);
     }
-    
-    // If error logging is enabled and SD card is mounted, write to file
-    if (s_error_logging_enabled && SdCard::IsMounted()) {
-        // Take mutex to prevent concurrent writes
-        if (s_log_mutex && xSemaphoreTake(s_log_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            // Format the log message
-            char log_buffer[512];
-            va_list args_copy2;
-            va_copy(args_copy2, args);
-            int len = vsnprintf(log_buffer, sizeof(log_buffer), format, args_copy2);
-            va_end(args_copy2);
-            
-            if (len > 0 && len < (int)sizeof(log_buffer)) {
-                // Filter: Only write ERROR (E) and WARNING (W) messages to err.txt
-                // ESP-IDF log format: "E (timestamp) TAG: message" or "W (timestamp) TAG: message"
-                // Skip INFO (I) and DEBUG (D) messages to keep the error log focused
-                bool should_log = false;
-                if (len >= 2) {
-                    // Check if message starts with "E (" for ERROR or "W (" for WARNING
-                    if ((log_buffer[0] == 'E' && log_buffer[1] == ' ') ||
-                        (log_buffer[0] == 'W' && log_buffer[1] == ' ')) {
-                        should_log = true;
-                    }
-                }
-                
-                if (should_log) {
-                    // Write directly to file to avoid recursion from AppendToFile's logging
-                    // This bypasses SdCard::AppendToFile which would log and cause recursion
-                    // Use the same path as ERROR_LOG_FILE constant: "/sdcard/err.txt"
-                    const char* full_path = "/sdcard/err.txt";
-                    FILE* file = fopen(full_path, "a");  // "a" = append mode
-                    if (file != NULL) {
-                        size_t bytes_written = fwrite(log_buffer, 1, len, file);
-                        fflush(file);  // Ensure data is flushed
-                        fclose(file);
-                        // Ignore write errors silently to avoid recursion
-                        (void)bytes_written;
-                    }
-                    // If file open fails, silently ignore to avoid recursion
-                }
-            }
-            
-            xSemaphoreGive(s_log_mutex);
-        }
+
+    // Filter: Only write ERROR (E) and WARNING (W) messages to err.txt
+    // ESP-IDF log format: "E (timestamp) TAG: message" or "W (timestamp) TAG: message"
+    // Skip INFO (I) and DEBUG (D) messages to keep the error log focused.
+    // The level letter is a literal at the start of the format string, so this
+    // is checked before paying for vsnprintf.
+    if (!s_error_logging_enabled || (format[0] != 'E' && format[0] != 'W') || format[1] != ' ') {
+        return result;
     }
-    
-    s_in_hook = false;
+    char log_buffer[512];
+    va_list args_copy2;
+    va_copy(args_copy2, args);
+    int len = vsnprintf(log_buffer, sizeof(log_buffer), format, args_copy2);
+    va_end(args_copy2);
+    if (len <= 0) {
+        return result;
+    }
+    if (len >= (int)sizeof(log_buffer)) {
+        len = sizeof(log_buffer) - 1;
+    }
+    SdLogSink::GetInstance().Enqueue(log_buffer, len);
     return result;
 }
 
@@ -269,13 +247,9 @@ void ErrorLogUploader::EnableErrorLoggingToSD() {
         return;
     }
     
-    // Create mutex if it doesn't exist
-    if (s_log_mutex == nullptr) {
-        s_log_mutex = xSemaphoreCreateMutex();
-        if (s_log_mutex == nullptr) {
-            ESP_LOGE(TAG, "Failed to create mutex for error logging");
-            return;
-        }
+    if (!SdLogSink::GetInstance().Start(ERROR_LOG_FILE, ERROR_LOG_MAX_FILE_BYTES, ERROR_LOG_MAX_ROTATED_FILES)) {
+        ESP_LOGE(TAG, "Failed to start SD log sink");
+        return;
     }
     
     // Store the original vprintf function
@@ -304,6 +278,11 @@ void ErrorLogUploader::DisableErrorLoggingToSD() {
     }
     
     s_error_logging_enabled = false;
-    ESP_LOGI(TAG, "Error logging to SD card disabled");
+    SdLogSink::GetInstance().Stop();
+
+    auto stats = SdLogSink::GetInstance().GetStats();
+    ESP_LOGI(TAG, "Error logging to SD card disabled (lines=%u dropped=%u truncated=%u bytes=%u rotations=%u max_enqueue=%uus)",
+             (unsigned)stats.enqueued, (unsigned)stats.dropped, (unsigned)stats.truncated,
+             (unsigned)stats.bytes_written, (unsigned)stats.rotations, (unsigned)stats.max_enqueue_us);
 }
 
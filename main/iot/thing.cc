@@ -52,6 +52,50 @@ std::string Thing::GetStateJson() {
     return json_str;
 }
 
+size_t Thing::SampleState() {
+    changed_.resize(properties_.size());
+    changed_count_ = 0;
+    size_t i = 0;
+    for (auto& property : properties_) {
+        changed_[i] = property.Sample();
+        changed_count_ += changed_[i] ? 1 : 0;
+        i++;
+    }
+    return changed_count_;
+}
+
+void Thing::AppendStateJson(std::string& json, bool changed_only) {
+    json += "{\"name\":\"" + name_ + "\",\"state\":{";
+    size_t i = 0;
+    bool first = true;
+    for (auto& property : properties_) {
+        if (!changed_only || changed_[i]) {
+            if (!first) {
+                json += ",";
+            }
+            property.AppendSampleJson(json);
+            first = false;
+        }
+        i++;
+    }
+    json += "}}";
+}
+
+void Thing::WriteStateCbor(CborWriter& writer, bool changed_only) {
+    writer.Map(2);
+    writer.String("name");
+    writer.String(name_);
+    writer.String("state");
+    writer.Map(changed_only ? changed_count_ : properties_.size());
+    size_t i = 0;
+    for (auto& property : properties_) {
+        if (!changed_only || changed_[i]) {
+            property.WriteSampleCbor(writer);
+        }
+        i++;
+    }
+}
+
 void Thing::Invoke(const cJSON* command) {
     auto method_name = cJSON_GetObjectItem(command, "method");
     auto input_params = cJSON_GetObjectItem(command, "parameters");
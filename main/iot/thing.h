@@ -8,6 +8,8 @@
 #include <stdexcept>
 #include <cJSON.h>
 
+#include "cbor_writer.h"
+
 namespace iot {
 
 enum ValueType {
@@ -25,6 +27,12 @@ private:
     std::function<int()> number_getter_;
     std::function<std::string()> string_getter_;
 
+    // Value read by the last Sample()
+    bool sampled_ = false;
+    bool boolean_value_ = false;
+    int number_value_ = 0;
+    std::string string_value_;
+
 public:
     Property(const std::string& name, const std::string& description, std::function<bool()> getter) :
         name_(name), description_(description), type_(kValueTypeBoolean), boolean_getter_(getter) {}
@@ -61,10 +69,79 @@ public:
         } else if (type_ == kValueTypeNumber) {
             return std::to_string(number_getter_());
         } else if (type_ == kValueTypeString) {
-            return "\"" + string_getter_() + "\"";
+            std::string json;
+            AppendJsonString(json, string_getter_());
+            return json;
         }
         return "null";
     }
+    // Read the getter once; returns true if the value differs from the
+    // previous sample (or there was none)
+    bool Sample() {
+        bool changed = !sampled_;
+        if (type_ == kValueTypeBoolean) {
+            bool value = boolean_getter_();
+            changed |= value != boolean_value_;
+            boolean_value_ = value;
+        } else if (type_ == kValueTypeNumber) {
+            int value = number_getter_();
+            changed |= value != number_value_;
+            number_value_ = value;
+        } else if (type_ == kValueTypeString) {
+            std::string value = string_getter_();
+            if (value != string_value_) {
+                changed = true;
+                string_value_ = std::move(value);
+            }
+        }
+        sampled_ = true;
+        return changed;
+    }
+
+    // Append "name":value from the last sample
+    void AppendSampleJson(std::string& json) const {
+        json += "\"" + name_ + "\":";
+        if (type_ == kValueTypeBoolean) {
+            json += boolean_value_ ? "true" : "false";
+        } else if (type_ == kValueTypeNumber) {
+            json += std::to_string(number_value_);
+        } else {
+            AppendJsonString(json, string_value_);
+        }
+    }
+
+    // Append value as a quoted JSON string; string properties carry
+    // arbitrary text (song titles, SSIDs) that may contain quotes
+    static void AppendJsonString(std::string& json, const std::string& value) {
+        static const char kHex[] = "0123456789abcdef";
+        json += '"';
+        for (char c : value) {
+            if (c == '"' || c == '\\') {
+                json += '\\';
+                json += c;
+            } else if (c == '\n') {
+                json += "\\n";
+            } else if ((unsigned char)c < 0x20) {
+                json += "\\u00";
+                json += kHex[(unsigned char)c >> 4];
+                json += kHex[c & 0xf];
+            } else {
+                json += c;
+            }
+        }
+        json += '"';
+    }
+
+    void WriteSampleCbor(CborWriter& writer) const {
+        writer.String(name_);
+        if (type_ == kValueTypeBoolean) {
+            writer.Bool(boolean_value_);
+        } else if (type_ == kValueTypeNumber) {
+            writer.Int(number_value_);
+        } else {
+            writer.String(string_value_);
+        }
+    }
 };
 
 class PropertyList {
@@ -85,6 +162,11 @@ public:
         properties_.push_back(Property(name, description, getter));
     }
 
+    // iterator
+    auto begin() { return properties_.begin(); }
+    auto end() { return properties_.end(); }
+    size_t size() const { return properties_.size(); }
+
     const Property& operator[](const std::string& name) const {
         for (auto& property : properties_) {
             if (property.name() == name) {
@@ -270,6 +352,14 @@ public:
     virtual std::string GetStateJson();
     virtual void Invoke(const cJSON* command);
 
+    // Sample every property and mark the ones that changed; returns how
+    // many did. Delta updates then serialise only those.
+    size_t SampleState();
+    bool has_changes() const { return changed_count_ > 0; }
+    // {"name":...,"state":{...}} from the last sample
+    void AppendStateJson(std::string& json, bool changed_only);
+    void WriteStateCbor(CborWriter& writer, bool changed_only);
+
     const std::string& name() const { return name_; }
     const std::string& description() const { return description_; }
 
@@ -280,6 +370,8 @@ protected:
 private:
     std::string name_;
     std::string description_;
+    std::vector<bool> changed_;     // Per property, from the last SampleState()
+    size_t changed_count_ = 0;
 };
 
 
@@ -1,6 +1,7 @@
 #include "thing_manager.h"
 
 #include <esp_log.h>
+#include <esp_timer.h>
 
 #define TAG "ThingManager"
 
@@ -22,32 +23,67 @@ std::string ThingManager::GetDescriptorsJson() {
     return json_str;
 }
 
+size_t ThingManager::SampleStates(bool delta) {
+    size_t count = 0;
+    for (auto& thing : things_) {
+        if (thing->SampleState() > 0 || !delta) {
+            count++;
+        }
+    }
+    return count;
+}
+
+void ThingManager::Account(int64_t start_us, size_t bytes) {
+    stats_.updates++;
+    stats_.bytes += bytes;
+    stats_.total_us += esp_timer_get_time() - start_us;
+}
+
 bool ThingManager::GetStatesJson(std::string& json, bool delta) {
-    if (!delta) {
-        last_states_.clear();
+    int64_t start_us = esp_timer_get_time();
+    size_t count = SampleStates(delta);
+    if (delta && count == 0) {
+        stats_.skipped++;
+        json = "[]";
+        return false;
     }
-    bool changed = false;
+
     json = "[";
-    // 枚举thing，获取每个thing的state，如果发生变化，则更新，保存到last_states_
-    // 如果delta为true，则只返回变化的部分
     for (auto& thing : things_) {
-        std::string state = thing->GetStateJson();
-        if (delta) {
-            // 如果delta为true，则只返回变化的部分
-            auto it = last_states_.find(thing->name());
-            if (it != last_states_.end() && it->second == state) {
-                continue;
-            }
-            changed = true;
-            last_states_[thing->name()] = state;
+        // The flags from SampleStates() decide what a delta carries
+        if (delta && !thing->has_changes()) {
+            continue;
         }
-        json += state + ",";
+        thing->AppendStateJson(json, delta);
+        json += ",";
     }
     if (json.back() == ',') {
         json.pop_back();
     }
     json += "]";
-    return changed;
+    Account(start_us, json.size());
+    return true;
+}
+
+bool ThingManager::GetStatesCbor(std::string& cbor, bool delta) {
+    int64_t start_us = esp_timer_get_time();
+    cbor.clear();
+    size_t count = SampleStates(delta);
+    if (delta && count == 0) {
+        stats_.skipped++;
+        return false;
+    }
+
+    CborWriter writer(cbor);
+    writer.Array(count);
+    for (auto& thing : things_) {
+        if (delta && !thing->has_changes()) {
+            continue;
+        }
+        thing->WriteStateCbor(writer, delta);
+    }
+    Account(start_us, cbor.size());
+    return true;
 }
 
 void ThingManager::Invoke(const cJSON* command) {
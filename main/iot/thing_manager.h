@@ -9,7 +9,6 @@
 #include <vector>
 #include <memory>
 #include <functional>
-#include <map>
 
 namespace iot {
 
@@ -24,16 +23,33 @@ public:
 
     void AddThing(Thing* thing);
 
+    struct Stats {
+        uint32_t updates;       // States messages built
+        uint32_t skipped;       // Delta polls with nothing to send
+        uint32_t bytes;         // Serialised states, JSON or CBOR
+        int64_t total_us;       // Sampling and serialising
+    };
+
     std::string GetDescriptorsJson();
+    // With delta, only things and properties that changed since the last
+    // call are included; returns false if there was nothing to send
     bool GetStatesJson(std::string& json, bool delta = false);
+    // Same as GetStatesJson, as a CBOR array
+    bool GetStatesCbor(std::string& cbor, bool delta = false);
     void Invoke(const cJSON* command);
 
+    Stats GetStats() const { return stats_; }
+
 private:
     ThingManager() = default;
     ~ThingManager() = default;
 
     std::vector<Thing*> things_;
-    std::map<std::string, std::string> last_states_;
+    Stats stats_ = {};
+
+    // Sample every thing; returns the number of things to serialise
+    size_t SampleStates(bool delta);
+    void Account(int64_t start_us, size_t bytes);
 };
 
 
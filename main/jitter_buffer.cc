@@ -0,0 +1,204 @@
+#include "jitter_buffer.h"
+
+#include <esp_log.h>
+#include <cstdlib>
+
+#define TAG "JitterBuffer"
+
+JitterBuffer::JitterBuffer() {
+}
+
+bool JitterBuffer::Accepts(uint32_t sequence) const {
+    // With nothing left to play out there is no backlog to wait for.
+    if (!started_ || depth_.load(std::memory_order_relaxed) == 0) {
+        return true;
+    }
+    int32_t ahead = (int32_t)(sequence - next_sequence_);
+    return ahead < JITTER_BUFFER_SLOTS || ahead >= JITTER_BUFFER_RESYNC_FRAMES;
+}
+
+void JitterBuffer::Insert(AudioStreamPacket&& packet, int64_t now_us) {
+    received_.fetch_add(1, std::memory_order_relaxed);
+    int64_t arrival_us = packet.arrival_us != 0 ? packet.arrival_us : now_us;
+
+    int32_t ahead = (int32_t)(packet.sequence - next_sequence_);
+    bool restart = false;
+    if (started_ && ahead < 0 && ahead >= -JITTER_BUFFER_SLOTS) {
+        restart = IsRestart(packet);
+        if (!restart) {
+            late_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    if (!started_ || restart || ahead < 0 || ahead >= JITTER_BUFFER_SLOTS) {
+        // First frame, or the sequence jumped (new session on the server side):
+        // restart from this frame.
+        if (started_) {
+            ESP_LOGW(TAG, "Sequence jump %lu -> %lu, resync", (unsigned long)next_sequence_,
+                     (unsigned long)packet.sequence);
+            resyncs_.fetch_add(1, std::memory_order_relaxed);
+            Flush();
+        }
+        started_ = true;
+        playing_ = false;
+        starved_ = false;
+        have_transit_ = false;
+        have_newest_ = false;
+        next_sequence_ = packet.sequence;
+    }
+
+    Slot& slot = SlotFor(packet.sequence);
+    if (slot.filled) {
+        duplicates_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    if (starved_) {
+        rebuffers_.fetch_add(1, std::memory_order_relaxed);
+        starved_ = false;
+    }
+    if (!playing_ && depth_.load(std::memory_order_relaxed) == 0) {
+        buffering_since_us_ = arrival_us;
+    }
+    sample_rate_ = packet.sample_rate;
+    frame_duration_ = packet.frame_duration;
+    UpdateJitter(packet.sequence, arrival_us);
+    if (packet.timestamp != 0 && (!have_newest_ || (int32_t)(packet.sequence - newest_sequence_) > 0)) {
+        have_newest_ = true;
+        newest_sequence_ = packet.sequence;
+        newest_timestamp_ = packet.timestamp;
+    }
+
+    slot.packet = std::move(packet);
+    slot.filled = true;
+    depth_.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool JitterBuffer::IsRestart(const AudioStreamPacket& packet) const {
+    // Without sender timestamps a frame behind playout can only be late
+    if (!have_newest_ || packet.timestamp == 0 || frame_duration_ <= 0) {
+        return false;
+    }
+    int64_t frames_behind = (int32_t)(newest_sequence_ - packet.sequence);
+    int64_t behind_ms = (int32_t)(newest_timestamp_ - packet.timestamp);
+    // A late frame was not sent after the newest one, nor long before it
+    return behind_ms < 0 || behind_ms > frames_behind * frame_duration_ + JITTER_BUFFER_RESYNC_SLACK_MS;
+}
+
+void JitterBuffer::UpdateJitter(uint32_t sequence, int64_t arrival_us) {
+    if (frame_duration_ <= 0) {
+        return;
+    }
+    int32_t transit_ms = (int32_t)(arrival_us / 1000 - (int64_t)sequence * frame_duration_);
+    if (have_transit_) {
+        int32_t d = abs(transit_ms - last_transit_ms_);
+        // A pause between sentences is not jitter; cap a single sample.
+        int32_t max_d = frame_duration_ * JITTER_BUFFER_MAX_DELAY_FRAMES;
+        if (d > max_d) {
+            d = max_d;
+        }
+        jitter_q4_ += d - ((jitter_q4_ + 8) >> 4);
+    }
+    last_transit_ms_ = transit_ms;
+    have_transit_ = true;
+
+    uint32_t jitter_ms = jitter_q4_ >> 4;
+    jitter_ms_.store(jitter_ms, std::memory_order_relaxed);
+    uint32_t target = 1 + (2 * jitter_ms + frame_duration_ / 2) / frame_duration_;
+    if (target < JITTER_BUFFER_MIN_DELAY_FRAMES) {
+        target = JITTER_BUFFER_MIN_DELAY_FRAMES;
+    } else if (target > JITTER_BUFFER_MAX_DELAY_FRAMES) {
+        target = JITTER_BUFFER_MAX_DELAY_FRAMES;
+    }
+    target_frames_.store(target, std::memory_order_relaxed);
+}
+
+JitterBuffer::Action JitterBuffer::Next(AudioStreamPacket& packet, int64_t now_us) {
+    if (!started_) {
+        return Action::kWait;
+    }
+
+    size_t depth = depth_.load(std::memory_order_relaxed);
+    if (!playing_) {
+        if (depth == 0) {
+            return Action::kWait;
+        }
+        // Start once the target depth is buffered, or once the target delay has
+        // passed anyway (a short utterance may never reach the target depth).
+        uint32_t target = target_frames_.load(std::memory_order_relaxed);
+        int64_t target_us = (int64_t)target * frame_duration_ * 1000;
+        if (depth < target && now_us - buffering_since_us_ < target_us) {
+            return Action::kWait;
+        }
+        playing_ = true;
+    }
+
+    Slot& slot = SlotFor(next_sequence_);
+    if (slot.filled) {
+        packet = std::move(slot.packet);
+        slot.filled = false;
+        depth_.fetch_sub(1, std::memory_order_relaxed);
+        next_sequence_++;
+        played_.fetch_add(1, std::memory_order_relaxed);
+        return Action::kDecode;
+    }
+
+    if (depth == 0) {
+        // Ran dry: either the stream ended or the network stalled. Buffer
+        // up to the target again before resuming.
+        playing_ = false;
+        starved_ = true;
+        have_transit_ = false;
+        return Action::kWait;
+    }
+
+    // The frame due now is missing while later ones are here: it is lost.
+    packet.sequence = next_sequence_++;
+    packet.sample_rate = sample_rate_;
+    packet.frame_duration = frame_duration_;
+    packet.timestamp = 0;
+    Slot& following = SlotFor(next_sequence_);
+    if (following.filled) {
+        packet.payload = following.packet.payload;
+        recovered_.fetch_add(1, std::memory_order_relaxed);
+        return Action::kDecodeFec;
+    }
+    packet.payload.clear();
+    concealed_.fetch_add(1, std::memory_order_relaxed);
+    return Action::kConceal;
+}
+
+void JitterBuffer::Flush() {
+    for (auto& slot : slots_) {
+        if (slot.filled) {
+            slot.packet = AudioStreamPacket();
+            slot.filled = false;
+        }
+    }
+    depth_.store(0, std::memory_order_relaxed);
+}
+
+void JitterBuffer::Reset() {
+    Flush();
+    started_ = false;
+    playing_ = false;
+    starved_ = false;
+    have_transit_ = false;
+    have_newest_ = false;
+}
+
+JitterBuffer::Stats JitterBuffer::GetStats() const {
+    Stats stats;
+    stats.received = received_.load(std::memory_order_relaxed);
+    stats.played = played_.load(std::memory_order_relaxed);
+    stats.late = late_.load(std::memory_order_relaxed);
+    stats.recovered = recovered_.load(std::memory_order_relaxed);
+    stats.concealed = concealed_.load(std::memory_order_relaxed);
+    stats.lost = stats.recovered + stats.concealed;
+    stats.duplicates = duplicates_.load(std::memory_order_relaxed);
+    stats.rebuffers = rebuffers_.load(std::memory_order_relaxed);
+    stats.resyncs = resyncs_.load(std::memory_order_relaxed);
+    stats.target_frames = target_frames_.load(std::memory_order_relaxed);
+    stats.jitter_ms = jitter_ms_.load(std::memory_order_relaxed);
+    return stats;
+}
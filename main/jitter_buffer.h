@@ -0,0 +1,131 @@
+#ifndef JITTER_BUFFER_H
+#define JITTER_BUFFER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "protocol.h"
+
+#define JITTER_BUFFER_SLOTS 16          // Power of two, ~1 s of 60 ms frames
+#define JITTER_BUFFER_MIN_DELAY_FRAMES 1
+#define JITTER_BUFFER_MAX_DELAY_FRAMES 8
+#define JITTER_BUFFER_RESYNC_FRAMES 64  // Jump this far ahead = new stream, not a backlog
+// A late frame's timestamp trails the newest one by about their sequence
+// distance; this much more is allowed for pauses and send pacing
+#define JITTER_BUFFER_RESYNC_SLACK_MS 1000
+
+/**
+ * @brief Reorders incoming TTS frames and paces them out with an adaptive delay
+ *
+ * Frames are slotted by AudioStreamPacket::sequence. Playout starts once the
+ * buffered depth reaches a target delay derived from the measured arrival
+ * jitter (RFC 3550 interarrival estimate): target = 1 + 2 * jitter / frame,
+ * clamped to [MIN, MAX] frames. When the next frame is missing but later
+ * ones are already here, it is declared lost and rebuilt from the FEC data of
+ * the following packet, or concealed with Opus PLC; if it shows up later it
+ * is counted as late and discarded. A frame just past the window is not
+ * taken (Accepts() is false) until playout catches up; only a jump of
+ * RESYNC_FRAMES or more restarts the buffer. A frame up to SLOTS behind is
+ * late only if its timestamp fits: one past the newest timestamp, or
+ * further behind it than the sequence gap allows, means the sender restarted
+ * its numbering, and the buffer restarts too.
+ *
+ * Owned by the audio loop task; only size() and GetStats() may be called
+ * from other tasks.
+ */
+class JitterBuffer {
+public:
+    enum class Action {
+        kWait,          // Nothing to play yet (buffering or ran dry)
+        kDecode,        // Decode packet normally
+        kDecodeFec,     // Previous frame lost: decode it from packet's FEC data
+        kConceal,       // Previous frame lost, no FEC source: run PLC
+    };
+
+    struct Stats {
+        uint32_t received;
+        uint32_t played;
+        uint32_t late;          // Arrived after its playout slot
+        uint32_t lost;          // Missing when due (recovered + concealed)
+        uint32_t recovered;     // Rebuilt from FEC
+        uint32_t concealed;     // Synthesized by PLC
+        uint32_t duplicates;
+        uint32_t rebuffers;     // Ran dry, then more audio arrived and was buffered again
+        uint32_t resyncs;       // Sequence jumped; buffer restarted
+        uint32_t target_frames;
+        uint32_t jitter_ms;
+    };
+
+    JitterBuffer();
+
+    JitterBuffer(const JitterBuffer&) = delete;
+    JitterBuffer& operator=(const JitterBuffer&) = delete;
+
+    size_t size() const { return depth_.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief False while the frame lies past the window but is not a jump;
+     *        the caller keeps it and retries after the next Next()
+     */
+    bool Accepts(uint32_t sequence) const;
+
+    /**
+     * @brief Slot a frame in, timed by packet.arrival_us (now_us if unset)
+     */
+    void Insert(AudioStreamPacket&& packet, int64_t now_us);
+
+    /**
+     * @brief Pick what the decoder should do for the next frame period
+     * @param packet Receives the frame to decode; for kDecodeFec a copy of
+     *               the following frame; for kConceal only the format fields
+     */
+    Action Next(AudioStreamPacket& packet, int64_t now_us);
+
+    void Reset();
+
+    Stats GetStats() const;
+
+private:
+    struct Slot {
+        bool filled = false;
+        AudioStreamPacket packet;
+    };
+
+    Slot slots_[JITTER_BUFFER_SLOTS];
+    std::atomic<size_t> depth_{0};
+    bool started_ = false;
+    bool playing_ = false;
+    bool starved_ = false;
+    uint32_t next_sequence_ = 0;
+    // Newest frame with a sender timestamp, to tell late frames from a restart
+    bool have_newest_ = false;
+    uint32_t newest_sequence_ = 0;
+    uint32_t newest_timestamp_ = 0;
+    int64_t buffering_since_us_ = 0;
+    int sample_rate_ = 0;
+    int frame_duration_ = 0;
+
+    // RFC 3550 jitter, in ms scaled by 16
+    bool have_transit_ = false;
+    int32_t last_transit_ms_ = 0;
+    uint32_t jitter_q4_ = 0;
+
+    std::atomic<uint32_t> jitter_ms_{0};
+    std::atomic<uint32_t> target_frames_{JITTER_BUFFER_MIN_DELAY_FRAMES};
+    std::atomic<uint32_t> received_{0};
+    std::atomic<uint32_t> played_{0};
+    std::atomic<uint32_t> late_{0};
+    std::atomic<uint32_t> recovered_{0};
+    std::atomic<uint32_t> concealed_{0};
+    std::atomic<uint32_t> duplicates_{0};
+    std::atomic<uint32_t> rebuffers_{0};
+    std::atomic<uint32_t> resyncs_{0};
+
+    Slot& SlotFor(uint32_t sequence) { return slots_[sequence & (JITTER_BUFFER_SLOTS - 1)]; }
+    void Flush();
+    bool IsRestart(const AudioStreamPacket& packet) const;
+    void UpdateJitter(uint32_t sequence, int64_t arrival_us);
+};
+
+#endif // JITTER_BUFFER_H
@@ -0,0 +1,66 @@
+#include "latency_histogram.h"
+
+#include <cstdio>
+
+namespace {
+
+constexpr uint32_t kFirstEdgeUs = 256;
+
+uint32_t BucketEdgeUs(size_t bucket) {
+    return kFirstEdgeUs << bucket;
+}
+
+} // namespace
+
+void LatencyHistogram::Record(int64_t duration_us) {
+    uint32_t us = duration_us < 0 ? 0 : (duration_us > UINT32_MAX ? UINT32_MAX : (uint32_t)duration_us);
+
+    size_t bucket = 0;
+    while (bucket < kBucketCount - 1 && us >= BucketEdgeUs(bucket)) {
+        bucket++;
+    }
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    sum_us_.fetch_add(us, std::memory_order_relaxed);
+
+    uint32_t prev = max_us_.load(std::memory_order_relaxed);
+    while (us > prev && !max_us_.compare_exchange_weak(prev, us, std::memory_order_relaxed)) {
+    }
+}
+
+uint32_t LatencyHistogram::mean_us() const {
+    uint32_t n = count();
+    return n == 0 ? 0 : (uint32_t)(sum_us_.load(std::memory_order_relaxed) / n);
+}
+
+uint32_t LatencyHistogram::PercentileUs(int percentile) const {
+    uint32_t n = count();
+    if (n == 0) {
+        return 0;
+    }
+    uint64_t wanted = ((uint64_t)n * percentile + 99) / 100;
+    uint32_t max = max_us();
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kBucketCount - 1; i++) {
+        seen += buckets_[i].load(std::memory_order_relaxed);
+        if (seen >= wanted) {
+            return BucketEdgeUs(i) < max ? BucketEdgeUs(i) : max;
+        }
+    }
+    return max;
+}
+
+int LatencyHistogram::Format(char* buffer, size_t size) const {
+    return snprintf(buffer, size, "n=%u mean=%uus p50<%uus p90<%uus p99<%uus max=%uus",
+                    (unsigned)count(), (unsigned)mean_us(), (unsigned)PercentileUs(50),
+                    (unsigned)PercentileUs(90), (unsigned)PercentileUs(99), (unsigned)max_us());
+}
+
+void LatencyHistogram::Reset() {
+    for (auto& bucket : buckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    count_.store(0, std::memory_order_relaxed);
+    sum_us_.store(0, std::memory_order_relaxed);
+    max_us_.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,45 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Lock-free log2 histogram of durations in microseconds
+ *
+ * Bucket i counts samples below 256 << i us (256 us ... 512 ms); the last
+ * bucket takes everything slower. Record() is a few relaxed atomic adds and
+ * safe to call from any task.
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kBucketCount = 13;
+
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+    void Record(int64_t duration_us);
+
+    uint32_t count() const { return count_.load(std::memory_order_relaxed); }
+    uint32_t max_us() const { return max_us_.load(std::memory_order_relaxed); }
+    uint32_t mean_us() const;
+
+    // Upper edge of the bucket holding the given percentile (0-100), capped at max_us()
+    uint32_t PercentileUs(int percentile) const;
+
+    // "n=.. mean=..us p50<..us p90<..us p99<..us max=..us"
+    int Format(char* buffer, size_t size) const;
+
+    void Reset();
+
+private:
+    std::atomic<uint32_t> buckets_[kBucketCount] = {};
+    std::atomic<uint32_t> count_{0};
+    std::atomic<uint64_t> sum_us_{0};
+    std::atomic<uint32_t> max_us_{0};
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,142 @@
+#include "mcp_server.h"
+#include "system_info.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+
+#include <algorithm>
+
+#define TAG "MCP"
+
+McpExecutor::McpExecutor(ReplyCallback reply) : reply_(std::move(reply)) {
+    SystemInfo::RegisterLatencyHistogram("mcp.wait", &wait_latency_);
+    SystemInfo::RegisterLatencyHistogram("mcp.run", &run_latency_);
+
+    static const struct {
+        const char* name;
+        uint32_t stack_size;
+    } kWorkers[kMcpStackClassCount] = {
+        {"mcp_small", MCP_SMALL_STACK_SIZE},
+        {"mcp_large", MCP_LARGE_STACK_SIZE},
+    };
+    for (int i = 0; i < kMcpStackClassCount; i++) {
+        lanes_[i].ready = xSemaphoreCreateCounting(MCP_EXECUTOR_QUEUE_DEPTH, 0);
+        auto args = new std::pair<McpExecutor*, McpStackClass>(this, (McpStackClass)i);
+        xTaskCreate([](void* arg) {
+            auto args = (std::pair<McpExecutor*, McpStackClass>*)arg;
+            auto executor = args->first;
+            auto stack_class = args->second;
+            delete args;
+            executor->WorkerLoop(stack_class);
+        }, kWorkers[i].name, kWorkers[i].stack_size, args, 1, nullptr);
+    }
+}
+
+bool McpExecutor::Submit(Call&& call, McpStackClass stack_class) {
+    auto& lane = lanes_[stack_class];
+    call.enqueue_us = esp_timer_get_time();
+    call.session = session_.load(std::memory_order_relaxed);
+    if (!lane.queue.TryPush(std::move(call))) {
+        rejected_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    xSemaphoreGive(lane.ready);
+    return true;
+}
+
+void McpExecutor::CancelPending() {
+    // Workers drop every call that was queued under an older session
+    session_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void McpExecutor::WorkerLoop(McpStackClass stack_class) {
+    auto& lane = lanes_[stack_class];
+    Call call;
+    while (true) {
+        xSemaphoreTake(lane.ready, portMAX_DELAY);
+        // Drain: a pop fails while an earlier Submit has claimed its slot but
+        // not filled it yet, and calls published behind it would otherwise
+        // wait for the next wakeup
+        while (lane.queue.TryPop(call)) {
+            Run(call);
+            // Release the arguments now rather than on the next call
+            call = Call();
+        }
+    }
+}
+
+void McpExecutor::Run(Call& call) {
+    int64_t start_us = esp_timer_get_time();
+    int64_t wait_us = start_us - call.enqueue_us;
+    wait_latency_.Record(wait_us);
+    if (call.session != session_.load(std::memory_order_relaxed)) {
+        ESP_LOGI(TAG, "tools/call: %s cancelled before it started", call.tool->name().c_str());
+        cancelled_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    bool error = false;
+    std::string result;
+    try {
+        result = call.tool->Call(call.arguments);
+    } catch (const std::exception& e) {
+        ESP_LOGE(TAG, "tools/call: %s", e.what());
+        result = e.what();
+        error = true;
+    }
+    int64_t run_us = esp_timer_get_time() - start_us;
+    run_latency_.Record(run_us);
+
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        auto& stats = stats_[call.tool->name()];
+        stats.calls++;
+        stats.errors += error ? 1 : 0;
+        stats.total_us += run_us;
+        stats.max_us = std::max(stats.max_us, run_us);
+        stats.total_wait_us += wait_us;
+        stats.max_wait_us = std::max(stats.max_wait_us, wait_us);
+    }
+
+    if (call.session != session_.load(std::memory_order_relaxed)) {
+        ESP_LOGI(TAG, "tools/call: %s finished after its session closed, result dropped", call.tool->name().c_str());
+        cancelled_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    reply_(call.id, error, result);
+}
+
+std::string McpExecutor::GetStatsJson() {
+    cJSON* root = cJSON_CreateObject();
+    cJSON_AddNumberToObject(root, "rejected", rejected_.load(std::memory_order_relaxed));
+    cJSON_AddNumberToObject(root, "cancelled", cancelled_.load(std::memory_order_relaxed));
+    cJSON* wait = cJSON_CreateObject();
+    cJSON_AddNumberToObject(wait, "p50", wait_latency_.PercentileUs(50));
+    cJSON_AddNumberToObject(wait, "p99", wait_latency_.PercentileUs(99));
+    cJSON_AddNumberToObject(wait, "max", wait_latency_.max_us());
+    cJSON_AddItemToObject(root, "queue_wait_us", wait);
+
+    cJSON* tools = cJSON_CreateArray();
+    {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        for (const auto& [name, stats] : stats_) {
+            cJSON* tool = cJSON_CreateObject();
+            cJSON_AddStringToObject(tool, "name", name.c_str());
+            cJSON_AddNumberToObject(tool, "calls", stats.calls);
+            cJSON_AddNumberToObject(tool, "errors", stats.errors);
+            cJSON_AddNumberToObject(tool, "mean_us", stats.calls ? stats.total_us / stats.calls : 0);
+            cJSON_AddNumberToObject(tool, "max_us", stats.max_us);
+            cJSON_AddNumberToObject(tool, "mean_wait_us", stats.calls ? stats.total_wait_us / stats.calls : 0);
+            cJSON_AddNumberToObject(tool, "max_wait_us", stats.max_wait_us);
+            cJSON_AddItemToArray(tools, tool);
+        }
+    }
+    cJSON_AddItemToObject(root, "tools", tools);
+
+    char* json_str = cJSON_PrintUnformatted(root);
+    std::string result(json_str);
+    cJSON_free(json_str);
+    cJSON_Delete(root);
+    return result;
+}
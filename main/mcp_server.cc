@@ -8,18 +8,27 @@
 #include <esp_app_desc.h>
 #include <algorithm>
 #include <cstring>
-#include <esp_pthread.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
 
 #include "application.h"
 #include "display.h"
 #include "board.h"
 #include "animation/animation_updater.h"
+#include "system_info.h"
 
 #define TAG "MCP"
 
 #define DEFAULT_TOOLCALL_STACK_SIZE 6144
 
-McpServer::McpServer() {
+McpServer::McpServer()
+    : executor_([this](int id, bool error, const std::string& result) {
+          if (error) {
+              ReplyError(id, result);
+          } else {
+              ReplyResult(id, result);
+          }
+      }) {
 }
 
 McpServer::~McpServer() {
@@ -86,7 +95,8 @@ void McpServer::AddCommonTools() {
 
     auto camera = board.GetCamera();
     if (camera) {
-        AddTool("self.camera.take_photo",
+        // Capture plus an HTTPS upload needs the large stack
+        auto take_photo = new McpTool("self.camera.take_photo",
             "Take a photo and explain it. Use this tool after the user asks you to see something.\n"
             "Args:\n"
             "  `question`: The question that you want to ask about the photo.\n"
@@ -102,6 +112,8 @@ void McpServer::AddCommonTools() {
                 auto question = properties["question"].value<std::string>();
                 return camera->Explain(question);
             });
+        take_photo->set_stack_class(kMcpStackLarge);
+        AddTool(take_photo);
     }
 
     // Add WiFi management tools
@@ -182,19 +194,30 @@ void McpServer::AddCommonTools() {
             return "Animation updater stopped.";
         });
 
+    AddTool("self.mcp.get_tool_stats",
+        "Provides tool call statistics of the device: calls, errors, run time and queue wait per tool, in microseconds.",
+        PropertyList(),
+        [this](const PropertyList& properties) -> ReturnValue {
+            return executor_.GetStatsJson();
+        });
+
     // Restore the original tools list to the end of the tools list
     tools_.insert(tools_.end(), original_tools.begin(), original_tools.end());
+    tool_pages_dirty_ = true;
 }
 
 void McpServer::AddTool(McpTool* tool) {
     // Prevent adding duplicate tools
-    if (std::find_if(tools_.begin(), tools_.end(), [tool](const McpTool* t) { return t->name() == tool->name(); }) != tools_.end()) {
+    auto [it, inserted] = tool_index_.try_emplace(tool->name(), ToolEntry{tool, std::string()});
+    if (!inserted) {
         ESP_LOGW(TAG, "Tool %s already added", tool->name().c_str());
         return;
     }
 
     ESP_LOGI(TAG, "Add tool: %s", tool->name().c_str());
+    it->second.descriptor = tool->to_json();
     tools_.push_back(tool);
+    tool_pages_dirty_ = true;
 }
 
 void McpServer::AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback) {
@@ -346,82 +369,90 @@ void McpServer::ReplyError(int id, const std::string& message) {
     Application::GetInstance().SendMcpMessage(payload);
 }
 
-void McpServer::GetToolsList(int id, const std::string& cursor) {
-    ESP_LOGI(TAG, "tools/list: Request received, id=%d, cursor='%s', total_tools=%u", id, cursor.c_str(), (unsigned)tools_.size());
-    const int max_payload_size = 8000;
+void McpServer::BuildToolPages() {
+    int64_t start_us = esp_timer_get_time();
+    tool_pages_.clear();
+    cursor_pages_.clear();
+
+    // Leave room for the closing brackets and a nextCursor
+    const size_t limit = MCP_TOOLS_LIST_MAX_PAYLOAD - 30;
+    ToolPage page;
     std::string json = "{\"tools\":[";
-    
-    bool found_cursor = cursor.empty();
-    auto it = tools_.begin();
-    std::string next_cursor = "";
-    size_t tools_added = 0;
-    
-    while (it != tools_.end()) {
-        // 如果我们还没有找到起始位置，继续搜索
-        if (!found_cursor) {
-            if ((*it)->name() == cursor) {
-                found_cursor = true;
-            } else {
-                ++it;
+    for (auto tool : tools_) {
+        const std::string& descriptor = tool_index_[tool->name()].descriptor;
+        bool empty = page.first_tool.empty();
+        if (!empty && json.length() + descriptor.length() + 1 > limit) {
+            json += "],\"nextCursor\":\"" + tool->name() + "\"}";
+            page.json = std::move(json);
+            tool_pages_.push_back(std::move(page));
+            page = ToolPage();
+            json = "{\"tools\":[";
+            empty = true;
+        }
+        if (empty) {
+            page.first_tool = tool->name();
+            if (json.length() + descriptor.length() + 1 > limit) {
+                // Reported to whoever pages this far, as before
+                ESP_LOGE(TAG, "tools/list: Tool %s exceeds the payload size limit", tool->name().c_str());
+                tool_pages_.push_back(std::move(page));
+                page = ToolPage();
                 continue;
             }
+        } else {
+            json += ",";
         }
-        
-        // 添加tool前检查大小
-        std::string tool_json = (*it)->to_json() + ",";
-        if (json.length() + tool_json.length() + 30 > max_payload_size) {
-            // 如果添加这个tool会超出大小限制，设置next_cursor并退出循环
-            next_cursor = (*it)->name();
-            break;
-        }
-        
-        json += tool_json;
-        tools_added++;
-        ++it;
+        json += descriptor;
     }
-    
-    ESP_LOGI(TAG, "tools/list: Built JSON with %u tools, current_size=%u", (unsigned)tools_added, (unsigned)json.length());
-    
-    if (json.back() == ',') {
-        json.pop_back();
+    if (!page.first_tool.empty() || tool_pages_.empty()) {
+        json += "]}";
+        page.json = std::move(json);
+        tool_pages_.push_back(std::move(page));
     }
-    
-    if (json.back() == '[' && !tools_.empty()) {
-        // 如果没有添加任何tool，返回错误
-        ESP_LOGE(TAG, "tools/list: Failed to add tool %s because of payload size limit", next_cursor.c_str());
-        ReplyError(id, "Failed to add tool " + next_cursor + " because of payload size limit");
-        return;
+
+    for (size_t i = 0; i < tool_pages_.size(); i++) {
+        cursor_pages_[tool_pages_[i].first_tool] = i;
     }
+    tool_pages_dirty_ = false;
+    ESP_LOGI(TAG, "tools/list: Built %u pages for %u tools in %lld us", (unsigned)tool_pages_.size(),
+             (unsigned)tools_.size(), (long long)(esp_timer_get_time() - start_us));
+}
 
-    if (next_cursor.empty()) {
-        json += "]}";
-    } else {
-        json += "],\"nextCursor\":\"" + next_cursor + "\"}";
+void McpServer::GetToolsList(int id, const std::string& cursor) {
+    if (tool_pages_dirty_) {
+        BuildToolPages();
     }
-    
-    ESP_LOGI(TAG, "tools/list: Final response size=%u bytes, has_next_cursor=%s", (unsigned)json.length(), next_cursor.empty() ? "false" : "true");
-    if (json.length() < 500) {
-        ESP_LOGI(TAG, "tools/list: Response preview: %s", json.c_str());
-    } else {
-        ESP_LOGI(TAG, "tools/list: Response preview (first 200 chars): %.200s...", json.c_str());
+
+    size_t index = 0;
+    if (!cursor.empty()) {
+        auto it = cursor_pages_.find(cursor);
+        if (it == cursor_pages_.end()) {
+            ESP_LOGE(TAG, "tools/list: Invalid cursor: %s", cursor.c_str());
+            ReplyError(id, "Invalid cursor: " + cursor);
+            return;
+        }
+        index = it->second;
     }
-    
-    ReplyResult(id, json);
+
+    const ToolPage& page = tool_pages_[index];
+    if (page.json.empty()) {
+        ReplyError(id, "Failed to add tool " + page.first_tool + " because of payload size limit");
+        return;
+    }
+    ESP_LOGI(TAG, "tools/list: id=%d, page %u/%u, %u bytes", id, (unsigned)index + 1,
+             (unsigned)tool_pages_.size(), (unsigned)page.json.length());
+    ReplyResult(id, page.json);
 }
 
 void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, int stack_size) {
-    auto tool_iter = std::find_if(tools_.begin(), tools_.end(), 
-                                 [&tool_name](const McpTool* tool) { 
-                                     return tool->name() == tool_name; 
-                                 });
-    
-    if (tool_iter == tools_.end()) {
+    auto tool_iter = tool_index_.find(tool_name);
+    if (tool_iter == tool_index_.end()) {
         ESP_LOGE(TAG, "tools/call: Unknown tool: %s", tool_name.c_str());
         ReplyError(id, "Unknown tool: " + tool_name);
         return;
     }
+    McpTool* tool = tool_iter->second.tool;
 
-    PropertyList arguments = (*tool_iter)->properties();
+    PropertyList arguments = tool->properties();
     try {
         for (auto& argument : arguments) {
             bool found = false;
@@ -451,21 +482,24 @@ void McpServer::DoToolCall(int id, const std::string& tool_name, const cJSON* to
         return;
     }
 
-    // Start a task to receive data with stack size
-    esp_pthread_cfg_t cfg = esp_pthread_get_default_config();
-    cfg.thread_name = "tool_call";
-    cfg.stack_size = stack_size;
-    cfg.prio = 1;
-    esp_pthread_set_cfg(&cfg);
-
-    // Use a thread to call the tool to avoid blocking the main thread
-    tool_call_thread_ = std::thread([this, id, tool_iter, arguments = std::move(arguments)]() {
-        try {
-            ReplyResult(id, (*tool_iter)->Call(arguments));
-        } catch (const std::exception& e) {
-            ESP_LOGE(TAG, "tools/call: %s", e.what());
-            ReplyError(id, e.what());
+    McpStackClass stack_class = tool->stack_class();
+    if (stack_size > MCP_SMALL_STACK_SIZE) {
+        stack_class = kMcpStackLarge;
+        if (stack_size > MCP_LARGE_STACK_SIZE) {
+            ESP_LOGW(TAG, "tools/call: stackSize %d capped to %d", stack_size, MCP_LARGE_STACK_SIZE);
         }
-    });
-    tool_call_thread_.detach();
-}
\ No newline at end of file
+    }
+
+    McpExecutor::Call call;
+    call.id = id;
+    call.tool = tool;
+    call.arguments = std::move(arguments);
+    if (!executor_.Submit(std::move(call), stack_class)) {
+        ESP_LOGW(TAG, "tools/call: Too many pending calls, rejecting %s", tool_name.c_str());
+        ReplyError(id, "Device busy, too many pending tool calls");
+    }
+}
+
+void McpServer::CancelToolCalls() {
+    executor_.CancelPending();
+}
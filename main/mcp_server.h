@@ -4,13 +4,35 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <functional>
 #include <variant>
 #include <optional>
 #include <stdexcept>
-#include <thread>
+#include <atomic>
+#include <mutex>
 
 #include <cJSON.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "bounded_ring.h"
+#include "latency_histogram.h"
+
+// Upper bound for one tools/list result
+#define MCP_TOOLS_LIST_MAX_PAYLOAD 8000
+
+// Calls waiting per stack class; more are rejected as busy
+#define MCP_EXECUTOR_QUEUE_DEPTH 4
+#define MCP_SMALL_STACK_SIZE 6144
+// Tools that do HTTPS or image work, or calls asking for more than the small stack
+#define MCP_LARGE_STACK_SIZE 12288
+
+enum McpStackClass {
+    kMcpStackSmall,
+    kMcpStackLarge,
+    kMcpStackClassCount
+};
 
 // 添加类型别名
 using ReturnValue = std::variant<bool, int, std::string>;
@@ -177,6 +199,7 @@ private:
     std::string description_;
     PropertyList properties_;
     std::function<ReturnValue(const PropertyList&)> callback_;
+    McpStackClass stack_class_ = kMcpStackSmall;
 
 public:
     McpTool(const std::string& name, 
@@ -191,6 +214,8 @@ public:
     inline const std::string& name() const { return name_; }
     inline const std::string& description() const { return description_; }
     inline const PropertyList& properties() const { return properties_; }
+    inline McpStackClass stack_class() const { return stack_class_; }
+    inline void set_stack_class(McpStackClass stack_class) { stack_class_ = stack_class; }
 
     std::string to_json() const {
         std::vector<std::string> required = properties_.GetRequired();
@@ -249,6 +274,65 @@ public:
     }
 };
 
+/**
+ * @brief Runs tool calls on worker tasks created once at startup
+ *
+ * There is one worker and one bounded queue per stack class, so back to
+ * back calls wait in the queue instead of each allocating a fresh thread
+ * stack. CancelPending() drops queued calls and the replies of running
+ * ones, e.g. when the session that asked for them has closed.
+ */
+class McpExecutor {
+public:
+    struct Call {
+        int id = 0;
+        McpTool* tool = nullptr;
+        PropertyList arguments;
+        int64_t enqueue_us = 0;
+        uint32_t session = 0;
+    };
+
+    // error is set when result is an error message
+    using ReplyCallback = std::function<void(int id, bool error, const std::string& result)>;
+
+    explicit McpExecutor(ReplyCallback reply);
+
+    // Returns false if the queue for the stack class is full
+    bool Submit(Call&& call, McpStackClass stack_class);
+    void CancelPending();
+
+    // Queue wait, run time and counters per tool, as JSON
+    std::string GetStatsJson();
+
+private:
+    struct Lane {
+        BoundedRing<Call, MCP_EXECUTOR_QUEUE_DEPTH> queue;
+        SemaphoreHandle_t ready = nullptr;
+    };
+
+    struct ToolStats {
+        uint32_t calls = 0;
+        uint32_t errors = 0;
+        int64_t total_us = 0;
+        int64_t max_us = 0;
+        int64_t total_wait_us = 0;
+        int64_t max_wait_us = 0;
+    };
+
+    ReplyCallback reply_;
+    Lane lanes_[kMcpStackClassCount];
+    std::atomic<uint32_t> session_{0};
+    std::atomic<uint32_t> rejected_{0};
+    std::atomic<uint32_t> cancelled_{0};
+    std::mutex stats_mutex_;
+    std::map<std::string, ToolStats> stats_;
+    LatencyHistogram wait_latency_;
+    LatencyHistogram run_latency_;
+
+    void WorkerLoop(McpStackClass stack_class);
+    void Run(Call& call);
+};
+
 class McpServer {
 public:
     static McpServer& GetInstance() {
@@ -261,6 +345,8 @@ public:
     void AddTool(const std::string& name, const std::string& description, const PropertyList& properties, std::function<ReturnValue(const PropertyList&)> callback);
     void ParseMessage(const cJSON* json);
     void ParseMessage(const std::string& message);
+    // Forget queued tool calls and the results of running ones
+    void CancelToolCalls();
 
 private:
     McpServer();
@@ -272,10 +358,29 @@ private:
     void ReplyError(int id, const std::string& message);
 
     void GetToolsList(int id, const std::string& cursor);
+    void BuildToolPages();
     void DoToolCall(int id, const std::string& tool_name, const cJSON* tool_arguments, int stack_size);
 
+    struct ToolEntry {
+        McpTool* tool;
+        std::string descriptor;     // to_json(), serialised once by AddTool
+    };
+
+    // A complete tools/list result; json is empty when first_tool alone
+    // does not fit in MCP_TOOLS_LIST_MAX_PAYLOAD
+    struct ToolPage {
+        std::string first_tool;
+        std::string json;
+    };
+
     std::vector<McpTool*> tools_;
-    std::thread tool_call_thread_;
+    std::unordered_map<std::string, ToolEntry> tool_index_;
+    // Rebuilt on the first tools/list after the tools change; page N is
+    // reached with the name of its first tool as the cursor
+    std::vector<ToolPage> tool_pages_;
+    std::unordered_map<std::string, size_t> cursor_pages_;
+    bool tool_pages_dirty_ = true;
+    McpExecutor executor_;
 };
 
 #endif // MCP_SERVER_H
@@ -0,0 +1,59 @@
+#include "opus_frame_decoder.h"
+
+#include <esp_log.h>
+
+#define TAG "OpusFrameDecoder"
+
+OpusFrameDecoder::OpusFrameDecoder(int sample_rate, int channels, int duration_ms)
+    : sample_rate_(sample_rate), duration_ms_(duration_ms) {
+    int error;
+    audio_dec_ = opus_decoder_create(sample_rate, channels, &error);
+    if (audio_dec_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to create audio decoder, error code: %d", error);
+    }
+    frame_size_ = sample_rate / 1000 * channels * duration_ms;
+}
+
+OpusFrameDecoder::~OpusFrameDecoder() {
+    if (audio_dec_ != nullptr) {
+        opus_decoder_destroy(audio_dec_);
+    }
+}
+
+void OpusFrameDecoder::ResetState() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_dec_ != nullptr) {
+        opus_decoder_ctl(audio_dec_, OPUS_RESET_STATE);
+    }
+}
+
+bool OpusFrameDecoder::Decode(const uint8_t* opus, size_t size, PcmFrame& pcm) {
+    return Run(opus, size, pcm, 0);
+}
+
+bool OpusFrameDecoder::DecodeFec(const uint8_t* next_opus, size_t size, PcmFrame& pcm) {
+    return Run(next_opus, size, pcm, 1);
+}
+
+bool OpusFrameDecoder::Conceal(PcmFrame& pcm) {
+    return Run(nullptr, 0, pcm, 0);
+}
+
+bool OpusFrameDecoder::Run(const uint8_t* opus, size_t size, PcmFrame& pcm, int decode_fec) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_dec_ == nullptr) {
+        ESP_LOGE(TAG, "Audio decoder is not configured");
+        return false;
+    }
+
+    // For FEC and PLC the output length selects how much audio to synthesize,
+    // so it must be exactly one frame.
+    pcm.resize(frame_size_);
+    auto ret = opus_decode(audio_dec_, opus, (opus_int32)size, pcm.data(), frame_size_, decode_fec);
+    if (ret < 0) {
+        ESP_LOGE(TAG, "Failed to decode audio, error code: %d", ret);
+        return false;
+    }
+    pcm.resize(ret);
+    return true;
+}
@@ -0,0 +1,56 @@
+#ifndef OPUS_FRAME_DECODER_H
+#define OPUS_FRAME_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "opus.h"
+#include "audio_frame_pool.h"
+
+/**
+ * @brief Opus decoder for the downlink that writes into pooled PCM frames
+ *
+ * Besides normal decoding it exposes the two loss paths libopus offers:
+ * in-band FEC (rebuild a lost frame from the redundancy carried by the
+ * following packet) and PLC (extrapolate a frame from decoder state when
+ * nothing is available).
+ */
+class OpusFrameDecoder {
+public:
+    OpusFrameDecoder(int sample_rate, int channels, int duration_ms);
+    ~OpusFrameDecoder();
+
+    OpusFrameDecoder(const OpusFrameDecoder&) = delete;
+    OpusFrameDecoder& operator=(const OpusFrameDecoder&) = delete;
+
+    int sample_rate() const { return sample_rate_; }
+    int duration_ms() const { return duration_ms_; }
+
+    void ResetState();
+
+    bool Decode(const uint8_t* opus, size_t size, PcmFrame& pcm);
+
+    /**
+     * @brief Recover the frame before `next_opus` from its FEC data
+     *
+     * Falls back to PLC inside libopus if the packet carries no FEC.
+     */
+    bool DecodeFec(const uint8_t* next_opus, size_t size, PcmFrame& pcm);
+
+    /**
+     * @brief Synthesize one frame of packet loss concealment
+     */
+    bool Conceal(PcmFrame& pcm);
+
+private:
+    std::mutex mutex_;
+    OpusDecoder* audio_dec_ = nullptr;
+    int sample_rate_;
+    int duration_ms_;
+    int frame_size_;
+
+    bool Run(const uint8_t* opus, size_t size, PcmFrame& pcm, int decode_fec);
+};
+
+#endif // OPUS_FRAME_DECODER_H
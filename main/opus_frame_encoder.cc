@@ -0,0 +1,108 @@
+#include "opus_frame_encoder.h"
+
+#include <esp_log.h>
+
+#define TAG "OpusFrameEncoder"
+
+OpusFrameEncoder::OpusFrameEncoder(int sample_rate, int channels, int duration_ms) {
+    int error;
+    audio_enc_ = opus_encoder_create(sample_rate, channels, OPUS_APPLICATION_VOIP, &error);
+    if (audio_enc_ == nullptr) {
+        ESP_LOGE(TAG, "Failed to create audio encoder, error code: %d", error);
+        frame_size_ = 0;
+        return;
+    }
+
+    SetDtx(true);
+    SetComplexity(5);
+
+    frame_size_ = sample_rate / 1000 * channels * duration_ms;
+    // Room for a partial frame plus one input chunk of up to two frames.
+    in_buffer_.reserve(frame_size_ * 3);
+}
+
+OpusFrameEncoder::~OpusFrameEncoder() {
+    if (audio_enc_ != nullptr) {
+        opus_encoder_destroy(audio_enc_);
+    }
+}
+
+void OpusFrameEncoder::SetDtx(bool enable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ != nullptr) {
+        opus_encoder_ctl(audio_enc_, OPUS_SET_DTX(enable ? 1 : 0));
+    }
+}
+
+void OpusFrameEncoder::SetComplexity(int complexity) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ != nullptr) {
+        opus_encoder_ctl(audio_enc_, OPUS_SET_COMPLEXITY(complexity));
+    }
+}
+
+void OpusFrameEncoder::SetBitrate(int bitrate) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ != nullptr) {
+        opus_encoder_ctl(audio_enc_, OPUS_SET_BITRATE(bitrate));
+    }
+}
+
+void OpusFrameEncoder::SetInbandFec(bool enable) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ != nullptr) {
+        opus_encoder_ctl(audio_enc_, OPUS_SET_INBAND_FEC(enable ? 1 : 0));
+    }
+}
+
+void OpusFrameEncoder::SetPacketLossPercent(int percent) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ != nullptr) {
+        opus_encoder_ctl(audio_enc_, OPUS_SET_PACKET_LOSS_PERC(percent));
+    }
+}
+
+void OpusFrameEncoder::ResetState() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ != nullptr) {
+        opus_encoder_ctl(audio_enc_, OPUS_RESET_STATE);
+    }
+    in_buffer_.clear();
+}
+
+bool OpusFrameEncoder::IsBufferEmpty() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return in_buffer_.empty();
+}
+
+void OpusFrameEncoder::Encode(const int16_t* pcm, size_t samples, const std::function<void(OpusFrame&& opus)>& handler) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (audio_enc_ == nullptr) {
+        ESP_LOGE(TAG, "Audio encoder is not configured");
+        return;
+    }
+
+    if (in_buffer_.size() + samples > in_buffer_.capacity()) {
+        AudioFramePool::GetInstance().pcm().CountHeapAllocation();
+    }
+    in_buffer_.insert(in_buffer_.end(), pcm, pcm + samples);
+
+    size_t consumed = 0;
+    while (in_buffer_.size() - consumed >= frame_size_) {
+        OpusFrame opus;
+        auto& out = opus.vector();
+        out.resize(out.capacity());
+        auto ret = opus_encode(audio_enc_, in_buffer_.data() + consumed, frame_size_, out.data(), out.size());
+        consumed += frame_size_;
+        if (ret < 0) {
+            ESP_LOGE(TAG, "Failed to encode audio, error code: %ld", (long)ret);
+            continue;
+        }
+        out.resize(ret);
+        if (handler != nullptr) {
+            handler(std::move(opus));
+        }
+    }
+    // erase() shifts the remainder down in place; capacity is kept.
+    in_buffer_.erase(in_buffer_.begin(), in_buffer_.begin() + consumed);
+}
@@ -0,0 +1,47 @@
+#ifndef OPUS_FRAME_ENCODER_H
+#define OPUS_FRAME_ENCODER_H
+
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "opus.h"
+#include "audio_frame_pool.h"
+
+/**
+ * @brief Opus encoder for the uplink that writes straight into pooled frames
+ *
+ * Same behaviour as OpusEncoderWrapper (VOIP, DTX on, complexity 5 by
+ * default), but PCM is accumulated in a buffer reserved once and every
+ * encoded packet is written directly into an OpusFrame from the
+ * AudioFramePool instead of a freshly allocated vector.
+ */
+class OpusFrameEncoder {
+public:
+    OpusFrameEncoder(int sample_rate, int channels, int duration_ms);
+    ~OpusFrameEncoder();
+
+    OpusFrameEncoder(const OpusFrameEncoder&) = delete;
+    OpusFrameEncoder& operator=(const OpusFrameEncoder&) = delete;
+
+    void SetDtx(bool enable);
+    void SetComplexity(int complexity);
+    void SetBitrate(int bitrate);
+    void SetInbandFec(bool enable);
+    void SetPacketLossPercent(int percent);
+    void ResetState();
+    bool IsBufferEmpty();
+
+    /**
+     * @brief Append PCM and emit one OpusFrame per complete frame
+     */
+    void Encode(const int16_t* pcm, size_t samples, const std::function<void(OpusFrame&& opus)>& handler);
+
+private:
+    std::mutex mutex_;
+    OpusEncoder* audio_enc_ = nullptr;
+    size_t frame_size_;
+    std::vector<int16_t> in_buffer_;
+};
+
+#endif // OPUS_FRAME_ENCODER_H
@@ -0,0 +1,243 @@
+#include "pcm_stream_player.h"
+
+#include <freertos/task.h>
+#include <esp_log.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define TAG "PcmStreamPlayer"
+
+#define GAIN_Q 12
+#define GAIN_ONE (1 << GAIN_Q)
+#define GAIN_MAX (8 * GAIN_ONE)
+
+namespace {
+
+inline int16_t Saturate(int32_t value) {
+    return (int16_t)std::min<int32_t>(std::max<int32_t>(value, -32768), 32767);
+}
+
+// The kernels are branch-free and unrolled by 8 so the compiler can keep
+// them in registers (and vectorise them where the target allows).
+void ScaleMono(const int16_t* __restrict in, int16_t* __restrict out, size_t samples, int32_t gain_q12) {
+    if (gain_q12 == GAIN_ONE) {
+        memcpy(out, in, samples * sizeof(int16_t));
+        return;
+    }
+    size_t i = 0;
+    for (; i + 8 <= samples; i += 8) {
+        for (int k = 0; k < 8; k++) {
+            out[i + k] = Saturate((in[i + k] * gain_q12 + (GAIN_ONE >> 1)) >> GAIN_Q);
+        }
+    }
+    for (; i < samples; i++) {
+        out[i] = Saturate((in[i] * gain_q12 + (GAIN_ONE >> 1)) >> GAIN_Q);
+    }
+}
+
+// (left + right) / 2 * gain, folded into a single shift
+void DownmixStereo(const int16_t* __restrict in, int16_t* __restrict out, size_t frames, int32_t gain_q12) {
+    size_t i = 0;
+    for (; i + 8 <= frames; i += 8) {
+        for (int k = 0; k < 8; k++) {
+            int32_t sum = in[2 * (i + k)] + in[2 * (i + k) + 1];
+            out[i + k] = Saturate((sum * gain_q12 + GAIN_ONE) >> (GAIN_Q + 1));
+        }
+    }
+    for (; i < frames; i++) {
+        int32_t sum = in[2 * i] + in[2 * i + 1];
+        out[i] = Saturate((sum * gain_q12 + GAIN_ONE) >> (GAIN_Q + 1));
+    }
+}
+
+} // namespace
+
+FilePcmSource::~FilePcmSource() {
+    if (file_ != nullptr) {
+        fclose(file_);
+    }
+}
+
+int FilePcmSource::Read(uint8_t* buffer, size_t size) {
+    if (remaining_ == 0) {
+        return 0;
+    }
+    size_t got = fread(buffer, 1, std::min(size, remaining_), file_);
+    if (got == 0) {
+        return ferror(file_) ? -1 : 0;
+    }
+    remaining_ -= got;
+    return (int)got;
+}
+
+PcmStreamPlayer::PcmStreamPlayer(AudioCodec* codec) : codec_(codec) {
+    free_queue_ = xQueueCreate(PCM_PLAYER_BUFFER_COUNT, sizeof(int));
+    // Room for every buffer plus the end-of-stream marker
+    filled_queue_ = xQueueCreate(PCM_PLAYER_BUFFER_COUNT + 1, sizeof(int));
+    for (auto& buffer : buffers_) {
+        buffer.reserve(PCM_PLAYER_BUFFER_SAMPLES);
+    }
+    read_buffer_.resize(PCM_PLAYER_BUFFER_SAMPLES * 2 * sizeof(int16_t));
+}
+
+PcmStreamPlayer::~PcmStreamPlayer() {
+    Stop();
+    Wait();
+    vQueueDelete(free_queue_);
+    vQueueDelete(filled_queue_);
+}
+
+bool PcmStreamPlayer::Play(std::unique_ptr<PcmSource> source, int channels, float gain, DoneCallback on_done) {
+    if (channels != 1 && channels != 2) {
+        ESP_LOGE(TAG, "Unsupported channel count %d", channels);
+        return false;
+    }
+    bool expected = false;
+    if (!playing_.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+        ESP_LOGW(TAG, "Already playing");
+        return false;
+    }
+
+    source_ = std::move(source);
+    channels_ = channels;
+    gain = (gain <= 0.0f) ? 1.0f : gain;
+    gain_q12_ = std::min<int32_t>((int32_t)(gain * GAIN_ONE + 0.5f), GAIN_MAX);
+    on_done_ = std::move(on_done);
+    source_ok_ = true;
+    samples_ = 0;
+    stop_requested_ = false;
+
+    xQueueReset(free_queue_);
+    xQueueReset(filled_queue_);
+    for (int i = 0; i < PCM_PLAYER_BUFFER_COUNT; i++) {
+        xQueueSend(free_queue_, &i, 0);
+    }
+
+    codec_->EnableOutput(true);
+    if (xTaskCreate([](void* arg) {
+            ((PcmStreamPlayer*)arg)->WriterLoop();
+            vTaskDelete(NULL);
+        }, "pcm_writer", PCM_PLAYER_WRITER_STACK_SIZE, this, 6, nullptr) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create writer task");
+        source_.reset();
+        on_done_ = nullptr;
+        playing_ = false;
+        return false;
+    }
+    if (xTaskCreate([](void* arg) {
+            ((PcmStreamPlayer*)arg)->ReaderLoop();
+            vTaskDelete(NULL);
+        }, "pcm_reader", PCM_PLAYER_READER_STACK_SIZE, this, 4, nullptr) != pdPASS) {
+        // The writer ends on the marker and reports the failure
+        ESP_LOGE(TAG, "Failed to create reader task");
+        source_.reset();
+        source_ok_ = false;
+        int end = -1;
+        xQueueSend(filled_queue_, &end, portMAX_DELAY);
+    }
+    return true;
+}
+
+void PcmStreamPlayer::Stop() {
+    stop_requested_ = true;
+}
+
+void PcmStreamPlayer::Wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this]() { return !playing_.load(std::memory_order_acquire); });
+}
+
+void PcmStreamPlayer::ReaderLoop() {
+    const size_t frame_bytes = channels_ * sizeof(int16_t);
+    size_t pending = 0;     // Bytes of an incomplete frame kept at the start of read_buffer_
+    bool end = false;
+    while (!end) {
+        int index;
+        xQueueReceive(free_queue_, &index, portMAX_DELAY);
+        auto& out = buffers_[index];
+        out.clear();
+        while (out.size() < PCM_PLAYER_BUFFER_SAMPLES) {
+            if (stop_requested_) {
+                end = true;
+                break;
+            }
+            size_t want = (PCM_PLAYER_BUFFER_SAMPLES - out.size()) * frame_bytes - pending;
+            int n = source_->Read(read_buffer_.data() + pending, want);
+            if (n <= 0) {
+                source_ok_ = n == 0;
+                end = true;
+                break;
+            }
+            pending += n;
+
+            size_t frames = pending / frame_bytes;
+            size_t offset = out.size();
+            out.resize(offset + frames);
+            auto in = reinterpret_cast<const int16_t*>(read_buffer_.data());
+            if (channels_ == 2) {
+                DownmixStereo(in, out.data() + offset, frames, gain_q12_);
+            } else {
+                ScaleMono(in, out.data() + offset, frames, gain_q12_);
+            }
+
+            size_t used = frames * frame_bytes;
+            pending -= used;
+            if (pending > 0) {
+                memmove(read_buffer_.data(), read_buffer_.data() + used, pending);
+            }
+        }
+
+        samples_ += out.size();
+        if (out.empty()) {
+            xQueueSend(free_queue_, &index, 0);
+        } else {
+            xQueueSend(filled_queue_, &index, portMAX_DELAY);
+        }
+    }
+
+    // Release the source before the marker: once the writer sees it, a new
+    // stream may start.
+    source_.reset();
+    int marker = -1;
+    xQueueSend(filled_queue_, &marker, portMAX_DELAY);
+}
+
+void PcmStreamPlayer::WriterLoop() {
+    bool started = false;
+    while (true) {
+        int index;
+        if (xQueueReceive(filled_queue_, &index, 0) != pdTRUE) {
+            if (started) {
+                underruns_.fetch_add(1, std::memory_order_relaxed);
+            }
+            xQueueReceive(filled_queue_, &index, portMAX_DELAY);
+        }
+        if (index < 0) {
+            break;
+        }
+        started = true;
+        codec_->OutputData(buffers_[index]);
+        xQueueSend(free_queue_, &index, portMAX_DELAY);
+    }
+
+    if (samples_ > 0) {
+        // Let the last DMA descriptors drain before reporting completion
+        int rate = codec_->output_sample_rate() > 0 ? codec_->output_sample_rate() : 16000;
+        vTaskDelay(pdMS_TO_TICKS(AUDIO_CODEC_DMA_DESC_NUM * AUDIO_CODEC_DMA_FRAME_NUM * 1000 / rate + 1));
+    }
+
+    bool ok = source_ok_ && samples_ > 0;
+    uint64_t samples = samples_;
+    DoneCallback on_done = std::move(on_done_);
+    on_done_ = nullptr;
+    ESP_LOGI(TAG, "Played %llu samples, %u underruns", (unsigned long long)samples, (unsigned)underruns());
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        playing_.store(false, std::memory_order_release);
+    }
+    done_cv_.notify_all();
+    if (on_done) {
+        on_done(ok, samples);
+    }
+}
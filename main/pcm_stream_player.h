@@ -0,0 +1,108 @@
+#ifndef PCM_STREAM_PLAYER_H
+#define PCM_STREAM_PLAYER_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/queue.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "audio_codec.h"
+
+// Each buffer holds a few DMA frames, so one I2S write fills whole descriptors
+#define PCM_PLAYER_DMA_FRAMES_PER_BUFFER 4
+#define PCM_PLAYER_BUFFER_SAMPLES (AUDIO_CODEC_DMA_FRAME_NUM * PCM_PLAYER_DMA_FRAMES_PER_BUFFER)
+#define PCM_PLAYER_BUFFER_COUNT 2
+// The reader may be pulling from HTTPS, so it gets a TLS-sized stack
+#define PCM_PLAYER_READER_STACK_SIZE (4096 * 6)
+#define PCM_PLAYER_WRITER_STACK_SIZE (4096)
+
+/**
+ * @brief Byte stream of 16-bit little-endian PCM samples
+ */
+class PcmSource {
+public:
+    virtual ~PcmSource() = default;
+
+    // Returns the number of bytes read, 0 at the end of the stream, < 0 on error
+    virtual int Read(uint8_t* buffer, size_t size) = 0;
+};
+
+/**
+ * @brief Reads at most `size` bytes from an open file, which it closes
+ */
+class FilePcmSource : public PcmSource {
+public:
+    FilePcmSource(FILE* file, size_t size) : file_(file), remaining_(size) {}
+    ~FilePcmSource() override;
+
+    int Read(uint8_t* buffer, size_t size) override;
+
+private:
+    FILE* file_;
+    size_t remaining_;
+};
+
+/**
+ * @brief Streams PCM to the codec without blocking the caller
+ *
+ * A reader task pulls bytes from the source and converts them (stereo
+ * downmix and gain) into one of two DMA-sized buffers while a writer task
+ * feeds the other one to I2S. Both tasks exist only while a stream plays.
+ */
+class PcmStreamPlayer {
+public:
+    using DoneCallback = std::function<void(bool ok, uint64_t samples)>;
+
+    explicit PcmStreamPlayer(AudioCodec* codec);
+    ~PcmStreamPlayer();
+
+    PcmStreamPlayer(const PcmStreamPlayer&) = delete;
+    PcmStreamPlayer& operator=(const PcmStreamPlayer&) = delete;
+
+    /**
+     * @brief Start playing; returns false if a stream is already playing
+     * @param channels 1 or 2; stereo is mixed down to mono
+     * @param on_done Called on the writer task once the last sample has left
+     *                the DMA buffers
+     */
+    bool Play(std::unique_ptr<PcmSource> source, int channels, float gain, DoneCallback on_done = nullptr);
+
+    // Ask the reader to end the stream early; buffered audio still plays
+    void Stop();
+    void Wait();
+
+    bool playing() const { return playing_.load(std::memory_order_acquire); }
+    uint32_t underruns() const { return underruns_.load(std::memory_order_relaxed); }
+
+private:
+    AudioCodec* codec_;
+    QueueHandle_t free_queue_ = nullptr;
+    QueueHandle_t filled_queue_ = nullptr;
+    std::vector<int16_t> buffers_[PCM_PLAYER_BUFFER_COUNT];
+    std::vector<uint8_t> read_buffer_;
+
+    std::unique_ptr<PcmSource> source_;
+    int channels_ = 1;
+    int32_t gain_q12_ = 4096;
+    DoneCallback on_done_;
+    bool source_ok_ = true;
+    uint64_t samples_ = 0;
+
+    std::atomic<bool> playing_{false};
+    std::atomic<bool> stop_requested_{false};
+    std::atomic<uint32_t> underruns_{0};
+    std::mutex mutex_;
+    std::condition_variable done_cv_;
+
+    void ReaderLoop();
+    void WriterLoop();
+};
+
+#endif // PCM_STREAM_PLAYER_H
@@ -0,0 +1,200 @@
+#include "json_dispatcher.h"
+#include "latency_histogram.h"
+#include "system_info.h"
+
+#include <esp_log.h>
+#include <esp_timer.h>
+
+#include <algorithm>
+#include <cstring>
+
+#define TAG "JsonDispatcher"
+
+namespace {
+
+std::atomic<uint32_t> messages{0};
+std::atomic<uint32_t> parsed{0};
+std::atomic<uint32_t> unhandled{0};
+
+// Shared by every dispatcher, registered on first use
+LatencyHistogram& DispatchLatency() {
+    static LatencyHistogram histogram;
+    static bool registered = [] {
+        SystemInfo::RegisterLatencyHistogram("json", &histogram);
+        return true;
+    }();
+    (void)registered;
+    return histogram;
+}
+
+inline size_t SkipSpace(const char* json, size_t i, size_t length) {
+    while (i < length && (json[i] == ' ' || json[i] == '\t' || json[i] == '\r' || json[i] == '\n')) {
+        i++;
+    }
+    return i;
+}
+
+// Index of the closing quote of the string starting after `i`, or length
+inline size_t SkipString(const char* json, size_t i, size_t length, bool* escaped) {
+    for (; i < length; i++) {
+        if (json[i] == '\\') {
+            *escaped = true;
+            i++;
+        } else if (json[i] == '"') {
+            return i;
+        }
+    }
+    return length;
+}
+
+} // namespace
+
+void JsonDispatcher::On(const char* type, Handler handler, bool needs_root) {
+    Entry entry{MessageTypeHash(type), type, strlen(type), needs_root, std::move(handler)};
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), entry.hash,
+                               [](const Entry& e, uint32_t hash) { return e.hash < hash; });
+    for (auto same = it; same != entries_.end() && same->hash == entry.hash; ++same) {
+        if (strcmp(same->type, type) == 0) {
+            ESP_LOGW(TAG, "Handler for %s replaced", type);
+            *same = std::move(entry);
+            return;
+        }
+    }
+    entries_.insert(it, std::move(entry));
+}
+
+void JsonDispatcher::Import(const JsonDispatcher& other, std::initializer_list<const char*> types) {
+    for (const char* type : types) {
+        const Entry* entry = other.Find(type, strlen(type));
+        if (entry != nullptr) {
+            On(entry->type, entry->handler, entry->needs_root);
+        }
+    }
+}
+
+const JsonDispatcher::Entry* JsonDispatcher::Find(const char* type, size_t length) const {
+    uint32_t hash = MessageTypeHash(type, length);
+    auto it = std::lower_bound(entries_.begin(), entries_.end(), hash,
+                               [](const Entry& e, uint32_t h) { return e.hash < h; });
+    for (; it != entries_.end() && it->hash == hash; ++it) {
+        if (it->length == length && memcmp(it->type, type, length) == 0) {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+bool JsonDispatcher::Deliver(const Entry* entry, const cJSON* root, const char* type, size_t length) {
+    if (entry != nullptr) {
+        entry->handler(root);
+        return true;
+    }
+    if (unhandled_ && unhandled_(root)) {
+        return true;
+    }
+    unhandled.fetch_add(1, std::memory_order_relaxed);
+    if (!unhandled_) {
+        ESP_LOGW(TAG, "Unknown message type: %.*s", (int)length, type);
+    }
+    return true;
+}
+
+bool JsonDispatcher::Dispatch(const cJSON* root) {
+    auto type = cJSON_GetObjectItem(root, "type");
+    if (!cJSON_IsString(type)) {
+        ESP_LOGE(TAG, "Message type is invalid");
+        return false;
+    }
+    size_t length = strlen(type->valuestring);
+    return Deliver(Find(type->valuestring, length), root, type->valuestring, length);
+}
+
+bool JsonDispatcher::Dispatch(const char* json, size_t length) {
+    int64_t start_us = esp_timer_get_time();
+    messages.fetch_add(1, std::memory_order_relaxed);
+
+    const char* type = nullptr;
+    size_t type_length = 0;
+    const Entry* entry = nullptr;
+    if (ScanType(json, length, &type, &type_length)) {
+        entry = Find(type, type_length);
+        if (entry != nullptr && !entry->needs_root) {
+            ESP_LOGD(TAG, "Dispatching %.*s without parsing", (int)type_length, type);
+            entry->handler(nullptr);
+            DispatchLatency().Record(esp_timer_get_time() - start_us);
+            return true;
+        }
+    }
+
+    cJSON* root = cJSON_ParseWithLength(json, length);
+    if (root == nullptr) {
+        ESP_LOGE(TAG, "Failed to parse json message %.*s", (int)length, json);
+        return false;
+    }
+    parsed.fetch_add(1, std::memory_order_relaxed);
+    bool ok = (type != nullptr) ? Deliver(entry, root, type, type_length) : Dispatch(root);
+    cJSON_Delete(root);
+    DispatchLatency().Record(esp_timer_get_time() - start_us);
+    return ok;
+}
+
+bool JsonDispatcher::ScanType(const char* json, size_t length, const char** type, size_t* type_length) {
+    size_t i = SkipSpace(json, 0, length);
+    if (i >= length || json[i] != '{') {
+        return false;
+    }
+    int depth = 0;
+    bool expect_key = false;
+    for (; i < length; i++) {
+        char c = json[i];
+        if (c == '"') {
+            bool escaped = false;
+            size_t start = i + 1;
+            size_t end = SkipString(json, start, length, &escaped);
+            if (end >= length) {
+                return false;
+            }
+            i = end;
+            if (depth != 1 || !expect_key) {
+                continue;
+            }
+            expect_key = false;
+            if (end - start != 4 || memcmp(json + start, "type", 4) != 0) {
+                continue;
+            }
+            size_t j = SkipSpace(json, end + 1, length);
+            if (j >= length || json[j] != ':') {
+                return false;
+            }
+            j = SkipSpace(json, j + 1, length);
+            if (j >= length || json[j] != '"') {
+                return false;
+            }
+            escaped = false;
+            size_t value_end = SkipString(json, j + 1, length, &escaped);
+            if (value_end >= length || escaped) {
+                return false;
+            }
+            *type = json + j + 1;
+            *type_length = value_end - j - 1;
+            return true;
+        }
+        if (c == '{' || c == '[') {
+            depth++;
+            expect_key = depth == 1;
+        } else if (c == '}' || c == ']') {
+            depth--;
+        } else if (c == ',' && depth == 1) {
+            expect_key = true;
+        }
+    }
+    return false;
+}
+
+JsonDispatcher::Stats JsonDispatcher::GetStats() {
+    Stats stats;
+    stats.messages = messages.load(std::memory_order_relaxed);
+    stats.parsed = parsed.load(std::memory_order_relaxed);
+    stats.unhandled = unhandled.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,101 @@
+#ifndef JSON_DISPATCHER_H
+#define JSON_DISPATCHER_H
+
+#include <cJSON.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <vector>
+
+// FNV-1a of a message type; constexpr so it can also label switch cases
+constexpr uint32_t MessageTypeHash(const char* type, size_t length) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash = (hash ^ (uint8_t)type[i]) * 16777619u;
+    }
+    return hash;
+}
+
+constexpr uint32_t MessageTypeHash(const char* type) {
+    size_t length = 0;
+    while (type[length] != '\0') {
+        length++;
+    }
+    return MessageTypeHash(type, length);
+}
+
+/**
+ * @brief Routes JSON control messages to handlers by their "type" field
+ *
+ * Handlers are registered once and kept sorted by the hash of their type,
+ * so a lookup is a binary search plus one string compare. Raw payloads are
+ * pre-scanned for the top-level "type" string; the cJSON tree is only built
+ * when the matching handler (or the fallback) needs it.
+ *
+ * Parse plus dispatch time of every raw payload is recorded in the shared
+ * "json" latency histogram.
+ */
+class JsonDispatcher {
+public:
+    // root is nullptr for handlers registered with needs_root = false
+    using Handler = std::function<void(const cJSON* root)>;
+    // Returns false if the message could not be passed on either
+    using Fallback = std::function<bool(const cJSON* root)>;
+
+    struct Stats {
+        uint32_t messages;
+        uint32_t parsed;        // Needed a cJSON tree
+        uint32_t unhandled;     // No handler or fallback took them
+    };
+
+    JsonDispatcher() = default;
+
+    JsonDispatcher(const JsonDispatcher&) = delete;
+    JsonDispatcher& operator=(const JsonDispatcher&) = delete;
+
+    /**
+     * @param type Must outlive the dispatcher (a string literal)
+     * @param needs_root false when the handler only cares that the message
+     *                   arrived, which spares building the tree
+     */
+    void On(const char* type, Handler handler, bool needs_root = true);
+
+    // Called with the parsed message when no handler matches its type
+    void OnUnhandled(Fallback fallback) { unhandled_ = std::move(fallback); }
+
+    // Registers the handlers other has for these types; missing ones are skipped
+    void Import(const JsonDispatcher& other, std::initializer_list<const char*> types);
+
+    // Returns false if the payload is not JSON or has no string "type"
+    bool Dispatch(const char* json, size_t length);
+    bool Dispatch(const cJSON* root);
+
+    /**
+     * @brief Find the top-level "type" string without building a tree
+     * @return false if not found or the value has escapes; the caller then
+     *         parses the payload normally
+     */
+    static bool ScanType(const char* json, size_t length, const char** type, size_t* type_length);
+
+    static Stats GetStats();
+
+private:
+    struct Entry {
+        uint32_t hash;
+        const char* type;
+        size_t length;
+        bool needs_root;
+        Handler handler;
+    };
+
+    std::vector<Entry> entries_;
+    Fallback unhandled_;
+
+    const Entry* Find(const char* type, size_t length) const;
+    bool Deliver(const Entry* entry, const cJSON* root, const char* type, size_t length);
+};
+
+#endif // JSON_DISPATCHER_H
@@ -43,6 +43,7 @@ static bool IsValidWebSocketUrl(const std::string& url) {
 MqttProtocol::MqttProtocol() {
     event_group_handle_ = xEventGroupCreate();
     server_requested_websocket_ = false;
+    RegisterMessageHandlers();
 }
 
 MqttProtocol::~MqttProtocol() {
@@ -56,6 +57,145 @@ MqttProtocol::~MqttProtocol() {
     vEventGroupDelete(event_group_handle_);
 }
 
+// Protocol-level messages are handled here; everything else (listen, tts,
+// stt, ...) goes on to the application
+void MqttProtocol::RegisterMessageHandlers() {
+    dispatcher_.On("hello", [this](const cJSON* root) {
+        ESP_LOGI(TAG, "Received server hello message");
+        ParseServerHello(root);
+    });
+    dispatcher_.On("ws_start", [this](const cJSON* root) {
+        // Server is redirecting to WebSocket
+        // ws_start indicates alarm mode (server-initiated conversation)
+        server_requested_websocket_ = true;
+        auto wss_url = cJSON_GetObjectItem(root, "wss");
+        auto version = cJSON_GetObjectItem(root, "version");
+        
+        if (cJSON_IsString(wss_url)) {
+            std::string url = wss_url->valuestring;
+            ESP_LOGI(TAG, "Server requests WebSocket connection (alarm mode): %s", url.c_str());
+            
+            // Set alarm mode flag - in alarm mode, TTS plays first, then listening starts
+            Application::GetInstance().SetAlarmMode(true);
+            
+            // Validate URL before saving
+            if (!IsValidWebSocketUrl(url)) {
+                ESP_LOGW(TAG, "Invalid WebSocket URL received (localhost/invalid): %s, will use default URL instead", url.c_str());
+                // Don't save invalid URL, let WebSocket protocol use default
+            } else {
+                // Save WebSocket URL and version to settings
+                Settings ws_settings("websocket", true);
+                ws_settings.SetString("url", url);
+                if (cJSON_IsNumber(version)) {
+                    ws_settings.SetInt("version", version->valueint);
+                    ESP_LOGI(TAG, "WebSocket version: %d", version->valueint);
+                }
+                ESP_LOGI(TAG, "WebSocket URL saved. Opening WebSocket connection for conversation...");
+            }
+            
+            // Schedule opening WebSocket connection in the application context
+            // (will use default URL if invalid URL was received)
+            // Always open WebSocket connection when ws_start is received, even if one exists
+            // This ensures a fresh session and proper callback setup for each new conversation
+            Application::GetInstance().Schedule([this]() {
+                auto& app = Application::GetInstance();
+                // Always open WebSocket connection - if one exists, it will be closed and recreated
+                // This ensures clean state and proper callback setup for each new conversation
+                ESP_LOGI(TAG, "Opening WebSocket connection for ws_start (alarm mode - TTS first, then listening)");
+                app.OpenWebSocketConnection();
+            });
+        } else {
+            ESP_LOGE(TAG, "ws_start message missing 'wss' field");
+        }
+    });
+    dispatcher_.On("goodbye", [this](const cJSON* root) {
+        auto session_id = cJSON_GetObjectItem(root, "session_id");
+        ESP_LOGI(TAG, "Received goodbye message, session_id: %s", session_id ? session_id->valuestring : "null");
+        if (session_id == nullptr || session_id_ == session_id->valuestring) {
+            Application::GetInstance().Schedule([this]() {
+                CloseAudioChannel();
+            });
+        }
+    });
+    dispatcher_.On("remote_anim_update", [](const cJSON*) {
+        // Remote animation update request - trigger animation updater's update loop
+        ESP_LOGI(TAG, "Received remote_anim_update message, triggering animation update loop");
+        Application::GetInstance().Schedule([]() {
+            auto& anim_updater = AnimationUpdater::GetInstance();
+            ESP_LOGI(TAG, "Calling AnimationUpdater::TriggerUpdateLoop()");
+            anim_updater.TriggerUpdateLoop();
+        });
+    }, false);
+    dispatcher_.On("wifi_reconfig_nimble", [](const cJSON*) {
+        // Remote WiFi reconfiguration request:
+        // enter NimBLE WiFi setup mode without clearing existing credentials.
+        ESP_LOGI(TAG, "Received wifi_reconfig_nimble message, entering BLE WiFi config mode");
+        Application::GetInstance().Schedule([]() {
+            Board::GetInstance().EnterBleWifiConfigMode();
+        });
+    });
+    dispatcher_.On("wifi_clear_credential", [](const cJSON*) {
+        // Clear all persisted WiFi credentials, then reboot into BLE onboarding mode.
+        ESP_LOGI(TAG, "Received wifi_clear_credential message, clearing saved WiFi credentials");
+        Application::GetInstance().Schedule([]() {
+            auto& board = Board::GetInstance();
+            board.ClearWifiConfiguration();
+            board.EnterBleWifiConfigMode();
+        });
+    });
+    dispatcher_.On("switch_wifi_to", [](const cJSON* root) {
+        auto message = cJSON_GetObjectItem(root, "message");
+        if (!cJSON_IsString(message) || message->valuestring == nullptr || strlen(message->valuestring) == 0) {
+            ESP_LOGW(TAG, "switch_wifi_to ignored: missing or invalid message field");
+        } else {
+            std::string target_ssid = message->valuestring;
+            auto& ssid_manager = SsidManager::GetInstance();
+            bool matched = false;
+            for (const auto& item : ssid_manager.GetSsidList()) {
+                if (item.ssid == target_ssid) {
+                    matched = true;
+                    break;
+                }
+            }
+
+            if (!matched) {
+                ESP_LOGI(TAG, "switch_wifi_to ignored: target SSID '%s' not found in saved credentials", target_ssid.c_str());
+            } else {
+                ESP_LOGI(TAG, "switch_wifi_to: scheduling one-shot preferred SSID '%s' for next reboot", target_ssid.c_str());
+                Settings wifi_settings("wifi", true);
+                wifi_settings.SetString("nxt_boot_ssid", target_ssid);
+                Application::GetInstance().Schedule([]() {
+                    esp_restart();
+                });
+            }
+        }
+    });
+    dispatcher_.On("set_ota_url", [](const cJSON* root) {
+        auto message = cJSON_GetObjectItem(root, "message");
+        if (!cJSON_IsString(message) || message->valuestring == nullptr || strlen(message->valuestring) == 0) {
+            ESP_LOGW(TAG, "set_ota_url ignored: missing or invalid message field");
+        } else {
+            std::string custom_ota_url = message->valuestring;
+            ESP_LOGI(TAG, "set_ota_url: saving custom OTA URL for next boot: %s", custom_ota_url.c_str());
+            Settings ota_settings("ota", true);
+            ota_settings.SetString("cus_ota_url", custom_ota_url);
+            ota_settings.EraseKey("ota_retry");
+            Application::GetInstance().Schedule([]() {
+                esp_restart();
+            });
+        }
+    });
+    // Forwarded messages are counted by the application's dispatcher
+    dispatcher_.OnUnhandled([this](const cJSON* root) {
+        if (on_incoming_json_ == nullptr) {
+            ESP_LOGW(TAG, "on_incoming_json_ callback is null, cannot forward message");
+            return false;
+        }
+        on_incoming_json_(root);
+        return true;
+    });
+}
+
 bool MqttProtocol::Start() {
     return StartMqttClient(false);
 }
@@ -187,153 +327,9 @@ bool MqttProtocol::StartMqttClient(bool report_error) {
             payload.find("type\":\"listen\"") != std::string::npos) {
             ESP_LOGI(TAG, "*** LISTEN MESSAGE DETECTED IN MQTT PAYLOAD ***");
         }
-        cJSON* root = cJSON_Parse(payload.c_str());
-        if (root == nullptr) {
-            ESP_LOGE(TAG, "Failed to parse json message %s", payload.c_str());
+        if (!dispatcher_.Dispatch(payload.data(), payload.size())) {
             return;
         }
-        cJSON* type = cJSON_GetObjectItem(root, "type");
-        if (!cJSON_IsString(type)) {
-            ESP_LOGE(TAG, "Message type is invalid");
-            cJSON_Delete(root);
-            return;
-        }
-
-        ESP_LOGI(TAG, "Processing message type: %s", type->valuestring);
-        if (strcmp(type->valuestring, "hello") == 0) {
-            ESP_LOGI(TAG, "Received server hello message");
-            ParseServerHello(root);
-        } else if (strcmp(type->valuestring, "ws_start") == 0) {
-            // Server is redirecting to WebSocket
-            // ws_start indicates alarm mode (server-initiated conversation)
-            server_requested_websocket_ = true;
-            auto wss_url = cJSON_GetObjectItem(root, "wss");
-            auto version = cJSON_GetObjectItem(root, "version");
-            
-            if (cJSON_IsString(wss_url)) {
-                std::string url = wss_url->valuestring;
-                ESP_LOGI(TAG, "Server requests WebSocket connection (alarm mode): %s", url.c_str());
-                
-                // Set alarm mode flag - in alarm mode, TTS plays first, then listening starts
-                Application::GetInstance().SetAlarmMode(true);
-                
-                // Validate URL before saving
-                if (!IsValidWebSocketUrl(url)) {
-                    ESP_LOGW(TAG, "Invalid WebSocket URL received (localhost/invalid): %s, will use default URL instead", url.c_str());
-                    // Don't save invalid URL, let WebSocket protocol use default
-                } else {
-                    // Save WebSocket URL and version to settings
-                    Settings ws_settings("websocket", true);
-                    ws_settings.SetString("url", url);
-                    if (cJSON_IsNumber(version)) {
-                        ws_settings.SetInt("version", version->valueint);
-                        ESP_LOGI(TAG, "WebSocket version: %d", version->valueint);
-                    }
-                    ESP_LOGI(TAG, "WebSocket URL saved. Opening WebSocket connection for conversation...");
-                }
-                
-                // Schedule opening WebSocket connection in the application context
-                // (will use default URL if invalid URL was received)
-                // Always open WebSocket connection when ws_start is received, even if one exists
-                // This ensures a fresh session and proper callback setup for each new conversation
-                Application::GetInstance().Schedule([this]() {
-                    auto& app = Application::GetInstance();
-                    // Always open WebSocket connection - if one exists, it will be closed and recreated
-                    // This ensures clean state and proper callback setup for each new conversation
-                    ESP_LOGI(TAG, "Opening WebSocket connection for ws_start (alarm mode - TTS first, then listening)");
-                    app.OpenWebSocketConnection();
-                });
-            } else {
-                ESP_LOGE(TAG, "ws_start message missing 'wss' field");
-            }
-            // Don't pass ws_start to on_incoming_json_ as it's a protocol-level message
-        } else if (strcmp(type->valuestring, "goodbye") == 0) {
-            auto session_id = cJSON_GetObjectItem(root, "session_id");
-            ESP_LOGI(TAG, "Received goodbye message, session_id: %s", session_id ? session_id->valuestring : "null");
-            if (session_id == nullptr || session_id_ == session_id->valuestring) {
-                Application::GetInstance().Schedule([this]() {
-                    CloseAudioChannel();
-                });
-            }
-            // Don't forward goodbye to on_incoming_json_ as it's a protocol-level message
-        } else if (strcmp(type->valuestring, "remote_anim_update") == 0) {
-            // Remote animation update request - trigger animation updater's update loop
-            ESP_LOGI(TAG, "Received remote_anim_update message, triggering animation update loop");
-            Application::GetInstance().Schedule([]() {
-                auto& anim_updater = AnimationUpdater::GetInstance();
-                ESP_LOGI(TAG, "Calling AnimationUpdater::TriggerUpdateLoop()");
-                anim_updater.TriggerUpdateLoop();
-            });
-            // Don't forward remote_anim_update to on_incoming_json_ as it's a protocol-level message
-        } else if (strcmp(type->valuestring, "wifi_reconfig_nimble") == 0) {
-            // Remote WiFi reconfiguration request:
-            // enter NimBLE WiFi setup mode without clearing existing credentials.
-            ESP_LOGI(TAG, "Received wifi_reconfig_nimble message, entering BLE WiFi config mode");
-            Application::GetInstance().Schedule([]() {
-                Board::GetInstance().EnterBleWifiConfigMode();
-            });
-            // Don't forward wifi_reconfig_nimble to on_incoming_json_ as it's a protocol-level message
-        } else if (strcmp(type->valuestring, "wifi_clear_credential") == 0) {
-            // Clear all persisted WiFi credentials, then reboot into BLE onboarding mode.
-            ESP_LOGI(TAG, "Received wifi_clear_credential message, clearing saved WiFi credentials");
-            Application::GetInstance().Schedule([]() {
-                auto& board = Board::GetInstance();
-                board.ClearWifiConfiguration();
-                board.EnterBleWifiConfigMode();
-            });
-            // Don't forward wifi_clear_credential to on_incoming_json_ as it's a protocol-level message
-        } else if (strcmp(type->valuestring, "switch_wifi_to") == 0) {
-            auto message = cJSON_GetObjectItem(root, "message");
-            if (!cJSON_IsString(message) || message->valuestring == nullptr || strlen(message->valuestring) == 0) {
-                ESP_LOGW(TAG, "switch_wifi_to ignored: missing or invalid message field");
-            } else {
-                std::string target_ssid = message->valuestring;
-                auto& ssid_manager = SsidManager::GetInstance();
-                bool matched = false;
-                for (const auto& item : ssid_manager.GetSsidList()) {
-                    if (item.ssid == target_ssid) {
-                        matched = true;
-                        break;
-                    }
-                }
-
-                if (!matched) {
-                    ESP_LOGI(TAG, "switch_wifi_to ignored: target SSID '%s' not found in saved credentials", target_ssid.c_str());
-                } else {
-                    ESP_LOGI(TAG, "switch_wifi_to: scheduling one-shot preferred SSID '%s' for next reboot", target_ssid.c_str());
-                    Settings wifi_settings("wifi", true);
-                    wifi_settings.SetString("nxt_boot_ssid", target_ssid);
-                    Application::GetInstance().Schedule([]() {
-                        esp_restart();
-                    });
-                }
-            }
-            // Don't forward switch_wifi_to to on_incoming_json_ as it's a protocol-level message
-        } else if (strcmp(type->valuestring, "set_ota_url") == 0) {
-            auto message = cJSON_GetObjectItem(root, "message");
-            if (!cJSON_IsString(message) || message->valuestring == nullptr || strlen(message->valuestring) == 0) {
-                ESP_LOGW(TAG, "set_ota_url ignored: missing or invalid message field");
-            } else {
-                std::string custom_ota_url = message->valuestring;
-                ESP_LOGI(TAG, "set_ota_url: saving custom OTA URL for next boot: %s", custom_ota_url.c_str());
-                Settings ota_settings("ota", true);
-                ota_settings.SetString("cus_ota_url", custom_ota_url);
-                ota_settings.EraseKey("ota_retry");
-                Application::GetInstance().Schedule([]() {
-                    esp_restart();
-                });
-            }
-            // Don't forward set_ota_url to on_incoming_json_ as it's a protocol-level message
-        } else {
-            // Forward all other message types (including "listen", "tts", "stt", etc.) to Application handler
-            ESP_LOGI(TAG, "Forwarding MQTT message type '%s' to Application::OnIncomingJson", type->valuestring);
-            if (on_incoming_json_ != nullptr) {
-                on_incoming_json_(root);
-            } else {
-                ESP_LOGW(TAG, "on_incoming_json_ callback is null, cannot forward message type '%s'", type->valuestring);
-            }
-        }
-        cJSON_Delete(root);
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
 
@@ -467,24 +463,38 @@ bool MqttProtocol::SendAudio(const AudioStreamPacket& packet) {
         return false;
     }
 
-    std::string nonce(aes_nonce_);
-    *(uint16_t*)&nonce[2] = htons(packet.payload.size());
-    *(uint32_t*)&nonce[8] = htonl(packet.timestamp);
-    *(uint32_t*)&nonce[12] = htonl(++local_sequence_);
-
-    std::string encrypted;
-    encrypted.resize(aes_nonce_.size() + packet.payload.size());
-    memcpy(encrypted.data(), nonce.data(), nonce.size());
-
+    size_t payload_size = packet.payload.size();
+    size_t datagram_size = MQTT_UDP_NONCE_SIZE + payload_size;
+    if (datagram_size > uplink_datagram_.capacity()) {
+        uplink_datagram_.reserve(std::max<size_t>(datagram_size, MQTT_UDP_DATAGRAM_RESERVE));
+        uplink_reallocations_++;
+    }
+    // Within capacity, so this never allocates
+    uplink_datagram_.resize(datagram_size);
+    auto datagram = (uint8_t*)uplink_datagram_.data();
+
+    *(uint16_t*)&aes_nonce_[2] = htons(payload_size);
+    *(uint32_t*)&aes_nonce_[8] = htonl(packet.timestamp);
+    *(uint32_t*)&aes_nonce_[12] = htonl(++local_sequence_);
+    memcpy(datagram, aes_nonce_, MQTT_UDP_NONCE_SIZE);
+
+    // CTR advances the counter block, so it runs on a copy of the nonce
+    uint8_t counter[MQTT_UDP_NONCE_SIZE];
+    memcpy(counter, aes_nonce_, MQTT_UDP_NONCE_SIZE);
     size_t nc_off = 0;
     uint8_t stream_block[16] = {0};
-    if (mbedtls_aes_crypt_ctr(&aes_ctx_, packet.payload.size(), &nc_off, (uint8_t*)nonce.c_str(), stream_block,
-        (uint8_t*)packet.payload.data(), (uint8_t*)&encrypted[nonce.size()]) != 0) {
+    if (mbedtls_aes_crypt_ctr(&aes_ctx_, payload_size, &nc_off, counter, stream_block,
+        packet.payload.data(), datagram + MQTT_UDP_NONCE_SIZE) != 0) {
         ESP_LOGE(TAG, "Failed to encrypt audio data");
         return false;
     }
 
-    return udp_->Send(encrypted) > 0;
+    if (udp_->Send(uplink_datagram_) <= 0) {
+        return false;
+    }
+    packets_sent_++;
+    bytes_sent_ += datagram_size;
+    return true;
 }
 
 void MqttProtocol::CloseAudioChannel() {
@@ -493,6 +503,8 @@ void MqttProtocol::CloseAudioChannel() {
         if (udp_ != nullptr) {
             delete udp_;
             udp_ = nullptr;
+            ESP_LOGI(TAG, "Audio channel closed: sent %lu packets (%lu bytes), received %lu packets (%lu bytes), %lu uplink reallocations",
+                packets_sent_, bytes_sent_, packets_received_.load(), bytes_received_.load(), uplink_reallocations_);
         }
     }
 
@@ -555,7 +567,7 @@ bool MqttProtocol::OpenAudioChannel() {
          * |type 1u|flags 1u|payload_len 2u|ssrc 4u|timestamp 4u|sequence 4u|
          * |payload payload_len|
          */
-        if (data.size() < sizeof(aes_nonce_)) {
+        if (data.size() < MQTT_UDP_NONCE_SIZE) {
             ESP_LOGE(TAG, "Invalid audio packet size: %u", data.size());
             return;
         }
@@ -565,25 +577,27 @@ bool MqttProtocol::OpenAudioChannel() {
         }
         uint32_t timestamp = ntohl(*(uint32_t*)&data[8]);
         uint32_t sequence = ntohl(*(uint32_t*)&data[12]);
-        if (sequence < remote_sequence_) {
-            ESP_LOGW(TAG, "Received audio packet with old sequence: %lu, expected: %lu", sequence, remote_sequence_);
-            return;
-        }
+        // Reordered and missing packets are handled by the jitter buffer
+        // downstream; only note them here.
         if (sequence != remote_sequence_ + 1) {
-            ESP_LOGW(TAG, "Received audio packet with wrong sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
+            ESP_LOGD(TAG, "Received audio packet out of sequence: %lu, expected: %lu", sequence, remote_sequence_ + 1);
         }
 
-        size_t decrypted_size = data.size() - aes_nonce_.size();
+        // Decrypt straight from the datagram into a pooled payload buffer.
+        // The nonce is copied out first because CTR advances the counter.
+        size_t decrypted_size = data.size() - MQTT_UDP_NONCE_SIZE;
         size_t nc_off = 0;
         uint8_t stream_block[16] = {0};
-        auto nonce = (uint8_t*)data.data();
-        auto encrypted = (uint8_t*)data.data() + aes_nonce_.size();
+        uint8_t counter[MQTT_UDP_NONCE_SIZE];
+        memcpy(counter, data.data(), MQTT_UDP_NONCE_SIZE);
+        auto encrypted = (const uint8_t*)data.data() + MQTT_UDP_NONCE_SIZE;
         AudioStreamPacket packet;
         packet.sample_rate = server_sample_rate_;
         packet.frame_duration = server_frame_duration_;
         packet.timestamp = timestamp;
+        packet.sequence = sequence;
         packet.payload.resize(decrypted_size);
-        int ret = mbedtls_aes_crypt_ctr(&aes_ctx_, decrypted_size, &nc_off, nonce, stream_block, encrypted, (uint8_t*)packet.payload.data());
+        int ret = mbedtls_aes_crypt_ctr(&aes_ctx_, decrypted_size, &nc_off, counter, stream_block, encrypted, packet.payload.data());
         if (ret != 0) {
             ESP_LOGE(TAG, "Failed to decrypt audio data, ret: %d", ret);
             return;
@@ -591,7 +605,11 @@ bool MqttProtocol::OpenAudioChannel() {
         if (on_incoming_audio_ != nullptr) {
             on_incoming_audio_(std::move(packet));
         }
-        remote_sequence_ = sequence;
+        packets_received_.fetch_add(1, std::memory_order_relaxed);
+        bytes_received_.fetch_add(data.size(), std::memory_order_relaxed);
+        if ((int32_t)(sequence - remote_sequence_) > 0) {
+            remote_sequence_ = sequence;
+        }
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
 
@@ -623,6 +641,9 @@ std::string MqttProtocol::GetHelloMessage() {
 #endif
 #if CONFIG_IOT_PROTOCOL_MCP
     cJSON_AddBoolToObject(features, "mcp", true);
+#endif
+#if CONFIG_IOT_PROTOCOL_XIAOZHI
+    cJSON_AddBoolToObject(features, "iot_cbor", true);
 #endif
     cJSON_AddItemToObject(root, "features", features);
     cJSON* audio_params = cJSON_CreateObject();
@@ -630,6 +651,9 @@ std::string MqttProtocol::GetHelloMessage() {
     cJSON_AddNumberToObject(audio_params, "sample_rate", requested_sample_rate);
     cJSON_AddNumberToObject(audio_params, "channels", 1);
     cJSON_AddNumberToObject(audio_params, "frame_duration", OPUS_FRAME_DURATION_MS);
+    // Uplink frames may be DTX and carry in-band FEC on lossy links
+    cJSON_AddBoolToObject(audio_params, "dtx", true);
+    cJSON_AddBoolToObject(audio_params, "fec", true);
     cJSON_AddItemToObject(root, "audio_params", audio_params);
     auto json_str = cJSON_PrintUnformatted(root);
     std::string message(json_str);
@@ -651,7 +675,16 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
         ESP_LOGI(TAG, "Session ID: %s", session_id_.c_str());
     }
 
+    // IoT states stay JSON unless the server opts in
+    server_iot_cbor_ = false;
+    auto features = cJSON_GetObjectItem(root, "features");
+    if (cJSON_IsObject(features)) {
+        server_iot_cbor_ = cJSON_IsTrue(cJSON_GetObjectItem(features, "iot_cbor"));
+    }
+
     // Get sample rate from hello message
+    // Servers that do not answer the dtx capability keep the old behaviour
+    server_dtx_ = true;
     auto audio_params = cJSON_GetObjectItem(root, "audio_params");
     if (cJSON_IsObject(audio_params)) {
         auto sample_rate = cJSON_GetObjectItem(audio_params, "sample_rate");
@@ -662,6 +695,10 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
         if (cJSON_IsNumber(frame_duration)) {
             server_frame_duration_ = frame_duration->valueint;
         }
+        auto dtx = cJSON_GetObjectItem(audio_params, "dtx");
+        if (cJSON_IsBool(dtx)) {
+            server_dtx_ = cJSON_IsTrue(dtx);
+        }
     }
 
     auto udp = cJSON_GetObjectItem(root, "udp");
@@ -676,11 +713,24 @@ void MqttProtocol::ParseServerHello(const cJSON* root) {
 
     // auto encryption = cJSON_GetObjectItem(udp, "encryption")->valuestring;
     // ESP_LOGI(TAG, "UDP server: %s, port: %d, encryption: %s", udp_server_.c_str(), udp_port_, encryption);
-    aes_nonce_ = DecodeHexString(nonce);
+    auto nonce_bytes = DecodeHexString(nonce);
+    if (nonce_bytes.size() != MQTT_UDP_NONCE_SIZE) {
+        ESP_LOGE(TAG, "Invalid UDP nonce size: %u", nonce_bytes.size());
+        return;
+    }
+    std::lock_guard<std::mutex> lock(channel_mutex_);
+    memcpy(aes_nonce_, nonce_bytes.data(), MQTT_UDP_NONCE_SIZE);
     mbedtls_aes_init(&aes_ctx_);
     mbedtls_aes_setkey_enc(&aes_ctx_, (const unsigned char*)DecodeHexString(key).c_str(), 128);
     local_sequence_ = 0;
     remote_sequence_ = 0;
+    packets_sent_ = 0;
+    bytes_sent_ = 0;
+    packets_received_ = 0;
+    bytes_received_ = 0;
+    if (uplink_datagram_.capacity() < MQTT_UDP_DATAGRAM_RESERVE) {
+        uplink_datagram_.reserve(MQTT_UDP_DATAGRAM_RESERVE);
+    }
     xEventGroupSetBits(event_group_handle_, MQTT_PROTOCOL_SERVER_HELLO_EVENT);
 }
 
@@ -3,6 +3,7 @@
 
 
 #include "protocol.h"
+#include "json_dispatcher.h"
 #include <mqtt.h>
 #include <udp.h>
 #include <cJSON.h>
@@ -14,12 +15,18 @@
 #include <string>
 #include <map>
 #include <mutex>
+#include <atomic>
 
 #define MQTT_PING_INTERVAL_SECONDS 90
 #define MQTT_RECONNECT_INTERVAL_MS 10000
 
 #define MQTT_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
 
+// Every UDP audio datagram starts with the 16-byte AES-CTR nonce
+#define MQTT_UDP_NONCE_SIZE 16
+// Nonce plus a typical Opus frame; larger frames grow the buffer once
+#define MQTT_UDP_DATAGRAM_RESERVE (MQTT_UDP_NONCE_SIZE + 512)
+
 class MqttProtocol : public Protocol {
 public:
     MqttProtocol();
@@ -40,18 +47,33 @@ private:
     bool reconnecting_ = false;  // Prevent multiple simultaneous reconnection attempts
     int reconnect_backoff_ms_ = 200;  // Reconnection backoff delay (200-500ms)
 
+    JsonDispatcher dispatcher_;
+
     std::mutex channel_mutex_;
     Mqtt* mqtt_ = nullptr;
     Udp* udp_ = nullptr;
     mbedtls_aes_context aes_ctx_;
-    std::string aes_nonce_;
+    // Nonce template from the server hello; size, timestamp and sequence are
+    // patched in per packet
+    alignas(4) uint8_t aes_nonce_[MQTT_UDP_NONCE_SIZE] = {};
+    // Uplink datagram, reused for every packet: the nonce is written into
+    // the headroom and the payload is encrypted straight in behind it
+    std::string uplink_datagram_;
     std::string udp_server_;
     int udp_port_;
     uint32_t local_sequence_;
     uint32_t remote_sequence_;
 
+    // Audio channel counters, logged when the channel closes
+    uint32_t packets_sent_ = 0;
+    uint32_t bytes_sent_ = 0;
+    uint32_t uplink_reallocations_ = 0;
+    std::atomic<uint32_t> packets_received_{0};
+    std::atomic<uint32_t> bytes_received_{0};
+
     bool StartMqttClient(bool report_error=false);
     void AttemptReconnection();  // Continuous retry until connected
+    void RegisterMessageHandlers();
     void ParseServerHello(const cJSON* root);
     std::string DecodeHexString(const std::string& hex_string);
 
@@ -2,6 +2,8 @@
 
 #include <esp_log.h>
 
+#include "cbor_writer.h"
+
 #define TAG "Protocol"
 
 void Protocol::OnIncomingJson(std::function<void(const cJSON* root)> callback) {
@@ -123,6 +125,24 @@ void Protocol::SendIotStates(const std::string& states) {
     SendText(message);
 }
 
+void Protocol::SendIotStatesCbor(const std::string& states) {
+    // Same envelope as SendIotStates. A CBOR map header is never '{', so the
+    // server tells the encodings apart by the first byte.
+    std::string message;
+    message.reserve(session_id_.size() + states.size() + 40);
+    CborWriter writer(message);
+    writer.Map(4);
+    writer.String("session_id");
+    writer.String(session_id_);
+    writer.String("type");
+    writer.String("iot");
+    writer.String("update");
+    writer.Bool(true);
+    writer.String("states");
+    writer.Raw(states);
+    SendText(message);
+}
+
 void Protocol::SendMcpMessage(const std::string& payload) {
     std::string message = "{\"session_id\":\"" + session_id_ + "\",\"type\":\"mcp\",\"payload\":" + payload + "}";
     ESP_LOGI(TAG, "SendMcpMessage: Wrapping MCP payload, session_id='%s', message_size=%zu bytes", session_id_.c_str(), message.length());
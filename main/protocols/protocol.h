@@ -7,11 +7,15 @@
 #include <chrono>
 #include <vector>
 
+#include "audio_frame_pool.h"
+
 struct AudioStreamPacket {
     int sample_rate = 0;
     int frame_duration = 0;
     uint32_t timestamp = 0;
-    std::vector<uint8_t> payload;
+    uint32_t sequence = 0;      // Playout order, used by the jitter buffer
+    int64_t arrival_us = 0;     // esp_timer time at network receive, 0 for local audio
+    OpusFrame payload;
 };
 
 struct BinaryProtocol2 {
@@ -30,6 +34,21 @@ struct BinaryProtocol3 {
     uint8_t payload[];
 } __attribute__((packed));
 
+// Batched uplink, used once both sides announce "audio_batch" in hello.
+// All fields are in network byte order.
+struct BinaryProtocol4 {
+    uint8_t type;           // Message type (0: OPUS)
+    uint8_t frame_count;
+    uint16_t payload_size;  // Bytes of frames that follow
+    uint8_t payload[];      // frame_count x BinaryProtocol4Frame
+} __attribute__((packed));
+
+struct BinaryProtocol4Frame {
+    uint32_t timestamp;     // Timestamp in milliseconds (used for server-side AEC)
+    uint16_t size;
+    uint8_t data[];
+} __attribute__((packed));
+
 enum AbortReason {
     kAbortReasonNone,
     kAbortReasonWakeWordDetected
@@ -51,6 +70,14 @@ public:
     inline int server_frame_duration() const {
         return server_frame_duration_;
     }
+    // Whether the server accepts DTX (silence sent as tiny or no frames)
+    inline bool server_dtx() const {
+        return server_dtx_;
+    }
+    // Whether the server takes IoT states as CBOR (SendIotStatesCbor)
+    inline bool server_iot_cbor() const {
+        return server_iot_cbor_;
+    }
     inline const std::string& session_id() const {
         return session_id_;
     }
@@ -66,12 +93,16 @@ public:
     virtual void CloseAudioChannel() = 0;
     virtual bool IsAudioChannelOpened() const = 0;
     virtual bool SendAudio(const AudioStreamPacket& packet) = 0;
+    // Send audio held back for batching; called after each burst of SendAudio
+    virtual bool FlushAudio() { return true; }
     virtual void SendWakeWordDetected(const std::string& wake_word);
     virtual void SendStartListening(ListeningMode mode);
     virtual void SendStopListening();
     virtual void SendAbortSpeaking(AbortReason reason);
     virtual void SendIotDescriptors(const std::string& descriptors);
     virtual void SendIotStates(const std::string& states);
+    // states is a CBOR array from ThingManager::GetStatesCbor
+    virtual void SendIotStatesCbor(const std::string& states);
     virtual void SendMcpMessage(const std::string& message);
     // Check if protocol has been inactive for specified seconds (for proactive timeout)
     bool IsInactiveFor(int seconds) const;
@@ -85,6 +116,8 @@ protected:
 
     int server_sample_rate_ = 24000;
     int server_frame_duration_ = 60;
+    bool server_dtx_ = true;
+    bool server_iot_cbor_ = false;
     bool error_occurred_ = false;
     std::string session_id_;
     std::chrono::time_point<std::chrono::steady_clock> last_incoming_time_;
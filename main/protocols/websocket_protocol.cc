@@ -7,8 +7,10 @@
 #include "ota.h"
 
 #include <cstring>
+#include <algorithm>
 #include <cJSON.h>
 #include <esp_log.h>
+#include <esp_timer.h>
 #include <arpa/inet.h>
 #include "assets/lang_config.h"
 
@@ -16,6 +18,19 @@
 
 WebsocketProtocol::WebsocketProtocol() {
     event_group_handle_ = xEventGroupCreate();
+
+    dispatcher_.On("hello", [this](const cJSON* root) {
+        ParseServerHello(root);
+    });
+    // Forwarded messages are counted by the application's dispatcher
+    dispatcher_.OnUnhandled([this](const cJSON* root) {
+        if (on_incoming_json_ == nullptr) {
+            ESP_LOGW(TAG, "on_incoming_json_ callback is null, cannot forward WebSocket message");
+            return false;
+        }
+        on_incoming_json_(root);
+        return true;
+    });
 }
 
 WebsocketProtocol::~WebsocketProtocol() {
@@ -30,16 +45,44 @@ bool WebsocketProtocol::Start() {
     return true;
 }
 
+// Tune the batch size every this many messages
+#define BATCH_TUNE_INTERVAL 8
+// Room for a full batch of typical frames; larger ones grow the buffer once
+#define SEND_BUFFER_RESERVE (sizeof(BinaryProtocol4) + WEBSOCKET_MAX_BATCH_FRAMES * (sizeof(BinaryProtocol4Frame) + 512))
+
 bool WebsocketProtocol::SendAudio(const AudioStreamPacket& packet) {
+    std::lock_guard<std::mutex> lock(send_mutex_);
     if (websocket_ == nullptr || !websocket_->IsConnected()) {
         ESP_LOGW(TAG, "Cannot send audio: websocket is null or not connected");
         return false;
     }
 
+    if (batch_max_frames_ > 1) {
+        size_t frame_size = sizeof(BinaryProtocol4Frame) + packet.payload.size();
+        if (batch_frames_ > 0 && send_buffer_.size() + frame_size - sizeof(BinaryProtocol4) > UINT16_MAX) {
+            if (!FlushBatch()) {
+                return false;
+            }
+        }
+        if (batch_frames_ == 0) {
+            send_buffer_.resize(sizeof(BinaryProtocol4));
+            batch_start_us_ = esp_timer_get_time();
+        }
+        BinaryProtocol4Frame frame;
+        frame.timestamp = htonl(packet.timestamp);
+        frame.size = htons(packet.payload.size());
+        send_buffer_.append((const char*)&frame, sizeof(frame));
+        send_buffer_.append((const char*)packet.payload.data(), packet.payload.size());
+        batch_frames_++;
+        if (batch_frames_ >= batch_target_) {
+            return FlushBatch();
+        }
+        return true;
+    }
+
     if (version_ == 2) {
-        std::string serialized;
-        serialized.resize(sizeof(BinaryProtocol2) + packet.payload.size());
-        auto bp2 = (BinaryProtocol2*)serialized.data();
+        send_buffer_.resize(sizeof(BinaryProtocol2) + packet.payload.size());
+        auto bp2 = (BinaryProtocol2*)send_buffer_.data();
         bp2->version = htons(version_);
         bp2->type = 0;
         bp2->reserved = 0;
@@ -47,7 +90,7 @@ bool WebsocketProtocol::SendAudio(const AudioStreamPacket& packet) {
         bp2->payload_size = htonl(packet.payload.size());
         memcpy(bp2->payload, packet.payload.data(), packet.payload.size());
 
-        return websocket_->Send(serialized.data(), serialized.size(), true);
+        return websocket_->Send(send_buffer_.data(), send_buffer_.size(), true);
     } else if (version_ == 3) {
         // Version 3: Send raw Opus frames as binary messages (no wrapper)
         // This matches the server's expectation for version 3
@@ -64,12 +107,92 @@ bool WebsocketProtocol::SendAudio(const AudioStreamPacket& packet) {
     }
 }
 
+bool WebsocketProtocol::FlushAudio() {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    if (batch_frames_ == 0 || websocket_ == nullptr) {
+        return true;
+    }
+    // Frames keep arriving every frame duration, so a batch only needs a
+    // push when the stream paused before it filled up
+    int64_t waited_us = esp_timer_get_time() - batch_start_us_;
+    if (waited_us < (int64_t)batch_target_ * OPUS_FRAME_DURATION_MS * 1000) {
+        return true;
+    }
+    return FlushBatch();
+}
+
+void WebsocketProtocol::ResetBatch() {
+    std::lock_guard<std::mutex> lock(send_mutex_);
+    batch_max_frames_ = 1;
+    batch_target_ = 1;
+    batch_frames_ = 0;
+    send_time_us_ = 0;
+    batch_tune_countdown_ = BATCH_TUNE_INTERVAL;
+    frames_sent_ = 0;
+    messages_sent_ = 0;
+    if (send_buffer_.capacity() < SEND_BUFFER_RESERVE) {
+        send_buffer_.reserve(SEND_BUFFER_RESERVE);
+    }
+}
+
+// Called with send_mutex_ held
+bool WebsocketProtocol::FlushBatch() {
+    if (batch_frames_ == 0) {
+        return true;
+    }
+    auto bp4 = (BinaryProtocol4*)send_buffer_.data();
+    bp4->type = 0;
+    bp4->frame_count = batch_frames_;
+    bp4->payload_size = htons(send_buffer_.size() - sizeof(BinaryProtocol4));
+    int frames = batch_frames_;
+    batch_frames_ = 0;
+
+    int64_t start_us = esp_timer_get_time();
+    if (!websocket_->Send(send_buffer_.data(), send_buffer_.size(), true)) {
+        return false;
+    }
+    frames_sent_ += frames;
+    messages_sent_++;
+    TuneBatch(esp_timer_get_time() - start_us);
+    return true;
+}
+
+// Pack more frames per message while a send takes a sizeable share of a
+// frame duration, and go back towards one frame per message once sends
+// are cheap again
+void WebsocketProtocol::TuneBatch(int64_t send_us) {
+    // EMA with alpha = 1/8
+    send_time_us_ += (send_us - send_time_us_) / 8;
+    if (--batch_tune_countdown_ > 0) {
+        return;
+    }
+    batch_tune_countdown_ = BATCH_TUNE_INTERVAL;
+
+    const int64_t frame_us = OPUS_FRAME_DURATION_MS * 1000;
+    int target = batch_target_;
+    if (send_time_us_ > frame_us / 4 && target < batch_max_frames_) {
+        target++;
+    } else if (send_time_us_ < frame_us / 16 && target > 1) {
+        target--;
+    }
+    if (target != batch_target_) {
+        ESP_LOGI(TAG, "Uplink batch %d -> %d frames (send time %lld us)", batch_target_, target, (long long)send_time_us_);
+        batch_target_ = target;
+    }
+}
+
 bool WebsocketProtocol::SendText(const std::string& text) {
+    std::unique_lock<std::mutex> lock(send_mutex_);
     if (websocket_ == nullptr) {
         ESP_LOGW(TAG, "SendText: WebSocket is null, cannot send");
         return false;
     }
 
+    // Audio queued before this message has to reach the server first
+    if (!FlushBatch()) {
+        ESP_LOGW(TAG, "SendText: Failed to flush batched audio");
+    }
+
     // Check if this is an MCP message for more detailed logging
     if (text.find("\"type\":\"mcp\"") != std::string::npos) {
         ESP_LOGI(TAG, "SendText: Sending MCP message, size=%zu bytes", text.length());
@@ -82,6 +205,8 @@ bool WebsocketProtocol::SendText(const std::string& text) {
 
     if (!websocket_->Send(text)) {
         ESP_LOGE(TAG, "Failed to send text: %s", text.c_str());
+        // The error handler may close the channel
+        lock.unlock();
         SetError(Lang::Strings::SERVER_ERROR);
         return false;
     }
@@ -97,10 +222,15 @@ bool WebsocketProtocol::IsAudioChannelOpened() const {
 }
 
 void WebsocketProtocol::CloseAudioChannel() {
+    std::lock_guard<std::mutex> lock(send_mutex_);
     if (websocket_ != nullptr) {
+        if (batch_max_frames_ > 1) {
+            ESP_LOGI(TAG, "Batched uplink: %lu frames in %lu messages", (unsigned long)frames_sent_, (unsigned long)messages_sent_);
+        }
         delete websocket_;
         websocket_ = nullptr;
     }
+    batch_frames_ = 0;
 }
 
 static bool IsValidWebSocketUrl(const std::string& url) {
@@ -206,6 +336,7 @@ bool WebsocketProtocol::OpenAudioChannel() {
 
     error_occurred_ = false;
     frame_count_ = 0;  // Reset frame counter for new session
+    ResetBatch();
     last_incoming_time_ = std::chrono::steady_clock::now();  // Initialize timestamp for inactivity checking
     websocket_ = Board::GetInstance().CreateWebSocket();
     websocket_->SetReceiveBufferSize(kWebSocketReceiveBufferSize);
@@ -234,61 +365,38 @@ bool WebsocketProtocol::OpenAudioChannel() {
                     bp2->type = ntohs(bp2->type);
                     bp2->timestamp = ntohl(bp2->timestamp);
                     bp2->payload_size = ntohl(bp2->payload_size);
-                    auto payload = (uint8_t*)bp2->payload;
-                    on_incoming_audio_(AudioStreamPacket{
-                        .sample_rate = server_sample_rate_,
-                        .frame_duration = server_frame_duration_,
-                        .timestamp = bp2->timestamp,
-                        .payload = std::vector<uint8_t>(payload, payload + bp2->payload_size)
-                    });
+                    AudioStreamPacket packet;
+                    packet.sample_rate = server_sample_rate_;
+                    packet.frame_duration = server_frame_duration_;
+                    packet.sequence = ++incoming_sequence_;  // TCP keeps frames in order
+                    packet.timestamp = bp2->timestamp;
+                    packet.payload.assign((uint8_t*)bp2->payload, bp2->payload_size);
+                    on_incoming_audio_(std::move(packet));
                 } else if (version_ == 3) {
                     // Version 3: Server sends raw Opus frames over WebSocket.
                     // No wrapper detection — previous heuristic could false-positive
                     // on random Opus byte patterns, corrupting ~0.1-0.5% of frames.
-                    on_incoming_audio_(AudioStreamPacket{
-                        .sample_rate = server_sample_rate_,
-                        .frame_duration = server_frame_duration_,
-                        .timestamp = 0,
-                        .payload = std::vector<uint8_t>((uint8_t*)data, (uint8_t*)data + len)
-                    });
+                    AudioStreamPacket packet;
+                    packet.sample_rate = server_sample_rate_;
+                    packet.frame_duration = server_frame_duration_;
+                    packet.sequence = ++incoming_sequence_;  // TCP keeps frames in order
+                    packet.payload.assign((const uint8_t*)data, len);
+                    on_incoming_audio_(std::move(packet));
                 } else {
-                    on_incoming_audio_(AudioStreamPacket{
-                        .sample_rate = server_sample_rate_,
-                        .frame_duration = server_frame_duration_,
-                        .timestamp = 0,
-                        .payload = std::vector<uint8_t>((uint8_t*)data, (uint8_t*)data + len)
-                    });
+                    AudioStreamPacket packet;
+                    packet.sample_rate = server_sample_rate_;
+                    packet.frame_duration = server_frame_duration_;
+                    packet.sequence = ++incoming_sequence_;  // TCP keeps frames in order
+                    packet.payload.assign((const uint8_t*)data, len);
+                    on_incoming_audio_(std::move(packet));
                 }
             }
         } else {
             // Parse JSON data
             ESP_LOGI(TAG, "WS RX text message len=%u data=%.*s", (unsigned)len, (int)std::min((int)len, 200), data);
-            auto root = cJSON_Parse(data);
-            if (root == nullptr) {
-                ESP_LOGE(TAG, "Failed to parse WebSocket JSON message: %.*s", (int)std::min((int)len, 200), data);
+            if (!dispatcher_.Dispatch(data, len)) {
                 return;
             }
-            auto type = cJSON_GetObjectItem(root, "type");
-            if (cJSON_IsString(type)) {
-                ESP_LOGI(TAG, "WS RX message type: %s", type->valuestring);
-                // Check if this is a listen message for immediate visibility
-                if (strcmp(type->valuestring, "listen") == 0) {
-                    ESP_LOGI(TAG, "*** LISTEN MESSAGE DETECTED IN WEBSOCKET ***");
-                }
-                if (strcmp(type->valuestring, "hello") == 0) {
-                    ParseServerHello(root);
-                } else {
-                    ESP_LOGI(TAG, "Forwarding WebSocket message type '%s' to Application::OnIncomingJson", type->valuestring);
-                    if (on_incoming_json_ != nullptr) {
-                        on_incoming_json_(root);
-                    } else {
-                        ESP_LOGW(TAG, "on_incoming_json_ callback is null, cannot forward WebSocket message type '%s'", type->valuestring);
-                    }
-                }
-            } else {
-                ESP_LOGE(TAG, "Missing message type in WebSocket message, data: %.*s", (int)std::min((int)len, 200), data);
-            }
-            cJSON_Delete(root);
         }
         last_incoming_time_ = std::chrono::steady_clock::now();
     });
@@ -345,6 +453,8 @@ std::string WebsocketProtocol::GetHelloMessage() {
 #if CONFIG_IOT_PROTOCOL_MCP
     cJSON_AddBoolToObject(features, "mcp", true);
 #endif
+    // Uplink may pack up to this many frames per message (BinaryProtocol4)
+    cJSON_AddNumberToObject(features, "audio_batch", WEBSOCKET_MAX_BATCH_FRAMES);
     cJSON_AddItemToObject(root, "features", features);
     cJSON_AddStringToObject(root, "transport", "websocket");
     cJSON* audio_params = cJSON_CreateObject();
@@ -352,6 +462,9 @@ std::string WebsocketProtocol::GetHelloMessage() {
     cJSON_AddNumberToObject(audio_params, "sample_rate", requested_sample_rate);
     cJSON_AddNumberToObject(audio_params, "channels", 1);
     cJSON_AddNumberToObject(audio_params, "frame_duration", OPUS_FRAME_DURATION_MS);
+    // Uplink frames may be DTX and carry in-band FEC on lossy links
+    cJSON_AddBoolToObject(audio_params, "dtx", true);
+    cJSON_AddBoolToObject(audio_params, "fec", true);
     cJSON_AddItemToObject(root, "audio_params", audio_params);
     auto json_str = cJSON_PrintUnformatted(root);
     std::string message(json_str);
@@ -373,6 +486,17 @@ void WebsocketProtocol::ParseServerHello(const cJSON* root) {
         ESP_LOGI(TAG, "Session ID: %s", session_id_.c_str());
     }
 
+    // Batching stays off unless the server answers with its own limit
+    auto features = cJSON_GetObjectItem(root, "features");
+    auto audio_batch = cJSON_IsObject(features) ? cJSON_GetObjectItem(features, "audio_batch") : nullptr;
+    if (cJSON_IsNumber(audio_batch) && audio_batch->valueint > 1) {
+        std::lock_guard<std::mutex> lock(send_mutex_);
+        batch_max_frames_ = std::min(audio_batch->valueint, WEBSOCKET_MAX_BATCH_FRAMES);
+        ESP_LOGI(TAG, "Uplink batching enabled, up to %d frames per message", batch_max_frames_);
+    }
+
+    // Servers that do not answer the dtx capability keep the old behaviour
+    server_dtx_ = true;
     auto audio_params = cJSON_GetObjectItem(root, "audio_params");
     if (cJSON_IsObject(audio_params)) {
         auto sample_rate = cJSON_GetObjectItem(audio_params, "sample_rate");
@@ -383,6 +507,10 @@ void WebsocketProtocol::ParseServerHello(const cJSON* root) {
         if (cJSON_IsNumber(frame_duration)) {
             server_frame_duration_ = frame_duration->valueint;
         }
+        auto dtx = cJSON_GetObjectItem(audio_params, "dtx");
+        if (cJSON_IsBool(dtx)) {
+            server_dtx_ = cJSON_IsTrue(dtx);
+        }
     }
 
     xEventGroupSetBits(event_group_handle_, WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT);
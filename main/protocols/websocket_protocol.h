@@ -3,13 +3,21 @@
 
 
 #include "protocol.h"
+#include "json_dispatcher.h"
 
 #include <web_socket.h>
 #include <freertos/FreeRTOS.h>
 #include <freertos/event_groups.h>
 
+#include <mutex>
+#include <string>
+
 #define WEBSOCKET_PROTOCOL_SERVER_HELLO_EVENT (1 << 0)
 
+// Most Opus frames packed into one BinaryProtocol4 message; each extra
+// frame adds one frame duration of uplink delay
+#define WEBSOCKET_MAX_BATCH_FRAMES 4
+
 class WebsocketProtocol : public Protocol {
 public:
     WebsocketProtocol();
@@ -17,6 +25,7 @@ public:
 
     bool Start() override;
     bool SendAudio(const AudioStreamPacket& packet) override;
+    bool FlushAudio() override;
     bool OpenAudioChannel() override;
     void CloseAudioChannel() override;
     bool IsAudioChannelOpened() const override;
@@ -26,7 +35,28 @@ private:
     WebSocket* websocket_ = nullptr;
     int version_ = 1;
     int frame_count_ = 0;  // Counter for Opus frames sent
+    uint32_t incoming_sequence_ = 0;  // Numbers received frames for the jitter buffer
+    JsonDispatcher dispatcher_;
+
+    // Serializes audio and text sends so a held-back batch always goes out
+    // before a later text message
+    std::mutex send_mutex_;
+    std::string send_buffer_;   // Reused for every binary message
+
+    // Uplink batching. The target follows the measured send time: slow
+    // sends mean per-message overhead dominates, so more frames are packed.
+    int batch_max_frames_ = 1;  // Agreed in hello; 1 disables batching
+    int batch_target_ = 1;
+    int batch_frames_ = 0;
+    int64_t batch_start_us_ = 0;
+    int64_t send_time_us_ = 0;  // Smoothed duration of one binary send
+    int batch_tune_countdown_ = 0;
+    uint32_t frames_sent_ = 0;
+    uint32_t messages_sent_ = 0;
 
+    void ResetBatch();
+    bool FlushBatch();
+    void TuneBatch(int64_t send_us);
     void ParseServerHello(const cJSON* root);
     bool SendText(const std::string& text) override;
     std::string GetHelloMessage();
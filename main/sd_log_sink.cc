@@ -0,0 +1,253 @@
+#include "sd_log_sink.h"
+#include "sd_card.h"
+
+#include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+#include <freertos/portmacro.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstring>
+
+// Nothing in this file may log from the producer path: ESP_LOG* would re-enter
+// the vprintf hook. The writer task may log; those lines are simply queued.
+#define TAG "SdLogSink"
+
+SdLogSink::SdLogSink() {
+    for (size_t i = 0; i < kSlotCount; i++) {
+        slots_[i].sequence.store((uint32_t)i, std::memory_order_relaxed);
+        slots_[i].length = 0;
+    }
+    file_mutex_ = xSemaphoreCreateMutex();
+}
+
+bool SdLogSink::Start(const char* path, size_t max_file_bytes, int max_rotated_files) {
+    if (running_.load(std::memory_order_acquire)) {
+        return true;
+    }
+    if (file_mutex_ == nullptr) {
+        return false;
+    }
+
+    xSemaphoreTake(file_mutex_, portMAX_DELAY);
+    strncpy(path_, path, sizeof(path_) - 1);
+    max_file_bytes_ = max_file_bytes;
+    max_rotated_files_ = max_rotated_files;
+    xSemaphoreGive(file_mutex_);
+
+    if (writer_task_ == nullptr) {
+        BaseType_t ok = xTaskCreate([](void* arg) {
+            ((SdLogSink*)arg)->WriterTask();
+        }, "sd_log_writer", 4096, this, 1, &writer_task_);
+        if (ok != pdPASS) {
+            writer_task_ = nullptr;
+            ESP_LOGE(TAG, "Failed to create writer task");
+            return false;
+        }
+        esp_register_shutdown_handler([]() {
+            SdLogSink::GetInstance().Flush();
+        });
+    }
+
+    running_.store(true, std::memory_order_release);
+    return true;
+}
+
+void SdLogSink::Stop() {
+    running_.store(false, std::memory_order_release);
+    Flush();
+    if (xSemaphoreTake(file_mutex_, pdMS_TO_TICKS(1000)) == pdTRUE) {
+        CloseFile();
+        xSemaphoreGive(file_mutex_);
+    }
+}
+
+bool SdLogSink::Enqueue(const char* line, size_t len) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    int64_t start_us = esp_timer_get_time();
+
+    if (len > kSlotSize) {
+        len = kSlotSize;
+        truncated_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Bounded MPMC queue (Vyukov): claim a slot by CAS on enqueue_pos_, fill it,
+    // then publish it by bumping its sequence number.
+    uint32_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    while (true) {
+        slot = &slots_[pos & (kSlotCount - 1)];
+        uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (diff == 0) {
+            if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        } else {
+            pos = enqueue_pos_.load(std::memory_order_relaxed);
+        }
+    }
+
+    memcpy(slot->data, line, len);
+    if (len == kSlotSize) {
+        slot->data[kSlotSize - 1] = '\n';
+    }
+    slot->length = (uint16_t)len;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+    enqueued_.fetch_add(1, std::memory_order_relaxed);
+
+    // Only wake the writer once the ring is half full; otherwise it picks the
+    // lines up on its idle timer, which keeps SD writes large and infrequent.
+    uint32_t depth = pos + 1 - dequeue_pos_.load(std::memory_order_relaxed);
+    if (depth >= kSlotCount / 2 && writer_task_ != nullptr) {
+        if (xPortInIsrContext()) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(writer_task_, &woken);
+            portYIELD_FROM_ISR(woken);
+        } else {
+            xTaskNotifyGive(writer_task_);
+        }
+    }
+
+    uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start_us);
+    uint32_t prev = max_enqueue_us_.load(std::memory_order_relaxed);
+    while (elapsed > prev && !max_enqueue_us_.compare_exchange_weak(prev, elapsed, std::memory_order_relaxed)) {
+    }
+    return true;
+}
+
+size_t SdLogSink::DrainToBatch() {
+    size_t drained = 0;
+    uint32_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+        Slot* slot = &slots_[pos & (kSlotCount - 1)];
+        uint32_t seq = slot->sequence.load(std::memory_order_acquire);
+        if ((int32_t)(seq - (pos + 1)) < 0) {
+            break;  // Empty, or the producer has not published yet
+        }
+        if (batch_len_ + slot->length > kBatchSize) {
+            WriteBatch();
+        }
+        memcpy(batch_ + batch_len_, slot->data, slot->length);
+        batch_len_ += slot->length;
+        drained += slot->length;
+        slot->sequence.store(pos + kSlotCount, std::memory_order_release);
+        pos++;
+        dequeue_pos_.store(pos, std::memory_order_relaxed);
+    }
+    return drained;
+}
+
+bool SdLogSink::OpenFile() {
+    if (file_ != nullptr) {
+        return true;
+    }
+    if (path_[0] == '\0' || !SdCard::IsMounted()) {
+        return false;
+    }
+    file_ = fopen(path_, "a");
+    if (file_ == nullptr) {
+        return false;
+    }
+    struct stat st;
+    file_size_ = stat(path_, &st) == 0 ? (size_t)st.st_size : 0;
+    return true;
+}
+
+void SdLogSink::CloseFile() {
+    if (file_ != nullptr) {
+        fclose(file_);
+        file_ = nullptr;
+    }
+}
+
+void SdLogSink::Rotate() {
+    CloseFile();
+
+    // "/sdcard/err.txt" -> "/sdcard/err.N.txt"
+    const char* dot = strrchr(path_, '.');
+    int base_len = dot ? (int)(dot - path_) : (int)strlen(path_);
+    const char* ext = dot ? dot : "";
+    char from[80];
+    char to[80];
+
+    snprintf(to, sizeof(to), "%.*s.%d%s", base_len, path_, max_rotated_files_, ext);
+    unlink(to);
+    for (int i = max_rotated_files_ - 1; i >= 1; i--) {
+        snprintf(from, sizeof(from), "%.*s.%d%s", base_len, path_, i, ext);
+        snprintf(to, sizeof(to), "%.*s.%d%s", base_len, path_, i + 1, ext);
+        rename(from, to);
+    }
+    snprintf(to, sizeof(to), "%.*s.1%s", base_len, path_, ext);
+    if (max_rotated_files_ > 0) {
+        rename(path_, to);
+    } else {
+        unlink(path_);
+    }
+    rotations_++;
+}
+
+void SdLogSink::WriteBatch() {
+    if (batch_len_ == 0) {
+        return;
+    }
+    if (!SdCard::IsMounted()) {
+        // Card went away; drop the batch rather than stall the ring.
+        CloseFile();
+        batch_len_ = 0;
+        return;
+    }
+    if (OpenFile()) {
+        size_t written = fwrite(batch_, 1, batch_len_, file_);
+        file_size_ += written;
+        bytes_written_ += written;
+        if (max_file_bytes_ > 0 && file_size_ >= max_file_bytes_) {
+            Rotate();
+        }
+    }
+    batch_len_ = 0;
+}
+
+void SdLogSink::Flush() {
+    if (file_mutex_ == nullptr || xSemaphoreTake(file_mutex_, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return;
+    }
+    DrainToBatch();
+    WriteBatch();
+    if (file_ != nullptr) {
+        fflush(file_);
+        fsync(fileno(file_));
+    }
+    xSemaphoreGive(file_mutex_);
+}
+
+void SdLogSink::WriterTask() {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(kIdleFlushMs));
+
+        xSemaphoreTake(file_mutex_, portMAX_DELAY);
+        if (DrainToBatch() > 0 || batch_len_ > 0) {
+            WriteBatch();
+            if (file_ != nullptr) {
+                fflush(file_);
+            }
+        }
+        xSemaphoreGive(file_mutex_);
+    }
+}
+
+SdLogSink::Stats SdLogSink::GetStats() const {
+    Stats stats;
+    stats.enqueued = enqueued_.load(std::memory_order_relaxed);
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.truncated = truncated_.load(std::memory_order_relaxed);
+    stats.bytes_written = bytes_written_.load(std::memory_order_relaxed);
+    stats.rotations = rotations_.load(std::memory_order_relaxed);
+    stats.max_enqueue_us = max_enqueue_us_.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,117 @@
+#ifndef SD_LOG_SINK_H
+#define SD_LOG_SINK_H
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+/**
+ * @brief Asynchronous, batched log writer for the SD card
+ *
+ * Producers (the esp_log vprintf hook, from any task) only copy a formatted
+ * line into a fixed lock-free multi-producer ring and return. A low-priority
+ * writer task drains the ring into a file that stays open, in large batched
+ * writes, and rotates it by size (err.txt -> err.1.txt -> err.2.txt ...).
+ * When the ring is full, new lines are dropped and counted rather than
+ * blocking the logging task.
+ */
+class SdLogSink {
+public:
+    struct Stats {
+        uint32_t enqueued;
+        uint32_t dropped;       // Ring full
+        uint32_t truncated;     // Line longer than a slot
+        uint32_t bytes_written;
+        uint32_t rotations;
+        uint32_t max_enqueue_us;
+    };
+
+    static SdLogSink& GetInstance() {
+        static SdLogSink instance;
+        return instance;
+    }
+
+    SdLogSink(const SdLogSink&) = delete;
+    SdLogSink& operator=(const SdLogSink&) = delete;
+
+    /**
+     * @brief Start accepting lines and writing them to path
+     *
+     * The writer task is created on the first call.
+     */
+    bool Start(const char* path, size_t max_file_bytes, int max_rotated_files);
+
+    /**
+     * @brief Stop accepting lines, flush what is queued and close the file
+     */
+    void Stop();
+
+    bool IsRunning() const { return running_.load(std::memory_order_acquire); }
+
+    /**
+     * @brief Copy one log line into the ring; never blocks
+     * @return false if the line was dropped
+     */
+    bool Enqueue(const char* line, size_t len);
+
+    /**
+     * @brief Drain the ring and fflush+fsync the file from the calling task
+     *
+     * Registered as a shutdown handler so lines queued right before
+     * esp_restart() still reach the card.
+     */
+    void Flush();
+
+    Stats GetStats() const;
+
+private:
+    static constexpr size_t kSlotCount = 32;        // Must be a power of two
+    static constexpr size_t kSlotSize = 256;
+    static constexpr size_t kBatchSize = 4096;
+    static constexpr uint32_t kIdleFlushMs = 1000;
+
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        uint16_t length;
+        char data[kSlotSize];
+    };
+
+    SdLogSink();
+    ~SdLogSink() = default;
+
+    Slot slots_[kSlotCount];
+    std::atomic<uint32_t> enqueue_pos_{0};
+    std::atomic<uint32_t> dequeue_pos_{0};  // Advanced by the consumer only
+
+    std::atomic<bool> running_{false};
+    TaskHandle_t writer_task_ = nullptr;
+    SemaphoreHandle_t file_mutex_ = nullptr; // Writer task vs. Flush()/Stop()
+    FILE* file_ = nullptr;
+    size_t file_size_ = 0;
+    char path_[64] = {0};
+    size_t max_file_bytes_ = 0;
+    int max_rotated_files_ = 0;
+    char batch_[kBatchSize];
+    size_t batch_len_ = 0;
+
+    std::atomic<uint32_t> enqueued_{0};
+    std::atomic<uint32_t> dropped_{0};
+    std::atomic<uint32_t> truncated_{0};
+    std::atomic<uint32_t> max_enqueue_us_{0};
+    std::atomic<uint32_t> bytes_written_{0};
+    std::atomic<uint32_t> rotations_{0};
+
+    void WriterTask();
+    size_t DrainToBatch();
+    void WriteBatch();
+    bool OpenFile();
+    void CloseFile();
+    void Rotate();
+};
+
+#endif // SD_LOG_SINK_H
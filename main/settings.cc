@@ -1,124 +1,363 @@
 #include "settings.h"
 
 #include <esp_log.h>
+#include <esp_system.h>
+#include <esp_timer.h>
 #include <nvs_flash.h>
 
+#include <algorithm>
+#include <vector>
+
 #define TAG "Settings"
 
-Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
-    esp_err_t err = nvs_open(ns.c_str(), read_write_ ? NVS_READWRITE : NVS_READONLY, &nvs_handle_);
-    if (err != ESP_OK) {
-        if (err == ESP_ERR_NVS_NOT_FOUND) {
-            ESP_LOGW(TAG, "NVS namespace '%s' not found (will use defaults)", ns.c_str());
+SettingsStore::Namespace& SettingsStore::GetNamespace(const std::string& ns) {
+    auto& space = namespaces_[ns];
+    if (!space.opened) {
+        space.opened = true;
+        esp_err_t err = nvs_open(ns.c_str(), NVS_READONLY, &space.handle);
+        if (err != ESP_OK) {
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                ESP_LOGW(TAG, "NVS namespace '%s' not found (will use defaults)", ns.c_str());
+            } else {
+                ESP_LOGE(TAG, "Failed to open NVS namespace '%s': %s", ns.c_str(), esp_err_to_name(err));
+            }
+            space.handle = 0;
+        }
+    }
+    return space;
+}
+
+SettingsStore::Entry& SettingsStore::Load(const std::string& ns, const std::string& key, EntryType type) {
+    auto& space = GetNamespace(ns);
+    auto [it, inserted] = space.entries.try_emplace(key);
+    Entry& entry = it->second;
+    if (!inserted || space.handle == 0 || space.fully_cached) {
+        return entry;
+    }
+
+    // First read of this key: probe the requested type first, then the other
+    stats_.nvs_reads++;
+    for (int i = 0; i < 2 && entry.type == kEntryMissing; i++) {
+        EntryType probe = (i == 0) ? type : (type == kEntryString ? kEntryInt : kEntryString);
+        if (probe == kEntryInt) {
+            if (nvs_get_i32(space.handle, key.c_str(), &entry.int_value) == ESP_OK) {
+                entry.type = kEntryInt;
+            }
+            continue;
+        }
+        size_t length = 0;
+        if (nvs_get_str(space.handle, key.c_str(), nullptr, &length) != ESP_OK) {
+            continue;
+        }
+        entry.string_value.resize(length);
+        if (nvs_get_str(space.handle, key.c_str(), entry.string_value.data(), &length) == ESP_OK) {
+            while (!entry.string_value.empty() && entry.string_value.back() == '\0') {
+                entry.string_value.pop_back();
+            }
+            entry.type = kEntryString;
         } else {
-            ESP_LOGE(TAG, "Failed to open NVS namespace '%s': %s", ns.c_str(), esp_err_to_name(err));
+            entry.string_value.clear();
         }
-        nvs_handle_ = 0;
     }
+    return entry;
 }
 
-Settings::~Settings() {
-    if (nvs_handle_ != 0) {
-        if (read_write_ && dirty_) {
-            ESP_ERROR_CHECK(nvs_commit(nvs_handle_));
+bool SettingsStore::GetString(const std::string& ns, const std::string& key, std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.reads++;
+    auto& entry = Load(ns, key, kEntryString);
+    if (entry.type != kEntryString) {
+        return false;
+    }
+    value = entry.string_value;
+    return true;
+}
+
+bool SettingsStore::GetInt(const std::string& ns, const std::string& key, int32_t& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.reads++;
+    auto& entry = Load(ns, key, kEntryInt);
+    if (entry.type != kEntryInt) {
+        return false;
+    }
+    value = entry.int_value;
+    return true;
+}
+
+void SettingsStore::MarkDirty(Entry& entry) {
+    stats_.writes++;
+    if (entry.sequence == 0) {
+        pending_++;
+    }
+    entry.sequence = ++sequence_;
+    ScheduleFlush();
+}
+
+void SettingsStore::ScheduleFlush() {
+    if (flusher_task_ == nullptr) {
+        // Pending writes must not be lost to a reboot
+        esp_register_shutdown_handler([]() {
+            SettingsStore::GetInstance().Flush();
+        });
+        xTaskCreate([](void* arg) {
+            ((SettingsStore*)arg)->FlusherLoop();
+        }, "settings", SETTINGS_FLUSHER_STACK_SIZE, this, 1, &flusher_task_);
+    }
+    if (flusher_task_ != nullptr) {
+        xTaskNotifyGive(flusher_task_);
+    }
+}
+
+void SettingsStore::SetString(const std::string& ns, const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = GetNamespace(ns).entries[key];
+    if (entry.type == kEntryString && entry.string_value == value) {
+        // Already in flash, or already on its way
+        return;
+    }
+    entry.type = kEntryString;
+    entry.string_value = value;
+    MarkDirty(entry);
+}
+
+void SettingsStore::SetInt(const std::string& ns, const std::string& key, int32_t value) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = GetNamespace(ns).entries[key];
+    if (entry.type == kEntryInt && entry.int_value == value) {
+        return;
+    }
+    entry.type = kEntryInt;
+    entry.int_value = value;
+    entry.string_value.clear();
+    MarkDirty(entry);
+}
+
+void SettingsStore::EraseKey(const std::string& ns, const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& entry = GetNamespace(ns).entries[key];
+    entry.type = kEntryMissing;
+    entry.string_value.clear();
+    MarkDirty(entry);
+}
+
+void SettingsStore::EraseAll(const std::string& ns) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto& space = GetNamespace(ns);
+    // Changes made before the erase are superseded by it
+    for (auto& [key, entry] : space.entries) {
+        if (entry.sequence != 0) {
+            pending_--;
         }
-        nvs_close(nvs_handle_);
     }
+    space.entries.clear();
+    space.fully_cached = true;
+    if (space.erase_all_sequence == 0) {
+        pending_++;
+    }
+    space.erase_all_sequence = ++sequence_;
+    stats_.writes++;
+    ScheduleFlush();
 }
 
-std::string Settings::GetString(const std::string& key, const std::string& default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
+void SettingsStore::FlusherLoop() {
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // Everything written during the delay goes out in the same flush
+        vTaskDelay(pdMS_TO_TICKS(SETTINGS_FLUSH_DELAY_MS));
+        Flush();
     }
+}
 
-    size_t length = 0;
-    if (nvs_get_str(nvs_handle_, key.c_str(), nullptr, &length) != ESP_OK) {
-        return default_value;
+void SettingsStore::Flush() {
+    struct Operation {
+        uint32_t sequence;
+        std::string ns;
+        std::string key;        // Empty for an erase-all
+        EntryType type;
+        std::string string_value;
+        int32_t int_value;
+        bool failed;
+    };
+
+    std::lock_guard<std::mutex> flush_lock(flush_mutex_);
+    std::vector<Operation> operations;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (pending_ == 0) {
+            return;
+        }
+        for (auto& [ns, space] : namespaces_) {
+            if (space.erase_all_sequence != 0) {
+                operations.push_back({space.erase_all_sequence, ns, std::string(), kEntryMissing, std::string(), 0, false});
+                space.erase_all_sequence = 0;
+            }
+            for (auto& [key, entry] : space.entries) {
+                if (entry.sequence != 0) {
+                    operations.push_back({entry.sequence, ns, key, entry.type, entry.string_value, entry.int_value, false});
+                    entry.sequence = 0;
+                }
+            }
+        }
+        pending_ = 0;
+        stats_.flushes++;
+        stats_.nvs_writes += operations.size();
+    }
+
+    // Replay in the order the changes were made
+    int64_t start_us = esp_timer_get_time();
+    std::sort(operations.begin(), operations.end(), [](const Operation& a, const Operation& b) {
+        return a.sequence < b.sequence;
+    });
+    std::map<std::string, nvs_handle_t> handles;
+    std::map<std::string, bool> erase_failed;     // Later writes would be wiped by the retried erase
+    for (auto& operation : operations) {
+        auto it = handles.find(operation.ns);
+        if (it == handles.end()) {
+            nvs_handle_t handle = 0;
+            esp_err_t err = nvs_open(operation.ns.c_str(), NVS_READWRITE, &handle);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to open NVS namespace '%s': %s", operation.ns.c_str(), esp_err_to_name(err));
+                handle = 0;
+            }
+            it = handles.emplace(operation.ns, handle).first;
+        }
+        if (it->second == 0 || erase_failed[operation.ns]) {
+            operation.failed = true;
+            continue;
+        }
+
+        esp_err_t err;
+        if (operation.key.empty()) {
+            err = nvs_erase_all(it->second);
+        } else if (operation.type == kEntryString) {
+            err = nvs_set_str(it->second, operation.key.c_str(), operation.string_value.c_str());
+        } else if (operation.type == kEntryInt) {
+            err = nvs_set_i32(it->second, operation.key.c_str(), operation.int_value);
+        } else {
+            err = nvs_erase_key(it->second, operation.key.c_str());
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                err = ESP_OK;
+            }
+        }
+        if (err != ESP_OK) {
+            if (operation.key.empty()) {
+                ESP_LOGE(TAG, "Failed to erase namespace '%s': %s", operation.ns.c_str(), esp_err_to_name(err));
+            } else {
+                ESP_LOGE(TAG, "Failed to write '%s' in namespace '%s': %s", operation.key.c_str(),
+                         operation.ns.c_str(), esp_err_to_name(err));
+            }
+            operation.failed = true;
+            if (operation.key.empty()) {
+                erase_failed[operation.ns] = true;
+            }
+        }
+    }
+    for (auto& [ns, handle] : handles) {
+        if (handle != 0) {
+            esp_err_t err = nvs_commit(handle);
+            if (err != ESP_OK) {
+                ESP_LOGE(TAG, "Failed to commit namespace '%s': %s", ns.c_str(), esp_err_to_name(err));
+                for (auto& operation : operations) {
+                    if (operation.ns == ns) {
+                        operation.failed = true;
+                    }
+                }
+            }
+            nvs_close(handle);
+        }
     }
 
+    // Failed changes become pending again under their old sequence, so the
+    // replay order holds, unless a newer change has superseded them
+    uint32_t failed = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& operation : operations) {
+            if (!operation.failed) {
+                continue;
+            }
+            failed++;
+            auto& space = namespaces_[operation.ns];
+            if (operation.key.empty()) {
+                if (space.erase_all_sequence == 0) {
+                    space.erase_all_sequence = operation.sequence;
+                    pending_++;
+                }
+                continue;
+            }
+            if (space.erase_all_sequence > operation.sequence) {
+                continue;
+            }
+            auto it = space.entries.find(operation.key);
+            if (it != space.entries.end() && it->second.sequence == 0) {
+                it->second.sequence = operation.sequence;
+                pending_++;
+            }
+        }
+        stats_.nvs_writes -= failed;
+        stats_.failed_writes += failed;
+        if (failed > 0) {
+            ScheduleFlush();
+        }
+    }
+    ESP_LOGI(TAG, "Flushed %u changes in %u namespaces in %lld us, %u failed", (unsigned)(operations.size() - failed),
+             (unsigned)handles.size(), (long long)(esp_timer_get_time() - start_us), (unsigned)failed);
+}
+
+SettingsStore::Stats SettingsStore::GetStats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+Settings::Settings(const std::string& ns, bool read_write) : ns_(ns), read_write_(read_write) {
+}
+
+Settings::~Settings() {
+}
+
+std::string Settings::GetString(const std::string& key, const std::string& default_value) {
     std::string value;
-    value.resize(length);
-    ESP_ERROR_CHECK(nvs_get_str(nvs_handle_, key.c_str(), value.data(), &length));
-    while (!value.empty() && value.back() == '\0') {
-        value.pop_back();
+    if (!SettingsStore::GetInstance().GetString(ns_, key, value)) {
+        return default_value;
     }
     return value;
 }
 
 void Settings::SetString(const std::string& key, const std::string& value) {
-    if (nvs_handle_ == 0) {
-        ESP_LOGE(TAG, "NVS handle is invalid, cannot set string for key '%s'", key.c_str());
-        return;
-    }
-    
     if (read_write_) {
-        esp_err_t err = nvs_set_str(nvs_handle_, key.c_str(), value.c_str());
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to set string for key '%s': %s", key.c_str(), esp_err_to_name(err));
-            return;
-        }
-        dirty_ = true;
+        SettingsStore::GetInstance().SetString(ns_, key, value);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
 int32_t Settings::GetInt(const std::string& key, int32_t default_value) {
-    if (nvs_handle_ == 0) {
-        return default_value;
-    }
-
     int32_t value;
-    if (nvs_get_i32(nvs_handle_, key.c_str(), &value) != ESP_OK) {
+    if (!SettingsStore::GetInstance().GetInt(ns_, key, value)) {
         return default_value;
     }
     return value;
 }
 
 void Settings::SetInt(const std::string& key, int32_t value) {
-    if (nvs_handle_ == 0) {
-        ESP_LOGE(TAG, "NVS handle is invalid, cannot set int for key '%s'", key.c_str());
-        return;
-    }
-    
     if (read_write_) {
-        esp_err_t err = nvs_set_i32(nvs_handle_, key.c_str(), value);
-        if (err != ESP_OK) {
-            ESP_LOGE(TAG, "Failed to set int for key '%s': %s", key.c_str(), esp_err_to_name(err));
-            return;
-        }
-        dirty_ = true;
+        SettingsStore::GetInstance().SetInt(ns_, key, value);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
 void Settings::EraseKey(const std::string& key) {
-    if (nvs_handle_ == 0) {
-        ESP_LOGE(TAG, "NVS handle is invalid, cannot erase key '%s'", key.c_str());
-        return;
-    }
-
     if (read_write_) {
-        auto ret = nvs_erase_key(nvs_handle_, key.c_str());
-        if (ret != ESP_ERR_NVS_NOT_FOUND) {
-            ESP_ERROR_CHECK(ret);
-        }
-        dirty_ = true;
+        SettingsStore::GetInstance().EraseKey(ns_, key);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
 }
 
 void Settings::EraseAll() {
-    if (nvs_handle_ == 0) {
-        ESP_LOGE(TAG, "NVS handle is invalid, cannot erase namespace '%s'", ns_.c_str());
-        return;
-    }
-
     if (read_write_) {
-        ESP_ERROR_CHECK(nvs_erase_all(nvs_handle_));
-        dirty_ = true;
+        SettingsStore::GetInstance().EraseAll(ns_);
     } else {
         ESP_LOGW(TAG, "Namespace %s is not open for writing", ns_.c_str());
     }
@@ -1,9 +1,98 @@
 #ifndef SETTINGS_H
 #define SETTINGS_H
 
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
 #include <string>
 #include <nvs_flash.h>
 
+// Upper bound between a Set*/Erase* call and its NVS commit
+#define SETTINGS_FLUSH_DELAY_MS 2000
+#define SETTINGS_FLUSHER_STACK_SIZE 4096
+
+/**
+ * @brief Process-wide RAM cache in front of NVS
+ *
+ * Each key is read from NVS once, then served from the cache (misses are
+ * cached too). Writes update the cache immediately and are written back by
+ * a flusher task at most SETTINGS_FLUSH_DELAY_MS later, so bursts of writes
+ * to the same key cost a single flash write. Pending writes reach NVS in the
+ * order they were made, with an EraseAll applied before anything written
+ * after it, and are also flushed from esp_restart().
+ */
+class SettingsStore {
+public:
+    struct Stats {
+        uint32_t reads;
+        uint32_t nvs_reads;     // Reads that missed the cache
+        uint32_t writes;
+        uint32_t nvs_writes;    // Writes that reached flash after coalescing
+        uint32_t failed_writes; // Left pending for the next flush
+        uint32_t flushes;
+    };
+
+    static SettingsStore& GetInstance() {
+        static SettingsStore instance;
+        return instance;
+    }
+    SettingsStore(const SettingsStore&) = delete;
+    SettingsStore& operator=(const SettingsStore&) = delete;
+
+    bool GetString(const std::string& ns, const std::string& key, std::string& value);
+    bool GetInt(const std::string& ns, const std::string& key, int32_t& value);
+    void SetString(const std::string& ns, const std::string& key, const std::string& value);
+    void SetInt(const std::string& ns, const std::string& key, int32_t value);
+    void EraseKey(const std::string& ns, const std::string& key);
+    void EraseAll(const std::string& ns);
+
+    // Write every pending change to NVS now
+    void Flush();
+    Stats GetStats();
+
+private:
+    enum EntryType {
+        kEntryMissing,
+        kEntryString,
+        kEntryInt,
+    };
+
+    struct Entry {
+        EntryType type = kEntryMissing;
+        std::string string_value;
+        int32_t int_value = 0;
+        uint32_t sequence = 0;  // Order of the last change; 0 when clean
+    };
+
+    struct Namespace {
+        nvs_handle_t handle = 0;        // Read-only, 0 if the namespace does not exist yet
+        bool opened = false;
+        bool fully_cached = false;      // Set by EraseAll; keys not in entries are missing
+        uint32_t erase_all_sequence = 0;    // Pending EraseAll, 0 when none
+        std::map<std::string, Entry> entries;
+    };
+
+    std::mutex mutex_;
+    std::mutex flush_mutex_;    // Serialises Flush() between the flusher and esp_restart()
+    std::map<std::string, Namespace> namespaces_;
+    uint32_t sequence_ = 0;
+    uint32_t pending_ = 0;
+    Stats stats_ = {};
+    TaskHandle_t flusher_task_ = nullptr;
+
+    SettingsStore() = default;
+    ~SettingsStore() = default;
+
+    Namespace& GetNamespace(const std::string& ns);
+    Entry& Load(const std::string& ns, const std::string& key, EntryType type);
+    void MarkDirty(Entry& entry);
+    void ScheduleFlush();
+    void FlusherLoop();
+};
+
 class Settings {
 public:
     Settings(const std::string& ns, bool read_write = false);
@@ -18,9 +107,7 @@ public:
 
 private:
     std::string ns_;
-    nvs_handle_t nvs_handle_ = 0;
     bool read_write_ = false;
-    bool dirty_ = false;
 };
 
 #endif
@@ -1,4 +1,5 @@
 #include "system_info.h"
+#include "latency_histogram.h"
 
 #include <freertos/task.h>
 #include <esp_log.h>
@@ -8,12 +9,29 @@
 #include <esp_partition.h>
 #include <esp_app_desc.h>
 #include <esp_ota_ops.h>
+
+#include <mutex>
 #if CONFIG_IDF_TARGET_ESP32P4
 #include "esp_wifi_remote.h"
 #endif
 
 #define TAG "SystemInfo"
 
+#define MAX_LATENCY_HISTOGRAMS 24
+
+namespace {
+
+struct NamedHistogram {
+    const char* name;
+    LatencyHistogram* histogram;
+};
+
+std::mutex latency_histograms_mutex;
+NamedHistogram latency_histograms[MAX_LATENCY_HISTOGRAMS];
+int latency_histogram_count = 0;
+
+} // namespace
+
 size_t SystemInfo::GetFlashSize() {
     uint32_t flash_size;
     if (esp_flash_get_size(NULL, &flash_size) != ESP_OK) {
@@ -143,3 +161,35 @@ void SystemInfo::PrintHeapStats() {
     int min_free_sram = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
     ESP_LOGI(TAG, "free sram: %u minimal sram: %u", free_sram, min_free_sram);
 }
+
+void SystemInfo::RegisterLatencyHistogram(const char* name, LatencyHistogram* histogram) {
+    std::lock_guard<std::mutex> lock(latency_histograms_mutex);
+    if (latency_histogram_count >= MAX_LATENCY_HISTOGRAMS) {
+        ESP_LOGE(TAG, "Too many latency histograms, %s not registered", name);
+        return;
+    }
+    latency_histograms[latency_histogram_count++] = {name, histogram};
+}
+
+void SystemInfo::UnregisterLatencyHistogram(LatencyHistogram* histogram) {
+    std::lock_guard<std::mutex> lock(latency_histograms_mutex);
+    for (int i = 0; i < latency_histogram_count; i++) {
+        if (latency_histograms[i].histogram == histogram) {
+            latency_histograms[i] = latency_histograms[--latency_histogram_count];
+            return;
+        }
+    }
+}
+
+void SystemInfo::PrintLatencyHistograms() {
+    std::lock_guard<std::mutex> lock(latency_histograms_mutex);
+    char buffer[128];
+    for (int i = 0; i < latency_histogram_count; i++) {
+        auto& entry = latency_histograms[i];
+        if (entry.histogram->count() == 0) {
+            continue;
+        }
+        entry.histogram->Format(buffer, sizeof(buffer));
+        ESP_LOGI(TAG, "latency %s: %s", entry.name, buffer);
+    }
+}
@@ -6,6 +6,8 @@
 #include <esp_err.h>
 #include <freertos/FreeRTOS.h>
 
+class LatencyHistogram;
+
 class SystemInfo {
 public:
     static size_t GetFlashSize();
@@ -16,6 +18,13 @@ public:
     static esp_err_t PrintTaskCpuUsage(TickType_t xTicksToWait);
     static void PrintTaskList();
     static void PrintHeapStats();
+
+    // Named latency histograms printed by PrintLatencyHistograms(); a
+    // histogram that does not live for the whole program must be
+    // unregistered before it is destroyed
+    static void RegisterLatencyHistogram(const char* name, LatencyHistogram* histogram);
+    static void UnregisterLatencyHistogram(LatencyHistogram* histogram);
+    static void PrintLatencyHistograms();
 };
 
 #endif // _SYSTEM_INFO_H_
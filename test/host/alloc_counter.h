@@ -0,0 +1,31 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Counts operator new calls; include from exactly one file of a test, since
+// it replaces the global allocation functions
+inline std::atomic<unsigned long> allocation_count{0};
+
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// GCC pairs the inlined new with free() and warns, but both sides use malloc
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+#endif // ALLOC_COUNTER_H
@@ -0,0 +1,36 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <cstdio>
+
+// Minimal checks for the host tests; a failed check is reported and the
+// test keeps going, main() returns HostTestResult()
+inline int host_test_failures = 0;
+
+#define CHECK(condition) do { \
+        if (!(condition)) { \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            host_test_failures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) do { \
+        long long actual_value = (long long)(actual); \
+        long long expected_value = (long long)(expected); \
+        if (actual_value != expected_value) { \
+            fprintf(stderr, "%s:%d: CHECK_EQ failed: %s == %lld, expected %s == %lld\n", __FILE__, __LINE__, \
+                    #actual, actual_value, #expected, expected_value); \
+            host_test_failures++; \
+        } \
+    } while (0)
+
+inline int HostTestResult(const char* name) {
+    if (host_test_failures > 0) {
+        printf("%s: %d check(s) FAILED\n", name, host_test_failures);
+        return 1;
+    }
+    printf("%s: passed\n", name);
+    return 0;
+}
+
+#endif // HOST_TEST_H
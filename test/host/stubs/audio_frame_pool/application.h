@@ -0,0 +1,11 @@
+// Stand-in for main/application.h next to the host copy of
+// audio_frame_pool.cc, which only needs the queue and frame sizes
+#ifndef _APPLICATION_H_
+#define _APPLICATION_H_
+
+#include "jitter_buffer.h"
+
+#define OPUS_FRAME_DURATION_MS 60
+#define MAX_AUDIO_PACKETS_IN_QUEUE (2400 / OPUS_FRAME_DURATION_MS)
+
+#endif
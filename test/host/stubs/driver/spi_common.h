@@ -0,0 +1,11 @@
+#ifndef HOST_DRIVER_SPI_COMMON_H
+#define HOST_DRIVER_SPI_COMMON_H
+
+// Types named by headers under test; no SPI driver exists on the host
+typedef enum {
+    SPI1_HOST = 0,
+    SPI2_HOST = 1,
+    SPI3_HOST = 2,
+} spi_host_device_t;
+
+#endif // HOST_DRIVER_SPI_COMMON_H
@@ -0,0 +1,26 @@
+#ifndef HOST_ESP_LOG_H
+#define HOST_ESP_LOG_H
+
+#include <stdio.h>
+
+// Errors and warnings go to stderr; info and debug are compiled (so format
+// strings are still checked) but only printed when HOST_LOG_VERBOSE is set.
+#ifdef HOST_LOG_VERBOSE
+#define HOST_LOG_INFO_ENABLED 1
+#else
+#define HOST_LOG_INFO_ENABLED 0
+#endif
+
+#define HOST_LOG(enabled, letter, tag, format, ...) do { \
+        if (enabled) { \
+            fprintf(stderr, letter " (%s) " format "\n", tag, ##__VA_ARGS__); \
+        } \
+    } while (0)
+
+#define ESP_LOGE(tag, format, ...) HOST_LOG(1, "E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) HOST_LOG(1, "W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) HOST_LOG(HOST_LOG_INFO_ENABLED, "I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) HOST_LOG(0, "D", tag, format, ##__VA_ARGS__)
+#define ESP_LOGV(tag, format, ...) HOST_LOG(0, "V", tag, format, ##__VA_ARGS__)
+
+#endif // HOST_ESP_LOG_H
@@ -0,0 +1,20 @@
+#ifndef HOST_ESP_SYSTEM_H
+#define HOST_ESP_SYSTEM_H
+
+#include "esp_err.h"
+
+typedef void (*shutdown_handler_t)(void);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Handlers are kept but only run by esp_restart(), which then exits
+esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler);
+void esp_restart(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_ESP_SYSTEM_H
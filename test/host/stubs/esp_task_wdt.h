@@ -0,0 +1,4 @@
+#ifndef HOST_ESP_TASK_WDT_H
+#define HOST_ESP_TASK_WDT_H
+
+#endif // HOST_ESP_TASK_WDT_H
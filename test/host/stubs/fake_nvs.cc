@@ -0,0 +1,327 @@
+#include "fake_nvs.h"
+
+#include <nvs_flash.h>
+
+#include <cstring>
+#include <map>
+#include <mutex>
+
+namespace {
+
+struct Value {
+    enum Type { kString, kInt, kBlob } type;
+    std::string bytes;      // String and blob values
+    int32_t int_value;
+};
+
+using Namespace = std::map<std::string, Value>;
+
+// A change staged on a handle, applied on commit
+struct Change {
+    fake_nvs::Operation operation;
+    std::string key;
+    Value value;
+};
+
+struct Handle {
+    std::string ns;
+    bool writable;
+    std::vector<Change> changes;
+};
+
+struct Failure {
+    fake_nvs::Operation operation;
+    std::string ns;
+    std::string key;
+    esp_err_t error;
+};
+
+std::mutex mutex;
+std::map<std::string, Namespace> flash;
+std::map<nvs_handle_t, Handle> handles;
+nvs_handle_t next_handle = 1;
+std::vector<std::string> log;
+std::vector<Failure> failures;
+fake_nvs::Counters counters = {};
+
+// Called with mutex held; consumes a matching injected failure
+esp_err_t InjectedError(fake_nvs::Operation operation, const std::string& ns, const std::string& key) {
+    for (auto it = failures.begin(); it != failures.end(); ++it) {
+        if (it->operation == operation && it->ns == ns && (it->key.empty() || it->key == key)) {
+            esp_err_t error = it->error;
+            failures.erase(it);
+            return error;
+        }
+    }
+    return ESP_OK;
+}
+
+// Reads see the flash contents plus the changes staged on the same handle
+const Value* Find(const Handle& handle, const std::string& key) {
+    const Value* found = nullptr;
+    auto space = flash.find(handle.ns);
+    if (space != flash.end()) {
+        auto it = space->second.find(key);
+        if (it != space->second.end()) {
+            found = &it->second;
+        }
+    }
+    for (const auto& change : handle.changes) {
+        if (change.operation == fake_nvs::kEraseAll) {
+            found = nullptr;
+        } else if (change.key == key) {
+            found = change.operation == fake_nvs::kSet ? &change.value : nullptr;
+        }
+    }
+    return found;
+}
+
+// Logged as "<verb> <ns><suffix>"
+esp_err_t Stage(nvs_handle_t handle, fake_nvs::Operation operation, const char* key, Value value,
+                const std::string& suffix) {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.writes++;
+    auto it = handles.find(handle);
+    if (it == handles.end()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (!it->second.writable) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    std::string key_string = key != nullptr ? key : "";
+    esp_err_t err = InjectedError(operation, it->second.ns, key_string);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (operation == fake_nvs::kEraseKey && Find(it->second, key_string) == nullptr) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    it->second.changes.push_back({operation, key_string, std::move(value)});
+    const char* verb = operation == fake_nvs::kSet ? "set " : (operation == fake_nvs::kEraseKey ? "erase " : "erase_all ");
+    log.push_back(verb + it->second.ns + suffix);
+    return ESP_OK;
+}
+
+template <typename T>
+esp_err_t GetScalar(nvs_handle_t handle, const char* key, T* out_value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.reads++;
+    auto it = handles.find(handle);
+    if (it == handles.end()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const Value* value = Find(it->second, key);
+    if (value == nullptr || value->type != Value::kInt) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    *out_value = (T)value->int_value;
+    return ESP_OK;
+}
+
+esp_err_t GetBytes(nvs_handle_t handle, const char* key, Value::Type type, void* out_value, size_t* length) {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.reads++;
+    auto it = handles.find(handle);
+    if (it == handles.end()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const Value* value = Find(it->second, key);
+    if (value == nullptr || value->type != type) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    // Strings are returned with their terminator
+    size_t size = value->bytes.size() + (type == Value::kString ? 1 : 0);
+    if (out_value == nullptr) {
+        *length = size;
+        return ESP_OK;
+    }
+    if (*length < size) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    memcpy(out_value, value->bytes.c_str(), size);
+    *length = size;
+    return ESP_OK;
+}
+
+} // namespace
+
+esp_err_t nvs_flash_init(void) {
+    return ESP_OK;
+}
+
+esp_err_t nvs_flash_erase(void) {
+    std::lock_guard<std::mutex> lock(mutex);
+    flash.clear();
+    return ESP_OK;
+}
+
+esp_err_t nvs_open(const char* name, nvs_open_mode_t open_mode, nvs_handle_t* out_handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.opens++;
+    esp_err_t err = InjectedError(fake_nvs::kOpen, name, "");
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (open_mode == NVS_READONLY && flash.find(name) == flash.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (open_mode == NVS_READWRITE) {
+        flash[name];
+    }
+    *out_handle = next_handle++;
+    handles[*out_handle] = {name, open_mode == NVS_READWRITE, {}};
+    return ESP_OK;
+}
+
+esp_err_t nvs_get_str(nvs_handle_t handle, const char* key, char* out_value, size_t* length) {
+    return GetBytes(handle, key, Value::kString, out_value, length);
+}
+
+esp_err_t nvs_get_blob(nvs_handle_t handle, const char* key, void* out_value, size_t* length) {
+    return GetBytes(handle, key, Value::kBlob, out_value, length);
+}
+
+esp_err_t nvs_get_i32(nvs_handle_t handle, const char* key, int32_t* out_value) {
+    return GetScalar(handle, key, out_value);
+}
+
+esp_err_t nvs_get_u8(nvs_handle_t handle, const char* key, uint8_t* out_value) {
+    return GetScalar(handle, key, out_value);
+}
+
+esp_err_t nvs_set_str(nvs_handle_t handle, const char* key, const char* value) {
+    return Stage(handle, fake_nvs::kSet, key, {Value::kString, value, 0}, std::string("/") + key + "=" + value);
+}
+
+esp_err_t nvs_set_blob(nvs_handle_t handle, const char* key, const void* value, size_t length) {
+    return Stage(handle, fake_nvs::kSet, key, {Value::kBlob, std::string((const char*)value, length), 0},
+                 std::string("/") + key + "=<" + std::to_string(length) + " bytes>");
+}
+
+esp_err_t nvs_set_i32(nvs_handle_t handle, const char* key, int32_t value) {
+    return Stage(handle, fake_nvs::kSet, key, {Value::kInt, "", value}, std::string("/") + key + "=" + std::to_string(value));
+}
+
+esp_err_t nvs_set_u8(nvs_handle_t handle, const char* key, uint8_t value) {
+    return nvs_set_i32(handle, key, value);
+}
+
+esp_err_t nvs_erase_key(nvs_handle_t handle, const char* key) {
+    return Stage(handle, fake_nvs::kEraseKey, key, {}, std::string("/") + key);
+}
+
+esp_err_t nvs_erase_all(nvs_handle_t handle) {
+    return Stage(handle, fake_nvs::kEraseAll, nullptr, {}, "");
+}
+
+esp_err_t nvs_commit(nvs_handle_t handle) {
+    std::lock_guard<std::mutex> lock(mutex);
+    counters.commits++;
+    auto it = handles.find(handle);
+    if (it == handles.end()) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    Handle& h = it->second;
+    esp_err_t err = InjectedError(fake_nvs::kCommit, h.ns, "");
+    if (err != ESP_OK) {
+        h.changes.clear();
+        return err;
+    }
+    Namespace& space = flash[h.ns];
+    for (auto& change : h.changes) {
+        if (change.operation == fake_nvs::kEraseAll) {
+            space.clear();
+        } else if (change.operation == fake_nvs::kEraseKey) {
+            space.erase(change.key);
+        } else {
+            space[change.key] = change.value;
+        }
+    }
+    if (!h.changes.empty()) {
+        log.push_back("commit " + h.ns);
+    }
+    h.changes.clear();
+    return ESP_OK;
+}
+
+void nvs_close(nvs_handle_t handle) {
+    // Uncommitted changes are dropped, as on the device
+    std::lock_guard<std::mutex> lock(mutex);
+    handles.erase(handle);
+}
+
+namespace fake_nvs {
+
+void Reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    flash.clear();
+    log.clear();
+    failures.clear();
+    counters = {};
+}
+
+void Put(const std::string& ns, const std::string& key, const std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    flash[ns][key] = {Value::kString, value, 0};
+}
+
+void PutInt(const std::string& ns, const std::string& key, int32_t value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    flash[ns][key] = {Value::kInt, "", value};
+}
+
+bool Get(const std::string& ns, const std::string& key, std::string& value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto space = flash.find(ns);
+    if (space == flash.end()) {
+        return false;
+    }
+    auto it = space->second.find(key);
+    if (it == space->second.end() || it->second.type != Value::kString) {
+        return false;
+    }
+    value = it->second.bytes;
+    return true;
+}
+
+bool GetInt(const std::string& ns, const std::string& key, int32_t& value) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto space = flash.find(ns);
+    if (space == flash.end()) {
+        return false;
+    }
+    auto it = space->second.find(key);
+    if (it == space->second.end() || it->second.type != Value::kInt) {
+        return false;
+    }
+    value = it->second.int_value;
+    return true;
+}
+
+bool Contains(const std::string& ns, const std::string& key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto space = flash.find(ns);
+    return space != flash.end() && space->second.count(key) > 0;
+}
+
+std::vector<std::string> Log() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return log;
+}
+
+void ClearLog() {
+    std::lock_guard<std::mutex> lock(mutex);
+    log.clear();
+}
+
+void FailNext(Operation operation, const std::string& ns, const std::string& key, esp_err_t error) {
+    std::lock_guard<std::mutex> lock(mutex);
+    failures.push_back({operation, ns, key, error});
+}
+
+Counters GetCounters() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return counters;
+}
+
+} // namespace fake_nvs
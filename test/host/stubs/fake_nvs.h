@@ -0,0 +1,57 @@
+#ifndef FAKE_NVS_H
+#define FAKE_NVS_H
+
+#include <esp_err.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Test controls of the in-memory NVS behind the nvs_* stubs
+ *
+ * Changes made through a handle are staged and only reach the flash
+ * contents on a successful nvs_commit(), so a failed commit loses them the
+ * way a reset before the commit would. Every successful call is appended to
+ * the log in call order as "set ns/key=value", "erase ns/key",
+ * "erase_all ns" or "commit ns".
+ */
+namespace fake_nvs {
+
+enum Operation {
+    kOpen,
+    kSet,
+    kEraseKey,
+    kEraseAll,
+    kCommit,
+};
+
+// Empty flash, empty log, no pending failures
+void Reset();
+
+// Write straight to flash (not logged), e.g. values from a previous boot
+void Put(const std::string& ns, const std::string& key, const std::string& value);
+void PutInt(const std::string& ns, const std::string& key, int32_t value);
+
+bool Get(const std::string& ns, const std::string& key, std::string& value);
+bool GetInt(const std::string& ns, const std::string& key, int32_t& value);
+bool Contains(const std::string& ns, const std::string& key);
+
+std::vector<std::string> Log();
+void ClearLog();
+
+// The next `operation` on `ns` (and `key`, if not empty) returns `error`
+void FailNext(Operation operation, const std::string& ns, const std::string& key = "", esp_err_t error = ESP_FAIL);
+
+// Calls that reached the fake, including failed ones
+struct Counters {
+    uint32_t opens;
+    uint32_t reads;
+    uint32_t writes;
+    uint32_t commits;
+};
+Counters GetCounters();
+
+} // namespace fake_nvs
+
+#endif // FAKE_NVS_H
@@ -0,0 +1,27 @@
+#ifndef HOST_FREERTOS_H
+#define HOST_FREERTOS_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+typedef struct HostTask* TaskHandle_t;
+typedef struct HostSemaphore* SemaphoreHandle_t;
+typedef struct HostQueue* QueueHandle_t;
+
+#define pdTRUE              1
+#define pdFALSE             0
+#define pdPASS              pdTRUE
+#define pdFAIL              pdFALSE
+#define portMAX_DELAY       ((TickType_t)0xffffffffUL)
+#define portTICK_PERIOD_MS  1
+#define pdMS_TO_TICKS(ms)   ((TickType_t)(ms))
+#define tskNO_AFFINITY      0x7fffffff
+#define configMAX_PRIORITIES 25
+
+#define portYIELD_FROM_ISR(woken) (void)(woken)
+
+#endif // HOST_FREERTOS_H
@@ -0,0 +1,11 @@
+#ifndef HOST_FREERTOS_PORTMACRO_H
+#define HOST_FREERTOS_PORTMACRO_H
+
+#include "FreeRTOS.h"
+
+// There are no interrupts on the host
+static inline BaseType_t xPortInIsrContext(void) {
+    return pdFALSE;
+}
+
+#endif // HOST_FREERTOS_PORTMACRO_H
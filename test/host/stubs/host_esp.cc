@@ -0,0 +1,86 @@
+// Host implementations of the ESP-IDF calls the tested modules make
+#include <esp_err.h>
+#include <esp_heap_caps.h>
+#include <esp_system.h>
+#include <esp_timer.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <mutex>
+#include <vector>
+
+#include "system_info.h"
+
+extern "C" const char* esp_err_to_name(esp_err_t code) {
+    switch (code) {
+    case ESP_OK: return "ESP_OK";
+    case ESP_FAIL: return "ESP_FAIL";
+    case ESP_ERR_NO_MEM: return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG: return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE: return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE: return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND: return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_TIMEOUT: return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_NVS_NOT_FOUND: return "ESP_ERR_NVS_NOT_FOUND";
+    default: return "ESP_ERR_UNKNOWN";
+    }
+}
+
+extern "C" int64_t esp_timer_get_time(void) {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+extern "C" void* heap_caps_malloc(size_t size, uint32_t) {
+    return malloc(size);
+}
+
+extern "C" void* heap_caps_calloc(size_t n, size_t size, uint32_t) {
+    return calloc(n, size);
+}
+
+extern "C" void* heap_caps_realloc(void* ptr, size_t size, uint32_t) {
+    return realloc(ptr, size);
+}
+
+extern "C" void heap_caps_free(void* ptr) {
+    free(ptr);
+}
+
+extern "C" size_t heap_caps_get_free_size(uint32_t) {
+    return 4 * 1024 * 1024;
+}
+
+extern "C" size_t heap_caps_get_largest_free_block(uint32_t) {
+    return 4 * 1024 * 1024;
+}
+
+namespace {
+std::mutex shutdown_mutex;
+std::vector<shutdown_handler_t> shutdown_handlers;
+}
+
+extern "C" esp_err_t esp_register_shutdown_handler(shutdown_handler_t handler) {
+    std::lock_guard<std::mutex> lock(shutdown_mutex);
+    shutdown_handlers.push_back(handler);
+    return ESP_OK;
+}
+
+extern "C" void esp_restart(void) {
+    std::vector<shutdown_handler_t> handlers;
+    {
+        std::lock_guard<std::mutex> lock(shutdown_mutex);
+        handlers = shutdown_handlers;
+    }
+    for (auto handler : handlers) {
+        handler();
+    }
+    exit(0);
+}
+
+// The histogram registry only prints on the device
+void SystemInfo::RegisterLatencyHistogram(const char*, LatencyHistogram*) {
+}
+
+void SystemInfo::UnregisterLatencyHistogram(LatencyHistogram*) {
+}
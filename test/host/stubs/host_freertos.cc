@@ -0,0 +1,161 @@
+// FreeRTOS tasks, notifications and semaphores on top of std::thread
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+
+#include <pthread.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+struct HostTask {
+    std::mutex mutex;
+    std::condition_variable condition;
+    uint32_t notifications = 0;
+};
+
+struct HostSemaphore {
+    std::mutex mutex;
+    std::condition_variable condition;
+    UBaseType_t count;
+    UBaseType_t max_count;
+};
+
+namespace {
+
+thread_local HostTask* current_task = nullptr;
+
+// Waits on condition until ready() holds; portMAX_DELAY waits forever
+template <typename Predicate>
+bool WaitTicks(std::condition_variable& condition, std::unique_lock<std::mutex>& lock, TickType_t ticks,
+               Predicate ready) {
+    if (ticks == portMAX_DELAY) {
+        condition.wait(lock, ready);
+        return true;
+    }
+    return condition.wait_for(lock, std::chrono::milliseconds(ticks * portTICK_PERIOD_MS), ready);
+}
+
+HostTask* CurrentTask() {
+    if (current_task == nullptr) {
+        // Threads not started through xTaskCreate (e.g. main) get one lazily
+        current_task = new HostTask();
+    }
+    return current_task;
+}
+
+} // namespace
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char*, uint32_t, void* arg, UBaseType_t,
+                       TaskHandle_t* handle) {
+    HostTask* task = new HostTask();
+    if (handle != nullptr) {
+        *handle = task;
+    }
+    std::thread([function, arg, task]() {
+        current_task = task;
+        function(arg);
+    }).detach();
+    return pdPASS;
+}
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t function, const char* name, uint32_t stack_depth, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t) {
+    return xTaskCreate(function, name, stack_depth, arg, priority, handle);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    if (task == nullptr || task == current_task) {
+        pthread_exit(nullptr);
+    }
+}
+
+void vTaskDelay(TickType_t ticks) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks * portTICK_PERIOD_MS));
+}
+
+TickType_t xTaskGetTickCount(void) {
+    static const auto start = std::chrono::steady_clock::now();
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    return (TickType_t)(elapsed.count() / portTICK_PERIOD_MS);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+    return CurrentTask();
+}
+
+void xTaskNotifyGive(TaskHandle_t task) {
+    std::lock_guard<std::mutex> lock(task->mutex);
+    task->notifications++;
+    task->condition.notify_all();
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t* higher_priority_task_woken) {
+    xTaskNotifyGive(task);
+    if (higher_priority_task_woken != nullptr) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks_to_wait) {
+    HostTask* task = CurrentTask();
+    std::unique_lock<std::mutex> lock(task->mutex);
+    WaitTicks(task->condition, lock, ticks_to_wait, [task]() { return task->notifications > 0; });
+    uint32_t value = task->notifications;
+    if (value > 0) {
+        task->notifications = clear_on_exit ? 0 : value - 1;
+    }
+    return value;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count) {
+    HostSemaphore* semaphore = new HostSemaphore();
+    semaphore->count = initial_count;
+    semaphore->max_count = max_count;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+    return xSemaphoreCreateCounting(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void) {
+    return xSemaphoreCreateCounting(1, 1);
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks_to_wait) {
+    std::unique_lock<std::mutex> lock(semaphore->mutex);
+    if (!WaitTicks(semaphore->condition, lock, ticks_to_wait, [semaphore]() { return semaphore->count > 0; })) {
+        return pdFALSE;
+    }
+    semaphore->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    if (semaphore->count >= semaphore->max_count) {
+        return pdFALSE;
+    }
+    semaphore->count++;
+    semaphore->condition.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* higher_priority_task_woken) {
+    if (higher_priority_task_woken != nullptr) {
+        *higher_priority_task_woken = pdFALSE;
+    }
+    return xSemaphoreGive(semaphore);
+}
+
+UBaseType_t uxSemaphoreGetCount(SemaphoreHandle_t semaphore) {
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    return semaphore->count;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
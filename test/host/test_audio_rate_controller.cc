@@ -0,0 +1,176 @@
+// AudioRateController fed window by window: the bitrate ladder under
+// congestion and jitter, FEC and expected loss under 5% and 15% downlink
+// loss, and the climb back with FEC held through the recovery
+#include "audio_rate_controller.h"
+#include "host_test.h"
+
+#include <cstdio>
+
+namespace {
+
+struct Expected {
+    int bitrate;
+    bool fec;
+    int packet_loss_percent;
+    bool changed;
+};
+
+// Keeps the cumulative counters the controller expects and advances the
+// clock one evaluation window per call
+class Link {
+public:
+    explicit Link(AudioRateController& controller) : controller_(controller) {
+        observation_.send_queue_limit = 40;
+        controller_.Update(now_us_, observation_);
+    }
+
+    bool Window(uint32_t received, uint32_t lost, uint32_t drops = 0, uint32_t failures = 0,
+                size_t queue_depth = 0, uint32_t jitter_ms = 20) {
+        observation_.downlink_received += received;
+        observation_.downlink_lost += lost;
+        observation_.send_drops += drops;
+        observation_.send_failures += failures;
+        observation_.send_queue_depth = queue_depth;
+        observation_.jitter_ms = jitter_ms;
+        now_us_ += RATE_CONTROL_INTERVAL_MS * 1000LL;
+        return controller_.Update(now_us_, observation_);
+    }
+
+    // An update before the window is over
+    bool Early(uint32_t drops) {
+        observation_.send_drops += drops;
+        return controller_.Update(now_us_ + 1000, observation_);
+    }
+
+private:
+    AudioRateController& controller_;
+    AudioRateController::Observation observation_ = {};
+    int64_t now_us_ = 1000000;
+};
+
+void CheckWindow(AudioRateController& controller, bool changed, const Expected& expected, int window) {
+    auto settings = controller.settings();
+    if (settings.bitrate != expected.bitrate || settings.fec != expected.fec ||
+        settings.packet_loss_percent != expected.packet_loss_percent || changed != expected.changed) {
+        fprintf(stderr, "  window %d: bitrate %d fec %d loss %d changed %d, expected %d %d %d %d\n", window,
+                settings.bitrate, settings.fec, settings.packet_loss_percent, changed, expected.bitrate,
+                expected.fec, expected.packet_loss_percent, expected.changed);
+    }
+    CHECK_EQ(settings.bitrate, expected.bitrate);
+    CHECK_EQ(settings.fec, expected.fec);
+    CHECK_EQ(settings.packet_loss_percent, expected.packet_loss_percent);
+    CHECK_EQ(changed, expected.changed);
+}
+
+void TestCongestionLadder() {
+    AudioRateController controller;
+    Link link(controller);
+    CHECK_EQ(controller.settings().bitrate, 16000);
+
+    // Each sign of congestion halves the distance to the bottom step
+    CheckWindow(controller, link.Window(50, 0, 1), {12000, false, 0, true}, 1);
+    CheckWindow(controller, link.Window(50, 0, 0, 0, 21), {10000, false, 0, true}, 2);
+    CheckWindow(controller, link.Window(50, 0, 0, 2), {8000, false, 0, true}, 3);
+    CheckWindow(controller, link.Window(50, 0, 3), {8000, false, 0, false}, 4);
+    // A queue at half its limit is not congested yet
+    CheckWindow(controller, link.Window(50, 0, 0, 0, 20), {8000, false, 0, false}, 5);
+
+    // Updates inside a window change nothing; their drops count in the next one
+    CHECK(!link.Early(1));
+    CheckWindow(controller, link.Window(50, 0), {8000, false, 0, false}, 6);
+
+    // One step back up per RATE_CONTROL_PROBE_WINDOWS clean windows
+    const int kClimb[] = {8000, 8000, 10000, 10000, 10000, 12000, 12000, 12000, 14000, 14000, 14000, 16000,
+                          16000, 16000, 16000};
+    for (int i = 0; i < (int)(sizeof(kClimb) / sizeof(kClimb[0])); i++) {
+        bool changed = link.Window(50, 0);
+        CheckWindow(controller, changed, {kClimb[i], false, 0, i > 0 && kClimb[i] != kClimb[i - 1]}, 7 + i);
+    }
+    CHECK_EQ(controller.changes(), 7);
+
+    // Congestion in the middle of a climb resets the clean count
+    link.Window(50, 0, 1);
+    link.Window(50, 0);
+    link.Window(50, 0);
+    link.Window(50, 0, 1);
+    link.Window(50, 0);
+    link.Window(50, 0);
+    CHECK_EQ(controller.settings().bitrate, 10000);
+}
+
+void TestJitterStepsDown() {
+    AudioRateController controller;
+    Link link(controller);
+    // Jitter steps down one rung at a time rather than halving
+    CheckWindow(controller, link.Window(50, 0, 0, 0, 0, 150), {14000, false, 0, true}, 1);
+    CheckWindow(controller, link.Window(50, 0, 0, 0, 0, 150), {12000, false, 0, true}, 2);
+    CheckWindow(controller, link.Window(50, 0, 0, 0, 0, 120), {12000, false, 0, false}, 3);
+    CHECK_EQ(controller.loss_percent(), 0);
+}
+
+void TestLossAndRecovery() {
+    AudioRateController controller;
+    Link link(controller);
+
+    // 5% loss: FEC on from the first lossy window, the expected loss follows
+    // the smoothed rate, the bitrate is left alone
+    const Expected kFivePercent[] = {
+        {16000, true, 1, true}, {16000, true, 2, true}, {16000, true, 3, true}, {16000, true, 3, false},
+        {16000, true, 4, true}, {16000, true, 4, false}, {16000, true, 4, false}, {16000, true, 4, false},
+        {16000, true, 5, true}, {16000, true, 5, false},
+    };
+    int window = 0;
+    for (const auto& expected : kFivePercent) {
+        CheckWindow(controller, link.Window(95, 5), expected, ++window);
+    }
+    CHECK_EQ(controller.loss_percent(), 5);
+
+    // Windows without downlink traffic say nothing about loss
+    CheckWindow(controller, link.Window(0, 0), {16000, true, 5, false}, ++window);
+
+    // 15% loss: once the smoothed loss reaches 10% the bitrate steps down
+    // every window
+    const Expected kFifteenPercent[] = {
+        {16000, true, 7, true}, {16000, true, 9, true}, {14000, true, 11, true}, {12000, true, 12, true},
+        {10000, true, 12, true}, {8000, true, 13, true}, {8000, true, 14, true}, {8000, true, 14, false},
+    };
+    for (const auto& expected : kFifteenPercent) {
+        CheckWindow(controller, link.Window(85, 15), expected, ++window);
+    }
+    CHECK_EQ(controller.loss_percent(), 14);
+
+    // Recovery: the bitrate climbs back as the smoothed loss decays; FEC stays
+    // on at 1% expected loss until RATE_CONTROL_FEC_HOLD_WINDOWS loss-free windows
+    const Expected kRecovery[] = {
+        {8000, true, 10, true}, {8000, true, 8, true}, {8000, true, 6, true}, {10000, true, 5, true},
+        {10000, true, 3, true}, {10000, true, 3, false}, {12000, true, 2, true}, {12000, true, 2, false},
+        {12000, true, 1, true}, {14000, true, 1, true}, {14000, true, 1, false}, {14000, true, 1, false},
+        {16000, true, 1, true}, {16000, true, 1, false}, {16000, true, 1, false}, {16000, true, 1, false},
+        {16000, false, 0, true}, {16000, false, 0, false},
+    };
+    int first_loss_free = 0;
+    int fec_off = 0;
+    for (const auto& expected : kRecovery) {
+        CheckWindow(controller, link.Window(100, 0), expected, ++window);
+        if (first_loss_free == 0 && controller.loss_percent() == 0) {
+            first_loss_free = window;
+        }
+        if (fec_off == 0 && !controller.settings().fec) {
+            fec_off = window;
+        }
+    }
+    // FEC went off on the RATE_CONTROL_FEC_HOLD_WINDOWS-th window without loss
+    CHECK_EQ(fec_off - first_loss_free + 1, RATE_CONTROL_FEC_HOLD_WINDOWS);
+
+    // A single lossy window switches FEC straight back on and restarts the hold
+    CheckWindow(controller, link.Window(90, 10), {16000, true, 3, true}, ++window);
+}
+
+} // namespace
+
+int main() {
+    TestCongestionLadder();
+    TestJitterStepsDown();
+    TestLossAndRecovery();
+    return HostTestResult("test_audio_rate_controller");
+}
@@ -0,0 +1,233 @@
+// BackgroundTask: lane order, coalescing, inline job storage, and a
+// comparison of the pooled lanes against the std::list<std::function>
+// queue they replaced
+#include "background_task.h"
+#include "alloc_counter.h"
+#include "host_test.h"
+
+#include <esp_timer.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+
+namespace {
+
+// The queue BackgroundTask used before the lanes: every Schedule() wraps the
+// callback in a second std::function and a std::list node
+class LegacyBackgroundTask {
+public:
+    LegacyBackgroundTask() {
+        xTaskCreate([](void* arg) {
+            ((LegacyBackgroundTask*)arg)->Loop();
+        }, "legacy_task", 8192, this, 2, nullptr);
+    }
+
+    void Schedule(std::function<void()> callback) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_tasks_++;
+        tasks_.emplace_back([this, cb = std::move(callback)]() {
+            cb();
+            std::lock_guard<std::mutex> lock(mutex_);
+            active_tasks_--;
+            if (tasks_.empty() && active_tasks_ == 0) {
+                condition_variable_.notify_all();
+            }
+        });
+        condition_variable_.notify_all();
+    }
+
+    void WaitForCompletion() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        condition_variable_.wait(lock, [this]() { return tasks_.empty() && active_tasks_ == 0; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::list<std::function<void()>> tasks_;
+    std::condition_variable condition_variable_;
+    size_t active_tasks_ = 0;
+
+    void Loop() {
+        while (true) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_variable_.wait(lock, [this]() { return !tasks_.empty(); });
+            std::list<std::function<void()>> tasks = std::move(tasks_);
+            lock.unlock();
+            for (auto& task : tasks) {
+                task();
+            }
+        }
+    }
+};
+
+// Holds the worker inside a task until Open(), so the test controls what is
+// queued when the worker next looks
+struct Gate {
+    std::promise<void> promise;
+    std::shared_future<void> future = promise.get_future().share();
+
+    void Wait() { future.wait(); }
+    void Open() { promise.set_value(); }
+};
+
+// The worker has picked up the gate task once it has run `executed` tasks
+template <typename Task>
+void WaitUntilBlocked(Task& task, BackgroundLane lane, uint32_t executed) {
+    while (task.GetLaneStats(lane).executed < executed) {
+        vTaskDelay(1);
+    }
+}
+
+void TestLaneOrder(BackgroundTask& task) {
+    Gate gate;
+    std::string order;
+    task.Schedule([&gate]() { gate.Wait(); }, kBackgroundLaneHousekeeping);
+    WaitUntilBlocked(task, kBackgroundLaneHousekeeping, 1);
+
+    task.Schedule([&order]() { order += "h1 "; }, kBackgroundLaneHousekeeping);
+    task.Schedule([&order]() { order += "u1 "; }, kBackgroundLaneUi);
+    task.Schedule([&order]() { order += "a1 "; }, kBackgroundLaneAudio);
+    task.Schedule([&order]() { order += "u2 "; }, kBackgroundLaneUi);
+    task.Schedule([&order]() { order += "a2 "; }, kBackgroundLaneAudio);
+    CHECK_EQ(task.GetLaneStats(kBackgroundLaneUi).depth, 2);
+    gate.Open();
+    task.WaitForCompletion();
+
+    CHECK(order == "a1 a2 u1 u2 h1 ");
+    CHECK_EQ(task.GetLaneStats(kBackgroundLaneUi).max_depth, 2);
+}
+
+void TestCoalesce(BackgroundTask& task) {
+    Gate gate;
+    std::string order;
+    uint32_t executed = task.GetLaneStats(kBackgroundLaneHousekeeping).executed;
+    task.Schedule([&gate]() { gate.Wait(); }, kBackgroundLaneHousekeeping);
+    WaitUntilBlocked(task, kBackgroundLaneHousekeeping, executed + 1);
+
+    uint32_t coalesced = task.GetLaneStats(kBackgroundLaneUi).coalesced;
+    task.Schedule([&order]() { order += "status1 "; }, kBackgroundLaneUi, 7);
+    task.Schedule([&order]() { order += "other "; }, kBackgroundLaneUi);
+    task.Schedule([&order]() { order += "status2 "; }, kBackgroundLaneUi, 7);
+    task.Schedule([&order]() { order += "battery "; }, kBackgroundLaneUi, 8);
+    task.Schedule([&order]() { order += "status3 "; }, kBackgroundLaneUi, 7);
+    // The same key on another lane is a different task
+    task.Schedule([&order]() { order += "audio7 "; }, kBackgroundLaneAudio, 7);
+    CHECK_EQ(task.GetLaneStats(kBackgroundLaneUi).depth, 3);
+    gate.Open();
+    task.WaitForCompletion();
+
+    // The newest callback runs in the queue position of the first one
+    CHECK(order == "audio7 status3 other battery ");
+    CHECK_EQ(task.GetLaneStats(kBackgroundLaneUi).coalesced - coalesced, 2);
+
+    // Once a keyed task has started, the key is free again
+    task.Schedule([&order]() { order += "status4 "; }, kBackgroundLaneUi, 7);
+    task.WaitForCompletion();
+    CHECK(order == "audio7 status3 other battery status4 ");
+}
+
+void TestInlineStorage() {
+    int counter = 0;
+    void* self = &counter;
+    BackgroundJob small([self, &counter, a = 1, b = 2]() { counter += a + b + (self != nullptr); });
+    CHECK(!small.on_heap());
+    std::function<void()> function = [&counter]() { counter++; };
+    BackgroundJob wrapped(function);
+    CHECK(!wrapped.on_heap());
+    char payload[128] = {1};
+    BackgroundJob large([payload, &counter]() { counter += payload[0]; });
+    CHECK(large.on_heap());
+
+    BackgroundJob moved(std::move(small));
+    CHECK(!small);
+    moved();
+    wrapped();
+    large();
+    CHECK_EQ(counter, 6);
+}
+
+struct BenchmarkResult {
+    double enqueue_ns;      // Per Schedule() call
+    double drain_ns;        // Per task, worker time including the queue overhead
+    double allocations;     // Per Schedule() call
+};
+
+// Queues `count` tasks behind a gate, then lets the worker drain them
+template <typename Task, typename ScheduleFn>
+BenchmarkResult Measure(Task& task, int count, ScheduleFn schedule) {
+    Gate gate;
+    volatile int sink = 0;
+    schedule([&gate]() { gate.Wait(); });
+    vTaskDelay(5);
+
+    unsigned long allocations_before = allocation_count.load();
+    int64_t start_us = esp_timer_get_time();
+    for (int i = 0; i < count; i++) {
+        schedule([&sink, i]() { sink = sink + i; });
+    }
+    int64_t queued_us = esp_timer_get_time();
+    unsigned long allocations = allocation_count.load() - allocations_before;
+    gate.Open();
+    task.WaitForCompletion();
+    int64_t done_us = esp_timer_get_time();
+
+    return {(queued_us - start_us) * 1000.0 / count, (done_us - queued_us) * 1000.0 / count,
+            (double)allocations / count};
+}
+
+void BenchmarkAgainstList(BackgroundTask& task) {
+    constexpr int kTasks = 2000;
+    constexpr int kRounds = 20;
+    // Leaked for the same reason as the BackgroundTask in main()
+    LegacyBackgroundTask& legacy = *new LegacyBackgroundTask();
+
+    auto pooled_schedule = [&task](auto&& callback) {
+        task.Schedule(std::forward<decltype(callback)>(callback), kBackgroundLaneUi);
+    };
+    auto legacy_schedule = [&legacy](auto&& callback) {
+        legacy.Schedule(std::forward<decltype(callback)>(callback));
+    };
+
+    // The first round grows the entry pool to kTasks, later rounds reuse it
+    Measure(task, kTasks, pooled_schedule);
+    Measure(legacy, kTasks, legacy_schedule);
+
+    BenchmarkResult pooled = {}, list = {};
+    for (int round = 0; round < kRounds; round++) {
+        BenchmarkResult p = Measure(task, kTasks, pooled_schedule);
+        BenchmarkResult l = Measure(legacy, kTasks, legacy_schedule);
+        pooled = {pooled.enqueue_ns + p.enqueue_ns / kRounds, pooled.drain_ns + p.drain_ns / kRounds,
+                  pooled.allocations + p.allocations / kRounds};
+        list = {list.enqueue_ns + l.enqueue_ns / kRounds, list.drain_ns + l.drain_ns / kRounds,
+                list.allocations + l.allocations / kRounds};
+    }
+
+    printf("%d tasks x %d rounds          enqueue     drain   allocations/task\n", kTasks, kRounds);
+    printf("  pooled lanes              %6.0f ns %6.0f ns  %.2f\n", pooled.enqueue_ns, pooled.drain_ns,
+           pooled.allocations);
+    printf("  std::list<std::function>  %6.0f ns %6.0f ns  %.2f\n", list.enqueue_ns, list.drain_ns,
+           list.allocations);
+
+    // Timing depends on the host; the allocation counts do not
+    CHECK(pooled.allocations == 0);
+    CHECK(list.allocations >= 2);
+}
+
+} // namespace
+
+int main() {
+    // Never destroyed: the host vTaskDelete cannot stop the worker thread
+    BackgroundTask* task = new BackgroundTask();
+
+    TestLaneOrder(*task);
+    TestCoalesce(*task);
+    TestInlineStorage();
+    BenchmarkAgainstList(*task);
+    task->PrintStats();
+    return HostTestResult("test_background_task");
+}
@@ -0,0 +1,294 @@
+// BoundedRing: FIFO and overflow policies, an MPMC stress run that checks
+// every item is consumed once, in order per producer, or counted as
+// dropped, and a comparison against the mutex-guarded std::list it replaced
+#include "bounded_ring.h"
+#include "host_test.h"
+
+#include <esp_timer.h>
+
+#include <atomic>
+#include <cstdio>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int kProducers = 4;
+constexpr int kConsumers = 3;
+
+uint64_t Tag(uint32_t producer, uint32_t sequence) {
+    return ((uint64_t)producer << 32) | sequence;
+}
+
+void TestFifoAndOverflow() {
+    BoundedRing<int, 8> ring;
+    CHECK(ring.empty());
+    for (int i = 0; i < 8; i++) {
+        int value = i;
+        CHECK(ring.TryPush(std::move(value)));
+    }
+    int extra = 99;
+    CHECK(!ring.TryPush(std::move(extra)));
+    CHECK_EQ(extra, 99);
+    CHECK_EQ(ring.size(), 8);
+    int value = -1;
+    for (int i = 0; i < 8; i++) {
+        CHECK(ring.TryPop(value));
+        CHECK_EQ(value, i);
+    }
+    CHECK(!ring.TryPop(value));
+
+    // Drop newest: the queue keeps 0..3 and rejects the rest
+    for (int i = 0; i < 6; i++) {
+        CHECK_EQ(ring.Push(int(i), 4, RingOverflow::kDropNewest), i < 4);
+    }
+    CHECK_EQ(ring.dropped(), 2);
+    CHECK(ring.TryPop(value) && value == 0);
+    ring.Clear();
+    CHECK(ring.empty());
+
+    // Drop oldest: the queue keeps the last 4
+    for (int i = 0; i < 6; i++) {
+        CHECK_EQ(ring.Push(int(i), 4, RingOverflow::kDropOldest), i < 4);
+    }
+    CHECK_EQ(ring.dropped(), 4);
+    for (int i = 2; i < 6; i++) {
+        CHECK(ring.TryPop(value) && value == i);
+    }
+    CHECK(ring.empty());
+
+    // Positions keep wrapping around the slots
+    for (int i = 0; i < 1000; i++) {
+        int in = i;
+        CHECK(ring.TryPush(std::move(in)));
+        CHECK(ring.TryPop(value) && value == i);
+    }
+}
+
+struct StressResult {
+    uint64_t attempts = 0;
+    uint64_t consumed = 0;
+    uint64_t remaining = 0;
+    uint32_t dropped = 0;
+    uint64_t false_returns = 0;
+    int order_errors = 0;
+    int duplicates = 0;
+};
+
+// kProducers push tagged items under the given policy while kConsumers pop;
+// every consumer checks that each producer's items reach it in order
+template <size_t Capacity>
+StressResult Stress(RingOverflow policy, size_t limit, uint32_t per_producer) {
+    BoundedRing<uint64_t, Capacity> ring;
+    StressResult result;
+    std::atomic<int> producers_left{kProducers};
+    std::atomic<uint64_t> consumed{0};
+    std::atomic<uint64_t> false_returns{0};
+    std::atomic<int> order_errors{0};
+    std::vector<std::vector<uint8_t>> seen(kProducers, std::vector<uint8_t>(per_producer, 0));
+    std::mutex seen_mutex;
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < kProducers; p++) {
+        threads.emplace_back([&, p]() {
+            for (uint32_t i = 0; i < per_producer; i++) {
+                if (!ring.Push(Tag(p, i), limit, policy)) {
+                    false_returns++;
+                }
+                if ((i & 15) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+            producers_left--;
+        });
+    }
+    for (int c = 0; c < kConsumers; c++) {
+        threads.emplace_back([&]() {
+            std::vector<int64_t> last(kProducers, -1);
+            std::vector<uint64_t> mine;
+            uint64_t item;
+            while (true) {
+                if (ring.TryPop(item)) {
+                    uint32_t producer = (uint32_t)(item >> 32);
+                    int64_t sequence = (uint32_t)item;
+                    if (sequence <= last[producer]) {
+                        order_errors++;
+                    }
+                    last[producer] = sequence;
+                    mine.push_back(item);
+                } else if (producers_left == 0) {
+                    break;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+            consumed += mine.size();
+            std::lock_guard<std::mutex> lock(seen_mutex);
+            for (uint64_t tag : mine) {
+                seen[tag >> 32][(uint32_t)tag]++;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    uint64_t item;
+    while (ring.TryPop(item)) {
+        seen[item >> 32][(uint32_t)item]++;
+        result.remaining++;
+    }
+    for (const auto& counts : seen) {
+        for (uint8_t count : counts) {
+            result.duplicates += count > 1 ? 1 : 0;
+        }
+    }
+    result.attempts = (uint64_t)kProducers * per_producer;
+    result.consumed = consumed;
+    result.dropped = ring.dropped();
+    result.false_returns = false_returns;
+    result.order_errors = order_errors;
+    return result;
+}
+
+void CheckStress(const char* name, RingOverflow policy, const StressResult& result) {
+    printf("%s: %llu pushed, %llu consumed, %llu left, %u dropped\n", name, (unsigned long long)result.attempts,
+           (unsigned long long)result.consumed, (unsigned long long)result.remaining, (unsigned)result.dropped);
+    // Every item is consumed once, still queued, or counted as dropped
+    CHECK_EQ(result.consumed + result.remaining + result.dropped, result.attempts);
+    CHECK_EQ(result.duplicates, 0);
+    CHECK_EQ(result.order_errors, 0);
+    if (policy == RingOverflow::kDropNewest) {
+        // Each refused push is one drop, and nothing else is dropped
+        CHECK_EQ(result.false_returns, result.dropped);
+    } else {
+        // A push may discard the head and still find no room if a racing
+        // producer took the slot: two drops, one false return
+        CHECK(result.false_returns <= result.dropped);
+    }
+    CHECK(result.consumed > 0);
+}
+
+void TestMpmcStress() {
+    // A full ring under either policy, and a limit below capacity
+    for (size_t limit : {16, 6}) {
+        for (RingOverflow policy : {RingOverflow::kDropNewest, RingOverflow::kDropOldest}) {
+            char name[48];
+            snprintf(name, sizeof(name), "%s at limit %zu",
+                     policy == RingOverflow::kDropNewest ? "drop newest" : "drop oldest", limit);
+            CheckStress(name, policy, Stress<16>(policy, limit, 200000));
+        }
+    }
+}
+
+// The queue the audio path used before: std::list behind a mutex. Counts
+// how often the lock was already held, which is what the ring removes.
+template <typename T>
+class LockedList {
+public:
+    bool Push(T&& item, size_t limit) {
+        std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+        Lock(lock);
+        if (list_.size() >= limit) {
+            return false;
+        }
+        list_.push_back(std::move(item));
+        return true;
+    }
+
+    bool Pop(T& item) {
+        std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+        Lock(lock);
+        if (list_.empty()) {
+            return false;
+        }
+        item = std::move(list_.front());
+        list_.pop_front();
+        return true;
+    }
+
+    uint64_t contended() const { return contended_; }
+
+private:
+    std::mutex mutex_;
+    std::list<T> list_;
+    std::atomic<uint64_t> contended_{0};
+
+    void Lock(std::unique_lock<std::mutex>& lock) {
+        if (!lock.try_lock()) {
+            contended_++;
+            lock.lock();
+        }
+    }
+};
+
+struct Packet {
+    std::vector<uint8_t> payload;
+    uint32_t timestamp = 0;
+};
+
+// One producer and one consumer moving packets, as the send and decode
+// queues do; returns the ns per item and how often either side found the
+// queue full or empty and had to retry
+template <typename Queue, typename PushFn, typename PopFn>
+double HandOver(Queue& queue, int items, PushFn push, PopFn pop, uint64_t* retries) {
+    std::atomic<uint64_t> spins{0};
+    int64_t start_us = esp_timer_get_time();
+    std::thread producer([&]() {
+        std::vector<uint8_t> payload(120, 0x55);
+        for (int i = 0; i < items; i++) {
+            Packet packet;
+            packet.payload = payload;
+            packet.timestamp = i;
+            while (!push(queue, packet)) {
+                spins++;
+                std::this_thread::yield();
+            }
+        }
+    });
+    int received = 0;
+    Packet packet;
+    while (received < items) {
+        if (pop(queue, packet)) {
+            received++;
+        } else {
+            spins++;
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    *retries = spins;
+    return (esp_timer_get_time() - start_us) * 1000.0 / items;
+}
+
+void BenchmarkAgainstLockedList() {
+    constexpr int kItems = 300000;
+    auto* ring = new BoundedRing<Packet, 64>();
+    LockedList<Packet> list;
+    uint64_t ring_retries = 0;
+    uint64_t list_retries = 0;
+
+    double ring_ns = HandOver(*ring, kItems,
+        [](BoundedRing<Packet, 64>& q, Packet& p) { return q.Push(std::move(p), 40, RingOverflow::kDropNewest); },
+        [](BoundedRing<Packet, 64>& q, Packet& p) { return q.TryPop(p); }, &ring_retries);
+    double list_ns = HandOver(list, kItems,
+        [](LockedList<Packet>& q, Packet& p) { return q.Push(std::move(p), 40); },
+        [](LockedList<Packet>& q, Packet& p) { return q.Pop(p); }, &list_retries);
+
+    printf("producer -> consumer per packet: ring %.0f ns (%llu retries), mutex+list %.0f ns (%llu retries, "
+           "%llu contended locks)\n", ring_ns, (unsigned long long)ring_retries, list_ns,
+           (unsigned long long)list_retries, (unsigned long long)list.contended());
+    CHECK(ring->empty());
+    delete ring;
+}
+
+} // namespace
+
+int main() {
+    TestFifoAndOverflow();
+    TestMpmcStress();
+    BenchmarkAgainstLockedList();
+    return HostTestResult("test_bounded_ring");
+}
@@ -0,0 +1,172 @@
+// CborWriter against the encoding examples of RFC 8949 Appendix A, and the
+// head-size boundaries at 23/24, 255/256, 65535/65536 and 2^32
+#include "cbor_writer.h"
+#include "host_test.h"
+
+#include <cstdio>
+#include <functional>
+#include <string>
+
+namespace {
+
+std::string Hex(const std::string& bytes) {
+    static const char kHex[] = "0123456789abcdef";
+    std::string hex;
+    for (unsigned char c : bytes) {
+        hex += kHex[c >> 4];
+        hex += kHex[c & 0xf];
+    }
+    return hex;
+}
+
+void Expect(const char* what, const std::function<void(CborWriter&)>& write, const std::string& expected_hex) {
+    std::string out;
+    CborWriter writer(out);
+    write(writer);
+    std::string actual = Hex(out);
+    if (actual != expected_hex) {
+        fprintf(stderr, "  %s: got %s, expected %s\n", what, actual.c_str(), expected_hex.c_str());
+    }
+    CHECK(actual == expected_hex);
+}
+
+void ExpectInt(int64_t value, const std::string& expected_hex) {
+    char what[32];
+    snprintf(what, sizeof(what), "%lld", (long long)value);
+    Expect(what, [value](CborWriter& w) { w.Int(value); }, expected_hex);
+}
+
+void TestIntegers() {
+    ExpectInt(0, "00");
+    ExpectInt(1, "01");
+    ExpectInt(10, "0a");
+    ExpectInt(23, "17");
+    ExpectInt(24, "1818");
+    ExpectInt(25, "1819");
+    ExpectInt(100, "1864");
+    ExpectInt(255, "18ff");
+    ExpectInt(256, "190100");
+    ExpectInt(1000, "1903e8");
+    ExpectInt(65535, "19ffff");
+    ExpectInt(65536, "1a00010000");
+    ExpectInt(1000000, "1a000f4240");
+    ExpectInt(4294967295LL, "1affffffff");
+    ExpectInt(4294967296LL, "1b0000000100000000");
+    ExpectInt(1000000000000LL, "1b000000e8d4a51000");
+    ExpectInt(INT64_MAX, "1b7fffffffffffffff");
+
+    ExpectInt(-1, "20");
+    ExpectInt(-10, "29");
+    ExpectInt(-24, "37");
+    ExpectInt(-25, "3818");
+    ExpectInt(-100, "3863");
+    ExpectInt(-256, "38ff");
+    ExpectInt(-257, "390100");
+    ExpectInt(-1000, "3903e7");
+    ExpectInt(-65536, "39ffff");
+    ExpectInt(-65537, "3a00010000");
+    ExpectInt(-4294967296LL, "3affffffff");
+    ExpectInt(-4294967297LL, "3b0000000100000000");
+    ExpectInt(INT64_MIN, "3b7fffffffffffffff");
+}
+
+void TestSimpleAndStrings() {
+    Expect("false", [](CborWriter& w) { w.Bool(false); }, "f4");
+    Expect("true", [](CborWriter& w) { w.Bool(true); }, "f5");
+
+    Expect("\"\"", [](CborWriter& w) { w.String(""); }, "60");
+    Expect("\"a\"", [](CborWriter& w) { w.String("a"); }, "6161");
+    Expect("\"IETF\"", [](CborWriter& w) { w.String("IETF"); }, "6449455446");
+    Expect("\"\\\"\\\\\"", [](CborWriter& w) { w.String("\"\\"); }, "62225c");
+    Expect("\"\\u00fc\"", [](CborWriter& w) { w.String("\xc3\xbc"); }, "62c3bc");
+    Expect("\"\\u6c34\"", [](CborWriter& w) { w.String("\xe6\xb0\xb4"); }, "63e6b0b4");
+    Expect("std::string with NUL", [](CborWriter& w) { w.String(std::string("a\0b", 3)); }, "63610062");
+
+    // Length heads at the same boundaries as integers
+    const struct {
+        size_t length;
+        const char* head;
+    } kLengths[] = {
+        {23, "77"}, {24, "7818"}, {255, "78ff"}, {256, "790100"}, {65535, "79ffff"}, {65536, "7a00010000"},
+    };
+    for (const auto& length : kLengths) {
+        std::string value(length.length, 'x');
+        std::string out;
+        CborWriter writer(out);
+        writer.String(value);
+        std::string head = Hex(out.substr(0, out.size() - length.length));
+        CHECK(head == length.head);
+        CHECK(out.compare(out.size() - length.length, length.length, value) == 0);
+    }
+}
+
+void TestContainers() {
+    Expect("[]", [](CborWriter& w) { w.Array(0); }, "80");
+    Expect("[1, 2, 3]", [](CborWriter& w) {
+        w.Array(3);
+        w.Int(1);
+        w.Int(2);
+        w.Int(3);
+    }, "83010203");
+    Expect("[1, [2, 3], [4, 5]]", [](CborWriter& w) {
+        w.Array(3);
+        w.Int(1);
+        w.Array(2);
+        w.Int(2);
+        w.Int(3);
+        w.Array(2);
+        w.Int(4);
+        w.Int(5);
+    }, "8301820203820405");
+    Expect("[1, ..., 25]", [](CborWriter& w) {
+        w.Array(25);
+        for (int i = 1; i <= 25; i++) {
+            w.Int(i);
+        }
+    }, "98190102030405060708090a0b0c0d0e0f101112131415161718181819");
+
+    Expect("{}", [](CborWriter& w) { w.Map(0); }, "a0");
+    Expect("{\"a\": 1, \"b\": [2, 3]}", [](CborWriter& w) {
+        w.Map(2);
+        w.String("a");
+        w.Int(1);
+        w.String("b");
+        w.Array(2);
+        w.Int(2);
+        w.Int(3);
+    }, "a26161016162820203");
+    Expect("[\"a\", {\"b\": \"c\"}]", [](CborWriter& w) {
+        w.Array(2);
+        w.String("a");
+        w.Map(1);
+        w.String("b");
+        w.String("c");
+    }, "826161a161626163");
+    Expect("{\"a\": \"A\", ..., \"e\": \"E\"}", [](CborWriter& w) {
+        w.Map(5);
+        for (char c = 'a'; c <= 'e'; c++) {
+            char key[2] = {c, 0};
+            char value[2] = {(char)(c - 'a' + 'A'), 0};
+            w.String(key);
+            w.String(value);
+        }
+    }, "a56161614161626142616361436164614461656145");
+
+    // Raw() splices a separately encoded item in unchanged
+    std::string item;
+    CborWriter(item).Int(1000);
+    Expect("[raw 1000, true]", [&](CborWriter& w) {
+        w.Array(2);
+        w.Raw(item);
+        w.Bool(true);
+    }, "821903e8f5");
+}
+
+} // namespace
+
+int main() {
+    TestIntegers();
+    TestSimpleAndStrings();
+    TestContainers();
+    return HostTestResult("test_cbor_writer");
+}
@@ -0,0 +1,201 @@
+// GifBundle against synthetic bundles: index lookups, positioned reads,
+// Load(), and rejection of missing, short and inconsistent files
+#include "animation/gif_bundle.h"
+#include "host_test.h"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BundleFile {
+    std::string name;
+    std::vector<uint8_t> payload;
+    uint16_t width;
+    uint16_t height;
+};
+
+void PutLe32(std::vector<uint8_t>& out, size_t at, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        out[at + i] = (uint8_t)(value >> (8 * i));
+    }
+}
+
+void PutLe16(std::vector<uint8_t>& out, size_t at, uint16_t value) {
+    out[at] = (uint8_t)value;
+    out[at + 1] = (uint8_t)(value >> 8);
+}
+
+// Lays files out the way the bundle tool does: header, table, then each
+// payload behind the 0x5A5A magic
+std::vector<uint8_t> BuildBundle(const std::vector<BundleFile>& files) {
+    size_t data_length = 0;
+    for (const auto& file : files) {
+        data_length += 2 + file.payload.size();
+    }
+    std::vector<uint8_t> bundle(12 + files.size() * 44 + data_length, 0);
+    PutLe32(bundle, 0, (uint32_t)files.size());
+    PutLe32(bundle, 4, 0x12345678);
+    PutLe32(bundle, 8, (uint32_t)data_length);
+
+    size_t table = 12;
+    size_t data_start = 12 + files.size() * 44;
+    size_t offset = 0;
+    for (const auto& file : files) {
+        memcpy(&bundle[table], file.name.data(), std::min<size_t>(file.name.size(), 32));
+        PutLe32(bundle, table + 32, (uint32_t)file.payload.size());
+        PutLe32(bundle, table + 36, (uint32_t)offset);
+        PutLe16(bundle, table + 40, file.width);
+        PutLe16(bundle, table + 42, file.height);
+        bundle[data_start + offset] = 0x5A;
+        bundle[data_start + offset + 1] = 0x5A;
+        memcpy(&bundle[data_start + offset + 2], file.payload.data(), file.payload.size());
+        table += 44;
+        offset += 2 + file.payload.size();
+    }
+    return bundle;
+}
+
+std::string WriteTemp(const std::vector<uint8_t>& data) {
+    char path[] = "/tmp/gif_bundle_XXXXXX";
+    int fd = mkstemp(path);
+    CHECK(fd >= 0);
+    CHECK(write(fd, data.data(), data.size()) == (ssize_t)data.size());
+    close(fd);
+    return path;
+}
+
+std::vector<uint8_t> Payload(size_t size, uint8_t seed) {
+    std::vector<uint8_t> payload(size);
+    for (size_t i = 0; i < size; i++) {
+        payload[i] = (uint8_t)(seed + i * 7);
+    }
+    return payload;
+}
+
+void TestLookups() {
+    std::vector<BundleFile> files;
+    const char* names[] = {"normal.gif", "happy.gif", "sad.gif", "thinking.gif", "sleepy.gif"};
+    for (int i = 0; i < 5; i++) {
+        files.push_back({names[i], Payload(100 + i * 997, (uint8_t)i), (uint16_t)(240 + i), (uint16_t)(320 + i)});
+    }
+    // A name that fills all 32 bytes, without a terminator
+    files.push_back({std::string(28, 'x') + ".gif", Payload(64, 99), 1, 2});
+    files.push_back({"empty.gif", {}, 0, 0});
+    std::string path = WriteTemp(BuildBundle(files));
+
+    GifBundle bundle;
+    CHECK(bundle.Open(path.c_str()) == GifBundle::OpenResult::kOk);
+    CHECK(bundle.IsOpen());
+    CHECK_EQ(bundle.file_count(), files.size());
+    CHECK(bundle.path() == path);
+
+    for (const auto& file : files) {
+        const GifBundle::Entry* entry = bundle.Find(file.name.c_str());
+        CHECK(entry != nullptr);
+        if (entry == nullptr) {
+            continue;
+        }
+        CHECK_EQ(entry->size, file.payload.size());
+        CHECK_EQ(entry->width, file.width);
+        CHECK_EQ(entry->height, file.height);
+
+        std::vector<uint8_t> read(entry->size + 1, 0xEE);
+        CHECK(bundle.Read(*entry, read.data()));
+        // Exactly entry->size bytes, nothing past them
+        CHECK(read.back() == 0xEE);
+        read.pop_back();
+        CHECK(read == file.payload);
+
+        size_t size = 0;
+        uint8_t* loaded = bundle.Load(file.name.c_str(), &size);
+        if (file.payload.empty()) {
+            CHECK(loaded == nullptr);
+        } else {
+            CHECK(loaded != nullptr && size == file.payload.size() &&
+                  memcmp(loaded, file.payload.data(), size) == 0);
+        }
+        free(loaded);
+    }
+
+    // Exact names only
+    CHECK(bundle.Find("missing.gif") == nullptr);
+    CHECK(bundle.Find("normal") == nullptr);
+    CHECK(bundle.Find("NORMAL.GIF") == nullptr);
+    CHECK(bundle.Find("") == nullptr);
+    CHECK(bundle.Load("missing.gif", nullptr) == nullptr);
+
+    // Reopening replaces the index
+    std::string other = WriteTemp(BuildBundle({{"other.gif", Payload(10, 1), 8, 8}}));
+    CHECK(bundle.Open(other.c_str()) == GifBundle::OpenResult::kOk);
+    CHECK_EQ(bundle.file_count(), 1);
+    CHECK(bundle.Find("normal.gif") == nullptr);
+    CHECK(bundle.Find("other.gif") != nullptr);
+
+    bundle.Close();
+    CHECK(!bundle.IsOpen());
+    CHECK_EQ(bundle.file_count(), 0);
+    uint8_t byte;
+    GifBundle::Entry entry = {12, 1, 0, 0};
+    CHECK(!bundle.Read(entry, &byte));
+    unlink(path.c_str());
+    unlink(other.c_str());
+}
+
+void TestRejectsBadFiles() {
+    GifBundle bundle;
+    CHECK(bundle.Open("/tmp/gif_bundle_does_not_exist") == GifBundle::OpenResult::kNotFound);
+
+    std::vector<uint8_t> good = BuildBundle({{"a.gif", Payload(50, 1), 1, 1}, {"b.gif", Payload(70, 2), 1, 1}});
+
+    std::string path = WriteTemp(std::vector<uint8_t>(good.begin(), good.begin() + 8));
+    CHECK(bundle.Open(path.c_str()) == GifBundle::OpenResult::kBadHeader);
+    unlink(path.c_str());
+
+    // The table runs past the end of the file
+    std::vector<uint8_t> truncated(good.begin(), good.begin() + 12 + 44 + 20);
+    path = WriteTemp(truncated);
+    CHECK(bundle.Open(path.c_str()) == GifBundle::OpenResult::kBadTable);
+    unlink(path.c_str());
+
+    // A file count that would make the table larger than any file
+    std::vector<uint8_t> huge_count = good;
+    PutLe32(huge_count, 0, 0xFFFFFFFF);
+    path = WriteTemp(huge_count);
+    CHECK(bundle.Open(path.c_str()) == GifBundle::OpenResult::kBadTable);
+    unlink(path.c_str());
+
+    // The last payload is cut short
+    path = WriteTemp(std::vector<uint8_t>(good.begin(), good.end() - 1));
+    CHECK(bundle.Open(path.c_str()) == GifBundle::OpenResult::kBadTable);
+    CHECK(!bundle.IsOpen());
+    CHECK_EQ(bundle.file_count(), 0);
+    unlink(path.c_str());
+
+    // An offset pointing past the end
+    std::vector<uint8_t> bad_offset = good;
+    PutLe32(bad_offset, 12 + 36, 0x7FFFFFF0);
+    path = WriteTemp(bad_offset);
+    CHECK(bundle.Open(path.c_str()) == GifBundle::OpenResult::kBadTable);
+    unlink(path.c_str());
+
+    // An empty bundle is valid
+    path = WriteTemp(BuildBundle({}));
+    CHECK(bundle.Open(path.c_str()) == GifBundle::OpenResult::kOk);
+    CHECK_EQ(bundle.file_count(), 0);
+    unlink(path.c_str());
+}
+
+} // namespace
+
+int main() {
+    TestLookups();
+    TestRejectsBadFiles();
+    return HostTestResult("test_gif_bundle");
+}
@@ -0,0 +1,99 @@
+// iot::Property state output: string values with quotes, backslashes and
+// control characters still give valid JSON that cJSON reads back unchanged
+#include "iot/thing.h"
+#include "host_test.h"
+
+#include <cstdio>
+#include <functional>
+#include <string>
+
+namespace {
+
+// Parses {<fragment>} and returns the string value of key, or "<invalid>"
+std::string ReadBack(const std::string& fragment, const char* key) {
+    std::string json = "{" + fragment + "}";
+    cJSON* root = cJSON_Parse(json.c_str());
+    if (root == nullptr) {
+        fprintf(stderr, "  not JSON: %s\n", json.c_str());
+        return "<invalid>";
+    }
+    auto item = cJSON_GetObjectItem(root, key);
+    std::string value = cJSON_IsString(item) ? item->valuestring : "<invalid>";
+    cJSON_Delete(root);
+    return value;
+}
+
+void TestStringValuesEscaped() {
+    const std::string kValues[] = {
+        "plain",
+        "",
+        "say \"hi\"",
+        "C:\\music\\",
+        "two\nlines\r\n",
+        "tab\there",
+        std::string("bell\x07 and escape\x1b"),
+        "\xe5\xb0\x8f\xe6\x99\xba \xf0\x9f\x98\x8a",
+        "\"}, \"injected\": true, \"x\": \"",
+    };
+    for (const auto& value : kValues) {
+        iot::Property property("title", "", [value]() { return value; });
+        CHECK(property.Sample());
+
+        std::string fragment;
+        property.AppendSampleJson(fragment);
+        CHECK(ReadBack(fragment, "title") == value);
+        CHECK(ReadBack("\"title\":" + property.GetStateJson(), "title") == value);
+
+        // Nothing below 0x20 is left raw in the output
+        bool raw_control = false;
+        for (char c : fragment) {
+            raw_control |= (unsigned char)c < 0x20;
+        }
+        CHECK(!raw_control);
+    }
+
+    // An injected key stays inside the string
+    iot::Property property("title", "", []() { return std::string("\", \"injected\": \"1"); });
+    property.Sample();
+    std::string fragment;
+    property.AppendSampleJson(fragment);
+    cJSON* root = cJSON_Parse(("{" + fragment + "}").c_str());
+    CHECK(root != nullptr && cJSON_GetObjectItem(root, "injected") == nullptr);
+    cJSON_Delete(root);
+}
+
+void TestOtherTypesAndCbor() {
+    int volume = 70;
+    iot::Property number("volume", "", std::function<int()>([&volume]() { return volume; }));
+    iot::Property flag("muted", "", std::function<bool()>([]() { return true; }));
+    iot::Property text("song", "", []() { return std::string("a\"b"); });
+    CHECK(number.Sample());
+    CHECK(!number.Sample());
+    volume = -3;
+    CHECK(number.Sample());
+    flag.Sample();
+    text.Sample();
+
+    std::string json;
+    number.AppendSampleJson(json);
+    json += ",";
+    flag.AppendSampleJson(json);
+    json += ",";
+    text.AppendSampleJson(json);
+    CHECK(json == "\"volume\":-3,\"muted\":true,\"song\":\"a\\\"b\"");
+
+    // CBOR strings carry their length, so they need no escaping
+    std::string cbor;
+    CborWriter writer(cbor);
+    text.WriteSampleCbor(writer);
+    number.WriteSampleCbor(writer);
+    CHECK(cbor == std::string("\x64song\x63" "a\"b" "\x66volume\x22", 17));
+}
+
+} // namespace
+
+int main() {
+    TestStringValuesEscaped();
+    TestOtherTypesAndCbor();
+    return HostTestResult("test_iot_property");
+}
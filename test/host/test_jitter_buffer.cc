@@ -0,0 +1,133 @@
+// JitterBuffer: reordering and late frames, and a sender that restarts its
+// sequence numbers without a Reset() - with a clock timestamp, with the
+// timestamp reset to 0, and without timestamps at all
+#include "jitter_buffer.h"
+#include "host_test.h"
+
+#include <cstdio>
+
+namespace {
+
+constexpr int kFrameMs = 60;
+
+// One 60 ms frame whose first payload byte carries the sequence
+AudioStreamPacket Frame(uint32_t sequence, uint32_t timestamp, int64_t arrival_us) {
+    AudioStreamPacket packet;
+    packet.sample_rate = 24000;
+    packet.frame_duration = kFrameMs;
+    packet.sequence = sequence;
+    packet.timestamp = timestamp;
+    packet.arrival_us = arrival_us;
+    packet.payload.resize(1);
+    packet.payload[0] = (uint8_t)sequence;
+    return packet;
+}
+
+// Feeds frames first..last, arriving on time, and plays each one out
+void PlayStream(JitterBuffer& buffer, uint32_t first, uint32_t last, uint32_t first_timestamp, int64_t& now_us) {
+    for (uint32_t sequence = first; sequence <= last; sequence++) {
+        uint32_t timestamp = first_timestamp == 0 ? 0 : first_timestamp + (sequence - first) * kFrameMs;
+        buffer.Insert(Frame(sequence, timestamp, now_us), now_us);
+        now_us += kFrameMs * 1000;
+        AudioStreamPacket packet;
+        CHECK(buffer.Next(packet, now_us) == JitterBuffer::Action::kDecode);
+        CHECK_EQ(packet.sequence, sequence);
+    }
+}
+
+void TestReorderAndLate() {
+    JitterBuffer buffer;
+    int64_t now_us = 1000000;
+    PlayStream(buffer, 1, 10, 60, now_us);
+
+    // 12 before 11 is reordering, not loss
+    buffer.Insert(Frame(12, 720, now_us), now_us);
+    buffer.Insert(Frame(11, 660, now_us), now_us);
+    AudioStreamPacket packet;
+    now_us += kFrameMs * 1000;
+    CHECK(buffer.Next(packet, now_us) == JitterBuffer::Action::kDecode && packet.sequence == 11);
+    CHECK(buffer.Next(packet, now_us) == JitterBuffer::Action::kDecode && packet.sequence == 12);
+
+    // Frames behind playout with timestamps that fit are late, even the
+    // newest one sent again
+    buffer.Insert(Frame(9, 540, now_us), now_us);
+    buffer.Insert(Frame(3, 180, now_us), now_us);
+    buffer.Insert(Frame(12, 720, now_us), now_us);
+    auto stats = buffer.GetStats();
+    CHECK_EQ(stats.late, 3);
+    CHECK_EQ(stats.resyncs, 0);
+    CHECK_EQ(stats.played, 12);
+}
+
+// A sender restarting at 1 after frames 1..10 without a Reset(); returns the
+// frames of the new stream that were played
+int RestartAndCount(uint32_t old_timestamp, uint32_t new_timestamp, JitterBuffer::Stats* stats) {
+    JitterBuffer buffer;
+    int64_t now_us = 1000000;
+    PlayStream(buffer, 1, 10, old_timestamp, now_us);
+
+    int played = 0;
+    for (uint32_t sequence = 1; sequence <= 16; sequence++) {
+        uint32_t timestamp = new_timestamp == 0 ? 0 : new_timestamp + (sequence - 1) * kFrameMs;
+        buffer.Insert(Frame(sequence, timestamp, now_us), now_us);
+        now_us += kFrameMs * 1000;
+        AudioStreamPacket packet;
+        while (buffer.Next(packet, now_us) == JitterBuffer::Action::kDecode) {
+            if (packet.payload.size() == 1 && packet.payload[0] == (uint8_t)packet.sequence) {
+                played++;
+            }
+        }
+    }
+    *stats = buffer.GetStats();
+    return played;
+}
+
+void TestSenderRestart() {
+    JitterBuffer::Stats stats;
+
+    // Clock timestamps keep going: the new frames are newer than anything seen
+    int played = RestartAndCount(1000000, 1000000 + 10 * kFrameMs + 2000, &stats);
+    printf("restart, clock timestamps: %d of 16 played, %u late, %u resyncs\n", played, (unsigned)stats.late,
+           (unsigned)stats.resyncs);
+    CHECK_EQ(played, 16);
+    CHECK_EQ(stats.late, 0);
+    CHECK_EQ(stats.resyncs, 1);
+
+    // Timestamps reset too, from far into the session: further behind than
+    // nine frames can be
+    played = RestartAndCount(600000, 60, &stats);
+    CHECK_EQ(played, 16);
+    CHECK_EQ(stats.late, 0);
+    CHECK_EQ(stats.resyncs, 1);
+
+    // Without timestamps a restart cannot be told from late frames: the first
+    // ten are dropped, the rest continue the old numbering
+    played = RestartAndCount(0, 0, &stats);
+    printf("restart, no timestamps: %d of 16 played, %u late, %u resyncs\n", played, (unsigned)stats.late,
+           (unsigned)stats.resyncs);
+    CHECK_EQ(played, 6);
+    CHECK_EQ(stats.late, 10);
+    CHECK_EQ(stats.resyncs, 0);
+}
+
+void TestJumpAhead() {
+    JitterBuffer buffer;
+    int64_t now_us = 1000000;
+    PlayStream(buffer, 1, 10, 60, now_us);
+    // A jump of RESYNC_FRAMES restarts from the new frame
+    buffer.Insert(Frame(11 + JITTER_BUFFER_RESYNC_FRAMES, 5000, now_us), now_us);
+    now_us += kFrameMs * 1000;
+    AudioStreamPacket packet;
+    CHECK(buffer.Next(packet, now_us) == JitterBuffer::Action::kDecode);
+    CHECK_EQ(packet.sequence, 11 + JITTER_BUFFER_RESYNC_FRAMES);
+    CHECK_EQ(buffer.GetStats().resyncs, 1);
+}
+
+} // namespace
+
+int main() {
+    TestReorderAndLate();
+    TestSenderRestart();
+    TestJumpAhead();
+    return HostTestResult("test_jitter_buffer");
+}
@@ -0,0 +1,198 @@
+// JsonDispatcher: ScanType on nested, escaped, spaced and truncated input,
+// routing, and parse+dispatch time against parse-then-strcmp-chain
+#include "protocols/json_dispatcher.h"
+#include "host_test.h"
+
+#include <esp_timer.h>
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The types the primary protocol handles, in the order the old if/else
+// chains compared them
+const char* const kTypes[] = {
+    "hello", "goodbye", "ws_start", "remote_anim_update", "wifi_reconfig_nimble", "wifi_clear_credential",
+    "switch_wifi_to", "tts", "stt", "llm", "mcp", "iot", "listen", "system", "alert", "play_url",
+    "adjust_volume", "custom",
+};
+
+std::string Scan(const std::string& json) {
+    const char* type = nullptr;
+    size_t length = 0;
+    if (!JsonDispatcher::ScanType(json.data(), json.size(), &type, &length)) {
+        return "<none>";
+    }
+    return std::string(type, length);
+}
+
+void TestScanType() {
+    CHECK(Scan(R"({"type":"tts","state":"start"})") == "tts");
+    CHECK(Scan(R"({"session_id":"abc","type":"llm"})") == "llm");
+    CHECK(Scan(" \r\n\t{ \"type\" :\n \"listen\" }") == "listen");
+    CHECK(Scan(R"({"type":""})") == "");
+
+    // Nested "type" keys belong to other objects
+    CHECK(Scan(R"({"payload":{"type":"inner"},"type":"mcp"})") == "mcp");
+    CHECK(Scan(R"({"list":[{"type":"a"},{"type":"b"}],"type":"iot"})") == "iot");
+    CHECK(Scan(R"({"payload":{"type":"inner"}})") == "<none>");
+    CHECK(Scan(R"([{"type":"tts"}])") == "<none>");
+
+    // "type" as a value, or inside another key or value, is not the key
+    CHECK(Scan(R"({"kind":"type","type":"stt"})") == "stt");
+    CHECK(Scan(R"({"a":"x\",\"type\":\"fake","type":"real"})") == "real");
+    CHECK(Scan(R"({"types":"x","type":"alert"})") == "alert");
+    CHECK(Scan(R"({"a":"}{[","type":"system"})") == "system");
+
+    // Escaped values are left to cJSON
+    CHECK(Scan(R"({"type":"t\"ts"})") == "<none>");
+    CHECK(Scan(R"({"type":"t\u0074s"})") == "<none>");
+    CHECK(Scan(R"({"text":"say \"hi\"","type":"stt"})") == "stt");
+
+    // Not a string
+    CHECK(Scan(R"({"type":1})") == "<none>");
+    CHECK(Scan(R"({"type":null,"x":"tts"})") == "<none>");
+
+    // Truncated anywhere before the closing quote of the value
+    std::string full = R"({"state":"start","type":"tts"})";
+    size_t value_end = full.rfind('"');
+    for (size_t length = 0; length < value_end + 1; length++) {
+        const char* type = nullptr;
+        size_t type_length = 0;
+        CHECK(!JsonDispatcher::ScanType(full.data(), length, &type, &type_length));
+    }
+    CHECK(Scan(full.substr(0, value_end + 1)) == "tts");
+    CHECK(Scan("") == "<none>");
+    CHECK(Scan("not json") == "<none>");
+}
+
+void TestRouting() {
+    JsonDispatcher dispatcher;
+    std::vector<std::string> calls;
+    dispatcher.On("tts", [&](const cJSON* root) {
+        auto state = cJSON_GetObjectItem(root, "state");
+        calls.push_back(std::string("tts ") + (cJSON_IsString(state) ? state->valuestring : "?"));
+    });
+    dispatcher.On("ping", [&](const cJSON* root) {
+        calls.push_back(root == nullptr ? "ping" : "ping parsed");
+    }, false);
+    dispatcher.OnUnhandled([&](const cJSON* root) {
+        calls.push_back(std::string("unhandled ") + cJSON_GetObjectItem(root, "type")->valuestring);
+        return true;
+    });
+
+    auto send = [&](const std::string& json) {
+        return dispatcher.Dispatch(json.data(), json.size());
+    };
+    auto before = JsonDispatcher::GetStats();
+    CHECK(send(R"({"type":"tts","state":"start"})"));
+    CHECK(send(R"({"type":"ping"})"));
+    // A handler without needs_root runs even if the rest does not parse
+    CHECK(send(R"({"type":"ping",)"));
+    CHECK(send(R"({"type":"other"})"));
+    // Escaped type: found by cJSON instead
+    CHECK(send(R"({"type":"t\u0074s","state":"stop"})"));
+    CHECK(!send(R"({"type":"tts","state":)"));
+    CHECK(!send(R"({"state":"start"})"));
+    auto after = JsonDispatcher::GetStats();
+
+    std::vector<std::string> expected = {"tts start", "ping", "ping", "unhandled other", "tts stop"};
+    CHECK(calls == expected);
+    CHECK_EQ(after.messages - before.messages, 7);
+    CHECK_EQ(after.parsed - before.parsed, 4);
+}
+
+// What every message went through before: a full parse, then strcmp down
+// the chain
+bool LegacyDispatch(const char* json, size_t length, int* hits) {
+    cJSON* root = cJSON_ParseWithLength(json, length);
+    if (root == nullptr) {
+        return false;
+    }
+    auto type = cJSON_GetObjectItem(root, "type");
+    bool ok = cJSON_IsString(type);
+    if (ok) {
+        for (size_t i = 0; i < sizeof(kTypes) / sizeof(kTypes[0]); i++) {
+            if (strcmp(type->valuestring, kTypes[i]) == 0) {
+                hits[i]++;
+                break;
+            }
+        }
+    }
+    cJSON_Delete(root);
+    return ok;
+}
+
+void BenchmarkAgainstStrcmpChain() {
+    constexpr int kRounds = 20000;
+    // A conversation turn as the device sees it
+    const std::vector<std::string> messages = {
+        R"({"type":"tts","state":"start","session_id":"f1e2d3c4"})",
+        R"({"type":"stt","text":"what is the weather like tomorrow","session_id":"f1e2d3c4"})",
+        R"({"type":"llm","emotion":"happy","text":"😊","session_id":"f1e2d3c4"})",
+        R"({"type":"tts","state":"sentence_start","text":"Tomorrow will be sunny with a high of 24 degrees.","session_id":"f1e2d3c4"})",
+        R"({"type":"tts","state":"stop","session_id":"f1e2d3c4"})",
+        R"({"session_id":"f1e2d3c4","type":"mcp","payload":{"jsonrpc":"2.0","id":7,"method":"tools/call","params":{"name":"self.audio_speaker.set_volume","arguments":{"volume":60}}}})",
+        R"({"type":"remote_anim_update"})",
+        R"({"type":"listen","state":"start","mode":"auto"})",
+    };
+
+    JsonDispatcher dispatcher;
+    int hits[sizeof(kTypes) / sizeof(kTypes[0])] = {};
+    for (size_t i = 0; i < sizeof(kTypes) / sizeof(kTypes[0]); i++) {
+        bool needs_root = strcmp(kTypes[i], "remote_anim_update") != 0;
+        dispatcher.On(kTypes[i], [&hits, i](const cJSON*) { hits[i]++; }, needs_root);
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    for (int round = 0; round < kRounds; round++) {
+        for (const auto& message : messages) {
+            dispatcher.Dispatch(message.data(), message.size());
+        }
+    }
+    int64_t dispatcher_us = esp_timer_get_time() - start_us;
+
+    start_us = esp_timer_get_time();
+    for (int round = 0; round < kRounds; round++) {
+        for (const auto& message : messages) {
+            LegacyDispatch(message.data(), message.size(), hits);
+        }
+    }
+    int64_t legacy_us = esp_timer_get_time() - start_us;
+
+    // The one message whose handler does not need the tree
+    const std::string& ping = messages[6];
+    start_us = esp_timer_get_time();
+    for (int round = 0; round < kRounds; round++) {
+        dispatcher.Dispatch(ping.data(), ping.size());
+    }
+    int64_t unparsed_us = esp_timer_get_time() - start_us;
+    start_us = esp_timer_get_time();
+    for (int round = 0; round < kRounds; round++) {
+        LegacyDispatch(ping.data(), ping.size(), hits);
+    }
+    int64_t unparsed_legacy_us = esp_timer_get_time() - start_us;
+
+    int total = 0;
+    for (int count : hits) {
+        total += count;
+    }
+    CHECK_EQ(total, 2 * kRounds * ((int)messages.size() + 1));
+
+    double count = (double)kRounds * messages.size();
+    printf("parse+dispatch per message: dispatcher %.0f ns, parse and strcmp chain %.0f ns\n",
+           dispatcher_us * 1000.0 / count, legacy_us * 1000.0 / count);
+    printf("remote_anim_update alone: dispatcher %.0f ns, parse and strcmp chain %.0f ns\n",
+           unparsed_us * 1000.0 / kRounds, unparsed_legacy_us * 1000.0 / kRounds);
+}
+
+} // namespace
+
+int main() {
+    TestScanType();
+    TestRouting();
+    BenchmarkAgainstStrcmpChain();
+    return HostTestResult("test_json_dispatcher");
+}
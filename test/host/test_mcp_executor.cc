@@ -0,0 +1,197 @@
+// McpExecutor: queue limits, lane independence, cancellation, and 100
+// concurrent tool calls per round without heap growth
+#include "mcp_server.h"
+#include "host_test.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#include <malloc.h>
+
+#include <atomic>
+#include <cstdio>
+#include <future>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<int> replies{0};
+std::atomic<int> error_replies{0};
+
+struct Gate {
+    std::promise<void> promise;
+    std::shared_future<void> future = promise.get_future().share();
+};
+
+McpExecutor::Call MakeCall(int id, McpTool* tool) {
+    McpExecutor::Call call;
+    call.id = id;
+    call.tool = tool;
+    return call;
+}
+
+// Polls until `done` holds or a second has passed
+template <typename Predicate>
+bool WaitFor(Predicate done) {
+    int64_t deadline = esp_timer_get_time() + 1000000;
+    while (!done()) {
+        if (esp_timer_get_time() > deadline) {
+            return false;
+        }
+        vTaskDelay(1);
+    }
+    return true;
+}
+
+size_t HeapInUse() {
+    return mallinfo2().uordblks;
+}
+
+void TestQueueLimitAndLanes(McpExecutor& executor) {
+    Gate gate;
+    std::atomic<bool> started{false};
+    McpTool blocking("self.test.blocking", "", PropertyList(), [&](const PropertyList&) -> ReturnValue {
+        started = true;
+        gate.future.wait();
+        return true;
+    });
+    McpTool quick("self.test.quick", "", PropertyList(), [](const PropertyList&) -> ReturnValue {
+        return 1;
+    });
+
+    int before = replies;
+    CHECK(executor.Submit(MakeCall(1, &blocking), kMcpStackSmall));
+    CHECK(WaitFor([&]() { return started.load(); }));
+    for (int i = 0; i < MCP_EXECUTOR_QUEUE_DEPTH; i++) {
+        CHECK(executor.Submit(MakeCall(10 + i, &quick), kMcpStackSmall));
+    }
+    // The small lane is full; the large lane is not held up by it
+    CHECK(!executor.Submit(MakeCall(20, &quick), kMcpStackSmall));
+    CHECK(executor.Submit(MakeCall(21, &quick), kMcpStackLarge));
+    CHECK(WaitFor([&]() { return replies - before == 1; }));
+
+    gate.promise.set_value();
+    CHECK(WaitFor([&]() { return replies - before == 2 + MCP_EXECUTOR_QUEUE_DEPTH; }));
+}
+
+void TestErrorReply(McpExecutor& executor) {
+    McpTool failing("self.test.failing", "", PropertyList(), [](const PropertyList&) -> ReturnValue {
+        throw std::runtime_error("no camera");
+    });
+    int before = error_replies;
+    CHECK(executor.Submit(MakeCall(30, &failing), kMcpStackSmall));
+    CHECK(WaitFor([&]() { return error_replies - before == 1; }));
+}
+
+void TestCancelPending(McpExecutor& executor) {
+    Gate gate;
+    std::atomic<bool> started{false};
+    McpTool blocking("self.test.blocking", "", PropertyList(), [&](const PropertyList&) -> ReturnValue {
+        started = true;
+        gate.future.wait();
+        return true;
+    });
+    McpTool quick("self.test.quick", "", PropertyList(), [](const PropertyList&) -> ReturnValue {
+        return 1;
+    });
+
+    int before = replies;
+    CHECK(executor.Submit(MakeCall(40, &blocking), kMcpStackSmall));
+    CHECK(WaitFor([&]() { return started.load(); }));
+    for (int i = 0; i < 3; i++) {
+        CHECK(executor.Submit(MakeCall(41 + i, &quick), kMcpStackSmall));
+    }
+    executor.CancelPending();
+    // Calls of the new session still run
+    CHECK(executor.Submit(MakeCall(50, &quick), kMcpStackLarge));
+    gate.promise.set_value();
+
+    CHECK(WaitFor([&]() { return replies - before == 1; }));
+    vTaskDelay(20);
+    CHECK_EQ(replies - before, 1);
+    CHECK(executor.GetStatsJson().find("\"cancelled\":4") != std::string::npos);
+}
+
+// Ten threads submit `calls` tool calls at once, split over both lanes;
+// returns the number rejected because a queue was full
+int ConcurrentBurst(McpExecutor& executor, McpTool& small, McpTool& large, int calls) {
+    constexpr int kThreads = 10;
+    std::atomic<int> rejected{0};
+    int before = replies;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t]() {
+            for (int i = 0; i < calls / kThreads; i++) {
+                bool use_large = i % 3 == 0;
+                McpExecutor::Call call = MakeCall(t * 1000 + i, use_large ? &large : &small);
+                call.arguments.AddProperty(Property("value", kPropertyTypeInteger, i));
+                if (!executor.Submit(std::move(call), use_large ? kMcpStackLarge : kMcpStackSmall)) {
+                    rejected++;
+                }
+                std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(WaitFor([&]() { return replies - before + rejected == calls; }));
+    return rejected;
+}
+
+void TestConcurrentCallsDoNotGrowHeap(McpExecutor& executor) {
+    constexpr int kCalls = 100;
+    constexpr int kRounds = 50;
+    McpTool small("self.test.small", "", PropertyList(), [](const PropertyList& arguments) -> ReturnValue {
+        return std::string("value ") + std::to_string(arguments["value"].value<int>());
+    });
+    McpTool large("self.test.large", "", PropertyList(), [](const PropertyList&) -> ReturnValue {
+        return true;
+    });
+
+    // Warm up: per-tool stats entries, thread arenas, stdio buffers
+    for (int i = 0; i < 3; i++) {
+        ConcurrentBurst(executor, small, large, kCalls);
+    }
+
+    int replies_before = replies;
+    int rejected = 0;
+    size_t heap_before = HeapInUse();
+    for (int round = 0; round < kRounds; round++) {
+        rejected += ConcurrentBurst(executor, small, large, kCalls);
+    }
+    size_t heap_after = HeapInUse();
+    int answered = replies - replies_before;
+
+    printf("%d rounds of %d concurrent calls: %d replies, %d rejected as busy; heap in use %zu -> %zu bytes\n",
+           kRounds, kCalls, answered, rejected, heap_before, heap_after);
+    printf("%s\n", executor.GetStatsJson().c_str());
+
+    CHECK_EQ(answered + rejected, kRounds * kCalls);
+    CHECK(answered > 0);
+    // Less than a byte per call: nothing is kept per call
+    CHECK(heap_after <= heap_before + 4096);
+}
+
+} // namespace
+
+int main() {
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    // Never destroyed: the host vTaskDelete cannot stop the worker threads
+    McpExecutor* executor = new McpExecutor([](int, bool error, const std::string&) {
+        if (error) {
+            error_replies++;
+        } else {
+            replies++;
+        }
+    });
+
+    TestQueueLimitAndLanes(*executor);
+    TestErrorReply(*executor);
+    TestCancelPending(*executor);
+    TestConcurrentCallsDoNotGrowHeap(*executor);
+    return HostTestResult("test_mcp_executor");
+}
@@ -0,0 +1,261 @@
+// SdLogSink under a log storm: hook latency stays bounded while the card
+// stalls, every line is written once and whole or counted as dropped, plus
+// truncation, unmounted cards and rotation. The old hook (mutex, then
+// fopen/fwrite/fflush/fclose per line) is timed for comparison.
+#include "sd_log_sink.h"
+#include "sd_card.h"
+#include "host_test.h"
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<bool> mounted{true};
+// How long the card "takes" per batch; the writer calls IsMounted() once
+// per batch, the producers never do
+std::atomic<int> card_stall_us{0};
+
+std::string temp_dir;
+
+std::string TempPath(const char* name) {
+    return temp_dir + "/" + name;
+}
+
+size_t FileSize(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0 ? (size_t)st.st_size : 0;
+}
+
+bool Exists(const std::string& path) {
+    struct stat st;
+    return stat(path.c_str(), &st) == 0;
+}
+
+std::vector<std::string> ReadLines(const std::string& path) {
+    std::vector<std::string> lines;
+    std::ifstream file(path);
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+struct Latency {
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t p999;
+    uint64_t max;
+};
+
+Latency Percentiles(std::vector<uint32_t>& samples) {
+    std::sort(samples.begin(), samples.end());
+    auto at = [&](double q) { return (uint64_t)samples[(size_t)(q * (samples.size() - 1))]; };
+    return {at(0.5), at(0.99), at(0.999), samples.back()};
+}
+
+// Runs `threads` producers logging `lines` lines each through `hook` and
+// returns the per-call latency in ns
+template <typename Hook>
+std::vector<uint32_t> Storm(int threads, int lines, Hook hook) {
+    std::vector<std::vector<uint32_t>> per_thread(threads);
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            auto& samples = per_thread[t];
+            samples.reserve(lines);
+            char line[128];
+            for (int i = 0; i < lines; i++) {
+                int len = snprintf(line, sizeof(line), "E (%d) storm: thread %d line %d of a burst of errors\n",
+                                   i, t, i);
+                auto start = std::chrono::steady_clock::now();
+                hook(line, (size_t)len);
+                auto elapsed = std::chrono::steady_clock::now() - start;
+                samples.push_back((uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+                if ((i & 7) == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    std::vector<uint32_t> all;
+    for (auto& samples : per_thread) {
+        all.insert(all.end(), samples.begin(), samples.end());
+    }
+    return all;
+}
+
+void TestStorm(int stall_us, const char* name) {
+    constexpr int kThreads = 4;
+    constexpr int kLines = 20000;
+    auto& sink = SdLogSink::GetInstance();
+    std::string path = TempPath(name);
+    CHECK(sink.Start(path.c_str(), 0, 0));
+    auto before = sink.GetStats();
+
+    card_stall_us = stall_us;
+    std::vector<uint32_t> samples = Storm(kThreads, kLines, [&](const char* line, size_t len) {
+        sink.Enqueue(line, len);
+    });
+    card_stall_us = 0;
+    sink.Stop();
+    auto after = sink.GetStats();
+
+    Latency latency = Percentiles(samples);
+    uint32_t enqueued = after.enqueued - before.enqueued;
+    uint32_t dropped = after.dropped - before.dropped;
+    printf("SdLogSink, card stalling %d us per batch: %u lines queued, %u dropped; Enqueue p50 %llu ns, "
+           "p99 %llu ns, p99.9 %llu ns, max %llu ns\n", stall_us, (unsigned)enqueued, (unsigned)dropped,
+           (unsigned long long)latency.p50, (unsigned long long)latency.p99, (unsigned long long)latency.p999,
+           (unsigned long long)latency.max);
+
+    CHECK_EQ(enqueued + dropped, kThreads * kLines);
+    if (stall_us > 0) {
+        CHECK(dropped > 0);
+    }
+    // Bounded by a copy into the ring, not by the card
+    CHECK(latency.p99 < 50000);
+    CHECK(latency.p999 < 1000000);
+
+    // Every queued line reached the file once, whole and in order per thread
+    std::vector<std::string> lines = ReadLines(path);
+    CHECK_EQ(lines.size(), enqueued);
+    CHECK_EQ(FileSize(path), after.bytes_written - before.bytes_written);
+    std::vector<int> last(kThreads, -1);
+    int malformed = 0;
+    for (const auto& line : lines) {
+        int seq = 0;
+        int thread = 0;
+        int index = 0;
+        if (sscanf(line.c_str(), "E (%d) storm: thread %d line %d of a burst of errors", &seq, &thread, &index) != 3 ||
+            thread < 0 || thread >= kThreads || index <= last[thread] || seq != index) {
+            malformed++;
+            continue;
+        }
+        last[thread] = index;
+    }
+    CHECK_EQ(malformed, 0);
+}
+
+void TestTruncationAndUnmountedCard() {
+    auto& sink = SdLogSink::GetInstance();
+    std::string path = TempPath("short.txt");
+    CHECK(sink.Start(path.c_str(), 0, 0));
+    auto before = sink.GetStats();
+
+    std::string long_line(300, 'x');
+    CHECK(sink.Enqueue(long_line.data(), long_line.size()));
+    sink.Flush();
+    CHECK_EQ(sink.GetStats().truncated - before.truncated, 1);
+    std::vector<std::string> lines = ReadLines(path);
+    CHECK_EQ(lines.size(), 1);
+    // Cut to a slot, still ending in a newline
+    CHECK_EQ(FileSize(path), 256);
+
+    // Without a card, batches are discarded rather than held
+    mounted = false;
+    CHECK(sink.Enqueue("W (1) lost\n", 11));
+    sink.Flush();
+    mounted = true;
+    CHECK(sink.Enqueue("W (2) kept\n", 11));
+    sink.Stop();
+    lines = ReadLines(path);
+    CHECK(lines.size() == 2 && lines[1] == "W (2) kept");
+
+    // A stopped sink refuses lines
+    CHECK(!sink.Enqueue("W (3) late\n", 11));
+}
+
+void TestRotation() {
+    auto& sink = SdLogSink::GetInstance();
+    std::string path = TempPath("err.txt");
+    CHECK(sink.Start(path.c_str(), 1000, 2));
+    auto before = sink.GetStats();
+    char line[64];
+    for (int i = 0; i < 100; i++) {
+        int len = snprintf(line, sizeof(line), "E (%d) rotation test line, fifty bytes long...\n", i);
+        CHECK(sink.Enqueue(line, (size_t)len));
+        if (i % 10 == 9) {
+            sink.Flush();
+        }
+    }
+    sink.Stop();
+    auto after = sink.GetStats();
+
+    CHECK(after.rotations - before.rotations >= 2);
+    CHECK(Exists(TempPath("err.1.txt")));
+    CHECK(Exists(TempPath("err.2.txt")));
+    CHECK(!Exists(TempPath("err.3.txt")));
+    // Each file is rotated once it reaches the limit, within one batch
+    CHECK(FileSize(TempPath("err.1.txt")) >= 1000 && FileSize(TempPath("err.1.txt")) < 1000 + 4096);
+    CHECK(FileSize(path) < 1000);
+}
+
+// The hook before the sink: every line waits for the mutex, then opens,
+// writes, flushes and closes the file on the logging task
+void BenchmarkLegacyHook() {
+    constexpr int kThreads = 4;
+    constexpr int kLines = 2000;
+    std::string path = TempPath("legacy.txt");
+    std::mutex mutex;
+    auto write_line = [&](const char* line, size_t len) {
+        std::lock_guard<std::mutex> lock(mutex);
+        FILE* file = fopen(path.c_str(), "a");
+        if (file != nullptr) {
+            fwrite(line, 1, len, file);
+            fflush(file);
+            fclose(file);
+        }
+    };
+
+    std::vector<uint32_t> samples = Storm(kThreads, kLines, write_line);
+    Latency latency = Percentiles(samples);
+    printf("Per-line open/write/close hook, card not stalled: p50 %llu ns, p99 %llu ns, p99.9 %llu ns, "
+           "max %llu ns\n", (unsigned long long)latency.p50, (unsigned long long)latency.p99,
+           (unsigned long long)latency.p999, (unsigned long long)latency.max);
+    CHECK_EQ(ReadLines(path).size(), kThreads * kLines);
+}
+
+} // namespace
+
+// The card driver is not part of the host build; the sink only asks this
+bool SdCard::IsMounted() {
+    int stall_us = card_stall_us.load();
+    if (stall_us > 0) {
+        std::this_thread::sleep_for(std::chrono::microseconds(stall_us));
+    }
+    return mounted.load();
+}
+
+int main() {
+    char dir[] = "/tmp/sd_log_sink_XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    temp_dir = dir;
+
+    TestStorm(0, "storm.txt");
+    // Every batch takes 5 ms, far longer than filling the ring
+    TestStorm(5000, "stalled.txt");
+    TestTruncationAndUnmountedCard();
+    TestRotation();
+    BenchmarkLegacyHook();
+
+    std::string cleanup = "rm -rf " + temp_dir;
+    CHECK(system(cleanup.c_str()) == 0);
+    return HostTestResult("test_sd_log_sink");
+}
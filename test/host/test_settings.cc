@@ -0,0 +1,178 @@
+// SettingsStore against the fake NVS: read cache, replay order, coalescing,
+// EraseAll ordering and re-queueing of failed writes
+#include "settings.h"
+#include "fake_nvs.h"
+#include "host_test.h"
+
+#include <string>
+#include <vector>
+
+namespace {
+
+using Log = std::vector<std::string>;
+
+// Flushes and returns what reached NVS during the flush
+Log FlushLog() {
+    fake_nvs::ClearLog();
+    SettingsStore::GetInstance().Flush();
+    return fake_nvs::Log();
+}
+
+void PrintLog(const Log& log) {
+    for (const auto& line : log) {
+        fprintf(stderr, "    %s\n", line.c_str());
+    }
+}
+
+#define CHECK_LOG(actual, ...) do { \
+        Log log_value = (actual); \
+        Log expected_log = {__VA_ARGS__}; \
+        CHECK(log_value == expected_log); \
+        if (log_value != expected_log) { \
+            PrintLog(log_value); \
+        } \
+    } while (0)
+
+void TestReadCache() {
+    fake_nvs::Put("cache", "ssid", "home");
+    auto before = SettingsStore::GetInstance().GetStats();
+    Settings settings("cache");
+    for (int i = 0; i < 3; i++) {
+        CHECK(settings.GetString("ssid") == "home");
+        // Misses are cached as well
+        CHECK_EQ(settings.GetInt("missing", 5), 5);
+    }
+    auto after = SettingsStore::GetInstance().GetStats();
+    CHECK_EQ(after.reads - before.reads, 6);
+    CHECK_EQ(after.nvs_reads - before.nvs_reads, 2);
+
+    // Writes from a read-only Settings are refused
+    settings.SetString("ssid", "other");
+    CHECK(settings.GetString("ssid") == "home");
+}
+
+void TestReplayOrder() {
+    fake_nvs::Put("order_b", "w", "stale");
+    Settings a("order_a", true);
+    Settings b("order_b", true);
+    a.SetString("x", "1");
+    b.SetInt("y", 2);
+    a.SetString("z", "3");
+    b.EraseKey("w");
+    a.SetString("x", "4");
+
+    // x moves behind z because its last change came later
+    CHECK_LOG(FlushLog(), "set order_b/y=2", "set order_a/z=3", "erase order_b/w", "set order_a/x=4",
+              "commit order_a", "commit order_b");
+    CHECK(!fake_nvs::Contains("order_b", "w"));
+    CHECK_LOG(FlushLog());
+}
+
+void TestCoalescing() {
+    auto before = SettingsStore::GetInstance().GetStats();
+    Settings settings("coalesce", true);
+    for (int i = 0; i < 100; i++) {
+        settings.SetInt("volume", i);
+    }
+    settings.SetString("name", "a");
+    settings.SetString("name", "b");
+    settings.SetString("name", "a");
+    CHECK_EQ(settings.GetInt("volume"), 99);
+
+    CHECK_LOG(FlushLog(), "set coalesce/volume=99", "set coalesce/name=a", "commit coalesce");
+    auto after = SettingsStore::GetInstance().GetStats();
+    CHECK_EQ(after.writes - before.writes, 103);
+    CHECK_EQ(after.nvs_writes - before.nvs_writes, 2);
+    CHECK_EQ(after.flushes - before.flushes, 1);
+
+    // Writing the value that is already stored is free
+    settings.SetInt("volume", 99);
+    CHECK_LOG(FlushLog());
+}
+
+void TestEraseAllOrdering() {
+    fake_nvs::Put("erase", "old", "1");
+    Settings settings("erase", true);
+    settings.SetString("before", "1");
+    settings.EraseAll();
+    settings.SetString("after", "2");
+
+    // Keys from before the erase read as missing without waiting for the flush
+    CHECK(settings.GetString("old", "none") == "none");
+    CHECK(settings.GetString("before", "none") == "none");
+    CHECK(settings.GetString("after") == "2");
+
+    CHECK_LOG(FlushLog(), "erase_all erase", "set erase/after=2", "commit erase");
+    CHECK(!fake_nvs::Contains("erase", "old"));
+    CHECK(!fake_nvs::Contains("erase", "before"));
+    CHECK(fake_nvs::Contains("erase", "after"));
+}
+
+void TestFailedWriteRequeued() {
+    Settings settings("retry", true);
+    auto before = SettingsStore::GetInstance().GetStats();
+
+    // A failed set stays pending; the rest of the namespace is committed
+    fake_nvs::FailNext(fake_nvs::kSet, "retry", "pw");
+    settings.SetString("pw", "x");
+    settings.SetInt("n", 3);
+    CHECK_LOG(FlushLog(), "set retry/n=3", "commit retry");
+    CHECK_EQ(SettingsStore::GetInstance().GetStats().failed_writes - before.failed_writes, 1);
+    CHECK(settings.GetString("pw") == "x");
+    CHECK_LOG(FlushLog(), "set retry/pw=x", "commit retry");
+
+    // A newer value replaces the failed one instead of both being written
+    fake_nvs::FailNext(fake_nvs::kSet, "retry", "pw");
+    settings.SetString("pw", "y");
+    CHECK_LOG(FlushLog());
+    settings.SetString("pw", "z");
+    CHECK_LOG(FlushLog(), "set retry/pw=z", "commit retry");
+
+    // A failed commit loses every change of the namespace, so all are retried in order
+    fake_nvs::FailNext(fake_nvs::kCommit, "retry");
+    settings.SetString("a", "1");
+    settings.SetString("b", "2");
+    CHECK_LOG(FlushLog(), "set retry/a=1", "set retry/b=2");
+    CHECK(!fake_nvs::Contains("retry", "a"));
+    CHECK_LOG(FlushLog(), "set retry/a=1", "set retry/b=2", "commit retry");
+    CHECK(fake_nvs::Contains("retry", "b"));
+
+    // So does a namespace that cannot be opened
+    fake_nvs::FailNext(fake_nvs::kOpen, "retry");
+    settings.SetInt("n", 4);
+    CHECK_LOG(FlushLog());
+    CHECK_LOG(FlushLog(), "set retry/n=4", "commit retry");
+
+    auto after = SettingsStore::GetInstance().GetStats();
+    CHECK_EQ(after.failed_writes - before.failed_writes, 5);
+}
+
+void TestFailedEraseAllHoldsBackLaterWrites() {
+    fake_nvs::Put("hold", "old", "1");
+    Settings settings("hold", true);
+    settings.SetString("before", "0");
+    fake_nvs::FailNext(fake_nvs::kEraseAll, "hold");
+    settings.EraseAll();
+    settings.SetString("after", "1");
+
+    // Writing "after" now would be wiped by the retried erase
+    CHECK_LOG(FlushLog());
+    CHECK(fake_nvs::Contains("hold", "old"));
+    CHECK_LOG(FlushLog(), "erase_all hold", "set hold/after=1", "commit hold");
+    CHECK(!fake_nvs::Contains("hold", "old"));
+    std::string value;
+    CHECK(fake_nvs::Get("hold", "after", value) && value == "1");
+}
+
+} // namespace
+
+int main() {
+    fake_nvs::Reset();
+    TestReadCache();
+    TestReplayOrder();
+    TestCoalescing();
+    TestEraseAllOrdering();
+    TestFailedWriteRequeued();
+    TestFailedEraseAllHoldsBackLaterWrites();
+    return HostTestResult("test_settings");
+}
@@ -2,12 +2,20 @@
 """
 Simple HTTP server for testing Xiaozhi Animation Updater
 Hosts animation files and provides the required API endpoints
+
+File downloads honour Range / If-Range and send ETag and Last-Modified, so
+resumed downloads can be exercised. With --drop-max N every download is cut
+at a random offset of up to N bytes, standing in for a Wi-Fi drop.
 """
 
+import argparse
+import email.utils
 import http.server
+import random
 import socketserver
 import json
 import os
+import re
 import urllib.parse
 from datetime import datetime
 
@@ -15,8 +23,17 @@ from datetime import datetime
 HOST = "192.168.5.15"
 PORT = 8081
 ANIMATIONS_DIR = "animations"  # Directory containing your .bin files
+DROP_MAX = 0                   # Cut downloads at a random offset up to this many bytes, 0 = never
 
 class AnimationRequestHandler(http.server.SimpleHTTPRequestHandler):
+    def do_HEAD(self):
+        path = urllib.parse.urlparse(self.path).path
+        print(f"[{datetime.now().strftime('%H:%M:%S')}] HEAD {self.path}")
+        if path.startswith('/api/animations/') and not path.startswith('/api/animations/check'):
+            self.handle_file_download(path.split('/')[-1], head=True)
+        else:
+            super().do_HEAD()
+
     def do_GET(self):
         # Parse the URL and query parameters
         parsed_url = urllib.parse.urlparse(self.path)
@@ -82,36 +99,84 @@ class AnimationRequestHandler(http.server.SimpleHTTPRequestHandler):
         
         print(f"  Response: {len(animations)} animations available")
     
-    def handle_file_download(self, filename):
-        """Handle direct file downloads"""
+    def handle_file_download(self, filename, head=False):
+        """Handle direct file downloads, including resumed (Range) ones"""
         file_path = os.path.join(ANIMATIONS_DIR, filename)
         
         if not os.path.exists(file_path):
             self.send_error(404, f"File not found: {filename}")
             return
         
+        stat = os.stat(file_path)
+        file_size = stat.st_size
+        etag = f'"{file_size:x}-{stat.st_mtime_ns:x}"'
+        last_modified = email.utils.formatdate(stat.st_mtime, usegmt=True)
+
+        # Range: bytes=<start>- is all the updater sends; If-Range must match the current version
+        start = 0
+        range_header = self.headers.get('Range')
+        if_range = self.headers.get('If-Range')
+        match = re.fullmatch(r'bytes=(\d+)-', range_header or '')
+        if match and (if_range is None or if_range in (etag, last_modified)):
+            start = int(match.group(1))
+            if start >= file_size:
+                self.send_response(416)
+                self.send_header('Content-Range', f'bytes */{file_size}')
+                self.send_header('Content-Length', '0')
+                self.end_headers()
+                print(f"  Range start {start} past end of {filename}")
+                return
+
         # Send file
-        self.send_response(200)
+        self.send_response(206 if start > 0 else 200)
         self.send_header('Content-Type', 'application/octet-stream')
         self.send_header('Content-Disposition', f'attachment; filename="{filename}"')
         self.send_header('Access-Control-Allow-Origin', '*')
-        
-        file_size = os.path.getsize(file_path)
-        self.send_header('Content-Length', str(file_size))
+        self.send_header('Accept-Ranges', 'bytes')
+        self.send_header('ETag', etag)
+        self.send_header('Last-Modified', last_modified)
+        if start > 0:
+            self.send_header('Content-Range', f'bytes {start}-{file_size - 1}/{file_size}')
+        self.send_header('Content-Length', str(file_size - start))
         self.end_headers()
-        
+        if head:
+            return
+
         with open(file_path, 'rb') as f:
-            self.wfile.write(f.read())
+            f.seek(start)
+            data = f.read()
+        if DROP_MAX > 0:
+            cut = random.randint(1, DROP_MAX)
+            if cut < len(data):
+                self.wfile.write(data[:cut])
+                self.wfile.flush()
+                self.close_connection = True
+                self.connection.shutdown(2)
+                print(f"  Dropped {filename} after bytes {start}-{start + cut - 1} of {file_size}")
+                return
+        self.wfile.write(data)
         
-        print(f"  Served file: {filename} ({file_size} bytes)")
+        print(f"  Served file: {filename} (bytes {start}-{file_size - 1}, {file_size} total)")
 
 def main():
+    global HOST, PORT, ANIMATIONS_DIR, DROP_MAX
+    parser = argparse.ArgumentParser(description="Xiaozhi Animation Updater test server")
+    parser.add_argument('--host', default=HOST)
+    parser.add_argument('--port', type=int, default=PORT)
+    parser.add_argument('--dir', default=ANIMATIONS_DIR, help="directory with the .bin files")
+    parser.add_argument('--drop-max', type=int, default=DROP_MAX,
+                        help="cut each download at a random offset up to this many bytes")
+    args = parser.parse_args()
+    HOST, PORT, ANIMATIONS_DIR, DROP_MAX = args.host, args.port, args.dir, args.drop_max
+
     print("=" * 60)
     print("Xiaozhi Animation Updater Test Server")
     print("=" * 60)
     print(f"Host: {HOST}")
     print(f"Port: {PORT}")
     print(f"Animations Directory: {ANIMATIONS_DIR}")
+    if DROP_MAX > 0:
+        print(f"Dropping downloads within {DROP_MAX} bytes")
     print()
     
     # Check if animations directory exists
@@ -137,6 +202,8 @@ def main():
     print()
     
     # Start the server
+    # Restarting between test runs must not wait for TIME_WAIT sockets
+    socketserver.TCPServer.allow_reuse_address = True
     with socketserver.TCPServer((HOST, PORT), AnimationRequestHandler) as httpd:
         print(f"🚀 Server started at http://{HOST}:{PORT}")
         print()